@@ -114,6 +114,7 @@ GLIST_HELPER_INOUT(OwnerList, SWIGTYPE_p__gncOwner);
 }
 #endif
 
+%newobject gncOwnerFindOpenLots;
 
 /* Parse the header files to generate wrappers */
 %include <gncAddress.h>
@@ -217,6 +217,7 @@ SplitList * qof_query_run_subquery (QofQuery *q, const QofQuery *q);
 %ignore qof_query_run;
 %ignore qof_query_last_run;
 %ignore qof_query_run_subquery;
+%ignore qof_query_run_foreach;
 %include <qofquery.h>
 %include <qofquerycore.h>
 %include <qofbookslots.h>
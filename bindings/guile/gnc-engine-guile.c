@@ -1905,6 +1905,47 @@ gnc_hook_add_scm_dangler (const gchar *name, SCM proc)
     LEAVE("");
 }
 
+SCM
+gnc_account_get_balances_at_dates (Account *acc, SCM dates,
+                                   gnc_commodity *report_commodity,
+                                   gboolean ignclosing,
+                                   gboolean include_children)
+{
+    gsize n_dates, n_accounts, i, j;
+    gnc_numeric *balances;
+    time64 *dates_c;
+    SCM rows = SCM_EOL;
+
+    g_return_val_if_fail (acc && scm_is_true (scm_list_p (dates)), SCM_EOL);
+
+    n_dates = scm_to_size_t (scm_length (dates));
+    dates_c = g_new (time64, n_dates);
+    for (i = 0; i < n_dates; i++, dates = SCM_CDR (dates))
+    {
+        /* The engine excludes splits posted on the date itself */
+        time64 date = scm_to_int64 (SCM_CAR (dates));
+        dates_c[i] = date < INT64_MAX ? date + 1 : date;
+    }
+
+    balances = xaccAccountGetBalancesAsOfDates (acc, dates_c, n_dates,
+                                                report_commodity, ignclosing,
+                                                include_children, &n_accounts);
+    g_free (dates_c);
+    if (!balances)
+        return SCM_EOL;
+
+    for (i = n_accounts; i-- > 0;)
+    {
+        SCM row = SCM_EOL;
+        for (j = n_dates; j-- > 0;)
+            row = scm_cons (gnc_numeric_to_scm (balances[i * n_dates + j]), row);
+        rows = scm_cons (row, rows);
+    }
+    g_free (balances);
+
+    return rows;
+}
+
 time64
 gnc_parse_time_to_time64 (const gchar *s, const gchar *format)
 {
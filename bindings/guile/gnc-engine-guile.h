@@ -64,6 +64,18 @@ SCM gnc_account_value_ptr_to_scm (GncAccountValue *);
  */
 void gnc_hook_add_scm_dangler(const gchar *name, SCM proc);
 
+/** Get the balances of an account, and optionally of its descendants,
+ *  at a list of dates in one pass; see xaccAccountGetBalancesAsOfDates.
+ *  Unlike that function, splits posted on a date are included in its
+ *  balance, as the reports expect.
+ *
+ *  @return A list with one list of balances per account, in the order
+ *  of the dates. */
+SCM gnc_account_get_balances_at_dates (Account *acc, SCM dates,
+                                       gnc_commodity *report_commodity,
+                                       gboolean ignclosing,
+                                       gboolean include_children);
+
 /** Convert a time string to calendar time representation.  Combine strptime and
  *  mktime into a single function to avoid the need to wrap struct tm *.
  *
@@ -101,6 +101,8 @@
 
 %include <qofid.h>
 
+// takes a C callback
+%ignore qof_query_run_foreach;
 %include <qofquery.h>
 
 %include <qofquerycore.h>
@@ -451,8 +451,7 @@ gnc_payment_window_fill_docs_list (PaymentWindow *pw)
 
     /* Get a list of open lots for this owner and post account */
     if (pw->owner.owner.undefined && pw->post_acct)
-        list = xaccAccountFindOpenLots (pw->post_acct, gncOwnerLotMatchOwnerFunc,
-                                        &pw->owner, NULL);
+        list = gncOwnerFindOpenLots (&pw->owner, pw->post_acct, NULL);
 
     /* If pre-existing transaction's post account equals the selected post account
      * and we have lots for this transaction then compensate the document list for those.
@@ -452,11 +452,17 @@
     (gnc:make-gnc-monetary (xaccAccountGetCommodity account) (or bal 0)))
   (define balance 0)
   (map amount->monetary
-       (gnc:account-accumulate-at-dates
-        account dates-list #:split->elt
-        (lambda (s)
-          (if s (set! balance (+ balance (or (split->amount s) 0))))
-          balance))))
+       (if (eq? split->amount xaccSplitGetAmount)
+           ;; plain balances come from the engine, which bisects its
+           ;; sorted split index instead of walking the split list.
+           (car (gnc-account-get-balances-at-dates
+                 account (sort dates-list <)
+                 (xaccAccountGetCommodity account) #f #f))
+           (gnc:account-accumulate-at-dates
+            account dates-list #:split->elt
+            (lambda (s)
+              (if s (set! balance (+ balance (or (split->amount s) 0))))
+              balance)))))
 
 
 ;; this function will scan through account splitlist, building a list
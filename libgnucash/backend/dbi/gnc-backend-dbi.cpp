@@ -180,7 +180,7 @@ UriStrings::quote_dbname(DbType t) const noexcept
 }
 
 static void
-set_options(dbi_conn conn, const PairVec& options)
+set_options(dbi_conn conn, const OptionVec& options)
 {
     for (auto option : options)
     {
@@ -210,7 +210,7 @@ GncDbiBackend<Type>::set_standard_connection_options (dbi_conn conn,
 
 {
     gint result;
-    PairVec options;
+    OptionVec options;
     options.push_back(std::make_pair("host", uri.m_host));
     options.push_back(std::make_pair("dbname", uri.m_dbname));
     options.push_back(std::make_pair("username", uri.m_username));
@@ -241,7 +241,7 @@ template <DbType Type> void error_handler(dbi_conn conn, void* data);
 void error_handler(dbi_conn conn, void* data);
 
 template <DbType Type> dbi_conn
-GncDbiBackend<Type>::conn_setup (PairVec& options, UriStrings& uri)
+GncDbiBackend<Type>::conn_setup (OptionVec& options, UriStrings& uri)
 {
     const char* dbstr = (Type == DbType::DBI_SQLITE ? "sqlite3" :
                          Type == DbType::DBI_MYSQL ? "mysql" : "pgsql");
@@ -300,7 +300,7 @@ GncDbiBackend<Type>::create_database(dbi_conn conn, const char* db)
         dbname = "postgres";
         dbcreate = "CREATE DATABASE %s WITH TEMPLATE template0 ENCODING 'UTF8'";
     }
-    PairVec options;
+    OptionVec options;
     options.push_back(std::make_pair("dbname", dbname));
     try
     {
@@ -363,7 +363,7 @@ GncDbiBackend<DbType::DBI_SQLITE>::session_begin(QofSession* session,
                                                  SessionOpenMode mode)
 {
     gboolean file_exists;
-    PairVec options;
+    OptionVec options;
 
     g_return_if_fail (session != nullptr);
     g_return_if_fail (new_uri != nullptr);
@@ -643,7 +643,7 @@ GncDbiBackend<Type>::session_begin (QofSession* session, const char* new_uri,
                                     SessionOpenMode mode)
 {
     GncDbiTestResult dbi_test_result = GNC_DBI_PASS;
-    PairVec options;
+    OptionVec options;
 
     g_return_if_fail (session != nullptr);
     g_return_if_fail (new_uri != nullptr);
@@ -957,6 +957,7 @@ GncDbiBackend<Type>::safe_sync (QofBook* book)
     g_return_if_fail (book != nullptr);
 
     ENTER ("book=%p, primary=%p", book, m_book);
+    ensure_all_loaded();
     if (!conn->begin_transaction())
     {
         LEAVE("Failed to obtain a transaction.");
@@ -1000,6 +1001,7 @@ GncDbiBackend<DbType::DBI_MYSQL>::safe_sync (QofBook* book)
     g_return_if_fail (book != nullptr);
 
     ENTER ("book=%p, primary=%p", book, m_book);
+    ensure_all_loaded();
     if (!conn->table_operation (TableOpType::backup))
     {
         set_error(ERR_BACKEND_SERVER_ERR);
@@ -38,6 +38,8 @@ extern "C"
 #include <gnc-sql-connection.hpp>
 
 class GncSqlRow;
+/** libdbi connection options, by name. */
+using OptionVec = std::vector<std::pair<std::string, std::string>>;
 
 #define GNC_HOST_NAME_MAX 255
 
@@ -111,7 +113,7 @@ public:
     bool exists() { return m_exists; }
     void set_exists(bool exists) { m_exists = exists; }
 private:
-    dbi_conn conn_setup(PairVec& options, UriStrings& uri);
+    dbi_conn conn_setup(OptionVec& options, UriStrings& uri);
     bool conn_test_dbi_library(dbi_conn conn);
     bool set_standard_connection_options(dbi_conn conn, const UriStrings& uri);
     bool create_database(dbi_conn conn, const char* db);
@@ -51,17 +51,47 @@ public:
     ~GncDbiSqlStatement() {}
     const char* to_sql() const override;
     void add_where_cond(QofIdTypeConst, const PairVec&) override;
+    void bind(size_t, const GncSqlValue&) override;
 
 private:
+    std::string value_to_sql(const GncSqlValue&) const;
     const GncSqlConnection* m_conn = nullptr;
     std::string m_sql;
+    /* libdbi can't bind parameters, so the bound values are quoted for the
+     * database and written into a copy of the statement. m_param_pos holds
+     * the offset of each ? in m_sql. */
+    std::vector<size_t> m_param_pos;
+    std::vector<std::string> m_params;
+    mutable std::string m_bound_sql;
+    mutable bool m_bound_sql_ok = false;
 };
 
 
 const char*
 GncDbiSqlStatement::to_sql() const
 {
-    return m_sql.c_str();
+    if (m_params.empty())
+        return m_sql.c_str();
+    if (!m_bound_sql_ok)
+    {
+        m_bound_sql.clear();
+        size_t start = 0;
+        for (size_t i = 0; i < m_param_pos.size(); ++i)
+        {
+            m_bound_sql.append (m_sql, start, m_param_pos[i] - start);
+            m_bound_sql += m_params[i];
+            start = m_param_pos[i] + 1;
+        }
+        m_bound_sql.append (m_sql, start, std::string::npos);
+        m_bound_sql_ok = true;
+    }
+    return m_bound_sql.c_str();
+}
+
+std::string
+GncDbiSqlStatement::value_to_sql(const GncSqlValue& value) const
+{
+    return value.is_text ? m_conn->quote_string(value.value) : value.value;
 }
 
 void
@@ -69,15 +99,32 @@ GncDbiSqlStatement::add_where_cond(QofIdTypeConst type_name,
                                    const PairVec& col_values)
 {
     m_sql += " WHERE ";
-    for (auto colpair : col_values)
+    for (auto const& colpair : col_values)
     {
-        if (colpair != *col_values.begin())
+        if (&colpair != &col_values.front())
             m_sql += " AND ";
-        if (colpair.second == "NULL")
-            m_sql += colpair.first + " IS " + colpair.second;
+        if (colpair.second.is_null())
+            m_sql += colpair.first + " IS NULL";
         else
-            m_sql += colpair.first + " = " + colpair.second;
+            m_sql += colpair.first + " = " + value_to_sql(colpair.second);
+    }
+}
+
+/* The statements built for binding have no quoted text, so every ? is a
+ * parameter. */
+void
+GncDbiSqlStatement::bind(size_t index, const GncSqlValue& value)
+{
+    if (m_param_pos.empty())
+    {
+        for (auto pos = m_sql.find('?'); pos != std::string::npos;
+             pos = m_sql.find('?', pos + 1))
+            m_param_pos.push_back(pos);
+        m_params.resize(m_param_pos.size(), "NULL");
     }
+    g_return_if_fail(index < m_params.size());
+    m_params[index] = value_to_sql(value);
+    m_bound_sql_ok = false;
 }
 
 GncDbiSqlConnection::GncDbiSqlConnection (DbType type, QofBackend* qbe,
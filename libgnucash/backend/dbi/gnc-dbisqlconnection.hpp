@@ -80,6 +80,7 @@ public:
      */
     bool verify() noexcept override;
     bool retry_connection(const char* msg) noexcept override;
+    bool readonly() const noexcept override { return m_readonly; }
 
     bool table_operation (TableOpType op) noexcept;
     std::string add_columns_ddl(const std::string& table_name,
@@ -44,12 +44,14 @@ extern "C"
 #include <TransLog.h>
 #include "Transaction.h"
 #include "Split.h"
+#include "Query.h"
 #include "gnc-commodity.h"
 #include "gncAddress.h"
 #include "gncCustomer.h"
 #include "gncInvoice.h"
     /* For version_control */
 #include <gnc-prefs.h>
+#include <gnc-features.h>
 }
 /* For test_conn_index_functions */
 #include "../gnc-backend-dbi.hpp"
@@ -132,6 +134,9 @@ setup_memory (Fixture* fixture, gconstpointer pData)
     xaccAccountSetType (acct1, ACCT_TYPE_BANK);
     xaccAccountSetName (acct1, "Bank 1");
     xaccAccountSetCommodity (acct1, currency);
+    /* Text the database must store as it is. */
+    xaccAccountSetDescription (acct1, "Joe's \\ \"savings\"");
+    xaccAccountSetCode (acct1, "NULL");
 
     auto frame = qof_instance_get_slots (QOF_INSTANCE (acct1));
     frame->set ({"int64-val"}, new KvpValue (INT64_C (100)));
@@ -423,6 +428,129 @@ test_dbi_store_and_reload (Fixture* fixture, gconstpointer pData)
     qof_session_destroy (session_3);
 }
 
+/* Save the data to a database, change it and load it back leaving the
+ * transactions in the database until a query asks for them. The balances,
+ * which come from the account balances table, must come out the same as in
+ * the saved book either way. */
+static void
+test_dbi_load_on_demand (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    auto msg = "[GncDbiSqlConnection::unlock_database()] There was no lock entry in the Lock table";
+    auto log_domain = nullptr;
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    // Save the session data
+    auto book2{qof_book_new()};
+    auto session_2 = qof_session_new (book2);
+    qof_session_begin (session_2, url, SESSION_NEW_OVERWRITE);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (fixture->session, session_2);
+    qof_book_mark_session_dirty (qof_session_get_book (session_2));
+    qof_session_save (session_2, NULL);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+
+    /* Move a transaction to another month, reconcile a split and make it
+     * a closing transaction, which the account balances table has to
+     * follow. */
+    auto saved_book = qof_session_get_book (session_2);
+    auto accounts = gnc_account_get_descendants (gnc_book_get_root_account (saved_book));
+    for (auto node = accounts; node; node = g_list_next (node))
+    {
+        auto splits = xaccAccountGetSplitList (GNC_ACCOUNT (node->data));
+        if (splits == nullptr)
+            continue;
+        auto split = GNC_SPLIT (splits->data);
+        auto tx = xaccSplitGetParent (split);
+        xaccTransBeginEdit (tx);
+        xaccTransSetDatePostedSecsNormalized (tx, xaccTransGetDate (tx) -
+                                              90 * 24 * 3600);
+        xaccSplitSetReconcile (split, YREC);
+        xaccTransSetIsClosingTxn (tx, TRUE);
+        xaccTransCommitEdit (tx);
+        g_assert_cmpint (qof_session_get_error (session_2), == ,
+                         ERR_BACKEND_NO_ERR);
+        break;
+    }
+
+    // Reload it on demand
+    gnc_prefs_set_sql_load_on_demand (TRUE);
+    auto book3{qof_book_new()};
+    auto session_3 = qof_session_new (book3);
+    qof_session_begin (session_3, url, SESSION_READ_ONLY);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    qof_session_load (session_3, NULL);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    gnc_prefs_set_sql_load_on_demand (FALSE);
+    g_assert (gnc_features_check_used (book3, GNC_FEATURE_SQL_ACCOUNT_BALANCES));
+
+    auto now = gnc_time (nullptr);
+    for (auto node = accounts; node; node = g_list_next (node))
+    {
+        auto acct = GNC_ACCOUNT (node->data);
+        auto acct3 = xaccAccountLookup (qof_instance_get_guid (acct), book3);
+        g_assert (acct3 != nullptr);
+        g_assert (gnc_numeric_equal (xaccAccountGetBalance (acct),
+                                     xaccAccountGetBalance (acct3)));
+        g_assert (gnc_numeric_equal (xaccAccountGetClearedBalance (acct),
+                                     xaccAccountGetClearedBalance (acct3)));
+        g_assert (gnc_numeric_equal (xaccAccountGetReconciledBalance (acct),
+                                     xaccAccountGetReconciledBalance (acct3)));
+        g_assert (gnc_numeric_equal (
+                      xaccAccountGetNoclosingBalanceAsOfDateInCurrency (acct, now,
+                                                                        nullptr, FALSE),
+                      xaccAccountGetNoclosingBalanceAsOfDateInCurrency (acct3, now,
+                                                                        nullptr, FALSE)));
+    }
+
+    // An account's register query loads all of its splits
+    if (accounts)
+    {
+        auto acct = GNC_ACCOUNT (accounts->data);
+        auto acct3 = xaccAccountLookup (qof_instance_get_guid (acct), book3);
+        auto query = qof_query_create_for (GNC_ID_SPLIT);
+        qof_query_set_book (query, book3);
+        xaccQueryAddSingleAccountMatch (query, acct3, QOF_QUERY_AND);
+        auto splits = qof_query_run (query);
+        g_assert_cmpint (g_list_length (splits), == ,
+                         g_list_length (xaccAccountGetSplitList (acct)));
+        g_assert (gnc_numeric_equal (xaccAccountGetBalance (acct),
+                                     xaccAccountGetBalance (acct3)));
+        qof_query_destroy (query);
+    }
+
+    // Reading the splits or a dated balance loads what they need
+    for (auto node = accounts; node; node = g_list_next (node))
+    {
+        auto acct = GNC_ACCOUNT (node->data);
+        auto acct3 = xaccAccountLookup (qof_instance_get_guid (acct), book3);
+        auto splits = xaccAccountGetSplitList (acct);
+        if (splits == nullptr)
+            continue;
+        auto date = xaccTransGetDate (xaccSplitGetParent (GNC_SPLIT (splits->data)));
+        g_assert (gnc_numeric_equal (xaccAccountGetBalanceAsOfDate (acct, date),
+                                     xaccAccountGetBalanceAsOfDate (acct3, date)));
+        g_assert_cmpint (g_list_length (xaccAccountGetSplitList (acct3)), == ,
+                         g_list_length (splits));
+    }
+    g_list_free (accounts);
+
+    // Loading the rest gives back the saved book
+    qof_session_ensure_all_data_loaded (session_3);
+    compare_books (saved_book, book3);
+
+    qof_session_end (session_2);
+    qof_session_destroy (session_2);
+    qof_session_end (session_3);
+    qof_session_destroy (session_3);
+}
+
 /** Test the safe_save mechanism.  Beware that this test used on its
  * own doesn't ensure that the resave is done safely, only that the
  * database is intact and unchanged after the save. To observe the
@@ -435,6 +563,9 @@ test_dbi_safe_save (Fixture* fixture, gconstpointer pData)
 {
     auto url = (gchar*)pData;
     QofSession* session_2 = nullptr; // Otherwise goto cleanup bypasses init.
+    QofSession* session_3 = nullptr;
+    Account* acct = nullptr;
+    KvpFrame* frame = nullptr;
     auto msg = "[GncDbiSqlConnection::unlock_database()] There was no lock entry in the Lock table";
     auto log_domain = nullptr;
     auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
@@ -486,12 +617,39 @@ test_dbi_safe_save (Fixture* fixture, gconstpointer pData)
     qof_session_load (session_2, NULL);
     compare_books (qof_session_get_book (session_1),
                    qof_session_get_book (session_2));
+
+    /* Change some of the slots of a loaded account, which only rewrites
+     * those rows, and check that the database has them all. */
+    acct = gnc_account_lookup_by_name (gnc_book_get_root_account (
+                                           qof_session_get_book (session_2)),
+                                       "Bank 1");
+    g_assert (acct != NULL);
+    xaccAccountBeginEdit (acct);
+    frame = qof_instance_get_slots (QOF_INSTANCE (acct));
+    delete frame->set ({"int64-val"}, new KvpValue (INT64_C (200)));
+    delete frame->set ({"string-val"}, nullptr);
+    frame->set ({"new-string-val"}, new KvpValue (g_strdup ("qrstuvwxyz")));
+    qof_instance_set_dirty (QOF_INSTANCE (acct));
+    xaccAccountCommitEdit (acct);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+
+    session_3 = qof_session_new (qof_book_new());
+    qof_session_begin (session_3, url, SESSION_READ_ONLY);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    qof_session_load (session_3, NULL);
+    compare_books (qof_session_get_book (session_2),
+                   qof_session_get_book (session_3));
 //    auto qof_be = qof_book_get_backend (qof_session_get_book (session_2));
 //    test_conn_index_functions (qof_be);
 
 cleanup:
     fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
                                                  (GLogFunc)test_checked_handler);
+    if (session_3 != NULL)
+    {
+        qof_session_end (session_3);
+        qof_session_destroy (session_3);
+    }
     if (session_2 != NULL)
     {
         qof_session_end (session_2);
@@ -644,6 +802,8 @@ create_dbi_test_suite (const char* dbm_name, const char* url)
     auto subsuite = g_strdup_printf ("%s/%s", suitename, dbm_name);
     GNC_TEST_ADD (subsuite, "store_and_reload", Fixture, url, setup,
                   test_dbi_store_and_reload, teardown);
+    GNC_TEST_ADD (subsuite, "load_on_demand", Fixture, url, setup,
+                  test_dbi_load_on_demand, teardown);
     GNC_TEST_ADD (subsuite, "safe_save", Fixture, url, setup_memory,
                   test_dbi_safe_save, teardown);
     GNC_TEST_ADD (subsuite, "version_control", Fixture, url, setup_memory,
@@ -0,0 +1,689 @@
+/********************************************************************
+ * gnc-account-balances-sql.cpp: load and save data to SQL          *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+/** @file gnc-account-balances-sql.cpp
+ *  @brief load and save account balance snapshots to SQL
+ *
+ * This file implements the top-level QofBackend API for saving/
+ * restoring data to/from an SQL db
+ */
+#include <guid.hpp>
+extern "C"
+{
+#include <config.h>
+
+#include "qof.h"
+#include "Account.h"
+#include "Transaction.h"
+#include "Split.h"
+#include "gnc-features.h"
+
+#if defined( S_SPLINT_S )
+#include "splint-defs.h"
+#endif
+}
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gnc-datetime.hpp>
+#include <kvp-frame.hpp>
+#include "gnc-sql-connection.hpp"
+#include "gnc-sql-backend.hpp"
+#include "gnc-sql-object-backend.hpp"
+#include "gnc-sql-column-table-entry.hpp"
+#include "gnc-account-balances-sql.h"
+
+static QofLogModule log_module = G_LOG_DOMAIN;
+
+#define TABLE_NAME "account_balances"
+#define TABLE_VERSION 1
+
+#define SPLIT_TABLE "splits"
+#define TRANSACTION_TABLE "transactions"
+
+/* A row of the table, or a change to one. */
+typedef struct
+{
+    GncGUID account_guid;
+    time64 period_start;
+    acct_balances_t bal;
+} period_balance_t;
+
+/* A split as it is in the database, with its transaction's post date. */
+typedef struct
+{
+    GncGUID account_guid;
+    char reconcile_state;
+    gnc_numeric quantity;
+    time64 post_date;
+} db_split_t;
+
+using PeriodBalances = std::map<std::pair<std::string, time64>,
+                                period_balance_t>;
+
+static gpointer get_account_guid (gpointer pObject);
+static void set_account_guid (gpointer pObject, gpointer pValue);
+static time64 get_period_start (gpointer pObject);
+static void set_period_start (gpointer pObject, time64 value);
+static gnc_numeric get_balance (gpointer pObject);
+static void set_balance (gpointer pObject, gnc_numeric value);
+static gnc_numeric get_cleared_balance (gpointer pObject);
+static void set_cleared_balance (gpointer pObject, gnc_numeric value);
+static gnc_numeric get_reconciled_balance (gpointer pObject);
+static void set_reconciled_balance (gpointer pObject, gnc_numeric value);
+static gnc_numeric get_noclosing_balance (gpointer pObject);
+static void set_noclosing_balance (gpointer pObject, gnc_numeric value);
+static void set_split_account_guid (gpointer pObject, gpointer pValue);
+static void set_split_reconcile_state (gpointer pObject, gpointer pValue);
+static void set_split_quantity (gpointer pObject, gnc_numeric value);
+static void set_split_post_date (gpointer pObject, time64 value);
+
+static const EntryVec col_table
+({
+    gnc_sql_make_table_entry<CT_GUID>("account_guid", 0, COL_NNUL,
+                                      (QofAccessFunc)get_account_guid,
+                                      (QofSetterFunc)set_account_guid),
+    gnc_sql_make_table_entry<CT_TIME>("period_start", 0, COL_NNUL,
+                                      (QofAccessFunc)get_period_start,
+                                      (QofSetterFunc)set_period_start),
+    gnc_sql_make_table_entry<CT_NUMERIC>("balance", 0, COL_NNUL,
+                                         (QofAccessFunc)get_balance,
+                                         (QofSetterFunc)set_balance),
+    gnc_sql_make_table_entry<CT_NUMERIC>("cleared_balance", 0, COL_NNUL,
+                                         (QofAccessFunc)get_cleared_balance,
+                                         (QofSetterFunc)set_cleared_balance),
+    gnc_sql_make_table_entry<CT_NUMERIC>("reconciled_balance", 0, COL_NNUL,
+                                         (QofAccessFunc)get_reconciled_balance,
+                                         (QofSetterFunc)set_reconciled_balance),
+    gnc_sql_make_table_entry<CT_NUMERIC>("noclosing_balance", 0, COL_NNUL,
+                                         (QofAccessFunc)get_noclosing_balance,
+                                         (QofSetterFunc)set_noclosing_balance),
+});
+
+static const EntryVec account_guid_col_table
+({
+    gnc_sql_make_table_entry<CT_GUID>("account_guid", 0, COL_NNUL,
+                                      (QofAccessFunc)get_account_guid,
+                                      (QofSetterFunc)set_account_guid),
+});
+
+static const EntryVec db_split_col_table
+({
+    gnc_sql_make_table_entry<CT_GUID>("account_guid", 0, 0, nullptr,
+                                      (QofSetterFunc)set_split_account_guid),
+    gnc_sql_make_table_entry<CT_STRING>("reconcile_state", 1, 0, nullptr,
+                                        (QofSetterFunc)set_split_reconcile_state),
+    gnc_sql_make_table_entry<CT_NUMERIC>("quantity", 0, 0, nullptr,
+                                         (QofSetterFunc)set_split_quantity),
+    gnc_sql_make_table_entry<CT_TIME>("post_date", 0, 0, nullptr,
+                                      (QofSetterFunc)set_split_post_date),
+});
+
+GncSqlAccountBalancesBackend::GncSqlAccountBalancesBackend() :
+    GncSqlObjectBackend(TABLE_VERSION, GNC_ID_ACCOUNT, TABLE_NAME, col_table) {}
+
+/* ================================================================= */
+
+static gpointer
+get_account_guid (gpointer pObject)
+{
+    g_return_val_if_fail (pObject != NULL, NULL);
+
+    return &((period_balance_t*)pObject)->account_guid;
+}
+
+static void
+set_account_guid (gpointer pObject, gpointer pValue)
+{
+    g_return_if_fail (pObject != NULL);
+    g_return_if_fail (pValue != NULL);
+
+    ((period_balance_t*)pObject)->account_guid = *(GncGUID*)pValue;
+}
+
+static time64
+get_period_start (gpointer pObject)
+{
+    g_return_val_if_fail (pObject != NULL, 0);
+
+    return ((period_balance_t*)pObject)->period_start;
+}
+
+static void
+set_period_start (gpointer pObject, time64 value)
+{
+    g_return_if_fail (pObject != NULL);
+
+    ((period_balance_t*)pObject)->period_start = value;
+}
+
+static gnc_numeric
+get_balance (gpointer pObject)
+{
+    g_return_val_if_fail (pObject != NULL, gnc_numeric_zero ());
+
+    return ((period_balance_t*)pObject)->bal.balance;
+}
+
+static void
+set_balance (gpointer pObject, gnc_numeric value)
+{
+    g_return_if_fail (pObject != NULL);
+
+    ((period_balance_t*)pObject)->bal.balance = value;
+}
+
+static gnc_numeric
+get_cleared_balance (gpointer pObject)
+{
+    g_return_val_if_fail (pObject != NULL, gnc_numeric_zero ());
+
+    return ((period_balance_t*)pObject)->bal.cleared_balance;
+}
+
+static void
+set_cleared_balance (gpointer pObject, gnc_numeric value)
+{
+    g_return_if_fail (pObject != NULL);
+
+    ((period_balance_t*)pObject)->bal.cleared_balance = value;
+}
+
+static gnc_numeric
+get_reconciled_balance (gpointer pObject)
+{
+    g_return_val_if_fail (pObject != NULL, gnc_numeric_zero ());
+
+    return ((period_balance_t*)pObject)->bal.reconciled_balance;
+}
+
+static void
+set_reconciled_balance (gpointer pObject, gnc_numeric value)
+{
+    g_return_if_fail (pObject != NULL);
+
+    ((period_balance_t*)pObject)->bal.reconciled_balance = value;
+}
+
+static gnc_numeric
+get_noclosing_balance (gpointer pObject)
+{
+    g_return_val_if_fail (pObject != NULL, gnc_numeric_zero ());
+
+    return ((period_balance_t*)pObject)->bal.noclosing_balance;
+}
+
+static void
+set_noclosing_balance (gpointer pObject, gnc_numeric value)
+{
+    g_return_if_fail (pObject != NULL);
+
+    ((period_balance_t*)pObject)->bal.noclosing_balance = value;
+}
+
+static void
+set_split_account_guid (gpointer pObject, gpointer pValue)
+{
+    g_return_if_fail (pObject != NULL);
+    g_return_if_fail (pValue != NULL);
+
+    ((db_split_t*)pObject)->account_guid = *(GncGUID*)pValue;
+}
+
+static void
+set_split_reconcile_state (gpointer pObject, gpointer pValue)
+{
+    const gchar* s = (const gchar*)pValue;
+
+    g_return_if_fail (pObject != NULL);
+    g_return_if_fail (pValue != NULL);
+
+    ((db_split_t*)pObject)->reconcile_state = s[0];
+}
+
+static void
+set_split_quantity (gpointer pObject, gnc_numeric value)
+{
+    g_return_if_fail (pObject != NULL);
+
+    ((db_split_t*)pObject)->quantity = value;
+}
+
+static void
+set_split_post_date (gpointer pObject, time64 value)
+{
+    g_return_if_fail (pObject != NULL);
+
+    ((db_split_t*)pObject)->post_date = value;
+}
+
+/* ================================================================= */
+
+void
+gnc_sql_acct_balances_add (acct_balances_t& bal, char reconcile_state,
+                           gnc_numeric amount, bool closing)
+{
+    auto add = [amount](gnc_numeric& n) {
+        n = gnc_numeric_add (n, amount, GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+    };
+    add (bal.balance);
+    if (reconcile_state != NREC)
+        add (bal.cleared_balance);
+    if (reconcile_state == YREC || reconcile_state == FREC)
+        add (bal.reconciled_balance);
+    if (!closing)
+        add (bal.noclosing_balance);
+}
+
+static void
+add_balances (acct_balances_t& bal, const acct_balances_t& other)
+{
+    auto add = [](gnc_numeric& n, gnc_numeric m) {
+        n = gnc_numeric_add (n, m, GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+    };
+    add (bal.balance, other.balance);
+    add (bal.cleared_balance, other.cleared_balance);
+    add (bal.reconciled_balance, other.reconciled_balance);
+    add (bal.noclosing_balance, other.noclosing_balance);
+}
+
+static bool
+balances_zero (const acct_balances_t& bal)
+{
+    return gnc_numeric_zero_p (bal.balance) &&
+        gnc_numeric_zero_p (bal.cleared_balance) &&
+        gnc_numeric_zero_p (bal.reconciled_balance) &&
+        gnc_numeric_zero_p (bal.noclosing_balance);
+}
+
+/* The start of the month, in UTC so that every client agrees on it. */
+static time64
+period_start (time64 date)
+{
+    auto tm = gnc_gmtime (&date);
+    if (tm == nullptr)
+        return date;
+    tm->tm_mday = 1;
+    tm->tm_hour = 0;
+    tm->tm_min = 0;
+    tm->tm_sec = 0;
+    auto start = gnc_timegm (tm);
+    gnc_tm_free (tm);
+    return start;
+}
+
+time64
+gnc_sql_account_balances_period_start (time64 date)
+{
+    return period_start (date);
+}
+
+static period_balance_t&
+period_balance (PeriodBalances& balances, const GncGUID& guid, time64 date)
+{
+    auto start = period_start (date);
+    auto zero = gnc_numeric_zero ();
+    auto key = std::make_pair (gnc::GUID{guid}.to_string(), start);
+    period_balance_t bal{guid, start, {nullptr, zero, zero, zero, zero}};
+    return balances.emplace (key, bal).first->second;
+}
+
+static std::string
+quoted_time (time64 t)
+{
+    return "'" + GncDateTime(t).format_iso8601() + "'";
+}
+
+/**
+ * Reads the splits the condition picks out as they are in the database.
+ *
+ * @param sql_be SQL backend
+ * @param condition SQL condition on the splits and transactions tables
+ * @param splits The splits are appended here
+ * @return TRUE if successful, FALSE if error
+ */
+static gboolean
+load_db_splits (GncSqlBackend* sql_be, const std::string& condition,
+                std::vector<db_split_t>& splits)
+{
+    std::string sql("SELECT " SPLIT_TABLE ".account_guid, "
+                    SPLIT_TABLE ".reconcile_state, "
+                    SPLIT_TABLE ".quantity_num, "
+                    SPLIT_TABLE ".quantity_denom, "
+                    TRANSACTION_TABLE ".post_date FROM " SPLIT_TABLE
+                    " INNER JOIN " TRANSACTION_TABLE " ON "
+                    SPLIT_TABLE ".tx_guid = " TRANSACTION_TABLE ".guid");
+    if (!condition.empty())
+        sql += " WHERE " + condition;
+    auto stmt = sql_be->create_statement_from_sql (sql);
+    auto result = sql_be->execute_select_statement (stmt);
+    if (result == nullptr)
+        return FALSE;
+
+    for (auto row : *result)
+    {
+        db_split_t split{*guid_null (), NREC, gnc_numeric_zero (), 0};
+        gnc_sql_load_object (sql_be, row, TABLE_NAME, &split,
+                             db_split_col_table);
+        splits.push_back (split);
+    }
+    return TRUE;
+}
+
+/**
+ * Adds the changes to the rows of the table, deleting the rows that come
+ * to nothing.
+ *
+ * @param sql_be SQL backend
+ * @param changes Changes by account and period
+ * @return TRUE if successful, FALSE if error
+ */
+static gboolean
+save_period_balances (GncSqlBackend* sql_be, PeriodBalances& changes)
+{
+    for (auto& entry : changes)
+    {
+        auto& change = entry.second;
+        if (balances_zero (change.bal))
+            continue;
+
+        std::string where(" WHERE account_guid = '" + entry.first.first +
+                          "' AND period_start = " +
+                          quoted_time (change.period_start));
+        auto stmt = sql_be->create_statement_from_sql ("SELECT * FROM "
+                                                       TABLE_NAME + where);
+        auto result = sql_be->execute_select_statement (stmt);
+        if (result == nullptr)
+            return FALSE;
+
+        auto in_db = false;
+        for (auto row : *result)
+        {
+            auto zero = gnc_numeric_zero ();
+            period_balance_t old{change.account_guid, change.period_start,
+                                 {nullptr, zero, zero, zero, zero}};
+            gnc_sql_load_object (sql_be, row, TABLE_NAME, &old, col_table);
+            add_balances (change.bal, old.bal);
+            in_db = true;
+        }
+        if (in_db)
+        {
+            stmt = sql_be->create_statement_from_sql ("DELETE FROM "
+                                                      TABLE_NAME + where);
+            if (sql_be->execute_nonselect_statement (stmt) == -1)
+                return FALSE;
+        }
+        if (!balances_zero (change.bal) &&
+            !sql_be->do_db_operation (OP_DB_INSERT, TABLE_NAME, TABLE_NAME,
+                                      &change, col_table))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+gboolean
+gnc_sql_account_balances_commit_tx (GncSqlBackend* sql_be, Transaction* pTx)
+{
+    g_return_val_if_fail (sql_be != NULL, FALSE);
+    g_return_val_if_fail (pTx != NULL, FALSE);
+
+    /* A new transaction's splits are added as they are committed, and
+     * sync writes the whole table. */
+    auto inst = QOF_INSTANCE (pTx);
+    if (sql_be->pristine() || qof_instance_get_infant (inst))
+        return TRUE;
+
+    std::vector<db_split_t> splits;
+    auto guid = gnc::GUID{*qof_instance_get_guid (inst)}.to_string();
+    if (!load_db_splits (sql_be, SPLIT_TABLE ".tx_guid = '" + guid + "'",
+                         splits))
+        return FALSE;
+
+    /* Whether the transaction was closing before comes from the slots it
+     * began its edit with; without them it's taken to be what it is now.
+     * Within the same month and flag the changes cancel out and nothing is
+     * written. */
+    auto closing = xaccTransGetIsClosingTxn (pTx);
+    auto was_closing = closing;
+    if (auto frame = sql_be->slots_at_begin (inst))
+    {
+        auto value = frame->get_slot ({"book_closing"});
+        was_closing = value != nullptr &&
+            value->get_type () == KvpValue::Type::INT64 &&
+            value->get<int64_t> () != 0;
+    }
+    auto destroying = qof_instance_get_destroying (inst);
+    PeriodBalances changes;
+    for (const auto& split : splits)
+    {
+        auto& old_bal = period_balance (changes, split.account_guid,
+                                        split.post_date);
+        gnc_sql_acct_balances_add (old_bal.bal, split.reconcile_state,
+                                   gnc_numeric_neg (split.quantity),
+                                   was_closing);
+        if (destroying)
+            continue;
+        auto& new_bal = period_balance (changes, split.account_guid,
+                                        xaccTransGetDate (pTx));
+        gnc_sql_acct_balances_add (new_bal.bal, split.reconcile_state,
+                                   split.quantity, closing);
+    }
+    return save_period_balances (sql_be, changes);
+}
+
+gboolean
+gnc_sql_account_balances_commit_split (GncSqlBackend* sql_be, Split* pSplit)
+{
+    g_return_val_if_fail (sql_be != NULL, FALSE);
+    g_return_val_if_fail (pSplit != NULL, FALSE);
+
+    auto inst = QOF_INSTANCE (pSplit);
+    if (sql_be->pristine())
+        return TRUE;
+
+    auto pTx = xaccSplitGetParent (pSplit);
+    auto closing = pTx != nullptr && xaccTransGetIsClosingTxn (pTx);
+    PeriodBalances changes;
+    if (!qof_instance_get_infant (inst))
+    {
+        std::vector<db_split_t> splits;
+        auto guid = gnc::GUID{*qof_instance_get_guid (inst)}.to_string();
+        if (!load_db_splits (sql_be, SPLIT_TABLE ".guid = '" + guid + "'",
+                             splits))
+            return FALSE;
+        for (const auto& split : splits)
+        {
+            auto& old_bal = period_balance (changes, split.account_guid,
+                                            split.post_date);
+            gnc_sql_acct_balances_add (old_bal.bal, split.reconcile_state,
+                                       gnc_numeric_neg (split.quantity),
+                                       closing);
+        }
+    }
+
+    auto acct = xaccSplitGetAccount (pSplit);
+    if (!qof_instance_get_destroying (inst) && acct != nullptr &&
+        pTx != nullptr)
+    {
+        auto& new_bal = period_balance (changes,
+                                        *qof_instance_get_guid (acct),
+                                        xaccTransGetDate (pTx));
+        gnc_sql_acct_balances_add (new_bal.bal, xaccSplitGetReconcile (pSplit),
+                                   xaccSplitGetAmount (pSplit), closing);
+    }
+    return save_period_balances (sql_be, changes);
+}
+
+gboolean
+gnc_sql_account_balances_load (GncSqlBackend* sql_be, time64 before,
+                               std::unordered_map<Account*, acct_balances_t>& balances,
+                               Account* acct)
+{
+    g_return_val_if_fail (sql_be != NULL, FALSE);
+
+    std::string sql("SELECT * FROM " TABLE_NAME);
+    std::string where;
+    if (before != INT64_MAX)
+        where = "period_start < " + quoted_time (before);
+    if (acct != nullptr)
+    {
+        if (!where.empty())
+            where += " AND ";
+        where += "account_guid = '" +
+            gnc::GUID{*qof_instance_get_guid (acct)}.to_string() + "'";
+    }
+    if (!where.empty())
+        sql += " WHERE " + where;
+    auto stmt = sql_be->create_statement_from_sql (sql);
+    auto result = sql_be->execute_select_statement (stmt);
+    if (result == nullptr)
+        return FALSE;
+
+    auto zero = gnc_numeric_zero ();
+    for (auto row : *result)
+    {
+        period_balance_t period{*guid_null (), 0,
+                                {nullptr, zero, zero, zero, zero}};
+        gnc_sql_load_object (sql_be, row, TABLE_NAME, &period, col_table);
+        auto account = xaccAccountLookup (&period.account_guid, sql_be->book());
+        if (account == nullptr)
+            continue;
+        auto& bal = balances.emplace (account, acct_balances_t{account, zero, zero,
+                                                               zero, zero}).first->second;
+        add_balances (bal, period.bal);
+    }
+    return TRUE;
+}
+
+/* ================================================================= */
+
+static gboolean
+save_db_splits (GncSqlBackend* sql_be)
+{
+    std::vector<db_split_t> splits;
+    if (!load_db_splits (sql_be, "", splits))
+        return FALSE;
+
+    PeriodBalances balances;
+    for (const auto& split : splits)
+    {
+        auto& bal = period_balance (balances, split.account_guid,
+                                    split.post_date);
+        gnc_sql_acct_balances_add (bal.bal, split.reconcile_state,
+                                   split.quantity, false);
+    }
+
+    /* Take the closing transactions back out of the noclosing balances. */
+    splits.clear();
+    if (!load_db_splits (sql_be, SPLIT_TABLE ".tx_guid IN (SELECT obj_guid "
+                         "FROM slots WHERE name = 'book_closing' "
+                         "AND int64_val <> 0)", splits))
+        return FALSE;
+    for (const auto& split : splits)
+    {
+        auto& bal = period_balance (balances, split.account_guid,
+                                    split.post_date);
+        bal.bal.noclosing_balance = gnc_numeric_sub (bal.bal.noclosing_balance,
+                                                     split.quantity,
+                                                     GNC_DENOM_AUTO,
+                                                     GNC_HOW_DENOM_LCD);
+    }
+
+    for (auto& entry : balances)
+    {
+        if (balances_zero (entry.second.bal))
+            continue;
+        if (!sql_be->do_db_operation (OP_DB_INSERT, TABLE_NAME, TABLE_NAME,
+                                      &entry.second, col_table))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * Creates the account balances table. A database from before the table
+ * gets it filled in from its splits.
+ *
+ * @param sql_be SQL backend
+ */
+void
+GncSqlAccountBalancesBackend::create_tables (GncSqlBackend* sql_be)
+{
+    g_return_if_fail (sql_be != NULL);
+
+    auto version = sql_be->get_table_version (m_table_name.c_str());
+    if (version == 0)
+    {
+        (void)sql_be->create_table (TABLE_NAME, TABLE_VERSION, col_table);
+        if (!sql_be->create_index ("account_balances_account_guid_index",
+                                   TABLE_NAME, account_guid_col_table))
+            PERR ("Unable to create index\n");
+        if (!save_db_splits (sql_be))
+            PERR ("Unable to fill in the account balances\n");
+        /* Older versions would change splits without following them here. */
+        sql_be->feature_used (GNC_FEATURE_SQL_ACCOUNT_BALANCES);
+    }
+}
+
+static void
+add_split_cb (QofInstance* inst, gpointer data)
+{
+    auto balances = static_cast<PeriodBalances*>(data);
+    auto split = GNC_SPLIT (inst);
+    auto acct = xaccSplitGetAccount (split);
+    auto pTx = xaccSplitGetParent (split);
+    if (acct == nullptr || pTx == nullptr)
+        return;
+
+    auto& bal = period_balance (*balances, *qof_instance_get_guid (acct),
+                                xaccTransGetDate (pTx));
+    gnc_sql_acct_balances_add (bal.bal, xaccSplitGetReconcile (split),
+                               xaccSplitGetAmount (split),
+                               xaccTransGetIsClosingTxn (pTx));
+}
+
+/**
+ * Writes the whole table from the splits in memory.
+ *
+ * @param sql_be SQL backend
+ * @return true if successful, false if error
+ */
+bool
+GncSqlAccountBalancesBackend::write (GncSqlBackend* sql_be)
+{
+    g_return_val_if_fail (sql_be != NULL, false);
+
+    PeriodBalances balances;
+    qof_collection_foreach (qof_book_get_collection (sql_be->book(),
+                                                     GNC_ID_SPLIT),
+                            add_split_cb, &balances);
+    for (auto& entry : balances)
+    {
+        if (balances_zero (entry.second.bal))
+            continue;
+        if (!sql_be->do_db_operation (OP_DB_INSERT, TABLE_NAME, TABLE_NAME,
+                                      &entry.second, col_table))
+            return false;
+    }
+    return true;
+}
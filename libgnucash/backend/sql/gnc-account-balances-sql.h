@@ -0,0 +1,99 @@
+/********************************************************************
+ * gnc-account-balances-sql.h: load and save data to SQL            *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+/** @file gnc-account-balances-sql.h
+ *  @brief load and save account balance snapshots to SQL
+ *
+ * The account_balances table holds, for each account and calendar month
+ * (UTC) in which it has splits, what those splits add up to. It is kept
+ * up to date as transactions and splits are committed, so an account's
+ * balance as of the start of any month is the sum of its earlier rows
+ * without reading the splits table.
+ */
+
+#ifndef GNC_ACCOUNT_BALANCES_SQL_H
+#define GNC_ACCOUNT_BALANCES_SQL_H
+
+extern "C"
+{
+#include "qof.h"
+#include "Account.h"
+#include "Transaction.h"
+}
+#include "gnc-sql-object-backend.hpp"
+
+#include <unordered_map>
+
+typedef struct
+{
+    Account* acct;
+    gnc_numeric balance;
+    gnc_numeric cleared_balance;
+    gnc_numeric reconciled_balance;
+    gnc_numeric noclosing_balance;
+} acct_balances_t;
+
+class GncSqlAccountBalancesBackend : public GncSqlObjectBackend
+{
+public:
+    GncSqlAccountBalancesBackend();
+    void load_all(GncSqlBackend*) override { return; }
+    void create_tables(GncSqlBackend*) override;
+    bool commit(GncSqlBackend*, QofInstance*) override { return false; }
+    bool write(GncSqlBackend*) override;
+};
+
+/**
+ * Adds a split's amount to the balances the way the engine's
+ * xaccAccountRecomputeBalance does.
+ */
+void gnc_sql_acct_balances_add (acct_balances_t& bal, char reconcile_state,
+                                gnc_numeric amount, bool closing);
+/**
+ * Moves the transaction's splits, as they are in the database, to the
+ * month of its new post date, or takes them out if it's being destroyed.
+ * Call before the transaction row is written.
+ */
+gboolean gnc_sql_account_balances_commit_tx (GncSqlBackend* sql_be,
+                                             Transaction* pTx);
+/**
+ * Replaces the split's database row in the balances with the split.
+ * Call before the split row is written.
+ */
+gboolean gnc_sql_account_balances_commit_split (GncSqlBackend* sql_be,
+                                                Split* pSplit);
+/**
+ * The start of the month a date is in, the period of a row of the table.
+ */
+time64 gnc_sql_account_balances_period_start (time64 date);
+/**
+ * Adds up the rows of each account for the months starting before
+ * before.
+ *
+ * @param sql_be SQL backend
+ * @param before INT64_MAX for the whole table
+ * @param balances The balances are added to those already there
+ * @param acct Only this account's rows, or nullptr for every account's
+ */
+gboolean gnc_sql_account_balances_load (GncSqlBackend* sql_be, time64 before,
+                                        std::unordered_map<Account*, acct_balances_t>& balances,
+                                        Account* acct = nullptr);
+
+#endif /* GNC_ACCOUNT_BALANCES_SQL_H */
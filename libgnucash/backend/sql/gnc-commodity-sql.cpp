@@ -156,6 +156,7 @@ GncSqlCommodityBackend::load_all (GncSqlBackend* sql_be)
 
             guid = *qof_instance_get_guid (QOF_INSTANCE (pCommodity));
             pCommodity = gnc_commodity_table_insert (pTable, pCommodity);
+            sql_be->set_commodity_in_db (pCommodity, true);
             if (qof_instance_is_dirty (QOF_INSTANCE (pCommodity)))
                 sql_be->commodity_for_postload_processing(pCommodity);
             qof_instance_set_guid (QOF_INSTANCE (pCommodity), &guid);
@@ -196,6 +197,8 @@ do_commit_commodity (GncSqlBackend* sql_be, QofInstance* inst,
 
     if (is_ok)
     {
+        sql_be->set_commodity_in_db (GNC_COMMODITY (inst), op != OP_DB_DELETE);
+
         // Now, commit any slots
         guid = qof_instance_get_guid (inst);
         if (!qof_instance_get_destroying (inst))
@@ -217,7 +220,7 @@ GncSqlCommodityBackend::commit (GncSqlBackend* sql_be, QofInstance* inst)
     g_return_val_if_fail (sql_be != NULL, FALSE);
     g_return_val_if_fail (inst != NULL, FALSE);
     g_return_val_if_fail (GNC_IS_COMMODITY (inst), FALSE);
-    auto in_be = instance_in_db(sql_be, inst);
+    auto in_be = sql_be->commodity_in_db(GNC_COMMODITY (inst));
     return do_commit_commodity (sql_be, inst, !in_be);
 }
 
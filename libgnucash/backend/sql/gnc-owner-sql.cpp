@@ -216,20 +216,17 @@ GncSqlColumnTableEntryImpl<CT_OWNERREF>::add_to_query(QofIdTypeConst obj_name,
     if (inst == nullptr)
     {
         /* Twice, once for type, once for guid. */
-        vec.emplace_back (std::make_pair (type_hdr, std::string{"NULL"}));
-        vec.emplace_back (std::make_pair (guid_hdr, std::string{"NULL"}));
+        vec.emplace_back (std::make_pair (type_hdr, literal_value("NULL")));
+        vec.emplace_back (std::make_pair (guid_hdr, literal_value("NULL")));
 
         return;
     }
-    std::ostringstream buf;
-
-    buf << type;
-    vec.emplace_back(std::make_pair(type_hdr, quote_string(buf.str())));
-    buf.str("");
+    vec.emplace_back(std::make_pair(type_hdr,
+                                    literal_value(std::to_string(type))));
     auto guid = qof_instance_get_guid(inst);
     if (guid != nullptr)
-        buf << guid_to_string(guid);
+        vec.emplace_back(std::make_pair(guid_hdr,
+                                        text_value(guid_to_string(guid))));
     else
-        buf << "NULL";
-    vec.emplace_back(std::make_pair(guid_hdr, quote_string(buf.str())));
+        vec.emplace_back(std::make_pair(guid_hdr, literal_value("NULL")));
 }
@@ -42,6 +42,7 @@ extern "C"
 
 #include <string>
 #include <sstream>
+#include <vector>
 
 #include "gnc-sql-connection.hpp"
 #include "gnc-sql-backend.hpp"
@@ -646,6 +647,60 @@ save_slot (const char* key, KvpValue* value, slot_info_t & slot_info)
     }
 }
 
+static bool
+is_nested (const KvpValue* value)
+{
+    auto type = value->get_type ();
+    return type == KvpValue::Type::FRAME || type == KvpValue::Type::GLIST;
+}
+
+/* Finds the top-level slots that differ between the two frames. Frames and
+ * lists keep their contents under generated guids, so if one of them has
+ * changed this gives up and returns false.
+ */
+static bool
+changed_slot_keys (KvpFrame* before, KvpFrame* after,
+                   std::vector<std::string>& keys)
+{
+    for (auto const& key : after->get_keys ())
+    {
+        auto old_value = before->get_slot ({key});
+        auto new_value = after->get_slot ({key});
+        if (old_value != nullptr && compare (old_value, new_value) == 0)
+            continue;
+        if (is_nested (new_value) ||
+            (old_value != nullptr && is_nested (old_value)))
+            return false;
+        keys.push_back (key);
+    }
+    for (auto const& key : before->get_keys ())
+    {
+        auto old_value = before->get_slot ({key});
+        if (after->get_slot ({key}) != nullptr)
+            continue;
+        if (is_nested (old_value))
+            return false;
+        keys.push_back (key);
+    }
+    return true;
+}
+
+static bool
+delete_slot_row (GncSqlBackend* sql_be, const GncGUID* guid,
+                 const std::string& name)
+{
+    gchar guid_buf[GUID_ENCODING_LENGTH + 1];
+
+    (void)guid_to_string_buff (guid, guid_buf);
+    std::string sql {"DELETE FROM " TABLE_NAME " WHERE obj_guid='"};
+    sql += guid_buf;
+    sql += "' AND name=" + sql_be->quote_string (name);
+    auto stmt = sql_be->create_statement_from_sql (sql);
+    if (stmt == nullptr)
+        return false;
+    return sql_be->execute_nonselect_statement (stmt) != -1;
+}
+
 gboolean
 gnc_sql_slots_save (GncSqlBackend* sql_be, const GncGUID* guid, gboolean is_infant,
                     QofInstance* inst)
@@ -658,14 +713,33 @@ gnc_sql_slots_save (GncSqlBackend* sql_be, const GncGUID* guid, gboolean is_infa
     g_return_val_if_fail (guid != NULL, FALSE);
     g_return_val_if_fail (pFrame != NULL, FALSE);
 
+    slot_info.be = sql_be;
+    slot_info.guid = guid;
+
+    /* If the slots the object started its edit with are known, only the
+     * rows of the ones that changed need to be replaced. */
+    std::vector<std::string> keys;
+    auto before = (!sql_be->pristine() && !is_infant) ?
+        sql_be->slots_at_begin (inst) : nullptr;
+    if (before != nullptr && changed_slot_keys (before, pFrame, keys))
+    {
+        for (auto const& key : keys)
+        {
+            if (!delete_slot_row (sql_be, guid, key))
+                return FALSE;
+            auto value = pFrame->get_slot ({key});
+            if (value != nullptr)
+                save_slot (key.c_str (), value, slot_info);
+        }
+        return slot_info.is_ok;
+    }
+
     // If this is not saving into a new db, clear out the old saved slots first
     if (!sql_be->pristine() && !is_infant)
     {
         (void)gnc_sql_slots_delete (sql_be, guid);
     }
 
-    slot_info.be = sql_be;
-    slot_info.guid = guid;
     pFrame->for_each_slot_temp (save_slot, slot_info);
 
     return slot_info.is_ok;
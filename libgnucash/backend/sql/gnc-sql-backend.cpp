@@ -32,6 +32,9 @@ extern "C"
 #include <gncTaxTable.h>
 #include <gncInvoice.h>
 #include <gnc-pricedb.h>
+#include <gnc-features.h>
+#include <AccountP.h>
+#include <Transaction.h>
 }
 
 #include <algorithm>
@@ -43,6 +46,7 @@ extern "C"
 #include "gnc-sql-column-table-entry.hpp"
 #include "gnc-sql-result.hpp"
 
+#include "gnc-account-balances-sql.h"
 #include "gnc-account-sql.h"
 #include "gnc-book-sql.h"
 #include "gnc-budget-sql.h"
@@ -69,6 +73,10 @@ static QofLogModule log_module = G_LOG_DOMAIN;
 #define MAX_TABLE_NAME_LEN 50
 #define TABLE_COL_NAME "table_name"
 #define VERSION_COL_NAME "table_version"
+/* Limits on a multi-row INSERT, kept well below SQLite's default maximum
+ * statement length and MySQL's max_allowed_packet. */
+#define INSERT_BATCH_ROWS 250
+#define INSERT_BATCH_SIZE (256 * 1024)
 
 using StrVec = std::vector<std::string>;
 
@@ -96,6 +104,9 @@ GncSqlBackend::~GncSqlBackend()
 void
 GncSqlBackend::connect(GncSqlConnection *conn) noexcept
 {
+    /* The cached statements belong to the old connection. */
+    m_prepared.clear();
+    m_commodity_in_db.clear();
     if (m_conn != nullptr && m_conn != conn)
         delete m_conn;
     finalize_version_info();
@@ -117,6 +128,9 @@ GncSqlBackend::create_statement_from_sql(const std::string& str) const noexcept
 GncSqlResultPtr
 GncSqlBackend::execute_select_statement(const GncSqlStatementPtr& stmt) const noexcept
 {
+    /* The query may need rows still waiting in an insert batch. */
+    if (!flush_insert_batches())
+        return nullptr;
     auto result = m_conn ? m_conn->execute_select_statement(stmt) : nullptr;
     if (result == nullptr)
     {
@@ -129,6 +143,8 @@ GncSqlBackend::execute_select_statement(const GncSqlStatementPtr& stmt) const no
 int
 GncSqlBackend::execute_nonselect_statement(const GncSqlStatementPtr& stmt) const noexcept
 {
+    if (!flush_insert_batches())
+        return -1;
     int result = m_conn ? m_conn->execute_nonselect_statement(stmt) : -1;
     if (result == -1)
     {
@@ -178,9 +194,27 @@ GncSqlBackend::create_index(const std::string& index_name,
                             const EntryVec& col_table) const noexcept
 {
     g_return_val_if_fail (m_conn != nullptr, false);
+    /* Filling a table is quicker without its indexes. */
+    if (m_bulk_write)
+    {
+        m_deferred_indexes.emplace_back(index_name, table_name, col_table);
+        return true;
+    }
     return m_conn->create_index(index_name, table_name, col_table);
 }
 
+void
+GncSqlBackend::create_deferred_indexes() noexcept
+{
+    for (auto const& index : m_deferred_indexes)
+    {
+        if (!m_conn->create_index(std::get<0>(index), std::get<1>(index),
+                                  std::get<2>(index)))
+            PERR ("Unable to create index %s\n", std::get<0>(index).c_str());
+    }
+    m_deferred_indexes.clear();
+}
+
 bool
 GncSqlBackend::add_columns_to_table(const std::string& table_name,
                                     const EntryVec& col_table) const noexcept
@@ -290,6 +324,7 @@ GncSqlBackend::load (QofBook* book, QofBackendLoadType loadType)
     {
         assert (m_book == nullptr);
         m_book = book;
+        m_load_on_demand = gnc_prefs_get_sql_load_on_demand ();
 
         auto num_types = m_backend_registry.size();
         auto num_done = 0;
@@ -322,6 +357,7 @@ GncSqlBackend::load (QofBook* book, QofBackendLoadType loadType)
 
         m_backend_registry.load_remaining(this);
 
+        gnc_account_tree_sort_and_recompute (root);
         gnc_account_foreach_descendant(root, (AccountCb)xaccAccountCommitEdit,
                                        nullptr);
     }
@@ -330,9 +366,12 @@ GncSqlBackend::load (QofBook* book, QofBackendLoadType loadType)
         // Load all transactions
         auto obe = m_backend_registry.get_object_backend (GNC_ID_TRANS);
         obe->load_all (this);
+        m_load_on_demand = false;
     }
 
     m_loading = FALSE;
+    if (!m_conn->readonly())
+        set_features_used (book);
     std::for_each(m_postload_commodities.begin(), m_postload_commodities.end(),
                  [](gnc_commodity* comm) {
                       gnc_commodity_begin_edit(comm);
@@ -466,12 +505,16 @@ GncSqlBackend::sync(QofBook* book)
     g_return_if_fail (book != NULL);
     g_return_if_fail (m_conn != nullptr);
 
+    if (book == m_book)
+        ensure_all_loaded();
     reset_version_info();
     ENTER ("book=%p, sql_be->book=%p", book, m_book);
     update_progress(101.0);
 
     /* Create new tables */
     m_is_pristine_db = true;
+    m_bulk_write = true;
+    m_commodity_in_db.clear();
     create_tables();
 
     /* Save all contents */
@@ -482,6 +525,10 @@ GncSqlBackend::sync(QofBook* book)
     // write_commodities(sql_be, book);
     if (is_ok)
     {
+        /* The book's commit writes them. */
+        m_loading = true;
+        set_features_used (book);
+        m_loading = false;
         auto obe = m_backend_registry.get_object_backend(GNC_ID_BOOK);
         is_ok = obe->commit (this, QOF_INSTANCE (book));
     }
@@ -507,9 +554,22 @@ GncSqlBackend::sync(QofBook* book)
             std::get<1>(entry)->write (this);
     }
     if (is_ok)
+    {
+        is_ok = flush_insert_batches();
+    }
+    if (is_ok)
     {
         is_ok = m_conn->commit_transaction();
     }
+    m_bulk_write = false;
+    m_insert_batches.clear();
+    if (is_ok)
+    {
+        /* After the commit, as MySQL would commit implicitly. The data is
+         * saved even if this fails, it's just slower to query. */
+        create_deferred_indexes();
+    }
+    m_deferred_indexes.clear();
     if (is_ok)
     {
         m_is_pristine_db = false;
@@ -523,6 +583,7 @@ GncSqlBackend::sync(QofBook* book)
     {
         set_error (ERR_BACKEND_SERVER_ERR);
         m_conn->rollback_transaction ();
+        m_commodity_in_db.clear();
     }
     finish_progress();
     LEAVE ("book=%p", book);
@@ -531,22 +592,128 @@ GncSqlBackend::sync(QofBook* book)
 /* ================================================================= */
 /* Routines to deal with the creation of multiple books. */
 
+/* Keep a copy of the slots, so that the commit only has to write the ones
+ * that change. A transaction's splits are committed along with it without
+ * a begin of their own.
+ */
 void
 GncSqlBackend::begin(QofInstance* inst)
 {
-    //g_return_if_fail (inst != NULL);
+    g_return_if_fail (inst != NULL);
 
-    //ENTER (" ");
-    //LEAVE ("");
+    if (m_loading)
+        return;
+    save_slots_at_begin (inst);
+    if (GNC_IS_TRANS (inst))
+    {
+        for (auto node = xaccTransGetSplitList (GNC_TRANS (inst)); node;
+             node = g_list_next (node))
+            save_slots_at_begin (QOF_INSTANCE (node->data));
+    }
 }
 
 void
 GncSqlBackend::rollback(QofInstance* inst)
 {
-    //g_return_if_fail (inst != NULL);
+    g_return_if_fail (inst != NULL);
+
+    m_begin_slots.erase (inst);
+    if (GNC_IS_TRANS (inst))
+    {
+        for (auto node = xaccTransGetSplitList (GNC_TRANS (inst)); node;
+             node = g_list_next (node))
+            m_begin_slots.erase (QOF_INSTANCE (node->data));
+    }
+}
+
+void
+GncSqlBackend::save_slots_at_begin (QofInstance* inst) noexcept
+{
+    m_begin_slots.erase (inst);
+    /* The database doesn't have the changes of a dirty instance yet. */
+    if (qof_instance_get_dirty_flag (inst) || qof_instance_get_infant (inst))
+        return;
+    auto frame = qof_instance_get_slots (inst);
+    if (frame != nullptr)
+        m_begin_slots[inst].reset (new KvpFrame {*frame});
+}
+
+void
+GncSqlBackend::feature_used (const char* feature) noexcept
+{
+    m_features_used.push_back (feature);
+}
+
+void
+GncSqlBackend::set_features_used (QofBook* book)
+{
+    for (auto feature : m_features_used)
+        gnc_features_set_used (book, feature);
+    m_features_used.clear();
+}
+
+KvpFrame*
+GncSqlBackend::slots_at_begin (const QofInstance* inst) const noexcept
+{
+    auto iter = m_begin_slots.find (inst);
+    return iter == m_begin_slots.end() ? nullptr : iter->second.get();
+}
+
+void
+GncSqlBackend::ensure_all_loaded()
+{
+    if (m_load_on_demand && m_book != nullptr)
+        load (m_book, LOAD_TYPE_LOAD_ALL);
+}
+
+/* The objects are loaded like in the initial load, so their commits only
+ * mark them clean, and without events, which could set off more queries.
+ */
+template <typename Load> void
+GncSqlBackend::load_quietly(Load load)
+{
+    m_in_query = true;
+    m_loading = true;
+    qof_event_suspend ();
+    load ();
+    qof_event_resume ();
+    m_loading = false;
+    m_in_query = false;
+}
+
+void
+GncSqlBackend::run_query(QofQuery* query)
+{
+    g_return_if_fail (query != NULL);
+
+    if (!m_load_on_demand || m_loading || m_in_query || m_conn == nullptr)
+        return;
+    auto obe = m_backend_registry.get_object_backend (qof_query_get_search_for (query));
+    if (obe == nullptr)
+        return;
+
+    ENTER ("query=%p", query);
+    load_quietly ([this, obe, query]() { obe->load_for_query (this, query); });
+    LEAVE ("");
+}
+
+/* Loaded transactions stay in memory: lots, invoices and open registers
+ * hold on to them, so nothing is ever unloaded again. */
+void
+GncSqlBackend::ensure_loaded(QofInstance* inst, time64 since)
+{
+    g_return_if_fail (inst != NULL);
+
+    if (!m_load_on_demand || m_loading || m_in_query || m_conn == nullptr ||
+        !GNC_IS_ACCOUNT (inst))
+        return;
+    auto obe = m_backend_registry.get_object_backend (GNC_ID_TRANS);
+    if (obe == nullptr)
+        return;
 
-    //ENTER (" ");
-    //LEAVE ("");
+    load_quietly ([this, obe, inst, since]() {
+            obe->load_for_instance (this, inst, since);
+        });
 }
 
 void
@@ -576,6 +743,20 @@ GncSqlBackend::commit (QofInstance* inst)
     g_return_if_fail (inst != NULL);
     g_return_if_fail (m_conn != nullptr);
 
+    /* The transaction is committed before its splits, and the clean ones
+     * aren't committed at all, so their copies from begin() go now. */
+    if (GNC_IS_TRANS (inst))
+    {
+        for (auto node = xaccTransGetSplitList (GNC_TRANS (inst)); node;
+             node = g_list_next (node))
+        {
+            auto split = QOF_INSTANCE (node->data);
+            if (!qof_instance_get_dirty_flag (split) &&
+                !qof_instance_get_destroying (split))
+                m_begin_slots.erase (split);
+        }
+    }
+
     if (qof_book_is_readonly(m_book))
     {
         set_error (ERR_BACKEND_READONLY);
@@ -610,6 +791,7 @@ GncSqlBackend::commit (QofInstance* inst)
 
     if (!is_dirty && !is_destroying)
     {
+        m_begin_slots.erase (inst);
         LEAVE ("!dirty OR !destroying");
         return;
     }
@@ -625,7 +807,11 @@ GncSqlBackend::commit (QofInstance* inst)
 
     auto obe = m_backend_registry.get_object_backend(std::string{inst->e_type});
     if (obe != nullptr)
+    {
         is_ok = obe->commit(this, inst);
+        /* The copy only matched the database until now. */
+        m_begin_slots.erase (inst);
+    }
     else
     {
         PERR ("Unknown object type '%s'\n", inst->e_type);
@@ -848,26 +1034,34 @@ GncSqlBackend::do_db_operation (E_DB_OPERATION op, const char* table_name,
                                 QofIdTypeConst obj_name, gpointer pObject,
                                 const EntryVec& table) const noexcept
 {
-    GncSqlStatementPtr stmt;
-
     g_return_val_if_fail (table_name != nullptr, false);
     g_return_val_if_fail (obj_name != nullptr, false);
     g_return_val_if_fail (pObject != nullptr, false);
 
-    switch(op)
-    {
-        case  OP_DB_INSERT:
-        stmt = build_insert_statement (table_name, obj_name, pObject, table);
-        break;
-        case OP_DB_UPDATE:
-        stmt = build_update_statement (table_name, obj_name, pObject, table);
-        break;
-        case OP_DB_DELETE:
-        stmt = build_delete_statement (table_name, obj_name, pObject, table);
-        break;
-    }
+    /* A delete only needs the first column, which should be the PK. */
+    PairVec values;
+    if (op == OP_DB_DELETE)
+        table[0]->add_to_query (obj_name, pObject, values);
+    else
+        values = get_object_values (obj_name, pObject, table);
+    if (values.empty())
+        return false;
+
+    if (m_bulk_write && op == OP_DB_INSERT)
+        return add_to_insert_batch (table_name, values);
+
+    auto& stmt = prepared_statement (op, table_name, values);
     if (stmt == nullptr)
         return false;
+
+    size_t param = 0;
+    if (op != OP_DB_DELETE)
+        for (auto const& col_value : values)
+            stmt->bind (param++, col_value.second);
+    /* The WHERE condition of an update or delete is the object's guid. */
+    if (op != OP_DB_INSERT)
+        stmt->bind (param, values[0].second);
+
     return (execute_nonselect_statement(stmt) != -1);
 }
 
@@ -875,106 +1069,211 @@ bool
 GncSqlBackend::save_commodity(gnc_commodity* comm) noexcept
 {
     if (comm == nullptr) return false;
+    if (commodity_in_db(comm))
+        return true;
     QofInstance* inst = QOF_INSTANCE(comm);
     auto obe = m_backend_registry.get_object_backend(std::string(inst->e_type));
-    if (obe && !obe->instance_in_db(this, inst))
-        return obe->commit(this, inst);
-    return true;
+    auto is_ok = true;
+    if (obe)
+        is_ok = obe->commit(this, inst);
+    return is_ok;
 }
 
-GncSqlStatementPtr
-GncSqlBackend::build_insert_statement (const char* table_name,
-                                       QofIdTypeConst obj_name,
-                                       gpointer pObject,
-                                       const EntryVec& table) const noexcept
+/* Every transaction refers to its currency, so the answer is remembered
+ * rather than asking the database on each commit.
+ */
+bool
+GncSqlBackend::commodity_in_db(gnc_commodity* comm) noexcept
 {
-    GncSqlStatementPtr stmt;
-    PairVec col_values;
-    std::ostringstream sql;
+    auto iter = m_commodity_in_db.find(comm);
+    if (iter != m_commodity_in_db.end())
+        return iter->second;
+    /* A new database only has what this session wrote, and looking would
+     * flush the insert batches. */
+    auto in_db = false;
+    if (!m_is_pristine_db)
+    {
+        auto obe = m_backend_registry.get_object_backend(GNC_ID_COMMODITY);
+        in_db = obe && obe->instance_in_db(this, QOF_INSTANCE(comm));
+    }
+    m_commodity_in_db[comm] = in_db;
+    return in_db;
+}
 
-    g_return_val_if_fail (table_name != nullptr, nullptr);
-    g_return_val_if_fail (obj_name != nullptr, nullptr);
-    g_return_val_if_fail (pObject != nullptr, nullptr);
-    PairVec values{get_object_values(obj_name, pObject, table)};
+void
+GncSqlBackend::set_commodity_in_db(gnc_commodity* comm, bool in_db) noexcept
+{
+    m_commodity_in_db[comm] = in_db;
+}
 
-    sql << "INSERT INTO " << table_name <<"(";
+/* Objects of a type don't always set the same columns, since a NULL value is
+ * usually left out, so the statements are cached by table, operation and
+ * column names. Their values are bound each time one is run.
+ */
+const GncSqlStatementPtr&
+GncSqlBackend::prepared_statement (E_DB_OPERATION op, const char* table_name,
+                                   const PairVec& values) const noexcept
+{
+    std::string key{table_name};
+    key += ':';
+    key += std::to_string (op);
     for (auto const& col_value : values)
     {
-        if (col_value != *values.begin())
-            sql << ",";
-        sql << col_value.first;
+        key += ':';
+        key += col_value.first;
     }
 
-    sql << ") VALUES(";
-    for (auto col_value : values)
+    auto& stmt = m_prepared[key];
+    if (stmt == nullptr)
     {
-        if (col_value != *values.begin())
-            sql << ",";
-        sql << col_value.second;
+        switch(op)
+        {
+        case OP_DB_INSERT:
+            stmt = create_statement_from_sql (build_insert_statement (table_name,
+                                                                      values));
+            break;
+        case OP_DB_UPDATE:
+            stmt = create_statement_from_sql (build_update_statement (table_name,
+                                                                      values));
+            break;
+        case OP_DB_DELETE:
+            stmt = create_statement_from_sql (build_delete_statement (table_name,
+                                                                      values));
+            break;
+        }
     }
-    sql << ")";
-
-    stmt = create_statement_from_sql(sql.str());
     return stmt;
 }
 
-GncSqlStatementPtr
-GncSqlBackend::build_update_statement(const gchar* table_name,
-                                      QofIdTypeConst obj_name, gpointer pObject,
-                                      const EntryVec& table) const noexcept
+std::string
+GncSqlBackend::build_insert_statement (const char* table_name,
+                                       const PairVec& values) const noexcept
 {
-    GncSqlStatementPtr stmt;
-    std::ostringstream sql;
-
-    g_return_val_if_fail (table_name != nullptr, nullptr);
-    g_return_val_if_fail (obj_name != nullptr, nullptr);
-    g_return_val_if_fail (pObject != nullptr, nullptr);
+    std::string sql{"INSERT INTO "};
+    sql += table_name;
+    sql += "(";
+    for (auto const& col_value : values)
+    {
+        if (&col_value != &values.front())
+            sql += ",";
+        sql += col_value.first;
+    }
 
+    sql += ") VALUES(";
+    for (auto const& col_value : values)
+        sql += &col_value != &values.front() ? ",?" : "?";
+    sql += ")";
 
-    PairVec values{get_object_values (obj_name, pObject, table)};
+    return sql;
+}
 
-    // Create the SQL statement
-    sql <<  "UPDATE " << table_name << " SET ";
+std::string
+GncSqlBackend::build_update_statement (const char* table_name,
+                                       const PairVec& values) const noexcept
+{
+    std::string sql{"UPDATE "};
+    sql += table_name;
+    sql += " SET ";
 
     for (auto const& col_value : values)
     {
-        if (col_value != *values.begin())
-            sql << ",";
-        sql << col_value.first << "=" <<
-            col_value.second;
+        if (&col_value != &values.front())
+            sql += ",";
+        sql += col_value.first + "=?";
     }
 
-    stmt = create_statement_from_sql(sql.str());
-    /* We want our where condition to be just the first column and
-     * value, i.e. the guid of the object.
+    /* We want our where condition to be just the first column,
+     * i.e. the guid of the object.
      */
-    values.erase(values.begin() + 1, values.end());
-    stmt->add_where_cond(obj_name, values);
-    return stmt;
+    sql += " WHERE " + values.front().first + " = ?";
+    return sql;
 }
 
-GncSqlStatementPtr
-GncSqlBackend::build_delete_statement(const gchar* table_name,
-                                      QofIdTypeConst obj_name,
-                                      gpointer pObject,
-                                      const EntryVec& table) const noexcept
+std::string
+GncSqlBackend::build_delete_statement (const char* table_name,
+                                       const PairVec& values) const noexcept
 {
-    std::ostringstream sql;
+    std::string sql{"DELETE FROM "};
+    sql += table_name;
+    sql += " WHERE " + values.front().first + " = ?";
+    return sql;
+}
 
-    g_return_val_if_fail (table_name != nullptr, nullptr);
-    g_return_val_if_fail (obj_name != nullptr, nullptr);
-    g_return_val_if_fail (pObject != nullptr, nullptr);
+/* Add a row to the multi-row INSERT for its table and columns, running the
+ * statement once it's full. */
+bool
+GncSqlBackend::add_to_insert_batch (const char* table_name,
+                                    const PairVec& values) const noexcept
+{
+    std::string key{table_name};
+    for (auto const& col_value : values)
+    {
+        key += ':';
+        key += col_value.first;
+    }
 
-    sql << "DELETE FROM " << table_name;
-    auto stmt = create_statement_from_sql (sql.str());
+    auto& batch = m_insert_batches[key];
+    if (batch.rows == 0)
+    {
+        batch.sql = "INSERT INTO ";
+        batch.sql += table_name;
+        batch.sql += "(";
+        for (auto const& col_value : values)
+        {
+            if (&col_value != &values.front())
+                batch.sql += ",";
+            batch.sql += col_value.first;
+        }
+        batch.sql += ") VALUES";
+    }
+    else
+        batch.sql += ",";
 
-    /* WHERE */
-    PairVec values;
-    table[0]->add_to_query (obj_name, pObject, values);
-    PairVec col_values{values[0]};
-    stmt->add_where_cond (obj_name, col_values);
+    batch.sql += "(";
+    for (auto const& col_value : values)
+    {
+        if (&col_value != &values.front())
+            batch.sql += ",";
+        if (col_value.second.is_text)
+            batch.sql += m_conn->quote_string(col_value.second.value);
+        else
+            batch.sql += col_value.second.value;
+    }
+    batch.sql += ")";
 
-    return stmt;
+    if (++batch.rows < INSERT_BATCH_ROWS && batch.sql.size() < INSERT_BATCH_SIZE)
+        return true;
+
+    auto stmt = create_statement_from_sql(batch.sql);
+    batch.rows = 0;
+    batch.sql.clear();
+    if (stmt == nullptr || m_conn->execute_nonselect_statement(stmt) == -1)
+    {
+        qof_backend_set_error ((QofBackend*)this, ERR_BACKEND_SERVER_ERR);
+        return false;
+    }
+    return true;
+}
+
+bool
+GncSqlBackend::flush_insert_batches () const noexcept
+{
+    bool is_ok = true;
+    for (auto& entry : m_insert_batches)
+    {
+        auto& batch = entry.second;
+        if (batch.rows == 0)
+            continue;
+        auto stmt = create_statement_from_sql(batch.sql);
+        batch.rows = 0;
+        batch.sql.clear();
+        if (stmt == nullptr || m_conn->execute_nonselect_statement(stmt) == -1)
+        {
+            qof_backend_set_error ((QofBackend*)this, ERR_BACKEND_SERVER_ERR);
+            is_ok = false;
+        }
+    }
+    return is_ok;
 }
 
 GncSqlBackend::ObjectBackendRegistry::ObjectBackendRegistry()
@@ -987,6 +1286,7 @@ GncSqlBackend::ObjectBackendRegistry::ObjectBackendRegistry()
     register_backend(std::make_shared<GncSqlTransBackend>());
     register_backend(std::make_shared<GncSqlSplitBackend>());
     register_backend(std::make_shared<GncSqlSlotsBackend>());
+    register_backend(std::make_shared<GncSqlAccountBalancesBackend>());
     register_backend(std::make_shared<GncSqlRecurrenceBackend>());
     register_backend(std::make_shared<GncSqlSchedXactionBackend>());
     register_backend(std::make_shared<GncSqlLotsBackend>());
@@ -32,8 +32,12 @@ extern "C"
 #include <memory>
 #include <exception>
 #include <sstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
 #include <vector>
 #include <qof-backend.hpp>
+#include <kvp-frame.hpp>
 
 class GncSqlColumnTableEntry;
 using GncSqlColumnTableEntryPtr = std::shared_ptr<GncSqlColumnTableEntry>;
@@ -45,6 +49,8 @@ using OBEVec = std::vector<OBEEntry>;
 class GncSqlConnection;
 class GncSqlStatement;
 using GncSqlStatementPtr = std::unique_ptr<GncSqlStatement>;
+struct GncSqlValue;
+using PairVec = std::vector<std::pair<std::string, GncSqlValue>>;
 class GncSqlResult;
 using GncSqlResultPtr = GncSqlResult*;
 using VersionPair = std::pair<const std::string, unsigned int>;
@@ -97,6 +103,21 @@ public:
      * @param inst Object being edited
      */
     void rollback(QofInstance*) override;
+    /**
+     * When transactions are loaded on demand, load those the query might
+     * match.
+     *
+     * @param query The query about to be run.
+     */
+    void run_query(QofQuery* query) override;
+    /**
+     * When transactions are loaded on demand, load an account's
+     * transactions posted on or after since.
+     *
+     * @param inst The account whose splits the engine is about to read.
+     * @param since The earliest post date, INT64_MIN for all.
+     */
+    void ensure_loaded(QofInstance* inst, time64 since) override;
     /** Connect the backend to a GncSqlConnection.
      * Sets up version info. Calling with nullptr clears the connection and
      * destroys the version info.
@@ -234,38 +255,77 @@ public:
      * @return true if the commodity needed to be saved.
      */
     bool save_commodity(gnc_commodity* comm) noexcept;
+    /**
+     * Checks whether a commodity has a row in the database. The answer is
+     * kept for the session, so each commodity is looked for at most once.
+     *
+     * @param comm The commodity in question
+     * @return true if the commodity is in the database.
+     */
+    bool commodity_in_db(gnc_commodity* comm) noexcept;
+    /**
+     * Records that a commodity was loaded, saved or deleted.
+     */
+    void set_commodity_in_db(gnc_commodity* comm, bool in_db) noexcept;
+    /**
+     * The slots an instance had when its edit began, if it was clean then
+     * and so matched the database.
+     *
+     * @param inst The instance being committed
+     * @return The copy of the slots, or nullptr if there isn't one.
+     */
+    KvpFrame* slots_at_begin(const QofInstance* inst) const noexcept;
+    /**
+     * Records that the database has started using a feature. It is set on
+     * the book when the book is next loaded or written, unless the session
+     * is read-only.
+     *
+     * @param feature One of the GNC_FEATURE names
+     */
+    void feature_used(const char* feature) noexcept;
     QofBook* book() const noexcept { return m_book; }
     void set_loading(bool loading) noexcept { m_loading = loading; }
     bool pristine() const noexcept { return m_is_pristine_db; }
+    bool load_on_demand() const noexcept { return m_load_on_demand; }
     void update_progress(double pct) const noexcept;
     void finish_progress() const noexcept;
 
 protected:
+    /** Load whatever load_on_demand left in the database, before the whole
+     * book is written from memory.
+     */
+    void ensure_all_loaded();
     GncSqlConnection* m_conn = nullptr;  /**< SQL connection */
     QofBook* m_book = nullptr;           /**< The primary, main open book */
     bool m_loading;        /**< We are performing an initial load */
     bool m_in_query;       /**< We are processing a query */
     bool m_is_pristine_db; /**< Are we saving to a new pristine db? */
+    bool m_load_on_demand = false; /**< Are transactions loaded when needed? */
     const char* m_time_format = nullptr; /**< Server-specific date-time string format */
     VersionVec m_versions;    /**< Version number for each table */
+    std::vector<const char*> m_features_used; /**< Features to set on the book */
 private:
+    template <typename Load> void load_quietly(Load load);
+    void set_features_used(QofBook* book);
     bool write_account_tree(Account*);
     bool write_accounts();
     bool write_transactions();
     bool write_template_transactions();
     bool write_schedXactions();
-    GncSqlStatementPtr build_insert_statement (const char* table_name,
-                                               QofIdTypeConst obj_name,
-                                               gpointer pObject,
-                                               const EntryVec& table) const noexcept;
-    GncSqlStatementPtr build_update_statement (const gchar* table_name,
-                                               QofIdTypeConst obj_name,
-                                               gpointer pObject,
-                                               const EntryVec& table) const noexcept;
-    GncSqlStatementPtr build_delete_statement (const char* table_name,
-                                               QofIdTypeConst obj_name,
-                                               gpointer pObject,
-                                               const EntryVec& table) const noexcept;
+    const GncSqlStatementPtr& prepared_statement (E_DB_OPERATION op,
+                                                  const char* table_name,
+                                                  const PairVec& values) const noexcept;
+    std::string build_insert_statement (const char* table_name,
+                                        const PairVec& values) const noexcept;
+    std::string build_update_statement (const char* table_name,
+                                        const PairVec& values) const noexcept;
+    std::string build_delete_statement (const char* table_name,
+                                        const PairVec& values) const noexcept;
+    bool add_to_insert_batch (const char* table_name,
+                              const PairVec& values) const noexcept;
+    bool flush_insert_batches () const noexcept;
+    void create_deferred_indexes () noexcept;
+    void save_slots_at_begin (QofInstance* inst) noexcept;
 
     class ObjectBackendRegistry
     {
@@ -288,6 +348,24 @@ private:
     };
     ObjectBackendRegistry m_backend_registry;
     std::vector<gnc_commodity*> m_postload_commodities;
+    /** INSERT, UPDATE and DELETE statements with ? parameters, by table,
+     * operation and columns. */
+    mutable std::unordered_map<std::string, GncSqlStatementPtr> m_prepared;
+    /** While sync writes a whole book, inserts are collected into multi-row
+     * statements by table and columns, and indexes are created at the end. */
+    bool m_bulk_write = false;
+    struct InsertBatch
+    {
+        std::string sql;
+        unsigned int rows = 0;
+    };
+    mutable std::unordered_map<std::string, InsertBatch> m_insert_batches;
+    using IndexDef = std::tuple<std::string, std::string, EntryVec>;
+    mutable std::vector<IndexDef> m_deferred_indexes;
+    /** Whether each commodity looked for so far is in the database. */
+    std::unordered_map<gnc_commodity*, bool> m_commodity_in_db;
+    /** Copies of the slots of the instances being edited. */
+    std::unordered_map<const QofInstance*, std::unique_ptr<KvpFrame>> m_begin_slots;
 };
 
 #endif //__GNC_SQL_BACKEND_HPP__
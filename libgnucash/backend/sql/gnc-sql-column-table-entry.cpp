@@ -104,7 +104,7 @@ GncSqlColumnTableEntry::add_objectref_guid_to_query (QofIdTypeConst obj_name,
     auto guid = qof_instance_get_guid (inst);
     if (guid != nullptr)
         vec.emplace_back (std::make_pair (std::string{m_col_name},
-                                          quote_string(guid_to_string(guid))));
+                                          text_value(guid_to_string(guid))));
 }
 
 void
@@ -152,10 +152,8 @@ GncSqlColumnTableEntryImpl<CT_STRING>::add_to_query(QofIdTypeConst obj_name,
 
     if (s != nullptr)
     {
-        std::ostringstream stream;
-        stream << s;
         vec.emplace_back (std::make_pair (std::string{m_col_name},
-                                          quote_string(stream.str())));
+                                          text_value(s)));
         return;
     }
 }
@@ -362,7 +360,7 @@ GncSqlColumnTableEntryImpl<CT_GUID>::add_to_query(QofIdTypeConst obj_name,
     {
 
         vec.emplace_back (std::make_pair (std::string{m_col_name},
-                                          quote_string(guid_to_string(s))));
+                                          text_value(guid_to_string(s))));
         return;
     }
 }
@@ -448,14 +446,13 @@ GncSqlColumnTableEntryImpl<CT_TIME>::add_to_query(QofIdTypeConst obj_name,
     if (t64 > MINTIME && t64 < MAXTIME)
     {
         GncDateTime time(t64);
-        std::string timestr("'");
-        timestr += time.format_iso8601() + "'";
-        vec.emplace_back (std::make_pair (std::string{m_col_name}, timestr));
+        vec.emplace_back (std::make_pair (std::string{m_col_name},
+                                          text_value(time.format_iso8601())));
     }
     else
     {
         vec.emplace_back (std::make_pair (std::string{m_col_name},
-                                          "NULL"));
+                                          literal_value("NULL")));
     }
 }
 
@@ -529,7 +526,7 @@ GncSqlColumnTableEntryImpl<CT_GDATE>::add_to_query(QofIdTypeConst obj_name,
             std::setw (2) << g_date_get_month (date) <<
             std::setw (2) << static_cast<int>(g_date_get_day (date));
         vec.emplace_back (std::make_pair (std::string{m_col_name},
-                                          quote_string(buf.str())));
+                                          text_value(buf.str())));
         return;
     }
 }
@@ -636,10 +633,10 @@ GncSqlColumnTableEntryImpl<CT_NUMERIC>::add_to_query(QofIdTypeConst obj_name,
     num_col += "_num";
     denom_col += "_denom";
     buf << gnc_numeric_num (n);
-    vec.emplace_back (std::make_pair (num_col, buf.str ()));
+    vec.emplace_back (std::make_pair (num_col, literal_value(buf.str ())));
     buf.str ("");
     buf << gnc_numeric_denom (n);
-    vec.emplace_back (denom_col, buf.str ());
+    vec.emplace_back (denom_col, literal_value(buf.str ()));
 }
 
 static void
@@ -34,10 +34,10 @@ extern "C"
 #include <iomanip>
 
 #include "gnc-sql-result.hpp"
+#include "gnc-sql-connection.hpp"
 
 struct GncSqlColumnInfo;
 using ColVec = std::vector<GncSqlColumnInfo>;
-using PairVec = std::vector<std::pair<std::string, std::string>>;
 using InstanceVec = std::vector<QofInstance*>;
 using uint_t = unsigned int;
 class GncSqlBackend;
@@ -89,25 +89,16 @@ enum GncSqlObjectType
     CT_TAXTABLEREF
 };
 
-static inline std::string
-quote_string(const std::string& str)
+static inline GncSqlValue
+text_value(const std::string& str)
 {
-    if (str == "NULL" || str == "null") return "NULL";
-    /* FIXME: This is here because transactions.num has a NULL
-     * constraint, which is dumb; it's often empty.
-     */
-    if (str.empty()) return "''";
-    std::string retval;
-    retval.reserve(str.length() + 2);
-    retval.insert(0, 1, '\'');
-    for (auto c = str.begin(); c != str.end(); ++c)
-    {
-        if (*c == '\'')
-            retval += *c;
-        retval += *c;
-    }
-    retval += '\'';
-    return retval;
+    return GncSqlValue{str, true};
+}
+
+static inline GncSqlValue
+literal_value(const std::string& str)
+{
+    return GncSqlValue{str, false};
 }
 
 /**
@@ -382,7 +373,8 @@ GncSqlColumnTableEntry::add_value_to_vec(QofIdTypeConst obj_name,
     {
         std::ostringstream stream;
         stream << *s;
-        vec.emplace_back(std::make_pair(std::string{m_col_name}, stream.str()));
+        vec.emplace_back(std::make_pair(std::string{m_col_name},
+                                    literal_value(stream.str())));
         return;
     }
 }
@@ -398,7 +390,8 @@ GncSqlColumnTableEntry::add_value_to_vec<double*>(QofIdTypeConst obj_name,
     {
         std::ostringstream stream;
         stream << std::setprecision(12) << std::fixed << *s;
-        vec.emplace_back(std::make_pair(std::string{m_col_name}, stream.str()));
+        vec.emplace_back(std::make_pair(std::string{m_col_name},
+                                    literal_value(stream.str())));
         return;
     }
 }
@@ -412,7 +405,8 @@ GncSqlColumnTableEntry::add_value_to_vec(QofIdTypeConst obj_name,
 
     std::ostringstream stream;
     stream << s;
-    vec.emplace_back(std::make_pair(std::string{m_col_name}, stream.str()));
+    vec.emplace_back(std::make_pair(std::string{m_col_name},
+                                    literal_value(stream.str())));
     return;
 }
 
@@ -425,7 +419,8 @@ GncSqlColumnTableEntry::add_value_to_vec<double>(QofIdTypeConst obj_name,
 
     std::ostringstream stream;
     stream << std::setprecision(12) << std::fixed << s;
-    vec.emplace_back(std::make_pair(std::string{m_col_name}, stream.str()));
+    vec.emplace_back(std::make_pair(std::string{m_col_name},
+                                    literal_value(stream.str())));
     return;
 }
 
@@ -37,10 +37,23 @@ using GncSqlResultPtr = GncSqlResult*;
 class GncSqlColumnTableEntry;
 using GncSqlColumnTableEntryPtr = std::shared_ptr<GncSqlColumnTableEntry>;
 using EntryVec = std::vector<GncSqlColumnTableEntryPtr>;
-using PairVec = std::vector<std::pair<std::string, std::string>>;
 struct GncSqlColumnInfo;
 using ColVec = std::vector<GncSqlColumnInfo>;
 
+/**
+ * A column value for a statement. Text is kept as it is and quoted for the
+ * database by the connection when the statement is run; anything else is
+ * written as it is, so it must be an SQL literal: a number or NULL.
+ */
+struct GncSqlValue
+{
+    std::string value;
+    bool is_text;
+    bool is_null() const noexcept { return !is_text && value == "NULL"; }
+};
+
+using PairVec = std::vector<std::pair<std::string, GncSqlValue>>;
+
 /**
  * SQL statement provider.
  */
@@ -50,6 +63,11 @@ public:
     virtual ~GncSqlStatement() {}
     virtual const char* to_sql() const = 0;
     virtual void add_where_cond (QofIdTypeConst, const PairVec&) = 0;
+    /**
+     * Set the value of a ? parameter of the statement; the first one is 0.
+     * A statement can be run again with new values after binding them.
+     */
+    virtual void bind (size_t, const GncSqlValue&) = 0;
 };
 
 using GncSqlStatementPtr = std::unique_ptr<GncSqlStatement>;
@@ -97,6 +115,8 @@ public:
                            bool retry) noexcept = 0;
     virtual bool verify() noexcept = 0;
     virtual bool retry_connection(const char* msg) noexcept = 0;
+    /** Whether the session was opened read-only. */
+    virtual bool readonly() const noexcept { return false; }
 
 };
 
@@ -60,6 +60,23 @@ public:
      * @param sql_be The GncSqlBackend containing the database connection.
      */
     virtual void load_all (GncSqlBackend* sql_be) = 0;
+    /**
+     * Load the objects a query might match that aren't in memory yet. Only
+     * object backends whose load_all can leave objects in the database need
+     * to do anything.
+     * @param sql_be The GncSqlBackend containing the database connection.
+     * @param query The query about to be run.
+     */
+    virtual void load_for_query (GncSqlBackend* sql_be, QofQuery* query) {}
+    /**
+     * Load the objects holding an instance's splits posted on or after
+     * since that aren't in memory yet.
+     * @param sql_be The GncSqlBackend containing the database connection.
+     * @param inst The instance whose splits the engine is about to read.
+     * @param since The earliest post date, INT64_MIN for all.
+     */
+    virtual void load_for_instance (GncSqlBackend* sql_be, QofInstance* inst,
+                                    time64 since) {}
     /**
      * Conditionally create or update a database table from m_col_table. The
      * condition is the version returned by querying the database's version
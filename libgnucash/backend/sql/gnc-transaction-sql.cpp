@@ -38,6 +38,7 @@ extern "C"
 
 #include "Account.h"
 #include "Transaction.h"
+#include "TransactionP.h"
 #include <Scrub.h>
 #include "gnc-lot.h"
 #include "engine-helpers.h"
@@ -51,6 +52,9 @@ extern "C"
 
 #include <string>
 #include <sstream>
+#include <algorithm>
+#include <map>
+#include <unordered_set>
 
 #include "escape.h"
 
@@ -62,6 +66,7 @@ extern "C"
 #include "gnc-transaction-sql.h"
 #include "gnc-commodity-sql.h"
 #include "gnc-slots-sql.h"
+#include "gnc-account-balances-sql.h"
 
 #define SIMPLE_QUERY_COMPILATION 1
 
@@ -71,6 +76,8 @@ static QofLogModule log_module = G_LOG_DOMAIN;
 #define TX_TABLE_VERSION 4
 #define SPLIT_TABLE "splits"
 #define SPLIT_TABLE_VERSION 5
+/* How many transaction guids go in one IN list. */
+#define TX_GUID_LIST_LEN 500
 
 struct split_info_t : public write_objects_t
 {
@@ -365,8 +372,29 @@ query_transactions (GncSqlBackend* sql_be, std::string selector)
         }
     }
 
+    /* Some of them were in memory already and may have been changed since,
+     * so their splits and slots aren't read again. */
+    if (!instances.empty() && instances.size() != result->size())
+    {
+        for (auto first = instances.begin(); first != instances.end();)
+        {
+            auto last = first + std::min<std::ptrdiff_t> (TX_GUID_LIST_LEN,
+                                                          instances.end() - first);
+            std::string guids;
+            for (auto iter = first; iter != last; ++iter)
+            {
+                if (iter != first)
+                    guids += ",";
+                guids += "'" + gnc::GUID(*qof_instance_get_guid (*iter)).to_string() + "'";
+            }
+            load_splits_for_transactions (sql_be, "(" + guids + ")");
+            gnc_sql_slots_load_for_sql_subquery (sql_be, guids,
+                                                 (BookLookupFn)xaccTransLookup);
+            first = last;
+        }
+    }
     // Load all splits and slots for the transactions
-    if (!instances.empty())
+    else if (!instances.empty())
     {
         const std::string tpkey(tx_col_table[0]->name());
         if (!selector.empty() && (selector[0] != '('))
@@ -391,6 +419,20 @@ query_transactions (GncSqlBackend* sql_be, std::string selector)
     for (auto instance : instances)
          xaccTransCommitEdit(GNC_TRANSACTION(instance));
 
+    if (sql_be->load_on_demand())
+    {
+        auto obe = sql_be->get_object_backend (GNC_ID_TRANS);
+        std::static_pointer_cast<GncSqlTransBackend>(obe)->transactions_loaded (instances);
+    }
+}
+
+static void
+set_start_balances (const acct_balances_t& bal)
+{
+    gnc_account_set_start_balance (bal.acct, bal.balance);
+    gnc_account_set_start_cleared_balance (bal.acct, bal.cleared_balance);
+    gnc_account_set_start_reconciled_balance (bal.acct, bal.reconciled_balance);
+    gnc_account_set_start_noclosing_balance (bal.acct, bal.noclosing_balance);
 }
 
 
@@ -564,8 +606,10 @@ GncSqlSplitBackend::commit (GncSqlBackend* sql_be, QofInstance* inst)
         qof_instance_set_guid (inst, guid);
     }
 
-    is_ok = sql_be->do_db_operation(op, SPLIT_TABLE, GNC_ID_SPLIT,
-                                    inst, split_col_table);
+    is_ok = gnc_sql_account_balances_commit_split (sql_be, GNC_SPLIT (inst));
+    if (is_ok)
+        is_ok = sql_be->do_db_operation(op, SPLIT_TABLE, GNC_ID_SPLIT,
+                                        inst, split_col_table);
 
     if (is_ok && !qof_instance_get_destroying (inst))
     {
@@ -613,6 +657,16 @@ GncSqlTransBackend::commit (GncSqlBackend* sql_be, QofInstance* inst)
         }
     }
 
+    if (is_ok)
+    {
+        // Before the splits' post date changes in the database
+        is_ok = gnc_sql_account_balances_commit_tx (sql_be, pTx);
+        if (! is_ok)
+        {
+            err = "Account balances save failed. Check trace log for SQL errors";
+        }
+    }
+
     if (is_ok)
     {
         is_ok = sql_be->do_db_operation(op, TRANSACTION_TABLE, GNC_ID_TRANS,
@@ -715,12 +769,371 @@ GncSqlTransBackend::load_all (GncSqlBackend* sql_be)
 {
     g_return_if_fail (sql_be != NULL);
 
+    if (sql_be->load_on_demand() && !m_on_demand)
+    {
+        /* The lots need all of their splits for the capital gains code, so
+         * their transactions are loaded now and the rest when queried.
+         */
+        m_unloaded.clear();
+        m_loaded_since.clear();
+        m_all_loaded = false;
+        load_balances (sql_be);
+        m_on_demand = true;
+        const std::string stkey(split_col_table[1]->name());
+        query_transactions (sql_be, "(SELECT DISTINCT " + stkey + " FROM "
+                            SPLIT_TABLE " WHERE lot_guid IS NOT NULL)");
+        return;
+    }
+
     auto root = gnc_book_get_root_account (sql_be->book());
     gnc_account_foreach_descendant(root, (AccountCb)xaccAccountBeginEdit,
                                    nullptr);
     query_transactions (sql_be, "");
     gnc_account_foreach_descendant(root, (AccountCb)xaccAccountCommitEdit,
                                    nullptr);
+    m_all_loaded = true;
+}
+
+static void
+remove_split_from_balances (QofInstance* inst, gpointer data)
+{
+    auto balances = static_cast<std::unordered_map<Account*, acct_balances_t>*>(data);
+    auto split = GNC_SPLIT (inst);
+    auto iter = balances->find (xaccSplitGetAccount (split));
+    if (iter == balances->end())
+        return;
+    gnc_sql_acct_balances_add (iter->second, xaccSplitGetReconcile (split),
+                               gnc_numeric_neg (xaccSplitGetAmount (split)),
+                               xaccTransGetIsClosingTxn (xaccSplitGetParent (split)));
+}
+
+/**
+ * Sets the starting balances of the accounts to what their splits in the
+ * database that aren't in memory add up to.
+ *
+ * @param sql_be SQL backend
+ */
+void
+GncSqlTransBackend::load_balances (GncSqlBackend* sql_be)
+{
+    if (!gnc_sql_account_balances_load (sql_be, INT64_MAX, m_unloaded))
+        return;
+
+    auto splits = qof_book_get_collection (sql_be->book(), GNC_ID_SPLIT);
+    qof_collection_foreach (splits, remove_split_from_balances, &m_unloaded);
+    for (const auto& entry : m_unloaded)
+        set_start_balances (entry.second);
+}
+
+void
+GncSqlTransBackend::transactions_loaded (const std::vector<QofInstance*>& instances) noexcept
+{
+    if (!m_on_demand)
+        return;
+
+    std::unordered_set<Account*> accounts;
+    for (auto inst : instances)
+    {
+        for (auto node = xaccTransGetSplitList (GNC_TRANSACTION (inst)); node;
+             node = g_list_next (node))
+        {
+            auto split = GNC_SPLIT (node->data);
+            remove_split_from_balances (QOF_INSTANCE (split), &m_unloaded);
+            accounts.insert (xaccSplitGetAccount (split));
+        }
+    }
+    for (auto acct : accounts)
+    {
+        auto iter = m_unloaded.find (acct);
+        if (iter == m_unloaded.end())
+            continue;
+        set_start_balances (iter->second);
+        xaccAccountRecomputeBalance (acct);
+    }
+}
+
+/* The accounts a query term restricts the splits to, or false if it
+ * doesn't.
+ */
+static bool
+term_accounts (QofQueryTerm* term, QofBook* book, std::vector<Account*>& accounts)
+{
+    auto path = qof_query_term_get_param_path (term);
+    auto pred_data = qof_query_term_get_pred_data (term);
+    if (qof_query_term_is_inverted (term) ||
+        g_strcmp0 (pred_data->type_name, QOF_TYPE_GUID) != 0)
+        return false;
+
+    auto guid_data = (query_guid_t)pred_data;
+    auto len = g_slist_length (path);
+    if (guid_data->options == QOF_GUID_MATCH_ANY && len == 2)
+    {
+        if (g_strcmp0 (static_cast<char*>(path->data), SPLIT_ACCOUNT) != 0 ||
+            g_strcmp0 (static_cast<char*>(path->next->data), QOF_PARAM_GUID) != 0)
+            return false;
+    }
+    /* Any one of the accounts is enough for MATCH_ALL, all of them are more
+     * than enough.
+     */
+    else if (guid_data->options == QOF_GUID_MATCH_ALL && len == 3)
+    {
+        if (g_strcmp0 (static_cast<char*>(g_slist_last (path)->data),
+                       SPLIT_ACCOUNT_GUID) != 0)
+            return false;
+    }
+    else
+        return false;
+
+    for (auto node = guid_data->guids; node; node = g_list_next (node))
+    {
+        auto acct = xaccAccountLookup (static_cast<GncGUID*>(node->data), book);
+        if (acct)
+            accounts.push_back (acct);
+    }
+    return true;
+}
+
+/* The earliest post date a query term allows, or INT64_MIN. */
+static time64
+term_since (QofQueryTerm* term)
+{
+    auto path = qof_query_term_get_param_path (term);
+    auto pred_data = qof_query_term_get_pred_data (term);
+    if (path == nullptr ||
+        g_strcmp0 (pred_data->type_name, QOF_TYPE_DATE) != 0 ||
+        g_strcmp0 (static_cast<char*>(g_slist_last (path)->data),
+                   TRANS_DATE_POSTED) != 0)
+        return INT64_MIN;
+
+    auto inverted = qof_query_term_is_inverted (term);
+    if ((!inverted && (pred_data->how == QOF_COMPARE_GT ||
+                       pred_data->how == QOF_COMPARE_GTE)) ||
+        (inverted && (pred_data->how == QOF_COMPARE_LT ||
+                      pred_data->how == QOF_COMPARE_LTE)))
+    {
+        /* A day match compares the whole day. */
+        auto date_data = (query_date_t)pred_data;
+        return gnc_time64_get_day_start (date_data->date);
+    }
+    return INT64_MIN;
+}
+
+static void
+add_all_accounts (Account* acct, gpointer data)
+{
+    static_cast<std::vector<Account*>*>(data)->push_back (acct);
+}
+
+/**
+ * Loads the transactions the query might match: those of the accounts it
+ * restricts the splits to, posted on or after the earliest date it allows.
+ *
+ * @param sql_be SQL backend
+ * @param query The query about to be run
+ */
+void
+GncSqlTransBackend::load_for_query (GncSqlBackend* sql_be, QofQuery* query)
+{
+    g_return_if_fail (sql_be != NULL);
+    g_return_if_fail (query != NULL);
+
+    if (!m_on_demand || m_all_loaded)
+        return;
+    if (qof_query_get_terms (query) == nullptr)
+    {
+        load_all (sql_be);
+        return;
+    }
+
+    /* The terms are ORed lists of ANDed terms, so each AND list is loaded
+     * on its own.
+     */
+    std::vector<std::pair<std::vector<Account*>, time64>> loads;
+    for (auto or_node = qof_query_get_terms (query); or_node;
+         or_node = g_list_next (or_node))
+    {
+        std::vector<Account*> accounts;
+        bool restricted = false;
+        time64 since = INT64_MIN;
+        for (auto and_node = static_cast<GList*>(or_node->data); and_node;
+             and_node = g_list_next (and_node))
+        {
+            auto term = static_cast<QofQueryTerm*>(and_node->data);
+            std::vector<Account*> term_accts;
+            if (term_accounts (term, sql_be->book(), term_accts))
+            {
+                /* ANDed account terms could be intersected; loading both is
+                 * merely more than needed. */
+                restricted = true;
+                accounts.insert (accounts.end(), term_accts.begin(),
+                                 term_accts.end());
+            }
+            since = std::max (since, term_since (term));
+        }
+        if (!restricted && since == INT64_MIN)
+        {
+            load_all (sql_be);
+            return;
+        }
+        if (!restricted)
+            gnc_account_foreach_descendant (gnc_book_get_root_account (sql_be->book()),
+                                            add_all_accounts, &accounts);
+        loads.emplace_back (std::move (accounts), since);
+    }
+
+    for (const auto& load : loads)
+        load_for_accounts (sql_be, load.first, load.second);
+}
+
+/* Whether a transaction with an edit open has a split in the account,
+ * or had one when the edit began. */
+static bool
+account_being_edited (Account* acct)
+{
+    auto open = xaccTransGetOpenList ();
+    auto found = false;
+    for (auto node = open; node && !found; node = g_list_next (node))
+    {
+        for (auto snode = xaccTransGetSplitList (GNC_TRANSACTION (node->data));
+             snode && !found; snode = g_list_next (snode))
+        {
+            auto split = GNC_SPLIT (snode->data);
+            found = split->acc == acct || split->orig_acc == acct;
+        }
+    }
+    g_list_free (open);
+    return found;
+}
+
+/**
+ * Loads the account's transactions posted on or after since, before the
+ * engine reads its splits.
+ *
+ * A dated load goes back to the start of the month, and the account's
+ * starting balances are then taken from the balances table's rows for
+ * the earlier months, less the splits from those months already in
+ * memory. They come out the same as the running count kept as
+ * transactions are loaded, unless that has gone wrong.
+ *
+ * @param sql_be SQL backend
+ * @param inst The account
+ * @param since The earliest post date, INT64_MIN for all
+ */
+void
+GncSqlTransBackend::load_for_instance (GncSqlBackend* sql_be, QofInstance* inst,
+                                       time64 since)
+{
+    g_return_if_fail (sql_be != NULL);
+    g_return_if_fail (GNC_IS_ACCOUNT (inst));
+
+    if (!m_on_demand || m_all_loaded)
+        return;
+    auto acct = GNC_ACCOUNT (inst);
+    if (since >= MAXTIME) // Nothing is posted that late.
+        return;
+    if (since > MINTIME)
+        since = gnc_sql_account_balances_period_start (since);
+    auto iter = m_loaded_since.find (acct);
+    if (iter != m_loaded_since.end() && iter->second <= since)
+        return;
+
+    load_for_accounts (sql_be, {acct}, since);
+    if (since <= MINTIME)
+        return;
+
+    /* An open edit may have changed splits the database still has as they
+     * were, the running count stays right through those. */
+    std::unordered_map<Account*, acct_balances_t> balances;
+    if (account_being_edited (acct) ||
+        !gnc_sql_account_balances_load (sql_be, since, balances, acct))
+        return;
+    auto zero = gnc_numeric_zero ();
+    auto& bal = balances.emplace (acct, acct_balances_t{acct, zero, zero,
+                                                        zero, zero}).first->second;
+    for (auto node = xaccAccountGetSplitList (acct); node;
+         node = g_list_next (node))
+    {
+        auto split = GNC_SPLIT (node->data);
+        if (xaccTransGetDate (xaccSplitGetParent (split)) >= since)
+            break;
+        remove_split_from_balances (QOF_INSTANCE (split), &balances);
+    }
+    m_unloaded[acct] = bal;
+    set_start_balances (bal);
+    xaccAccountRecomputeBalance (acct);
+}
+
+/**
+ * Loads the transactions of the accounts posted on or after since that
+ * aren't loaded yet.
+ *
+ * @param sql_be SQL backend
+ * @param accounts The accounts
+ * @param since The earliest post date, INT64_MIN for all
+ */
+void
+GncSqlTransBackend::load_for_accounts (GncSqlBackend* sql_be,
+                                       const std::vector<Account*>& accounts,
+                                       time64 since)
+{
+    if (since <= MINTIME)
+        since = INT64_MIN;
+
+    /* Accounts loaded from the same date get the same selector. */
+    std::map<time64, std::vector<Account*>> until_groups;
+    for (auto acct : accounts)
+    {
+        auto iter = m_loaded_since.find (acct);
+        auto until = iter == m_loaded_since.end() ? INT64_MAX : iter->second;
+        if (since >= until)
+            continue;
+        until_groups[until].push_back (acct);
+        m_loaded_since[acct] = since;
+    }
+
+    const std::string tpkey(tx_col_table[0]->name());    //guid
+    const std::string stkey(split_col_table[1]->name()); //tx_guid
+    const std::string sakey(split_col_table[2]->name()); //account_guid
+    const std::string pdkey(tx_col_table[3]->name());    //post_date
+    for (const auto& group : until_groups)
+    {
+        std::string sql("(SELECT DISTINCT " SPLIT_TABLE "." + stkey + " FROM "
+                        SPLIT_TABLE " INNER JOIN " TRANSACTION_TABLE " ON "
+                        SPLIT_TABLE "." + stkey + " = " TRANSACTION_TABLE "." +
+                        tpkey + " WHERE " SPLIT_TABLE "." + sakey + " IN (");
+        for (auto acct : group.second)
+        {
+            if (acct != group.second.front())
+                sql += ",";
+            sql += "'" + gnc::GUID(*qof_instance_get_guid (acct)).to_string() + "'";
+        }
+        sql += ")";
+
+        const std::string date_col(TRANSACTION_TABLE "." + pdkey);
+        auto until = group.first;
+        if (since != INT64_MIN)
+        {
+            sql += " AND (" + date_col + " >= '" +
+                GncDateTime(since).format_iso8601() + "'";
+            /* Transactions without a post date go with the first load. */
+            if (until == INT64_MAX)
+                sql += " OR " + date_col + " IS NULL";
+            sql += ")";
+        }
+        if (until != INT64_MAX)
+            sql += " AND " + date_col + " < '" +
+                GncDateTime(until).format_iso8601() + "'";
+        sql += ")";
+        query_transactions (sql_be, sql);
+    }
+}
+
+/* Split queries load whole transactions. */
+void
+GncSqlSplitBackend::load_for_query (GncSqlBackend* sql_be, QofQuery* query)
+{
+    auto obe = sql_be->get_object_backend (GNC_ID_TRANS);
+    obe->load_for_query (sql_be, query);
 }
 
 static void
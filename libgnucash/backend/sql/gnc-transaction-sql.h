@@ -35,13 +35,43 @@ extern "C"
 #include "qof.h"
 #include "Account.h"
 }
+#include "gnc-account-balances-sql.h"
+
+#include <unordered_map>
+#include <vector>
+
+/**
+ * When the backend loads transactions on demand, the initial load_all only
+ * reads the account balances and the transactions that belong to lots. The
+ * rest are loaded by account and post date as queries need them, and each
+ * account's starting balances are kept at what its splits still in the
+ * database add up to.
+ */
 class GncSqlTransBackend : public GncSqlObjectBackend
 {
 public:
     GncSqlTransBackend();
     void load_all(GncSqlBackend*) override;
+    void load_for_query(GncSqlBackend*, QofQuery*) override;
+    void load_for_instance(GncSqlBackend*, QofInstance*, time64) override;
     void create_tables(GncSqlBackend*) override;
     bool commit (GncSqlBackend* sql_be, QofInstance* inst) override;
+    /**
+     * Takes newly loaded transactions out of their accounts' starting
+     * balances.
+     */
+    void transactions_loaded (const std::vector<QofInstance*>& instances) noexcept;
+private:
+    void load_balances (GncSqlBackend* sql_be);
+    void load_for_accounts (GncSqlBackend* sql_be,
+                            const std::vector<Account*>& accounts,
+                            time64 since);
+    bool m_on_demand = false;
+    bool m_all_loaded = false;
+    /** What the splits of each account still in the database add up to. */
+    std::unordered_map<Account*, acct_balances_t> m_unloaded;
+    /** The post date from which each account's transactions are loaded. */
+    std::unordered_map<Account*, time64> m_loaded_since;
 };
 
 class GncSqlSplitBackend : public GncSqlObjectBackend
@@ -49,6 +79,7 @@ class GncSqlSplitBackend : public GncSqlObjectBackend
 public:
     GncSqlSplitBackend();
     void load_all(GncSqlBackend*) override { return; } // loaded by transaction.
+    void load_for_query(GncSqlBackend*, QofQuery*) override;
     void create_tables(GncSqlBackend*) override;
     bool commit (GncSqlBackend* sql_be, QofInstance* inst) override;
 };
@@ -61,13 +92,6 @@ public:
  */
 void gnc_sql_transaction_load_tx_for_account (GncSqlBackend* sql_be,
                                               Account* account);
-typedef struct
-{
-    Account* acct;
-    gnc_numeric balance;
-    gnc_numeric cleared_balance;
-    gnc_numeric reconciled_balance;
-} acct_balances_t;
 
 
 #endif /* GNC_TRANSACTION_SQL_H */
@@ -91,6 +91,7 @@ class GncMockSqlStatement : public GncSqlStatement
 public:
     const char* to_sql() const { return "SELECT * FROM foo"; }
     void add_where_cond (QofIdTypeConst, const PairVec&) {}
+    void bind (size_t, const GncSqlValue&) {}
 };
 
 
@@ -33,6 +33,7 @@ extern "C"
 #include "sixtp.h"
 #include "sixtp-utils.h"
 #include "sixtp-parsers.h"
+#include "sixtp-sax-parser.hpp"
 #include "sixtp-dom-parsers.h"
 #include "sixtp-dom-generators.h"
 #include "io-gncxml-gen.h"
@@ -78,162 +79,197 @@ static QofLogModule log_module = GNC_MOD_IO;
 /****************************************************************************/
 /* <price>
 
-  restores a price.  Does so via a walk of the XML tree in memory.
-  Returns a GNCPrice * in result.
+  restores a price.  Does so straight from the sax events, without
+  building the XML tree in memory.  Returns a GNCPrice * in result.
 
   Right now, a price is legitimate even if all of it's fields are not
   set.  We may need to change that later, but at the moment.
 
 */
 
-static gboolean
-price_parse_xml_sub_node (GNCPrice* p, xmlNodePtr sub_node, QofBook* book)
+static void
+cleanup_gnc_price (sixtp_child_result* result)
+{
+    if (result->data) gnc_price_unref ((GNCPrice*) result->data);
+}
+
+struct price_sax_data : public sixtp_sax_state
+{
+    price_sax_data (QofBook* b);
+    ~price_sax_data ();
+    void element_start (const gchar* tag, gchar** attrs) override;
+    void element_end (const gchar* tag, const gchar* text) override;
+    GNCPrice* finish ();
+
+private:
+    void price_field (const gchar* tag, const gchar* text);
+
+    QofBook* book;
+    GNCPrice* price;
+    gboolean ok = TRUE;
+    gboolean has_children = FALSE;
+    gboolean guid_ok = FALSE;       // the open id element has type="guid"
+    sixtp_sax_date date;
+    sixtp_sax_commodity_ref cmdty;
+};
+
+price_sax_data::price_sax_data (QofBook* b) : book{b}
+{
+    price = gnc_price_create (book);
+    gnc_price_begin_edit (price);
+}
+
+price_sax_data::~price_sax_data ()
+{
+    /* Only a failed parse leaves anything here. */
+    if (price)
+    {
+        gnc_price_commit_edit (price);
+        gnc_price_unref (price);
+    }
+}
+
+void
+price_sax_data::element_start (const gchar* tag, gchar** attrs)
 {
-    if (!p || !sub_node) return FALSE;
+    if (depth != 1)
+        return;
+
+    has_children = TRUE;
+    if (g_strcmp0 ("price:id", tag) == 0)
+        guid_ok = sixtp_sax_guid_type (attrs);
+    else if (g_strcmp0 ("price:commodity", tag) == 0 ||
+             g_strcmp0 ("price:currency", tag) == 0)
+        cmdty.reset ();
+    else if (g_strcmp0 ("price:time", tag) == 0)
+        date.reset ();
+}
+
+void
+price_sax_data::element_end (const gchar* tag, const gchar* text)
+{
+    if (depth == 1)
+    {
+        price_field (tag, text);
+    }
+    else if (depth == 2)
+    {
+        if (path[0] == "price:commodity" || path[0] == "price:currency")
+            cmdty.add (tag, text);
+        else if (path[0] == "price:time" && g_strcmp0 ("ts:date", tag) == 0)
+            date.add (text);
+    }
+}
 
-    gnc_price_begin_edit (p);
-    if (g_strcmp0 ("price:id", (char*)sub_node->name) == 0)
+void
+price_sax_data::price_field (const gchar* tag, const gchar* text)
+{
+    if (g_strcmp0 ("price:id", tag) == 0)
     {
-        GncGUID* c = dom_tree_to_guid (sub_node);
-        if (!c) return FALSE;
-        gnc_price_set_guid (p, c);
-        guid_free (c);
+        GncGUID guid;
+        if (!guid_ok)
+        {
+            ok = FALSE;
+            return;
+        }
+        sixtp_sax_text_to_guid (text, &guid);
+        gnc_price_set_guid (price, &guid);
     }
-    else if (g_strcmp0 ("price:commodity", (char*)sub_node->name) == 0)
+    else if (g_strcmp0 ("price:commodity", tag) == 0)
     {
-        gnc_commodity* c = dom_tree_to_commodity_ref (sub_node, book);
-        if (!c) return FALSE;
-        gnc_price_set_commodity (p, c);
+        gnc_commodity* c = cmdty.lookup (book);
+        if (!c) ok = FALSE;
+        else gnc_price_set_commodity (price, c);
     }
-    else if (g_strcmp0 ("price:currency", (char*)sub_node->name) == 0)
+    else if (g_strcmp0 ("price:currency", tag) == 0)
     {
-        gnc_commodity* c = dom_tree_to_commodity_ref (sub_node, book);
-        if (!c) return FALSE;
-        gnc_price_set_currency (p, c);
+        gnc_commodity* c = cmdty.lookup (book);
+        if (!c) ok = FALSE;
+        else gnc_price_set_currency (price, c);
     }
-    else if (g_strcmp0 ("price:time", (char*)sub_node->name) == 0)
+    else if (g_strcmp0 ("price:time", tag) == 0)
     {
-        time64 time = dom_tree_to_time64 (sub_node);
-        if (!dom_tree_valid_time64 (time, sub_node->name)) time = 0;
-        gnc_price_set_time64 (p, time);
+        time64 time = date.to_time64 ();
+        if (!dom_tree_valid_time64 (time, BAD_CAST tag)) time = 0;
+        gnc_price_set_time64 (price, time);
     }
-    else if (g_strcmp0 ("price:source", (char*)sub_node->name) == 0)
+    else if (g_strcmp0 ("price:source", tag) == 0)
     {
-        char* text = dom_tree_to_text (sub_node);
-        if (!text) return FALSE;
-        gnc_price_set_source_string (p, text);
-        g_free (text);
+        gnc_price_set_source_string (price, text);
     }
-    else if (g_strcmp0 ("price:type", (char*)sub_node->name) == 0)
+    else if (g_strcmp0 ("price:type", tag) == 0)
     {
-        char* text = dom_tree_to_text (sub_node);
-        if (!text) return FALSE;
-        gnc_price_set_typestr (p, text);
-        g_free (text);
+        gnc_price_set_typestr (price, text);
     }
-    else if (g_strcmp0 ("price:value", (char*)sub_node->name) == 0)
+    else if (g_strcmp0 ("price:value", tag) == 0)
     {
-        gnc_numeric* value = dom_tree_to_gnc_numeric (sub_node);
-        if (!value) return FALSE;
-        gnc_price_set_value (p, *value);
-        g_free (value);
+        gnc_numeric value;
+        if (!string_to_gnc_numeric (text, &value))
+            value = gnc_numeric_zero ();
+        gnc_price_set_value (price, value);
     }
+}
+
+GNCPrice*
+price_sax_data::finish ()
+{
+    GNCPrice* p = price;
+
+    price = NULL;
     gnc_price_commit_edit (p);
-    return TRUE;
+    if (!ok || !has_children)
+    {
+        gnc_price_unref (p);
+        return NULL;
+    }
+    return p;
 }
 
 static gboolean
-price_parse_xml_end_handler (gpointer data_for_children,
-                             GSList* data_from_children,
-                             GSList* sibling_data,
-                             gpointer parent_data,
-                             gpointer global_data,
-                             gpointer* result,
-                             const gchar* tag)
+price_sax_start_handler (GSList* sibling_data, gpointer parent_data,
+                         gpointer global_data, gpointer* data_for_children,
+                         gpointer* result, const gchar* tag, gchar** attrs)
 {
-    gboolean ok = TRUE;
-    xmlNodePtr price_xml = (xmlNodePtr) data_for_children;
-    xmlNodePtr child;
-    GNCPrice* p = NULL;
     gxpf_data* gdata = static_cast<decltype (gdata)> (global_data);
     QofBook* book = static_cast<decltype (book)> (gdata->bookdata);
 
-    /* we haven't been handed the *top* level node yet... */
-    if (parent_data) return TRUE;
+    g_return_val_if_fail (book, FALSE);
 
+    sixtp_sax_state* state = new price_sax_data {book};
+    *data_for_children = state;
     *result = NULL;
+    return TRUE;
+}
 
-    if (!price_xml) return FALSE;
-    if (price_xml->next)
-    {
-        ok = FALSE;
-        goto cleanup_and_exit;
-    }
-    if (price_xml->prev)
-    {
-        ok = FALSE;
-        goto cleanup_and_exit;
-    }
-    if (!price_xml->xmlChildrenNode)
-    {
-        ok = FALSE;
-        goto cleanup_and_exit;
-    }
+static gboolean
+price_sax_end_handler (gpointer data_for_children,
+                       GSList* data_from_children,
+                       GSList* sibling_data,
+                       gpointer parent_data,
+                       gpointer global_data,
+                       gpointer* result,
+                       const gchar* tag)
+{
+    auto state = static_cast<sixtp_sax_state*> (data_for_children);
 
-    p = gnc_price_create (book);
-    if (!p)
-    {
-        ok = FALSE;
-        goto cleanup_and_exit;
-    }
+    if (!tag) return TRUE;
 
-    for (child = price_xml->xmlChildrenNode; child; child = child->next)
-    {
-        switch (child->type)
-        {
-        case XML_COMMENT_NODE:
-        case XML_TEXT_NODE:
-            break;
-        case XML_ELEMENT_NODE:
-            if (!price_parse_xml_sub_node (p, child, book))
-            {
-                ok = FALSE;
-                goto cleanup_and_exit;
-            }
-            break;
-        default:
-            PERR ("Unknown node type (%d) while parsing gnc-price xml.", child->type);
-            child = NULL;
-            ok = FALSE;
-            goto cleanup_and_exit;
-            break;
-        }
-    }
+    *result = NULL;
+    g_return_val_if_fail (state, FALSE);
 
-cleanup_and_exit:
-    if (ok)
-    {
-        *result = p;
-    }
-    else
-    {
-        *result = NULL;
-        gnc_price_unref (p);
-    }
-    xmlFreeNode (price_xml);
-    return ok;
-}
+    auto pdata = static_cast<price_sax_data*> (state);
+    *result = pdata->finish ();
+    delete pdata;
 
-static void
-cleanup_gnc_price (sixtp_child_result* result)
-{
-    if (result->data) gnc_price_unref ((GNCPrice*) result->data);
+    return *result != NULL;
 }
 
 static sixtp*
 gnc_price_parser_new (void)
 {
-    return sixtp_dom_parser_new (price_parse_xml_end_handler,
+    return sixtp_sax_parser_new ("price",
+                                 price_sax_start_handler,
+                                 price_sax_end_handler,
                                  cleanup_gnc_price,
                                  cleanup_gnc_price);
 }
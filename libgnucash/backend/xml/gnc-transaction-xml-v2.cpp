@@ -36,9 +36,15 @@ extern "C"
 
 #include "gnc-xml-helper.h"
 
+#include <optional>
+#include <string>
+#include <vector>
+
 #include "sixtp.h"
 #include "sixtp-utils.h"
 #include "sixtp-parsers.h"
+#include "sixtp-sax-parser.hpp"
+#include "sixtp-xml-writer.hpp"
 #include "sixtp-utils.h"
 #include "sixtp-dom-parsers.h"
 #include "sixtp-dom-generators.h"
@@ -194,6 +200,77 @@ gnc_transaction_dom_tree_create (Transaction* trn)
     return ret;
 }
 
+/* The same elements as split_to_dom_tree and gnc_transaction_dom_tree_create,
+   written without building the tree first. */
+static void
+write_split (sixtp_xml_writer& writer, const gchar* tag, Split* spl)
+{
+    writer.start_element (tag);
+
+    writer.guid_element ("split:id", xaccSplitGetGUID (spl));
+
+    auto memo = xaccSplitGetMemo (spl);
+    if (memo && g_strcmp0 (memo, "") != 0)
+        writer.text_element ("split:memo", memo);
+
+    auto action = xaccSplitGetAction (spl);
+    if (action && g_strcmp0 (action, "") != 0)
+        writer.text_element ("split:action", action);
+
+    char tmp[2];
+    tmp[0] = xaccSplitGetReconcile (spl);
+    tmp[1] = '\0';
+    writer.text_element ("split:reconciled-state", tmp);
+
+    auto reconciled = xaccSplitGetDateReconciled (spl);
+    if (reconciled)
+        writer.time64_element ("split:reconcile-date", reconciled);
+
+    writer.numeric_element ("split:value", xaccSplitGetValue (spl));
+    writer.numeric_element ("split:quantity", xaccSplitGetAmount (spl));
+
+    writer.guid_element ("split:account",
+                         xaccAccountGetGUID (xaccSplitGetAccount (spl)));
+
+    GNCLot* lot = xaccSplitGetLot (spl);
+    if (lot)
+        writer.guid_element ("split:lot", gnc_lot_get_guid (lot));
+
+    writer.slots_element ("split:slots", QOF_INSTANCE (spl));
+
+    writer.end_element ();
+}
+
+void
+gnc_transaction_write (sixtp_xml_writer& writer, Transaction* trn)
+{
+    writer.start_element ("gnc:transaction");
+    writer.attribute ("version", transaction_version_string);
+
+    writer.guid_element ("trn:id", xaccTransGetGUID (trn));
+    writer.commodity_ref_element ("trn:currency", xaccTransGetCurrency (trn));
+
+    auto num = xaccTransGetNum (trn);
+    if (num && g_strcmp0 (num, "") != 0)
+        writer.text_element ("trn:num", num);
+
+    writer.time64_element ("trn:date-posted", xaccTransRetDatePosted (trn));
+    writer.time64_element ("trn:date-entered", xaccTransRetDateEntered (trn));
+
+    auto description = xaccTransGetDescription (trn);
+    if (description)
+        writer.text_element ("trn:description", description);
+
+    writer.slots_element ("trn:slots", QOF_INSTANCE (trn));
+
+    writer.start_element ("trn:splits");
+    for (auto n = xaccTransGetSplitList (trn); n; n = n->next)
+        write_split (writer, "trn:split", static_cast<Split*> (n->data));
+    writer.end_element ();
+
+    writer.end_element ();
+}
+
 /***********************************************************************/
 
 struct split_pdata
@@ -297,26 +374,45 @@ spl_quantity_handler (xmlNodePtr node, gpointer data)
 
 gboolean gnc_transaction_xml_v2_testing = FALSE;
 
-static gboolean
-spl_account_handler (xmlNodePtr node, gpointer data)
+static void
+spl_set_account (Split* split, QofBook* book, const GncGUID* id)
 {
-    struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
-    GncGUID* id = dom_tree_to_guid (node);
-    Account* account;
-
-    g_return_val_if_fail (id, FALSE);
-
-    account = xaccAccountLookup (id, pdata->book);
+    Account* account = xaccAccountLookup (id, book);
     if (!account && gnc_transaction_xml_v2_testing &&
         !guid_equal (id, guid_null ()))
     {
-        account = xaccMallocAccount (pdata->book);
+        account = xaccMallocAccount (book);
         xaccAccountSetGUID (account, id);
         xaccAccountSetCommoditySCU (account,
-                                    xaccSplitGetAmount (pdata->split).denom);
+                                    xaccSplitGetAmount (split).denom);
+    }
+
+    xaccAccountInsertSplit (account, split);
+}
+
+static void
+spl_set_lot (Split* split, QofBook* book, const GncGUID* id)
+{
+    GNCLot* lot = gnc_lot_lookup (id, book);
+    if (!lot && gnc_transaction_xml_v2_testing &&
+        !guid_equal (id, guid_null ()))
+    {
+        lot = gnc_lot_new (book);
+        gnc_lot_set_guid (lot, *id);
     }
 
-    xaccAccountInsertSplit (account, pdata->split);
+    gnc_lot_add_split (lot, split);
+}
+
+static gboolean
+spl_account_handler (xmlNodePtr node, gpointer data)
+{
+    struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
+    GncGUID* id = dom_tree_to_guid (node);
+
+    g_return_val_if_fail (id, FALSE);
+
+    spl_set_account (pdata->split, pdata->book, id);
 
     guid_free (id);
 
@@ -328,19 +424,10 @@ spl_lot_handler (xmlNodePtr node, gpointer data)
 {
     struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
     GncGUID* id = dom_tree_to_guid (node);
-    GNCLot* lot;
 
     g_return_val_if_fail (id, FALSE);
 
-    lot = gnc_lot_lookup (id, pdata->book);
-    if (!lot && gnc_transaction_xml_v2_testing &&
-        !guid_equal (id, guid_null ()))
-    {
-        lot = gnc_lot_new (pdata->book);
-        gnc_lot_set_guid (lot, *id);
-    }
-
-    gnc_lot_add_split (lot, pdata->split);
+    spl_set_lot (pdata->split, pdata->book, id);
 
     guid_free (id);
 
@@ -644,7 +731,457 @@ dom_tree_to_transaction (xmlNodePtr node, QofBook* book)
 }
 
 sixtp*
-gnc_transaction_sixtp_parser_create (void)
+gnc_transaction_dom_sixtp_parser_create (void)
 {
     return sixtp_dom_parser_new (gnc_transaction_end_handler, NULL, NULL);
 }
+
+/***********************************************************************/
+/* <gnc:transaction> read straight from the sax events, without building
+   a DOM tree first.  It gives the same results as the DOM parser above,
+   which is still used for the template transactions. */
+
+static const gchar* trn_required_tags[] =
+{
+    "trn:id", "trn:date-posted", "trn:date-entered", "trn:splits", NULL
+};
+
+static const gchar* spl_required_tags[] =
+{
+    "split:id", "split:reconciled-state", "split:value", "split:quantity",
+    "split:account", NULL
+};
+
+/* A <trn:split> or <gnc:transaction> as read from the file, in plain data
+   that a worker can fill in without the engine.  Only the fields that
+   were in the file are set. */
+struct split_record
+{
+    std::optional<GncGUID> id;
+    std::optional<std::string> memo;
+    std::optional<std::string> action;
+    std::optional<char> reconciled;
+    std::optional<time64> reconcile_date;
+    std::optional<gnc_numeric> value;
+    std::optional<gnc_numeric> quantity;
+    std::optional<GncGUID> account;
+    std::optional<GncGUID> lot;
+    sixtp_sax_events slots;
+};
+
+struct trans_record
+{
+    gboolean ok = TRUE;
+    std::optional<GncGUID> id;
+    gboolean has_currency = FALSE;
+    sixtp_sax_commodity_ref currency;
+    std::optional<std::string> num;
+    std::optional<time64> date_posted;
+    std::optional<time64> date_entered;
+    std::optional<std::string> description;
+    sixtp_sax_events slots;
+    std::vector<split_record> splits;
+};
+
+/* Reads the elements of a <gnc:transaction> into a trans_record.  The
+   slots are only recorded: KvpFrame keys go through the string cache,
+   so they're read when the transaction is built. */
+struct trans_sax_reader : public sixtp_sax_state
+{
+    trans_sax_reader (trans_record& r) : rec{r} {}
+    void element_start (const gchar* tag, gchar** attrs) override;
+    void element_end (const gchar* tag, const gchar* text) override;
+    void finish ();
+
+private:
+    void trans_field (const gchar* tag, const gchar* text);
+    void split_field (const gchar* tag, const gchar* text);
+    void finish_split ();
+    time64 date_value (const gchar* tag) const;
+
+    trans_record& rec;
+    split_record* split = nullptr;  // the <trn:split> being read
+    gboolean split_ok = TRUE;
+    gboolean skip_splits = FALSE;   // a bad split ends its <trn:splits>
+    gboolean guid_ok = FALSE;       // the open id element has type="guid"
+    size_t slots_depth = 0;         // depth of the open slots element
+    sixtp_sax_events* slots = nullptr;
+    sixtp_sax_required trn_required {trn_required_tags};
+    sixtp_sax_required spl_required {spl_required_tags};
+    sixtp_sax_date date;
+};
+
+void
+trans_sax_reader::element_start (const gchar* tag, gchar** attrs)
+{
+    if (slots_depth)
+    {
+        slots->start (tag, attrs);
+        return;
+    }
+
+    if (depth == 1)
+    {
+        if (g_strcmp0 (tag, "trn:id") == 0)
+            guid_ok = sixtp_sax_guid_type (attrs);
+        else if (g_strcmp0 (tag, "trn:currency") == 0)
+            rec.currency.reset ();
+        else if (g_strcmp0 (tag, "trn:date-posted") == 0 ||
+                 g_strcmp0 (tag, "trn:date-entered") == 0)
+            date.reset ();
+        else if (g_strcmp0 (tag, "trn:splits") == 0)
+            skip_splits = FALSE;
+        else if (g_strcmp0 (tag, "trn:slots") == 0)
+        {
+            slots = &rec.slots;
+            slots_depth = depth;
+        }
+    }
+    else if (depth == 2 && path[0] == "trn:splits" && !skip_splits)
+    {
+        if (g_strcmp0 (tag, "trn:split") == 0)
+        {
+            rec.splits.emplace_back ();
+            split = &rec.splits.back ();
+            split_ok = TRUE;
+            spl_required.reset ();
+        }
+        else
+        {
+            PERR ("unexpected tag %s in trn:splits", tag);
+            skip_splits = TRUE;
+        }
+    }
+    else if (depth == 3 && split)
+    {
+        if (g_strcmp0 (tag, "split:id") == 0 ||
+            g_strcmp0 (tag, "split:account") == 0 ||
+            g_strcmp0 (tag, "split:lot") == 0)
+            guid_ok = sixtp_sax_guid_type (attrs);
+        else if (g_strcmp0 (tag, "split:reconcile-date") == 0)
+            date.reset ();
+        else if (g_strcmp0 (tag, "split:slots") == 0)
+        {
+            slots = &split->slots;
+            slots_depth = depth;
+        }
+    }
+}
+
+void
+trans_sax_reader::element_end (const gchar* tag, const gchar* text)
+{
+    if (slots_depth)
+    {
+        if (depth > slots_depth)
+        {
+            slots->end (tag, text);
+            return;
+        }
+        slots = nullptr;
+        slots_depth = 0;
+    }
+
+    switch (depth)
+    {
+    case 1:
+        trans_field (tag, text);
+        break;
+    case 2:
+        if (path[0] == "trn:currency")
+            rec.currency.add (tag, text);
+        else if (path[0] == "trn:date-posted" ||
+                 path[0] == "trn:date-entered")
+        {
+            if (g_strcmp0 (tag, "ts:date") == 0)
+                date.add (text);
+        }
+        else if (split)
+            finish_split ();
+        break;
+    case 3:
+        if (split)
+            split_field (tag, text);
+        break;
+    case 4:
+        if (split && path[2] == "split:reconcile-date" &&
+            g_strcmp0 (tag, "ts:date") == 0)
+            date.add (text);
+        break;
+    default:
+        break;
+    }
+}
+
+time64
+trans_sax_reader::date_value (const gchar* tag) const
+{
+    time64 time = date.to_time64 ();
+    if (!dom_tree_valid_time64 (time, BAD_CAST tag)) time = 0;
+    return time;
+}
+
+static gnc_numeric
+sax_text_to_numeric (const gchar* text)
+{
+    gnc_numeric num;
+    if (!string_to_gnc_numeric (text, &num))
+        num = gnc_numeric_zero ();
+    return num;
+}
+
+static GncGUID
+sax_text_guid (const gchar* text)
+{
+    GncGUID guid;
+    sixtp_sax_text_to_guid (text, &guid);
+    return guid;
+}
+
+void
+trans_sax_reader::trans_field (const gchar* tag, const gchar* text)
+{
+    if (g_strcmp0 (tag, "trn:id") == 0)
+    {
+        if (guid_ok)
+            rec.id = sax_text_guid (text);
+    }
+    else if (g_strcmp0 (tag, "trn:currency") == 0)
+        rec.has_currency = TRUE;
+    else if (g_strcmp0 (tag, "trn:num") == 0)
+        rec.num = text;
+    else if (g_strcmp0 (tag, "trn:date-posted") == 0)
+        rec.date_posted = date_value (tag);
+    else if (g_strcmp0 (tag, "trn:date-entered") == 0)
+        rec.date_entered = date_value (tag);
+    else if (g_strcmp0 (tag, "trn:description") == 0)
+        rec.description = text;
+    else if (g_strcmp0 (tag, "trn:slots") != 0 &&
+             g_strcmp0 (tag, "trn:splits") != 0)
+    {
+        PERR ("Unhandled tag: %s", tag);
+        rec.ok = FALSE;
+        return;
+    }
+    trn_required.seen (tag);
+}
+
+void
+trans_sax_reader::split_field (const gchar* tag, const gchar* text)
+{
+    if (g_strcmp0 (tag, "split:id") == 0)
+    {
+        if (guid_ok)
+            split->id = sax_text_guid (text);
+    }
+    else if (g_strcmp0 (tag, "split:memo") == 0)
+        split->memo = text;
+    else if (g_strcmp0 (tag, "split:action") == 0)
+        split->action = text;
+    else if (g_strcmp0 (tag, "split:reconciled-state") == 0)
+        split->reconciled = text[0];
+    else if (g_strcmp0 (tag, "split:reconcile-date") == 0)
+        split->reconcile_date = date_value (tag);
+    else if (g_strcmp0 (tag, "split:value") == 0)
+        split->value = sax_text_to_numeric (text);
+    else if (g_strcmp0 (tag, "split:quantity") == 0)
+        split->quantity = sax_text_to_numeric (text);
+    else if (g_strcmp0 (tag, "split:account") == 0)
+    {
+        if (guid_ok)
+            split->account = sax_text_guid (text);
+    }
+    else if (g_strcmp0 (tag, "split:lot") == 0)
+    {
+        if (guid_ok)
+            split->lot = sax_text_guid (text);
+    }
+    else if (g_strcmp0 (tag, "split:slots") != 0)
+    {
+        PERR ("Unhandled tag: %s", tag);
+        split_ok = FALSE;
+        return;
+    }
+    spl_required.seen (tag);
+}
+
+void
+trans_sax_reader::finish_split ()
+{
+    if (!split_ok || !spl_required.all_seen ())
+    {
+        /* Like trn_splits_handler, drop it and the splits after it. */
+        PERR ("bad split in transaction");
+        rec.splits.pop_back ();
+        skip_splits = TRUE;
+    }
+    split = nullptr;
+}
+
+void
+trans_sax_reader::finish ()
+{
+    if (!trn_required.all_seen ())
+        rec.ok = FALSE;
+}
+
+/* Build the transaction on the parsing thread, setting its fields in the
+   order they are written. */
+static Transaction*
+trans_record_commit (const trans_record& rec, QofBook* book)
+{
+    sixtp_sax_slots slots;
+
+    if (!rec.ok)
+    {
+        PERR ("didn't find all of the expected tags in the input");
+        return NULL;
+    }
+
+    auto trn = xaccMallocTransaction (book);
+    xaccTransBeginEdit (trn);
+    if (rec.id)
+        xaccTransSetGUID (trn, &*rec.id);
+    if (rec.has_currency)
+        xaccTransSetCurrency (trn, rec.currency.lookup (book));
+    if (rec.num)
+        xaccTransSetNum (trn, rec.num->c_str ());
+    if (rec.date_posted)
+        xaccTransSetDatePostedSecs (trn, *rec.date_posted);
+    if (rec.date_entered)
+        xaccTransSetDateEnteredSecs (trn, *rec.date_entered);
+    if (rec.description)
+        xaccTransSetDescription (trn, rec.description->c_str ());
+    slots.read (qof_instance_get_slots (QOF_INSTANCE (trn)), rec.slots);
+
+    for (auto& srec : rec.splits)
+    {
+        auto split = xaccMallocSplit (book);
+
+        if (srec.id)
+            xaccSplitSetGUID (split, &*srec.id);
+        if (srec.memo)
+            xaccSplitSetMemo (split, srec.memo->c_str ());
+        if (srec.action)
+            xaccSplitSetAction (split, srec.action->c_str ());
+        if (srec.reconciled)
+            xaccSplitSetReconcile (split, *srec.reconciled);
+        if (srec.reconcile_date)
+            xaccSplitSetDateReconciledSecs (split, *srec.reconcile_date);
+        if (srec.value)
+            xaccSplitSetValue (split, *srec.value);
+        if (srec.quantity)
+            xaccSplitSetAmount (split, *srec.quantity);
+        if (srec.account)
+            spl_set_account (split, book, &*srec.account);
+        if (srec.lot)
+            spl_set_lot (split, book, &*srec.lot);
+        slots.read (qof_instance_get_slots (QOF_INSTANCE (split)), srec.slots);
+        xaccTransAppendSplit (trn, split);
+    }
+
+    xaccTransCommitEdit (trn);
+    return trn;
+}
+
+/* Records the elements of a <gnc:transaction> for a trans_job. */
+struct trans_sax_data : public sixtp_sax_state
+{
+    void element_start (const gchar* tag, gchar** attrs) override
+    {
+        events.start (tag, attrs);
+    }
+    void element_end (const gchar* tag, const gchar* text) override
+    {
+        events.end (tag, text);
+    }
+
+    sixtp_sax_events events;
+};
+
+/* Reads a transaction on a worker and adds it to the book. */
+struct trans_job : public sixtp_job
+{
+    trans_job (sixtp_sax_events&& e, gxpf_data* g, const gchar* t) :
+        events{std::move (e)}, gdata{g}, tag{t} {}
+    void run () override;
+    gboolean commit () override;
+
+    sixtp_sax_events events;
+    gxpf_data* gdata;
+    std::string tag;
+    trans_record rec;
+};
+
+void
+trans_job::run ()
+{
+    trans_sax_reader reader {rec};
+
+    events.replay (reader);
+    reader.finish ();
+    events.clear ();
+}
+
+gboolean
+trans_job::commit ()
+{
+    auto book = static_cast<QofBook*> (gdata->bookdata);
+    auto trn = trans_record_commit (rec, book);
+
+    if (trn != NULL)
+        gdata->cb (tag.c_str (), gdata->parsedata, trn);
+
+    return trn != NULL;
+}
+
+static gboolean
+gnc_transaction_start_handler (GSList* sibling_data, gpointer parent_data,
+                               gpointer global_data,
+                               gpointer* data_for_children, gpointer* result,
+                               const gchar* tag, gchar** attrs)
+{
+    gxpf_data* gdata = (gxpf_data*)global_data;
+    QofBook* book = static_cast<QofBook*> (gdata->bookdata);
+
+    g_return_val_if_fail (book, FALSE);
+
+    sixtp_sax_state* state = new trans_sax_data;
+    *data_for_children = state;
+    *result = NULL;
+    return TRUE;
+}
+
+static gboolean
+gnc_transaction_sax_end_handler (gpointer data_for_children,
+                                 GSList* data_from_children,
+                                 GSList* sibling_data,
+                                 gpointer parent_data, gpointer global_data,
+                                 gpointer* result, const gchar* tag)
+{
+    auto state = static_cast<sixtp_sax_state*> (data_for_children);
+    gxpf_data* gdata = (gxpf_data*)global_data;
+
+    /* Called once more with a NULL tag when this is the top parser. */
+    if (!tag)
+    {
+        return TRUE;
+    }
+
+    g_return_val_if_fail (state, FALSE);
+
+    auto pdata = static_cast<trans_sax_data*> (state);
+    auto job = new trans_job {std::move (pdata->events), gdata, tag};
+    delete pdata;
+
+    return sixtp_queue_job (job);
+}
+
+sixtp*
+gnc_transaction_sixtp_parser_create (void)
+{
+    return sixtp_sax_parser_new ("gnc:transaction",
+                                 gnc_transaction_start_handler,
+                                 gnc_transaction_sax_end_handler,
+                                 NULL, NULL);
+}
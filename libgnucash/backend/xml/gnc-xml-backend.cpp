@@ -35,9 +35,11 @@ extern "C"
 #include <gnc-uri-utils.h>
 #include <TransLog.h>
 #include <gnc-prefs.h>
+#include <Transaction.h>
 
 }
 
+#include <algorithm>
 #include <sstream>
 
 #include "gnc-xml-backend.hpp"
@@ -47,6 +49,9 @@ extern "C"
 
 #define XML_URI_PREFIX "xml://"
 #define FILE_URI_PREFIX "file://"
+/* First line of a journal: the size and mtime of the data file it goes with */
+#define JOURNAL_HEADER "<!-- gnc-journal data-size=%" G_GINT64_MODIFIER "d data-mtime=%" G_GINT64_MODIFIER "d -->"
+#define JOURNAL_ENTRY_END "</gnc:journal-entry>\n"
 static QofLogModule log_module = GNC_MOD_BACKEND;
 
 GncXmlBackend::~GncXmlBackend()
@@ -161,6 +166,18 @@ GncXmlBackend::session_end()
         return;
     }
 
+    /* Leave a data file that's complete on its own.  Only when the book
+     * hasn't changed since the last save, though, or this would save
+     * changes the user chose not to, and not from a read-only session. */
+    if (m_book && m_journal_ok && !m_lockfile.empty() &&
+        qof_book_get_backend (m_book) == this &&
+        !qof_book_session_not_saved (m_book) &&
+        g_file_test (journal_path().c_str(), G_FILE_TEST_EXISTS))
+    {
+        if (write_to_file (true))
+            g_unlink (journal_path().c_str());
+    }
+
     if (!m_linkfile.empty())
         g_unlink (m_linkfile.c_str());
 
@@ -190,6 +207,7 @@ GncXmlBackend::session_end()
     m_fullpath.clear();
     m_lockfile.clear();
     m_linkfile.clear();
+    reset_journal (false);
 }
 
 static QofBookFileType
@@ -243,6 +261,8 @@ GncXmlBackend::load(QofBook* book, QofBackendLoadType loadType)
             PWARN ("Syntax error in Xml File %s", m_fullpath.c_str());
             error = ERR_FILEIO_PARSE_ERROR;
         }
+        else if (!replay_journal ())
+            error = ERR_FILEIO_PARSE_ERROR;
         break;
 
     case GNC_BOOK_XML2_FILE_NO_ENCODING:
@@ -291,6 +311,7 @@ GncXmlBackend::load(QofBook* book, QofBackendLoadType loadType)
 
     /* We just got done loading, it can't possibly be dirty !! */
     qof_book_mark_session_saved (book);
+    reset_journal (error == ERR_BACKEND_NO_ERR && !check_error());
 }
 
 void
@@ -312,17 +333,153 @@ GncXmlBackend::sync(QofBook* book)
         return;
     }
 
-    write_to_file (true);
+    if (gnc_prefs_get_file_save_journaled () && append_journal ())
+        return;
+
+    if (write_to_file (true))
+    {
+        g_unlink (journal_path().c_str());
+        reset_journal (true);
+    }
     remove_old_files();
 }
 
 void
 GncXmlBackend::commit(QofInstance* instance)
 {
+    if (m_journal_ok &&
+        (qof_instance_is_dirty(instance) || qof_instance_get_destroying(instance)))
+    {
+        /* Splits are written with their transaction, which is committed
+         * too when one is moved to another. */
+        if (GNC_IS_SPLIT (instance))
+        {
+            auto trans = xaccSplitGetParent (GNC_SPLIT (instance));
+            if (trans)
+                m_journal_trans.push_back (*qof_instance_get_guid (trans));
+        }
+        else if (GNC_IS_TRANSACTION (instance))
+            m_journal_trans.push_back (*qof_instance_get_guid (instance));
+        else
+            m_journal_full = true;
+    }
     if (qof_instance_is_dirty(instance))
         qof_instance_mark_clean(instance);
 }
 
+void
+GncXmlBackend::reset_journal (bool file_matches_book)
+{
+    m_journal_trans.clear();
+    m_journal_full = false;
+    m_journal_ok = file_matches_book;
+}
+
+/* Append the transactions changed since the last save to the journal
+ * instead of rewriting the file.  Anything else having changed, or the
+ * journal having grown to a quarter of the file's size, calls for a full
+ * save instead. */
+bool
+GncXmlBackend::append_journal ()
+{
+    if (!m_journal_ok || m_journal_full || m_journal_trans.empty())
+        return false;
+
+    GStatBuf data_stat, journal_stat;
+    if (g_stat (m_fullpath.c_str(), &data_stat) != 0)
+        return false;
+
+    auto journal = journal_path();
+    auto have_journal = g_stat (journal.c_str(), &journal_stat) == 0;
+    if (have_journal && journal_stat.st_size * 4 > data_stat.st_size)
+        return false;
+
+    std::sort (m_journal_trans.begin(), m_journal_trans.end(),
+               [](const GncGUID& a, const GncGUID& b)
+               { return guid_compare (&a, &b) < 0; });
+    m_journal_trans.erase (std::unique (m_journal_trans.begin(),
+                                        m_journal_trans.end(),
+                                        [](const GncGUID& a, const GncGUID& b)
+                                        { return guid_equal (&a, &b); }),
+                           m_journal_trans.end());
+
+    auto out = g_fopen (journal.c_str(), "ab");
+    if (out == nullptr)
+    {
+        PWARN ("Unable to open the journal %s: %s", journal.c_str(),
+               g_strerror (errno) ? g_strerror (errno) : "");
+        return false;
+    }
+
+    auto ok = have_journal ||
+        fprintf (out, JOURNAL_HEADER "\n", (gint64) data_stat.st_size,
+                 (gint64) data_stat.st_mtime) > 0;
+    ok = ok && gnc_book_write_xml_journal_entry_v2 (m_book, out,
+                                                    m_journal_trans);
+    if (fclose (out) != 0)
+        ok = false;
+    if (!ok)
+    {
+        /* An incomplete entry is ignored when the journal is replayed, and
+         * the full save that follows removes it anyway. */
+        PWARN ("Unable to write the journal %s", journal.c_str());
+        return false;
+    }
+
+    m_journal_trans.clear();
+    qof_book_mark_session_saved (m_book);
+    return true;
+}
+
+/* Apply the journal, if the data file has one, to the book just loaded from
+ * it.  A journal left by a crash after a full save ends on an older data
+ * file; it is moved aside rather than applied. */
+bool
+GncXmlBackend::replay_journal ()
+{
+    auto journal = journal_path();
+    if (!g_file_test (journal.c_str(), G_FILE_TEST_EXISTS))
+        return true;
+
+    gchar* contents = nullptr;
+    gsize length = 0;
+    if (!g_file_get_contents (journal.c_str(), &contents, &length, nullptr))
+    {
+        PWARN ("Unable to read the journal %s", journal.c_str());
+        return false;
+    }
+
+    gint64 size = -1, mtime = -1;
+    GStatBuf data_stat;
+    if (sscanf (contents, JOURNAL_HEADER, &size, &mtime) != 2 ||
+        g_stat (m_fullpath.c_str(), &data_stat) != 0 ||
+        size != (gint64) data_stat.st_size || mtime != (gint64) data_stat.st_mtime)
+    {
+        auto orphan = journal + ".orphan";
+        PWARN ("The journal %s doesn't belong to %s, moving it to %s",
+               journal.c_str(), m_fullpath.c_str(), orphan.c_str());
+        g_unlink (orphan.c_str());
+        g_rename (journal.c_str(), orphan.c_str());
+        g_free (contents);
+        return true;
+    }
+
+    /* Skip the header and whatever an interrupted save left after the last
+     * complete entry. */
+    auto ok = true;
+    auto start = strchr (contents, '\n');
+    auto end = g_strrstr (contents, JOURNAL_ENTRY_END);
+    if (start && end && end > start)
+    {
+        end += strlen (JOURNAL_ENTRY_END);
+        ok = gnc_book_replay_xml_journal_v2 (m_book, start + 1, end - start - 1);
+        if (!ok)
+            PWARN ("Syntax error in the journal %s", journal.c_str());
+    }
+    g_free (contents);
+    return ok;
+}
+
 bool
 GncXmlBackend::save_may_clobber_data()
 {
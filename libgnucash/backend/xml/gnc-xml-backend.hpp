@@ -24,6 +24,7 @@ extern "C"
 }
 
 #include <string>
+#include <vector>
 #include <qof-backend.hpp>
 
 class GncXmlBackend : public QofBackend
@@ -56,6 +57,10 @@ private:
     void remove_old_files();
     void write_accounts(QofBook* book);
     bool check_path(const char* fullpath, bool create);
+    std::string journal_path() const { return m_fullpath + ".journal"; }
+    bool append_journal();
+    bool replay_journal();
+    void reset_journal(bool file_matches_book);
 
     std::string m_dirname;
     std::string m_lockfile;
@@ -63,5 +68,12 @@ private:
     int m_lockfd = -1;
 
     QofBook* m_book = nullptr;  /* The primary, main open book */
+
+    /* Journaled saves: the transactions committed since the last save, and
+     * whether anything else was.  m_journal_ok is set once the file (with
+     * its journal) holds the book as it was at the last save. */
+    std::vector<GncGUID> m_journal_trans;
+    bool m_journal_full = false;
+    bool m_journal_ok = false;
 };
 #endif // __GNC_XML_BACKEND_HPP__
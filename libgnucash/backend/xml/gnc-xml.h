@@ -36,6 +36,8 @@ extern "C"
 #include "gnc-xml-helper.h"
 #include "sixtp.h"
 
+class sixtp_xml_writer;
+
 xmlNodePtr gnc_account_dom_tree_create (Account* act, gboolean exporting,
                                         gboolean allow_incompat);
 sixtp* gnc_account_sixtp_parser_create (void);
@@ -63,7 +65,12 @@ xmlNodePtr gnc_budget_dom_tree_create (GncBudget* bgt);
 sixtp* gnc_budget_sixtp_parser_create (void);
 
 xmlNodePtr gnc_transaction_dom_tree_create (Transaction* txn);
+/* Writes the same text as xmlElemDump of gnc_transaction_dom_tree_create,
+   followed by a newline. */
+void gnc_transaction_write (sixtp_xml_writer& writer, Transaction* txn);
 sixtp* gnc_transaction_sixtp_parser_create (void);
+/* The DOM based parser gnc_transaction_sixtp_parser_create used to return */
+sixtp* gnc_transaction_dom_sixtp_parser_create (void);
 
 sixtp* gnc_template_transaction_sixtp_parser_create (void);
 
@@ -48,6 +48,7 @@ extern "C"
 #include <errno.h>
 
 #include "gnc-engine.h"
+#include "AccountP.h"
 #include "gnc-pricedb-p.h"
 #include "Scrub.h"
 #include "SX-book.h"
@@ -55,6 +56,7 @@ extern "C"
 #include "Transaction.h"
 #include "TransactionP.h"
 #include "TransLog.h"
+#include "gnc-prefs.h"
 #if PLATFORM(WINDOWS)
 #ifdef __STRICT_ANSI_UNSET__
 #undef __STRICT_ANSI_UNSET__
@@ -73,9 +75,13 @@ extern "C"
 #include "gnc-xml.h"
 #include "io-utils.h"
 #include "sixtp-dom-parsers.h"
+#include "sixtp-xml-writer.hpp"
 #include "io-gncxml-v2.h"
 #include "io-gncxml-gen.h"
 
+#include <deque>
+#include <string>
+
 /* Do not treat -Wstrict-aliasing warnings as errors because of problems of the
  * G_LOCK* macros as declared by glib.  See
  * https://bugs.gnucash.org/show_bug.cgi?id=316221 for additional information.
@@ -96,6 +102,7 @@ typedef struct
     gchar* filename;
     gchar* perms;
     gboolean write;
+    gint level;
 } gz_thread_params_t;
 
 /* Callback structure */
@@ -546,6 +553,9 @@ static const char* TRANSACTION_TAG = "gnc:transaction";
 static const char* SCHEDXACTION_TAG = "gnc:schedxaction";
 static const char* TEMPLATE_TRANSACTION_TAG = "gnc:template-transactions";
 static const char* BUDGET_TAG = "gnc:budget";
+static const char* JOURNAL_TAG = "gnc-journal";
+static const char* JOURNAL_ENTRY_TAG = "gnc:journal-entry";
+static const char* JOURNAL_REMOVE_TAG = "gnc:journal-remove";
 
 static void
 add_item (const GncXmlDataType_t& data, struct file_backend* be_data)
@@ -707,6 +717,7 @@ qof_session_load_from_xml_file_v2_full (
     struct file_backend be_data;
     gboolean retval;
     char* v2type = NULL;
+    GTimer* timer;
 
     gd = gnc_sixtp_gdv2_new (book, FALSE, file_rw_feedback,
                              xml_be->get_percentage());
@@ -776,6 +787,7 @@ qof_session_load_from_xml_file_v2_full (
     xaccLogDisable ();
     xaccDisableDataScrubbing ();
 
+    timer = g_timer_new ();
     if (push_handler)
     {
         gpointer parse_result = NULL;
@@ -815,6 +827,11 @@ qof_session_load_from_xml_file_v2_full (
         }
     }
 
+    PINFO ("Parsed %d transactions and %d prices in %.3f seconds",
+           gd->counter.transactions_loaded, gd->counter.prices_loaded,
+           g_timer_elapsed (timer, NULL));
+    g_timer_destroy (timer);
+
     if (!retval)
     {
         sixtp_destroy (top_parser);
@@ -849,10 +866,15 @@ qof_session_load_from_xml_file_v2_full (
     /* Fix split amount/value */
     xaccAccountTreeScrubSplits (root);
 
+    /* Sort and balance every account in parallel while they are still
+     * open for editing, which leaves nothing for the commits to do. */
+    template_root = gnc_book_get_template_root (book);
+    gnc_account_tree_sort_and_recompute (root);
+    gnc_account_tree_sort_and_recompute (template_root);
+
     /* commit all groups, this completes the BeginEdit started when the
      * account_end_handler finished reading the account.
      */
-    template_root = gnc_book_get_template_root (book);
     gnc_account_foreach_descendant (root,
                                     (AccountCb) xaccAccountCommitEdit,
                                     NULL);
@@ -882,6 +904,113 @@ qof_session_load_from_xml_file_v2 (GncXmlBackend* xml_be, QofBook* book,
     return qof_session_load_from_xml_file_v2_full (xml_be, book, NULL, NULL, type);
 }
 
+/* A journal entry lists the transactions changed since the previous entry
+ * (or the data file).  Each one is removed from the book, then the ones
+ * still present are added back in their new state. */
+static gboolean
+journal_remove_end_handler (gpointer data_for_children,
+                            GSList* data_from_children, GSList* sibling_data,
+                            gpointer parent_data, gpointer global_data,
+                            gpointer* result, const gchar* tag)
+{
+    xmlNodePtr tree = (xmlNodePtr)data_for_children;
+    gxpf_data* gdata = (gxpf_data*)global_data;
+
+    g_return_val_if_fail (tree, FALSE);
+
+    auto guid = dom_tree_to_guid (tree);
+    xmlFreeNode (tree);
+    if (!guid)
+        return FALSE;
+
+    auto trn = xaccTransLookup (guid, static_cast<QofBook*> (gdata->bookdata));
+    guid_free (guid);
+    if (trn)
+    {
+        /* Not xaccTransDestroy: the change was saved, so replay it even if
+         * the transaction has since become read-only. */
+        xaccTransBeginEdit (trn);
+        qof_instance_set_destroying (trn, TRUE);
+        xaccTransCommitEdit (trn);
+    }
+    return TRUE;
+}
+
+static gboolean
+journal_callback (const char* tag, gpointer globaldata, gpointer data)
+{
+    if (g_strcmp0 (tag, TRANSACTION_TAG) == 0)
+        add_transaction_local ((sixtp_gdv2*)globaldata, (Transaction*)data);
+    return TRUE;
+}
+
+gboolean
+gnc_book_replay_xml_journal_v2 (QofBook* book, const char* entries,
+                                gsize length)
+{
+    sixtp* top_parser;
+    sixtp* journal_parser;
+    sixtp* entry_parser;
+    sixtp_gdv2* gd;
+    gboolean retval = FALSE;
+    std::string buffer;
+
+    top_parser = sixtp_new ();
+    journal_parser = sixtp_new ();
+    entry_parser = sixtp_new ();
+
+    if (!sixtp_add_some_sub_parsers (
+            top_parser, TRUE,
+            JOURNAL_TAG, journal_parser,
+            NULL, NULL)
+        || !sixtp_add_some_sub_parsers (
+            journal_parser, TRUE,
+            JOURNAL_ENTRY_TAG, entry_parser,
+            NULL, NULL)
+        || !sixtp_add_some_sub_parsers (
+            entry_parser, TRUE,
+            JOURNAL_REMOVE_TAG, sixtp_dom_parser_new (journal_remove_end_handler,
+                                                      NULL, NULL),
+            TRANSACTION_TAG, gnc_transaction_sixtp_parser_create (),
+            NULL, NULL))
+    {
+        sixtp_destroy (top_parser);
+        return FALSE;
+    }
+
+    /* The entries are appended one after the other, so they need an
+     * enclosing element to be a document. */
+    buffer.reserve (length + 32);
+    buffer.append ("<").append (JOURNAL_TAG).append (">\n");
+    buffer.append (entries, length);
+    buffer.append ("</").append (JOURNAL_TAG).append (">\n");
+
+    gd = gnc_sixtp_gdv2_new (book, FALSE, file_rw_feedback, NULL);
+
+    xaccLogDisable ();
+    xaccDisableDataScrubbing ();
+    {
+        gpointer parse_result = NULL;
+        gxpf_data gpdata;
+
+        gpdata.cb = journal_callback;
+        gpdata.parsedata = gd;
+        gpdata.bookdata = book;
+
+        retval = sixtp_parse_buffer (top_parser, &buffer[0], buffer.size (),
+                                     NULL, &gpdata, &parse_result);
+    }
+    xaccEnableDataScrubbing ();
+    xaccLogEnable ();
+
+    PINFO ("Replayed %d transactions from the journal",
+           gd->counter.transactions_loaded);
+
+    sixtp_destroy (top_parser);
+    g_free (gd);
+    return retval;
+}
+
 /***********************************************************************/
 
 static gboolean
@@ -1161,14 +1290,11 @@ static int
 xml_add_trn_data (Transaction* t, gpointer data)
 {
     struct file_backend* be_data = static_cast<decltype (be_data)> (data);
-    xmlNodePtr node;
-
-    node = gnc_transaction_dom_tree_create (t);
+    auto writer = static_cast<sixtp_xml_writer*> (be_data->data);
 
-    xmlElemDump (be_data->out, NULL, node);
-    xmlFreeNode (node);
+    gnc_transaction_write (*writer, t);
 
-    if (ferror (be_data->out) || fprintf (be_data->out, "\n") < 0)
+    if (ferror (be_data->out))
         return -1;
 
     be_data->gd->counter.transactions_loaded++;
@@ -1180,13 +1306,16 @@ static gboolean
 write_transactions (FILE* out, QofBook* book, sixtp_gdv2* gd)
 {
     struct file_backend be_data;
+    sixtp_xml_writer writer (out);
+    gint ret;
 
     be_data.out = out;
     be_data.gd = gd;
-    return 0 ==
-           xaccAccountTreeForEachTransaction (gnc_book_get_root_account (book),
-                                              xml_add_trn_data,
-                                              (gpointer) &be_data);
+    be_data.data = &writer;
+    ret = xaccAccountTreeForEachTransaction (gnc_book_get_root_account (book),
+                                             xml_add_trn_data,
+                                             (gpointer) &be_data);
+    return writer.flush () && ret == 0;
 }
 
 static gboolean
@@ -1194,9 +1323,11 @@ write_template_transaction_data (FILE* out, QofBook* book, sixtp_gdv2* gd)
 {
     Account* ra;
     struct file_backend be_data;
+    sixtp_xml_writer writer (out);
 
     be_data.out = out;
     be_data.gd = gd;
+    be_data.data = &writer;
 
     ra = gnc_book_get_template_root (book);
     if (gnc_account_n_descendants (ra) > 0)
@@ -1204,6 +1335,7 @@ write_template_transaction_data (FILE* out, QofBook* book, sixtp_gdv2* gd)
         if (fprintf (out, "<%s>\n", TEMPLATE_TRANSACTION_TAG) < 0
             || !write_account_tree (out, ra, gd)
             || xaccAccountTreeForEachTransaction (ra, xml_add_trn_data, (gpointer)&be_data)
+            || !writer.flush ()
             || fprintf (out, "</%s>\n", TEMPLATE_TRANSACTION_TAG) < 0)
 
             return FALSE;
@@ -1389,17 +1521,235 @@ gnc_book_write_accounts_to_xml_filehandle_v2 (QofBackend* qof_be, QofBook* book,
 
 #define BUFLEN 4096
 
+/* Saving compresses the data in blocks of GZ_BLOCK_SIZE, each deflated on
+ * its own by a thread pool with the last GZ_DICT_SIZE bytes of the block
+ * before as dictionary, so little is lost against a single deflate stream.
+ * Every block ends with a sync flush, which leaves it on a byte boundary,
+ * so the blocks simply concatenate into one ordinary gzip member. */
+#define GZ_BLOCK_SIZE (128 * 1024)
+#define GZ_DICT_SIZE (32 * 1024)
+#ifdef G_OS_WIN32
+#define GZ_OS_CODE 10
+#else
+#define GZ_OS_CODE 3
+#endif
+
+struct gz_block
+{
+    gz_block (gint lvl) : level{lvl}
+    {
+        g_mutex_init (&mutex);
+        g_cond_init (&cond);
+    }
+    ~gz_block ()
+    {
+        g_mutex_clear (&mutex);
+        g_cond_clear (&cond);
+    }
+
+    gint level;
+    std::string dict;
+    std::string in;
+    std::string out;
+    uLong crc = 0;
+    gboolean ok = FALSE;
+    gboolean done = FALSE;
+    GMutex mutex;
+    GCond cond;
+};
+
+static void
+gz_compress_block (gpointer data, gpointer user_data)
+{
+    auto block = static_cast<gz_block*> (data);
+    z_stream strm{};
+    gint ret;
+
+    ret = deflateInit2 (&strm, block->level, Z_DEFLATED, -MAX_WBITS, 8,
+                        Z_DEFAULT_STRATEGY);
+    if (ret == Z_OK && !block->dict.empty ())
+        ret = deflateSetDictionary (&strm, (const Bytef*) block->dict.data (),
+                                    block->dict.size ());
+    if (ret == Z_OK)
+    {
+        size_t have = 0;
+
+        strm.next_in = (Bytef*) block->in.data ();
+        strm.avail_in = block->in.size ();
+        /* A sync flush appends a few bytes more than deflateBound allows
+         * for; the loop grows the buffer if it needs to. */
+        block->out.resize (deflateBound (&strm, block->in.size ()) + 16);
+        do
+        {
+            if (have == block->out.size ())
+                block->out.resize (2 * have);
+            strm.next_out = (Bytef*) &block->out[have];
+            strm.avail_out = block->out.size () - have;
+            ret = deflate (&strm, Z_SYNC_FLUSH);
+            have = block->out.size () - strm.avail_out;
+        }
+        while (ret == Z_OK && strm.avail_out == 0);
+        /* When the flush exactly filled the buffer the call after it has
+         * nothing left to do and reports that as Z_BUF_ERROR. */
+        if (ret == Z_BUF_ERROR && strm.avail_in == 0)
+            ret = Z_OK;
+        block->out.resize (have);
+        deflateEnd (&strm);
+    }
+    block->crc = crc32 (crc32 (0L, Z_NULL, 0), (const Bytef*) block->in.data (),
+                        block->in.size ());
+
+    g_mutex_lock (&block->mutex);
+    block->ok = (ret == Z_OK);
+    block->done = TRUE;
+    g_cond_signal (&block->cond);
+    g_mutex_unlock (&block->mutex);
+}
+
+static void
+gz_put_le32 (std::string& out, uLong value)
+{
+    for (int i = 0; i < 4; ++i)
+        out += static_cast<char> ((value >> (8 * i)) & 0xff);
+}
+
+/* Read the pipe until EOF and write it gzipped to params->filename.
+ * Returns 1 on success or 0 otherwise. */
+static gint
+gz_write_blocks (gz_thread_params_t* params)
+{
+    static const char header[] = { '\x1f', '\x8b', Z_DEFLATED, 0, 0, 0, 0, 0,
+                                   0, GZ_OS_CODE };
+    /* A final fixed Huffman block holding just its end code. */
+    static const char last_block[] = { 3, 0 };
+    auto n_threads = MAX (g_get_num_processors (), 1);
+    std::deque<gz_block*> pending;
+    std::string dict, trailer;
+    uLong crc = crc32 (0L, Z_NULL, 0);
+    uLong total = 0;
+    gboolean eof = FALSE;
+    gint success = 1;
+
+    FILE* file = g_fopen (params->filename, "wb");
+    if (file == NULL)
+    {
+        g_warning ("Could not open the compressed file '%s'. The error is '%s' (errno %d)",
+                   params->filename, g_strerror (errno) ? g_strerror (errno) : "", errno);
+        return 0;
+    }
+
+    auto pool = g_thread_pool_new (gz_compress_block, NULL, n_threads, FALSE,
+                                   NULL);
+    fwrite (header, 1, sizeof (header), file);
+
+    while (success)
+    {
+        /* Keep every thread busy with one block and one more queued. */
+        while (success && !eof && pending.size () < 2 * (size_t) n_threads)
+        {
+            auto block = new gz_block (params->level);
+            size_t have = 0;
+
+            block->in.resize (GZ_BLOCK_SIZE);
+            while (have < GZ_BLOCK_SIZE)
+            {
+                auto bytes = read (params->fd, &block->in[have],
+                                   GZ_BLOCK_SIZE - have);
+                if (bytes > 0)
+                    have += bytes;
+                else if (bytes == 0)
+                {
+                    eof = TRUE;
+                    break;
+                }
+                else if (errno != EINTR)
+                {
+                    g_warning ("Could not read from pipe. The error is '%s' (errno %d)",
+                               g_strerror (errno) ? g_strerror (errno) : "", errno);
+                    success = 0;
+                    break;
+                }
+            }
+            block->in.resize (have);
+            if (!success || have == 0)
+            {
+                delete block;
+                break;
+            }
+
+            block->dict.swap (dict);
+            dict.assign (block->in, have > GZ_DICT_SIZE ? have - GZ_DICT_SIZE : 0,
+                         GZ_DICT_SIZE);
+            pending.push_back (block);
+            g_thread_pool_push (pool, block, NULL);
+        }
+
+        if (!success || pending.empty ())
+            break;
+
+        auto block = pending.front ();
+        pending.pop_front ();
+        g_mutex_lock (&block->mutex);
+        while (!block->done)
+            g_cond_wait (&block->cond, &block->mutex);
+        g_mutex_unlock (&block->mutex);
+
+        if (!block->ok)
+        {
+            g_warning ("Could not compress the data for '%s'", params->filename);
+            success = 0;
+        }
+        else if (fwrite (block->out.data (), 1, block->out.size (), file)
+                 != block->out.size ())
+        {
+            g_warning ("Could not write the compressed file '%s'. The error is '%s' (errno %d)",
+                       params->filename, g_strerror (errno) ? g_strerror (errno) : "", errno);
+            success = 0;
+        }
+        crc = crc32_combine (crc, block->crc, block->in.size ());
+        total += block->in.size ();
+        delete block;
+    }
+
+    /* Let the pool finish whatever is still queued before freeing it. */
+    g_thread_pool_free (pool, FALSE, TRUE);
+    for (auto block : pending)
+        delete block;
+
+    if (success)
+    {
+        trailer.assign (last_block, sizeof (last_block));
+        gz_put_le32 (trailer, crc);
+        gz_put_le32 (trailer, total);
+        if (fwrite (trailer.data (), 1, trailer.size (), file) != trailer.size ())
+            success = 0;
+    }
+
+    if (fclose (file) != 0 || !success)
+    {
+        g_warning ("Could not write the compressed file '%s'", params->filename);
+        success = 0;
+    }
+
+    return success;
+}
+
 /* Compress or decompress function that is to be run in a separate thread.
  * Returns 1 on success or 0 otherwise, stuffed into a pointer type. */
 static gpointer
 gz_thread_func (gz_thread_params_t* params)
 {
     gchar buffer[BUFLEN];
-    gssize bytes;
     gint gzval;
     gzFile file;
     gint success = 1;
 
+    if (params->write)
+    {
+        success = gz_write_blocks (params);
+        goto cleanup_gz_thread_func;
+    }
+
 #ifdef G_OS_WIN32
     {
         gchar* conv_name = g_win32_locale_filename_from_utf8 (params->filename);
@@ -1433,68 +1783,36 @@ gz_thread_func (gz_thread_params_t* params)
         goto cleanup_gz_thread_func;
     }
 
-    if (params->write)
+    while (success)
     {
-        while (success)
+        gzval = gzread (file, buffer, BUFLEN);
+        if (gzval > 0)
         {
-            bytes = read (params->fd, buffer, BUFLEN);
-            if (bytes > 0)
-            {
-                if (gzwrite (file, buffer, bytes) <= 0)
-                {
-                    gint errnum;
-                    const gchar* error = gzerror (file, &errnum);
-                    g_warning ("Could not write the compressed file '%s'. The error is: '%s' (%d)",
-                               params->filename, error, errnum);
-                    success = 0;
-                }
-            }
-            else if (bytes == 0)
-            {
-                printf("gz_thread_func EOF\n");
-                break;
-            }
-            else
-            {
-                g_warning ("Could not read from pipe. The error is '%s' (errno %d)",
-                           g_strerror (errno) ? g_strerror (errno) : "", errno);
-                success = 0;
-            }
-        }
-    }
-    else
-    {
-        while (success)
-        {
-            gzval = gzread (file, buffer, BUFLEN);
-            if (gzval > 0)
-            {
-                if (
+            if (
 #if COMPILER(MSVC)
-                    _write
+                _write
 #else
-                    write
+                write
 #endif
-                    (params->fd, buffer, gzval) < 0)
-                {
-                    g_warning ("Could not write to pipe. The error is '%s' (%d)",
-                               g_strerror (errno) ? g_strerror (errno) : "", errno);
-                    success = 0;
-                }
-            }
-            else if (gzval == 0)
-            {
-                break;
-            }
-            else
+                (params->fd, buffer, gzval) < 0)
             {
-                gint errnum;
-                const gchar* error = gzerror (file, &errnum);
-                g_warning ("Could not read from compressed file '%s'. The error is: '%s' (%d)",
-                           params->filename, error, errnum);
+                g_warning ("Could not write to pipe. The error is '%s' (%d)",
+                           g_strerror (errno) ? g_strerror (errno) : "", errno);
                 success = 0;
             }
         }
+        else if (gzval == 0)
+        {
+            break;
+        }
+        else
+        {
+            gint errnum;
+            const gchar* error = gzerror (file, &errnum);
+            g_warning ("Could not read from compressed file '%s'. The error is: '%s' (%d)",
+                       params->filename, error, errnum);
+            success = 0;
+        }
     }
 
     if ((gzval = gzclose (file)) != Z_OK)
@@ -1558,6 +1876,7 @@ try_gz_open (const char* filename, const char* perms, gboolean compress,
         params->filename = g_strdup (filename);
         params->perms = g_strdup (perms);
         params->write = write;
+        params->level = gnc_prefs_get_file_compression_level ();
 
         thread = g_thread_new ("xml_thread", (GThreadFunc) gz_thread_func,
                                params);
@@ -1638,6 +1957,25 @@ gnc_book_write_to_xml_file_v2 (
     return success;
 }
 
+gboolean
+gnc_book_write_xml_journal_entry_v2 (QofBook* book, FILE* out,
+                                     const std::vector<GncGUID>& trans_guids)
+{
+    sixtp_xml_writer writer (out);
+
+    writer.start_element (JOURNAL_ENTRY_TAG);
+    for (const auto& guid : trans_guids)
+    {
+        writer.guid_element (JOURNAL_REMOVE_TAG, &guid);
+        auto trn = xaccTransLookup (&guid, book);
+        if (trn)
+            gnc_transaction_write (writer, trn);
+    }
+    writer.end_element ();
+
+    return writer.flush ();
+}
+
 /*
  * Have to pass in the backend as this routine needs the temporary
  * backend for file export, not the real backend which could be
@@ -93,6 +93,14 @@ gboolean gnc_book_write_to_xml_filehandle_v2 (QofBook* book, FILE* fh);
 gboolean gnc_book_write_to_xml_file_v2 (QofBook* book, const char* filename,
                                         gboolean compress);
 
+/** Journaled saves: append one entry holding the current state of the
+ * given transactions (an absent one was deleted) to a journal, or replay
+ * the complete entries of a journal into a freshly loaded book. */
+gboolean gnc_book_write_xml_journal_entry_v2 (QofBook* book, FILE* out,
+                                              const std::vector<GncGUID>& trans_guids);
+gboolean gnc_book_replay_xml_journal_v2 (QofBook* book, const char* entries,
+                                         gsize length);
+
 /** write just the commodities and accounts to a file */
 gboolean gnc_book_write_accounts_to_xml_filehandle_v2 (QofBackend* be,
                                                        QofBook* book, FILE* fh);
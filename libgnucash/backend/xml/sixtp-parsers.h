@@ -35,4 +35,16 @@ sixtp* sixtp_dom_parser_new (sixtp_end_handler ender,
                              sixtp_result_handler cleanup_result_by_default_func,
                              sixtp_result_handler cleanup_result_on_fail_func);
 
+/* Create a parser that hands the entire sub-tree, element by element, to
+   the sixtp_sax_state (see sixtp-sax-parser.hpp) that starter leaves in
+   *data_for_children instead of building a DOM tree.  ender gets the
+   state back in data_for_children and must delete it.  The parser also
+   accepts tag as its own child so that it can be the top of a parse.
+*/
+sixtp* sixtp_sax_parser_new (const gchar* tag,
+                             sixtp_start_handler starter,
+                             sixtp_end_handler ender,
+                             sixtp_result_handler cleanup_result_by_default_func,
+                             sixtp_result_handler cleanup_result_on_fail_func);
+
 #endif /* _SIXTP_PARSERS_H_ */
@@ -0,0 +1,599 @@
+/********************************************************************
+ * sixtp-sax-parser.cpp -- read engine objects from sixtp events    *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+extern "C"
+{
+#include <config.h>
+#include <stdio.h>
+#include <gnc-engine.h>
+}
+
+#include <glib.h>
+
+#include "sixtp-parsers.h"
+#include "sixtp-utils.h"
+#include "sixtp.h"
+#include "sixtp-sax-parser.hpp"
+#include <kvp-frame.hpp>
+
+static QofLogModule log_module = GNC_MOD_IO;
+
+/* The elements below the top-level one all share the state it
+   created, so their handlers only have to keep the path and the text
+   and pass the events on. */
+void
+sixtp_sax_state::open (const gchar* tag, gchar** attrs)
+{
+    if (depth == path.size ())
+        path.emplace_back (tag);
+    else
+        path[depth].assign (tag);
+    depth++;
+    text.clear ();
+    element_start (tag, attrs);
+}
+
+void
+sixtp_sax_state::close (const gchar* tag, const gchar* element_text)
+{
+    element_end (tag, element_text);
+    text.clear ();
+    depth--;
+}
+
+static gboolean
+sax_element_start_handler (GSList* sibling_data, gpointer parent_data,
+                           gpointer global_data, gpointer* data_for_children,
+                           gpointer* result, const gchar* tag, gchar** attrs)
+{
+    auto state = static_cast<sixtp_sax_state*> (parent_data);
+
+    g_return_val_if_fail (state, FALSE);
+
+    state->open (tag, attrs);
+
+    *data_for_children = state;
+    *result = NULL;
+    return TRUE;
+}
+
+static gboolean
+sax_chars_handler (GSList* sibling_data, gpointer parent_data,
+                   gpointer global_data, gpointer* result,
+                   const char* text, int length)
+{
+    auto state = static_cast<sixtp_sax_state*> (parent_data);
+
+    if (state && length > 0)
+        state->text.append (text, length);
+    return TRUE;
+}
+
+static gboolean
+sax_element_end_handler (gpointer data_for_children,
+                         GSList* data_from_children, GSList* sibling_data,
+                         gpointer parent_data, gpointer global_data,
+                         gpointer* result, const gchar* tag)
+{
+    auto state = static_cast<sixtp_sax_state*> (data_for_children);
+
+    g_return_val_if_fail (state && state->depth > 0, FALSE);
+
+    state->close (tag, state->text.c_str ());
+    return TRUE;
+}
+
+static void
+sax_fail_handler (gpointer data_for_children,
+                  GSList* data_from_children,
+                  GSList* sibling_data,
+                  gpointer parent_data,
+                  gpointer global_data,
+                  gpointer* result,
+                  const gchar* tag)
+{
+    delete static_cast<sixtp_sax_state*> (data_for_children);
+}
+
+sixtp*
+sixtp_sax_parser_new (const gchar* tag,
+                      sixtp_start_handler starter,
+                      sixtp_end_handler ender,
+                      sixtp_result_handler cleanup_result_by_default_func,
+                      sixtp_result_handler cleanup_result_on_fail_func)
+{
+    sixtp* top_level;
+    sixtp* element;
+
+    g_return_val_if_fail (tag, NULL);
+    g_return_val_if_fail (starter, NULL);
+    g_return_val_if_fail (ender, NULL);
+
+    if (! (top_level =
+               sixtp_set_any (sixtp_new (), FALSE,
+                              SIXTP_START_HANDLER_ID, starter,
+                              SIXTP_CHARACTERS_HANDLER_ID, sax_chars_handler,
+                              SIXTP_END_HANDLER_ID, ender,
+                              SIXTP_FAIL_HANDLER_ID, sax_fail_handler,
+                              SIXTP_NO_MORE_HANDLERS)))
+    {
+        return NULL;
+    }
+
+    if (cleanup_result_by_default_func)
+    {
+        sixtp_set_cleanup_result (top_level, cleanup_result_by_default_func);
+    }
+
+    if (cleanup_result_on_fail_func)
+    {
+        sixtp_set_result_fail (top_level, cleanup_result_on_fail_func);
+    }
+
+    if (! (element =
+               sixtp_set_any (sixtp_new (), FALSE,
+                              SIXTP_START_HANDLER_ID, sax_element_start_handler,
+                              SIXTP_CHARACTERS_HANDLER_ID, sax_chars_handler,
+                              SIXTP_END_HANDLER_ID, sax_element_end_handler,
+                              SIXTP_NO_MORE_HANDLERS)))
+    {
+        sixtp_destroy (top_level);
+        return NULL;
+    }
+
+    if (!sixtp_add_sub_parser (element, SIXTP_MAGIC_CATCHER, element))
+    {
+        sixtp_destroy (element);
+        sixtp_destroy (top_level);
+        return NULL;
+    }
+
+    return sixtp_add_some_sub_parsers (top_level, TRUE,
+                                       SIXTP_MAGIC_CATCHER, element,
+                                       tag, top_level,
+                                       NULL, NULL);
+}
+
+/***********************************************************************/
+
+gchar**
+sixtp_sax_events::event::c_attrs (std::vector<gchar*>& buf) const
+{
+    if (attrs.empty ())
+        return NULL;
+
+    buf.clear ();
+    for (auto& attr : attrs)
+        buf.push_back (const_cast<gchar*> (attr.c_str ()));
+    buf.push_back (NULL);
+    return buf.data ();
+}
+
+void
+sixtp_sax_events::start (const gchar* tag, gchar** attrs)
+{
+    event ev {TRUE, tag};
+
+    for (auto attr = attrs; attr && *attr; attr++)
+        ev.attrs.emplace_back (*attr);
+    m_events.push_back (std::move (ev));
+}
+
+void
+sixtp_sax_events::end (const gchar* tag, const gchar* text)
+{
+    m_events.push_back (event {FALSE, tag, {}, text});
+}
+
+void
+sixtp_sax_events::replay (sixtp_sax_state& state) const
+{
+    std::vector<gchar*> attrs;
+
+    for (auto& ev : m_events)
+    {
+        if (ev.start)
+            state.open (ev.tag.c_str (), ev.c_attrs (attrs));
+        else
+            state.close (ev.tag.c_str (), ev.text.c_str ());
+    }
+}
+
+/***********************************************************************/
+
+gboolean
+sixtp_sax_guid_type (gchar** attrs)
+{
+    /* Like dom_tree_to_guid, only look at the first attribute. */
+    if (!attrs || !attrs[0])
+        return FALSE;
+
+    if (g_strcmp0 (attrs[0], "type") != 0)
+    {
+        PERR ("Unknown attribute for id tag: %s", attrs[0]);
+        return FALSE;
+    }
+
+    /* handle new and guid the same for the moment */
+    if (g_strcmp0 ("guid", attrs[1]) == 0 || g_strcmp0 ("new", attrs[1]) == 0)
+        return TRUE;
+
+    PERR ("Unknown type %s for attribute type",
+          attrs[1] ? attrs[1] : "(null)");
+    return FALSE;
+}
+
+void
+sixtp_sax_text_to_guid (const gchar* text, GncGUID* guid)
+{
+    if (!string_to_guid (text, guid))
+        *guid = guid_new_return ();
+}
+
+void
+sixtp_sax_date::reset ()
+{
+    count = 0;
+    text.clear ();
+}
+
+void
+sixtp_sax_date::add (const gchar* date_text)
+{
+    count++;
+    text.assign (date_text);
+}
+
+time64
+sixtp_sax_date::to_time64 () const
+{
+    if (count == 0)
+    {
+        PERR ("no ts:date node found.");
+        return INT64_MAX;
+    }
+
+    if (count > 1)
+        return INT64_MAX;
+
+    return gnc_iso8601_to_time64_gmt (text.c_str ());
+}
+
+gboolean
+sixtp_sax_date::to_gdate (GDate* date) const
+{
+    gint year, month, day;
+
+    if (count == 0)
+    {
+        PWARN ("no gdate node found.");
+        return FALSE;
+    }
+
+    if (count > 1 ||
+        sscanf (text.c_str (), "%d-%d-%d", &year, &month, &day) != 3)
+        return FALSE;
+
+    g_date_clear (date, 1);
+    g_date_set_dmy (date, day, static_cast<GDateMonth> (month), year);
+    if (!g_date_valid (date))
+    {
+        PWARN ("invalid date");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void
+sixtp_sax_commodity_ref::reset ()
+{
+    n_space = n_id = 0;
+    space.clear ();
+    id.clear ();
+}
+
+void
+sixtp_sax_commodity_ref::add (const gchar* tag, const gchar* text)
+{
+    if (g_strcmp0 ("cmdty:space", tag) == 0)
+    {
+        n_space++;
+        space.assign (text);
+    }
+    else if (g_strcmp0 ("cmdty:id", tag) == 0)
+    {
+        n_id++;
+        id.assign (text);
+    }
+}
+
+gnc_commodity*
+sixtp_sax_commodity_ref::lookup (QofBook* book) const
+{
+    gnc_commodity_table* table;
+    gnc_commodity* ret;
+
+    if (n_space != 1 || n_id != 1)
+    {
+        PERR ("bad commodity reference");
+        return NULL;
+    }
+
+    table = gnc_commodity_table_get_table (book);
+
+    g_return_val_if_fail (table != NULL, NULL);
+
+    auto space_str = g_strstrip (g_strdup (space.c_str ()));
+    auto id_str = g_strstrip (g_strdup (id.c_str ()));
+    ret = gnc_commodity_table_lookup (table, space_str, id_str);
+    g_free (space_str);
+    g_free (id_str);
+
+    g_return_val_if_fail (ret != NULL, NULL);
+
+    return ret;
+}
+
+void
+sixtp_sax_required::seen (const gchar* tag)
+{
+    for (guint i = 0; m_tags[i]; i++)
+    {
+        if (g_strcmp0 (tag, m_tags[i]) == 0)
+        {
+            m_seen |= 1 << i;
+            break;
+        }
+    }
+}
+
+gboolean
+sixtp_sax_required::all_seen () const
+{
+    gboolean ret = TRUE;
+
+    for (guint i = 0; m_tags[i]; i++)
+    {
+        if (! (m_seen & (1 << i)))
+        {
+            PERR ("Not defined and it should be: %s", m_tags[i]);
+            ret = FALSE;
+        }
+    }
+    return ret;
+}
+
+/***********************************************************************/
+/* slots */
+
+static void
+slot_value_free (gpointer value)
+{
+    delete static_cast<KvpValue*> (value);
+}
+
+void
+sixtp_sax_slots::begin (KvpFrame* frame)
+{
+    level top;
+
+    clear ();
+    top.kind = level::FRAME;
+    top.frame = frame;
+    m_levels.push_back (std::move (top));
+}
+
+void
+sixtp_sax_slots::read (KvpFrame* frame, const sixtp_sax_events& events)
+{
+    std::vector<gchar*> attrs;
+
+    if (events.events ().empty ())
+        return;
+
+    begin (frame);
+    for (auto& ev : events.events ())
+    {
+        if (ev.start)
+            element_start (ev.tag.c_str (), ev.c_attrs (attrs));
+        else
+            element_end (ev.text.c_str ());
+    }
+    finish ();
+}
+
+void
+sixtp_sax_slots::clear ()
+{
+    for (auto& l : m_levels)
+    {
+        if (l.kind == level::SLOT)
+        {
+            delete l.value;
+        }
+        else if (l.kind == level::VALUE)
+        {
+            delete l.frame;
+            g_list_free_full (l.list, slot_value_free);
+        }
+    }
+    m_levels.clear ();
+}
+
+void
+sixtp_sax_slots::element_start (const gchar* tag, gchar** attrs)
+{
+    level next;
+
+    g_return_if_fail (!m_levels.empty ());
+
+    /* Anything dom_tree_to_kvp_frame_given would not look at is
+       skipped, along with its children. */
+    auto& parent = m_levels.back ();
+    switch (parent.kind)
+    {
+    case level::FRAME:
+        if (g_strcmp0 (tag, "slot") == 0)
+            next.kind = level::SLOT;
+        break;
+    case level::SLOT:
+        if (g_strcmp0 (tag, "slot:key") == 0)
+            next.kind = level::KEY;
+        else if (g_strcmp0 (tag, "slot:value") == 0)
+            next.kind = level::VALUE;
+        break;
+    case level::VALUE:
+        if (parent.type == "frame" && g_strcmp0 (tag, "slot") == 0)
+            next.kind = level::SLOT;
+        else if (parent.type == "list")
+            next.kind = level::VALUE;
+        else if ((parent.type == "timespec" && g_strcmp0 (tag, "ts:date") == 0) ||
+                 (parent.type == "gdate" && g_strcmp0 (tag, "gdate") == 0))
+            next.kind = level::DATE;
+        break;
+    default:
+        break;
+    }
+
+    if (next.kind == level::VALUE)
+    {
+        for (auto attr = attrs; attr && attr[0]; attr += 2)
+        {
+            if (g_strcmp0 (attr[0], "type") == 0)
+            {
+                next.type.assign (attr[1] ? attr[1] : "");
+                break;
+            }
+        }
+        if (next.type == "frame")
+            next.frame = new KvpFrame;
+    }
+
+    m_levels.push_back (std::move (next));
+}
+
+void
+sixtp_sax_slots::element_end (const gchar* text)
+{
+    g_return_if_fail (m_levels.size () > 1);
+
+    auto done = std::move (m_levels.back ());
+    m_levels.pop_back ();
+
+    auto& parent = m_levels.back ();
+    switch (done.kind)
+    {
+    case level::KEY:
+        parent.key.assign (text);
+        parent.has_key = TRUE;
+        break;
+    case level::DATE:
+        parent.date.add (text);
+        break;
+    case level::VALUE:
+    {
+        auto value = make_value (done, text);
+        if (parent.kind == level::SLOT)
+        {
+            delete parent.value;
+            parent.value = value;
+        }
+        else if (value)
+        {
+            parent.list = g_list_prepend (parent.list, value);
+        }
+        break;
+    }
+    case level::SLOT:
+        if (done.has_key && done.value)
+        {
+            //We're deleting the old KvpValue returned by replace_nc().
+            delete parent.frame->set ({done.key}, done.value);
+        }
+        else
+        {
+            delete done.value;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/* The converters of dom_tree_to_kvp_value. */
+KvpValue*
+sixtp_sax_slots::make_value (level& value, const gchar* text)
+{
+    if (value.type == "integer")
+    {
+        gint64 daint;
+        if (string_to_gint64 (text, &daint))
+            return new KvpValue {daint};
+    }
+    else if (value.type == "double")
+    {
+        double dadoub;
+        if (string_to_double (text, &dadoub))
+            return new KvpValue {dadoub};
+    }
+    else if (value.type == "numeric")
+    {
+        gnc_numeric danum;
+        if (!string_to_gnc_numeric (text, &danum))
+            danum = gnc_numeric_zero ();
+        return new KvpValue {danum};
+    }
+    else if (value.type == "string")
+    {
+        const gchar* datext = g_strdup (text);
+        return new KvpValue {datext};
+    }
+    else if (value.type == "guid")
+    {
+        auto daguid = guid_new ();
+        string_to_guid (text, daguid);
+        return new KvpValue {daguid};
+    }
+    else if (value.type == "timespec")
+    {
+        Time64 t {value.date.to_time64 ()};
+        return new KvpValue {t};
+    }
+    else if (value.type == "gdate")
+    {
+        GDate date;
+        if (value.date.to_gdate (&date))
+            return new KvpValue {date};
+    }
+    else if (value.type == "list")
+    {
+        auto list = g_list_reverse (value.list);
+        value.list = nullptr;
+        return new KvpValue {list};
+    }
+    else if (value.type == "frame")
+    {
+        auto frame = value.frame;
+        value.frame = nullptr;
+        return new KvpValue {frame};
+    }
+    return nullptr;
+}
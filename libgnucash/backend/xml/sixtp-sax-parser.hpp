@@ -0,0 +1,196 @@
+/********************************************************************\
+ * sixtp-sax-parser.hpp -- read engine objects from sixtp events    *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+#ifndef SIXTP_SAX_PARSER_HPP
+#define SIXTP_SAX_PARSER_HPP
+
+extern "C"
+{
+#include <glib.h>
+
+#include "gnc-commodity.h"
+#include "qof.h"
+}
+
+#include <string>
+#include <vector>
+
+#include "sixtp.h"
+
+/* The state of a sub-tree read by a sixtp_sax_parser_new() parser.  The
+   parser's start handler allocates one and leaves it in
+   *data_for_children; every element below the top-level one is then
+   handed to element_start when it opens and to element_end, with its
+   text, when it closes.  path holds the tags of the open elements below
+   the top-level one, the current element at path[depth - 1].
+
+   The end handler gets the state back in data_for_children and must
+   delete it; if the parse fails first the parser deletes it, so the
+   destructor has to release any half-built object. */
+struct sixtp_sax_state
+{
+    virtual ~sixtp_sax_state () = default;
+    virtual void element_start (const gchar* tag, gchar** attrs) = 0;
+    virtual void element_end (const gchar* tag, const gchar* text) = 0;
+
+    /* Keep path and depth up to date and pass the event on. */
+    void open (const gchar* tag, gchar** attrs);
+    void close (const gchar* tag, const gchar* element_text);
+
+    /* Only the first depth entries of path are open; the strings are
+       kept to reuse their buffers. */
+    std::vector<std::string> path;
+    size_t depth = 0;
+    std::string text;
+};
+
+/* The events below a top-level element, recorded so that they can be
+   read later, possibly on another thread, by replaying them to a
+   sixtp_sax_state. */
+class sixtp_sax_events
+{
+public:
+    struct event
+    {
+        gboolean start;
+        std::string tag;
+        std::vector<std::string> attrs;     // start only
+        std::string text;                   // end only
+        /* attrs as the handlers get them, kept in buf */
+        gchar** c_attrs (std::vector<gchar*>& buf) const;
+    };
+    void start (const gchar* tag, gchar** attrs);
+    void end (const gchar* tag, const gchar* text);
+    void replay (sixtp_sax_state& state) const;
+    void clear () { m_events.clear (); m_events.shrink_to_fit (); }
+    const std::vector<event>& events () const { return m_events; }
+private:
+    std::vector<event> m_events;
+};
+
+/* Work that a parser splits off the parsing thread.  run is called on a
+   worker thread and mustn't touch the engine, whose collections and
+   string cache aren't thread safe.  commit is then called on the parsing
+   thread and returns FALSE if the parse should fail. */
+struct sixtp_job
+{
+    virtual ~sixtp_job () = default;
+    virtual void run () = 0;
+    virtual gboolean commit () = 0;
+};
+
+/* Hand a job over from an end handler, which should return what this
+   returns.  While sixtp_parse_fd is parsing on this thread the job runs
+   on a worker and TRUE is returned.  It's committed later: jobs are
+   committed in the order they were queued, and before the parse goes on
+   to any element other than another one like those that queued them, so
+   the book is still built in file order.  Otherwise the job is run and
+   committed at once.  Either way it's deleted afterwards. */
+gboolean sixtp_queue_job (sixtp_job* job);
+
+/* TRUE if attrs carry the type="guid" (or "new") attribute that
+   dom_tree_to_guid expects on an id element. */
+gboolean sixtp_sax_guid_type (gchar** attrs);
+
+/* Parse the text of an id element.  Like dom_tree_to_guid, text that
+   isn't a guid gives a new one. */
+void sixtp_sax_text_to_guid (const gchar* text, GncGUID* guid);
+
+/* Collects the <ts:date> or <gdate> child of a date element.  Only one
+   is allowed, as in dom_tree_to_time64 and dom_tree_to_gdate. */
+struct sixtp_sax_date
+{
+    void reset ();
+    void add (const gchar* text);
+    /* INT64_MAX if there wasn't exactly one date */
+    time64 to_time64 () const;
+    /* FALSE if there wasn't exactly one valid date */
+    gboolean to_gdate (GDate* date) const;
+
+    int count = 0;
+    std::string text;
+};
+
+/* Collects the <cmdty:space> and <cmdty:id> children of a commodity
+   reference and looks the commodity up like dom_tree_to_commodity_ref. */
+struct sixtp_sax_commodity_ref
+{
+    void reset ();
+    void add (const gchar* tag, const gchar* text);
+    gnc_commodity* lookup (QofBook* book) const;
+
+    int n_space = 0;
+    int n_id = 0;
+    std::string space;
+    std::string id;
+};
+
+/* Tracks which of a NULL-terminated list of required child tags were
+   seen, like the required flags of a dom_tree_handler table. */
+class sixtp_sax_required
+{
+public:
+    sixtp_sax_required (const gchar* const* tags) : m_tags{tags} {}
+    void reset () { m_seen = 0; }
+    void seen (const gchar* tag);
+    gboolean all_seen () const;
+private:
+    const gchar* const* m_tags;
+    guint m_seen = 0;
+};
+
+/* Reads the <slot> children of a slots element into a KvpFrame, with the
+   same results as dom_tree_create_instance_slots.  Call begin when the
+   slots element opens, hand it every element below that, and call finish
+   when it closes. */
+class sixtp_sax_slots
+{
+public:
+    ~sixtp_sax_slots () { clear (); }
+    void begin (KvpFrame* frame);
+    void element_start (const gchar* tag, gchar** attrs);
+    void element_end (const gchar* text);
+    void finish () { clear (); }
+    /* Read recorded slots elements into frame. */
+    void read (KvpFrame* frame, const sixtp_sax_events& events);
+    /* Release whatever a failed parse left half-built. */
+    void clear ();
+private:
+    /* One open element: a frame's list of slots, a slot, its key, a
+       typed value or the date inside one.  Values being built are owned
+       by their level until they are handed to the parent. */
+    struct level
+    {
+        enum { FRAME, SLOT, KEY, VALUE, DATE, SKIP } kind = SKIP;
+        KvpFrame* frame = nullptr;  // FRAME: target; VALUE of type frame: owned
+        KvpValue* value = nullptr;  // SLOT
+        GList* list = nullptr;      // VALUE of type list
+        gboolean has_key = FALSE;   // SLOT
+        std::string key;            // SLOT
+        std::string type;           // VALUE
+        sixtp_sax_date date;        // VALUE of type timespec or gdate
+    };
+    static KvpValue* make_value (level& value, const gchar* text);
+    std::vector<level> m_levels;
+};
+
+#endif /* SIXTP_SAX_PARSER_HPP */
@@ -0,0 +1,370 @@
+/********************************************************************
+ * sixtp-xml-writer.cpp -- write engine objects as xml text         *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+#include <glib.h>
+
+extern "C"
+{
+#include <config.h>
+
+#include <gnc-date.h>
+}
+
+#include "gnc-xml-helper.h"
+#include "sixtp-dom-generators.h"
+#include "sixtp-xml-writer.hpp"
+
+#include <kvp-frame.hpp>
+#include <gnc-datetime.hpp>
+
+#include <algorithm>
+
+static QofLogModule log_module = GNC_MOD_IO;
+
+/* Write out whenever this much has been collected. */
+#define WRITER_BUFFER_SIZE (64 * 1024)
+/* xmlElemDump stops indenting deeper than 60 columns. */
+#define WRITER_MAX_INDENT 30
+
+void
+sixtp_xml_writer::close_start_tag ()
+{
+    auto& parent = m_open.back ();
+    if (parent.open)
+    {
+        m_buf += '>';
+        parent.open = FALSE;
+    }
+}
+
+void
+sixtp_xml_writer::indent (size_t level)
+{
+    m_buf.append (2 * std::min (level, (size_t) WRITER_MAX_INDENT), ' ');
+}
+
+void
+sixtp_xml_writer::start_element (const gchar* tag)
+{
+    if (!m_open.empty ())
+    {
+        auto& parent = m_open.back ();
+        if (!parent.has_children)
+        {
+            close_start_tag ();
+            m_buf += '\n';
+            parent.has_children = TRUE;
+        }
+        indent (m_open.size ());
+    }
+    m_buf += '<';
+    m_buf += tag;
+    m_open.push_back ({tag, TRUE, FALSE});
+}
+
+/* Attribute values are our own type names, so only the ASCII escapes
+   are needed. */
+void
+sixtp_xml_writer::attribute (const gchar* name, const gchar* value)
+{
+    g_return_if_fail (!m_open.empty () && m_open.back ().open);
+
+    m_buf += ' ';
+    m_buf += name;
+    m_buf += "=\"";
+    for (auto p = value; *p; ++p)
+    {
+        switch (*p)
+        {
+        case '<': m_buf += "&lt;"; break;
+        case '>': m_buf += "&gt;"; break;
+        case '&': m_buf += "&amp;"; break;
+        case '"': m_buf += "&quot;"; break;
+        case '\n': m_buf += "&#10;"; break;
+        case '\r': m_buf += "&#13;"; break;
+        case '\t': m_buf += "&#9;"; break;
+        default: m_buf += *p; break;
+        }
+    }
+    m_buf += '"';
+}
+
+void
+sixtp_xml_writer::text (const gchar* str)
+{
+    g_return_if_fail (!m_open.empty () && !m_open.back ().has_children);
+
+    close_start_tag ();
+    m_scratch.assign (str);
+    checked_char_cast (&m_scratch[0]);
+    for (auto c : m_scratch)
+    {
+        switch (c)
+        {
+        case '<': m_buf += "&lt;"; break;
+        case '>': m_buf += "&gt;"; break;
+        case '&': m_buf += "&amp;"; break;
+        case '\r': m_buf += "&#13;"; break;
+        default: m_buf += c; break;
+        }
+    }
+}
+
+void
+sixtp_xml_writer::end_element ()
+{
+    g_return_if_fail (!m_open.empty ());
+
+    auto& elt = m_open.back ();
+    if (elt.open)
+        m_buf += "/>";
+    else
+    {
+        if (elt.has_children)
+            indent (m_open.size () - 1);
+        m_buf += "</";
+        m_buf += elt.tag;
+        m_buf += '>';
+    }
+    m_open.pop_back ();
+    m_buf += '\n';
+
+    if (m_buf.size () >= WRITER_BUFFER_SIZE)
+        flush ();
+}
+
+gboolean
+sixtp_xml_writer::flush ()
+{
+    if (!m_buf.empty ())
+    {
+        fwrite (m_buf.data (), 1, m_buf.size (), m_out);
+        m_buf.clear ();
+    }
+    return !ferror (m_out);
+}
+
+void
+sixtp_xml_writer::text_element (const gchar* tag, const gchar* str)
+{
+    start_element (tag);
+    text (str);
+    end_element ();
+}
+
+void
+sixtp_xml_writer::guid_element (const gchar* tag, const GncGUID* guid)
+{
+    char guid_str[GUID_ENCODING_LENGTH + 1];
+
+    if (!guid_to_string_buff (guid, guid_str))
+    {
+        PERR ("guid_to_string_buff failed\n");
+        return;
+    }
+
+    start_element (tag);
+    attribute ("type", "guid");
+    text (guid_str);
+    end_element ();
+}
+
+void
+sixtp_xml_writer::commodity_ref_element (const gchar* tag,
+                                         const gnc_commodity* c)
+{
+    g_return_if_fail (c);
+
+    auto name_space = gnc_commodity_get_namespace (c);
+    auto mnemonic = gnc_commodity_get_mnemonic (c);
+    if (!name_space || !mnemonic)
+        return;
+
+    start_element (tag);
+    text_element ("cmdty:space", name_space);
+    text_element ("cmdty:id", mnemonic);
+    end_element ();
+}
+
+/* The date value of a slot carries its type like the other values. */
+static void
+write_time64 (sixtp_xml_writer& writer, const gchar* tag, const gchar* type,
+              time64 time)
+{
+    g_return_if_fail (time != INT64_MAX);
+    auto date_str = GncDateTime (time).format_iso8601 ();
+    if (date_str.empty ())
+        return;
+    date_str += " +0000"; //Tack on a UTC offset to mollify GnuCash for Android
+
+    writer.start_element (tag);
+    if (type)
+        writer.attribute ("type", type);
+    writer.text_element ("ts:date", date_str.c_str ());
+    writer.end_element ();
+}
+
+static void
+write_gdate (sixtp_xml_writer& writer, const gchar* tag, const gchar* type,
+             const GDate* date)
+{
+    gchar date_str[512];
+
+    g_return_if_fail (date);
+    g_date_strftime (date_str, sizeof (date_str), "%Y-%m-%d", date);
+
+    writer.start_element (tag);
+    if (type)
+        writer.attribute ("type", type);
+    writer.text_element ("gdate", date_str);
+    writer.end_element ();
+}
+
+void
+sixtp_xml_writer::time64_element (const gchar* tag, time64 time)
+{
+    write_time64 (*this, tag, nullptr, time);
+}
+
+void
+sixtp_xml_writer::gdate_element (const gchar* tag, const GDate* date)
+{
+    write_gdate (*this, tag, nullptr, date);
+}
+
+void
+sixtp_xml_writer::numeric_element (const gchar* tag, gnc_numeric num)
+{
+    auto numstr = gnc_numeric_to_string (num);
+    g_return_if_fail (numstr);
+
+    text_element (tag, numstr);
+    g_free (numstr);
+}
+
+/* These follow add_kvp_value_node and add_kvp_slot. */
+void
+sixtp_xml_writer::kvp_value (const gchar* tag, KvpValue* val)
+{
+    gchar* str = nullptr;
+
+    switch (val->get_type ())
+    {
+    case KvpValue::Type::INT64:
+        str = g_strdup_printf ("%" G_GINT64_FORMAT, val->get<int64_t> ());
+        start_element (tag);
+        attribute ("type", "integer");
+        text (str);
+        end_element ();
+        break;
+    case KvpValue::Type::DOUBLE:
+        str = double_to_string (val->get<double> ());
+        start_element (tag);
+        attribute ("type", "double");
+        text (str);
+        end_element ();
+        break;
+    case KvpValue::Type::NUMERIC:
+        str = gnc_numeric_to_string (val->get<gnc_numeric> ());
+        start_element (tag);
+        attribute ("type", "numeric");
+        text (str);
+        end_element ();
+        break;
+    case KvpValue::Type::STRING:
+    {
+        auto string = val->get<const char*> ();
+        start_element (tag);
+        attribute ("type", "string");
+        if (string)
+            text (string);
+        end_element ();
+        break;
+    }
+    case KvpValue::Type::GUID:
+    {
+        gchar guidstr[GUID_ENCODING_LENGTH + 1];
+        start_element (tag);
+        attribute ("type", "guid");
+        if (guid_to_string_buff (val->get<GncGUID*> (), guidstr))
+            text (guidstr);
+        end_element ();
+        break;
+    }
+    /* Note: The type attribute must remain 'timespec' to maintain
+     * compatibility.
+     */
+    case KvpValue::Type::TIME64:
+        write_time64 (*this, tag, "timespec", val->get<Time64> ().t);
+        break;
+    case KvpValue::Type::GDATE:
+    {
+        auto d = val->get<GDate> ();
+        write_gdate (*this, tag, "gdate", &d);
+        break;
+    }
+    case KvpValue::Type::GLIST:
+        start_element (tag);
+        attribute ("type", "list");
+        for (auto cursor = val->get<GList*> (); cursor; cursor = cursor->next)
+            kvp_value ("slot:value", static_cast<KvpValue*> (cursor->data));
+        end_element ();
+        break;
+    case KvpValue::Type::FRAME:
+    {
+        start_element (tag);
+        attribute ("type", "frame");
+        auto frame = val->get<KvpFrame*> ();
+        if (frame)
+            frame->for_each_slot_temp ([this] (const char* key, KvpValue* value)
+                                       { slot (key, value); });
+        end_element ();
+        break;
+    }
+    default:
+        start_element (tag);
+        end_element ();
+        break;
+    }
+    g_free (str);
+}
+
+void
+sixtp_xml_writer::slot (const char* key, KvpValue* value)
+{
+    start_element ("slot");
+    text_element ("slot:key", key);
+    kvp_value ("slot:value", value);
+    end_element ();
+}
+
+void
+sixtp_xml_writer::slots_element (const gchar* tag, const QofInstance* inst)
+{
+    KvpFrame* frame = qof_instance_get_slots (inst);
+    if (!frame || frame->empty ())
+        return;
+
+    start_element (tag);
+    frame->for_each_slot_temp ([this] (const char* key, KvpValue* value)
+                               { slot (key, value); });
+    end_element ();
+}
@@ -0,0 +1,91 @@
+/********************************************************************\
+ * sixtp-xml-writer.hpp -- write engine objects as xml text         *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+#ifndef SIXTP_XML_WRITER_HPP
+#define SIXTP_XML_WRITER_HPP
+
+extern "C"
+{
+#include <glib.h>
+#include <stdio.h>
+
+#include "gnc-commodity.h"
+#include "qof.h"
+}
+
+#include <string>
+#include <vector>
+
+class KvpValue;
+
+/* Writes elements straight into a buffered FILE* stream, laid out the
+   way xmlElemDump lays out the tree the matching sixtp-dom-generators
+   function builds, so the two can be mixed in one file.  An element
+   holds either text or child elements, never both.  Each top-level
+   element is followed by a newline.
+
+   Like the generators, the element functions write nothing when the
+   generator would return NULL. */
+class sixtp_xml_writer
+{
+public:
+    sixtp_xml_writer (FILE* out) : m_out{out} {}
+    ~sixtp_xml_writer () { flush (); }
+
+    void start_element (const gchar* tag);
+    /* Only between start_element and the first child or text. */
+    void attribute (const gchar* name, const gchar* value);
+    /* The text is cleaned up by checked_char_cast and escaped. */
+    void text (const gchar* str);
+    void end_element ();
+
+    /* Like xmlNewTextChild: str may be empty but not NULL. */
+    void text_element (const gchar* tag, const gchar* str);
+    void guid_element (const gchar* tag, const GncGUID* guid);
+    void commodity_ref_element (const gchar* tag, const gnc_commodity* c);
+    void time64_element (const gchar* tag, time64 time);
+    void gdate_element (const gchar* tag, const GDate* date);
+    void numeric_element (const gchar* tag, gnc_numeric num);
+    void slots_element (const gchar* tag, const QofInstance* inst);
+
+    /* Write out the buffer; FALSE if the stream is in error. */
+    gboolean flush ();
+
+private:
+    struct element
+    {
+        const gchar* tag;
+        gboolean open;          // the start tag still lacks its '>'
+        gboolean has_children;
+    };
+    void close_start_tag ();
+    void indent (size_t level);
+    void slot (const char* key, KvpValue* value);
+    void kvp_value (const gchar* tag, KvpValue* value);
+
+    FILE* m_out;
+    std::string m_buf;
+    std::string m_scratch;
+    std::vector<element> m_open;
+};
+
+#endif /* SIXTP_XML_WRITER_HPP */
@@ -41,6 +41,11 @@ extern "C"
 #include "sixtp.h"
 #include "sixtp-parsers.h"
 #include "sixtp-stack.h"
+#include "sixtp-sax-parser.hpp"
+
+#include <deque>
+#include <string>
+#include <vector>
 
 #undef G_LOG_DOMAIN
 #define G_LOG_DOMAIN "gnc.backend.file.sixtp"
@@ -385,12 +390,12 @@ sixtp_add_some_sub_parsers (sixtp* tochange, int cleanup, ...)
 
 /************************************************************************/
 
-void
-sixtp_sax_start_handler (void* user_data,
+static void
+sixtp_sax_start_element (sixtp_sax_data* pdata,
                          const xmlChar* name,
-                         const xmlChar** attrs)
+                         const xmlChar** attrs,
+                         int line, int col)
 {
-    sixtp_sax_data* pdata = (sixtp_sax_data*) user_data;
     sixtp_stack_frame* current_frame = NULL;
     sixtp* current_parser = NULL;
     sixtp* next_parser = NULL;
@@ -454,8 +459,8 @@ sixtp_sax_start_handler (void* user_data,
     /* now allocate the new stack frame and shift to it */
     new_frame = sixtp_stack_frame_new (next_parser, g_strdup ((char*) name));
 
-    new_frame->line = xmlSAX2GetLineNumber (pdata->saxParserCtxt);
-    new_frame->col  = xmlSAX2GetColumnNumber (pdata->saxParserCtxt);
+    new_frame->line = line;
+    new_frame->col  = col;
 
     pdata->stack = g_slist_prepend (pdata->stack, (gpointer) new_frame);
 
@@ -472,6 +477,18 @@ sixtp_sax_start_handler (void* user_data,
     }
 }
 
+void
+sixtp_sax_start_handler (void* user_data,
+                         const xmlChar* name,
+                         const xmlChar** attrs)
+{
+    sixtp_sax_data* pdata = (sixtp_sax_data*) user_data;
+
+    sixtp_sax_start_element (pdata, name, attrs,
+                             xmlSAX2GetLineNumber (pdata->saxParserCtxt),
+                             xmlSAX2GetColumnNumber (pdata->saxParserCtxt));
+}
+
 void
 sixtp_sax_characters_handler (void* user_data, const xmlChar* text, int len)
 {
@@ -697,6 +714,9 @@ gnc_bad_xml_end_handler (gpointer data_for_children,
     return TRUE;
 }
 
+static gboolean sixtp_parse_finish (sixtp_parser_context* ctxt,
+                                    int parse_ret, gpointer* parse_result);
+
 static gboolean
 sixtp_parse_file_common (sixtp* sixtp,
                          xmlParserCtxtPtr xml_context,
@@ -721,6 +741,13 @@ sixtp_parse_file_common (sixtp* sixtp,
     parse_ret = xmlParseDocument (ctxt->data.saxParserCtxt);
     //xmlSAXUserParseFile(&ctxt->handler, &ctxt->data, filename);
 
+    return sixtp_parse_finish (ctxt, parse_ret, parse_result);
+}
+
+static gboolean
+sixtp_parse_finish (sixtp_parser_context* ctxt, int parse_ret,
+                    gpointer* parse_result)
+{
     sixtp_context_run_end_handler (ctxt);
 
     if (parse_ret == 0 && ctxt->data.parsing_ok)
@@ -782,6 +809,301 @@ sixtp_parser_read (void* context, char* buffer, int len)
     return ret;
 }
 
+/* sixtp_parse_fd splits the work between threads: a tokenizer thread
+   runs libxml2 over the file and records the SAX events in blocks, and
+   the calling thread replays them through the sixtp handlers.  Parsers
+   that can read their elements without the engine queue sixtp_jobs to a
+   pool of workers, and the calling thread commits the results in file
+   order; it is the only one that touches the engine. */
+
+#define SIXTP_EVENT_BLOCK_SIZE 4096 /* events per block */
+#define SIXTP_EVENT_BLOCKS 8        /* blocks the tokenizer may run ahead */
+
+typedef enum
+{
+    SIXTP_EVENT_START,
+    SIXTP_EVENT_CHARS,
+    SIXTP_EVENT_END
+} sixtp_event_type;
+
+struct sixtp_event
+{
+    sixtp_event_type type;
+    size_t text;        /* offset of the name or text in the pool */
+    int len;            /* length of the text */
+    size_t attrs;       /* first of the attribute offsets */
+    size_t n_attrs;     /* attribute names and values */
+    int line;
+    int col;
+};
+
+struct sixtp_event_block
+{
+    std::vector<sixtp_event> events;
+    std::string pool;
+    std::vector<size_t> attrs;
+    gboolean last = FALSE;
+    int parse_ret = 0;
+};
+
+struct sixtp_event_pipe
+{
+    xmlSAXHandler handler;
+    xmlParserCtxtPtr xml_context;
+    GAsyncQueue* full;
+    GAsyncQueue* empty;
+    sixtp_event_block* block;   /* being filled by the tokenizer */
+};
+
+static sixtp_event_block*
+sixtp_pipe_block (sixtp_event_pipe* pipe)
+{
+    if (!pipe->block)
+        pipe->block = static_cast<sixtp_event_block*> (g_async_queue_pop (pipe->empty));
+    return pipe->block;
+}
+
+static void
+sixtp_pipe_push (sixtp_event_pipe* pipe, sixtp_event& event)
+{
+    sixtp_event_block* block = pipe->block;
+
+    event.line = xmlSAX2GetLineNumber (pipe->xml_context);
+    event.col = xmlSAX2GetColumnNumber (pipe->xml_context);
+    block->events.push_back (event);
+    if (block->events.size () >= SIXTP_EVENT_BLOCK_SIZE)
+    {
+        g_async_queue_push (pipe->full, block);
+        pipe->block = NULL;
+    }
+}
+
+static size_t
+sixtp_pipe_add_text (sixtp_event_block* block, const xmlChar* text, int len)
+{
+    size_t offset = block->pool.size ();
+    block->pool.append ((const char*) text, len);
+    block->pool.push_back ('\0');
+    return offset;
+}
+
+static void
+sixtp_pipe_start_handler (void* user_data, const xmlChar* name,
+                          const xmlChar** attrs)
+{
+    sixtp_event_pipe* pipe = (sixtp_event_pipe*) user_data;
+    sixtp_event_block* block = sixtp_pipe_block (pipe);
+    sixtp_event event {SIXTP_EVENT_START};
+
+    event.text = sixtp_pipe_add_text (block, name, xmlStrlen (name));
+    event.attrs = block->attrs.size ();
+    for (; attrs && *attrs; attrs++)
+        block->attrs.push_back (sixtp_pipe_add_text (block, *attrs,
+                                                     xmlStrlen (*attrs)));
+    event.n_attrs = block->attrs.size () - event.attrs;
+    sixtp_pipe_push (pipe, event);
+}
+
+static void
+sixtp_pipe_characters_handler (void* user_data, const xmlChar* text, int len)
+{
+    sixtp_event_pipe* pipe = (sixtp_event_pipe*) user_data;
+    sixtp_event_block* block = sixtp_pipe_block (pipe);
+    sixtp_event event {SIXTP_EVENT_CHARS};
+
+    event.text = sixtp_pipe_add_text (block, text, len);
+    event.len = len;
+    sixtp_pipe_push (pipe, event);
+}
+
+static void
+sixtp_pipe_end_handler (void* user_data, const xmlChar* name)
+{
+    sixtp_event_pipe* pipe = (sixtp_event_pipe*) user_data;
+    sixtp_event_block* block = sixtp_pipe_block (pipe);
+    sixtp_event event {SIXTP_EVENT_END};
+
+    event.text = sixtp_pipe_add_text (block, name, xmlStrlen (name));
+    sixtp_pipe_push (pipe, event);
+}
+
+static gpointer
+sixtp_pipe_thread_func (gpointer data)
+{
+    sixtp_event_pipe* pipe = (sixtp_event_pipe*) data;
+    int parse_ret = xmlParseDocument (pipe->xml_context);
+    sixtp_event_block* block = sixtp_pipe_block (pipe);
+
+    block->last = TRUE;
+    block->parse_ret = parse_ret;
+    g_async_queue_push (pipe->full, block);
+    pipe->block = NULL;
+    return NULL;
+}
+
+#define SIXTP_JOBS_PER_THREAD 64   /* jobs queued ahead per worker */
+
+struct sixtp_job_entry
+{
+    sixtp_job* job;
+    gboolean done;
+};
+
+struct sixtp_job_queue
+{
+    sixtp_sax_data* pdata;
+    GThreadPool* pool;
+    GMutex mutex;
+    GCond cond;
+    std::deque<sixtp_job_entry*> jobs;
+    size_t max_jobs;
+    guint depth;            /* of the elements that queued the jobs */
+    std::string tag;        /* and their tag */
+};
+
+/* The queue of the sixtp_parse_fd running on this thread, if any. */
+static thread_local sixtp_job_queue* sixtp_current_jobs = NULL;
+
+static void
+sixtp_job_run (gpointer data, gpointer user_data)
+{
+    auto entry = static_cast<sixtp_job_entry*> (data);
+    auto queue = static_cast<sixtp_job_queue*> (user_data);
+
+    entry->job->run ();
+
+    g_mutex_lock (&queue->mutex);
+    entry->done = TRUE;
+    g_cond_broadcast (&queue->cond);
+    g_mutex_unlock (&queue->mutex);
+}
+
+/* Commit the finished jobs at the head of the queue, waiting for them
+   while more than keep are queued. */
+static void
+sixtp_jobs_commit (sixtp_job_queue* queue, size_t keep)
+{
+    while (!queue->jobs.empty ())
+    {
+        auto entry = queue->jobs.front ();
+        gboolean done;
+
+        g_mutex_lock (&queue->mutex);
+        while (!entry->done && queue->jobs.size () > keep)
+            g_cond_wait (&queue->cond, &queue->mutex);
+        done = entry->done;
+        g_mutex_unlock (&queue->mutex);
+        if (!done)
+            break;
+
+        queue->jobs.pop_front ();
+        queue->pdata->parsing_ok &= entry->job->commit ();
+        delete entry->job;
+        delete entry;
+    }
+}
+
+/* Commit all of the queued jobs unless the next event is inside one of
+   the elements that queued them or starts another one like them. */
+static void
+sixtp_jobs_barrier (sixtp_job_queue* queue, const xmlChar* start_tag)
+{
+    guint depth;
+
+    if (queue->jobs.empty ())
+        return;
+
+    depth = g_slist_length (queue->pdata->stack);
+    if (depth >= queue->depth ||
+        (start_tag && depth + 1 == queue->depth &&
+         queue->tag == (const char*) start_tag))
+        return;
+
+    sixtp_jobs_commit (queue, 0);
+}
+
+gboolean
+sixtp_queue_job (sixtp_job* job)
+{
+    auto queue = sixtp_current_jobs;
+    gboolean ok;
+
+    if (!queue)
+    {
+        job->run ();
+        ok = job->commit ();
+        delete job;
+        return ok;
+    }
+
+    auto frame = (sixtp_stack_frame*) queue->pdata->stack->data;
+    guint depth = g_slist_length (queue->pdata->stack);
+    if (depth != queue->depth || queue->tag != frame->tag)
+    {
+        sixtp_jobs_commit (queue, 0);
+        queue->depth = depth;
+        queue->tag.assign (frame->tag);
+    }
+
+    auto entry = new sixtp_job_entry {job, FALSE};
+    queue->jobs.push_back (entry);
+    g_thread_pool_push (queue->pool, entry, NULL);
+    sixtp_jobs_commit (queue, queue->max_jobs);
+    return TRUE;
+}
+
+/* Run the recorded events through the sixtp handlers until the
+   tokenizer is done, and return what xmlParseDocument returned. */
+static int
+sixtp_pipe_replay (sixtp_event_pipe* pipe, sixtp_sax_data* pdata,
+                   sixtp_job_queue* jobs)
+{
+    std::vector<const xmlChar*> attrs;
+    gboolean last;
+    int parse_ret;
+
+    do
+    {
+        auto block = static_cast<sixtp_event_block*> (g_async_queue_pop (pipe->full));
+        auto pool = (const xmlChar*) block->pool.c_str ();
+
+        for (auto& event : block->events)
+        {
+            switch (event.type)
+            {
+            case SIXTP_EVENT_START:
+                sixtp_jobs_barrier (jobs, pool + event.text);
+                attrs.clear ();
+                for (size_t i = 0; i < event.n_attrs; i++)
+                    attrs.push_back (pool + block->attrs[event.attrs + i]);
+                attrs.push_back (NULL);
+                sixtp_sax_start_element (pdata, pool + event.text,
+                                         event.n_attrs ? attrs.data () : NULL,
+                                         event.line, event.col);
+                break;
+            case SIXTP_EVENT_CHARS:
+                sixtp_sax_characters_handler (pdata, pool + event.text,
+                                              event.len);
+                break;
+            case SIXTP_EVENT_END:
+                sixtp_jobs_barrier (jobs, NULL);
+                sixtp_sax_end_handler (pdata, pool + event.text);
+                break;
+            }
+        }
+
+        last = block->last;
+        parse_ret = block->parse_ret;
+        block->events.clear ();
+        block->pool.clear ();
+        block->attrs.clear ();
+        g_async_queue_push (pipe->empty, block);
+    }
+    while (!last);
+
+    return parse_ret;
+}
+
 gboolean
 sixtp_parse_fd (sixtp* sixtp,
                 FILE* fd,
@@ -789,13 +1111,66 @@ sixtp_parse_fd (sixtp* sixtp,
                 gpointer global_data,
                 gpointer* parse_result)
 {
-    gboolean ret;
-    xmlParserCtxtPtr context = xmlCreateIOParserCtxt (NULL, NULL,
-                                                      sixtp_parser_read, NULL /*no close */, fd,
-                                                      XML_CHAR_ENCODING_NONE);
-    ret = sixtp_parse_file_common (sixtp, context, data_for_top_level,
-                                   global_data, parse_result);
-    return ret;
+    sixtp_parser_context* ctxt;
+    sixtp_event_pipe pipe {};
+    sixtp_job_queue jobs {};
+    GThread* thread;
+    gint n_threads;
+    int parse_ret;
+
+    if (! (ctxt = sixtp_context_new (sixtp, global_data, data_for_top_level)))
+    {
+        g_critical ("sixtp_context_new returned null");
+        return FALSE;
+    }
+
+    pipe.handler.startElement = sixtp_pipe_start_handler;
+    pipe.handler.endElement = sixtp_pipe_end_handler;
+    pipe.handler.characters = sixtp_pipe_characters_handler;
+    pipe.handler.getEntity = sixtp_sax_get_entity_handler;
+    pipe.full = g_async_queue_new ();
+    pipe.empty = g_async_queue_new ();
+    for (int i = 0; i < SIXTP_EVENT_BLOCKS; i++)
+    {
+        auto block = new sixtp_event_block;
+        block->events.reserve (SIXTP_EVENT_BLOCK_SIZE);
+        g_async_queue_push (pipe.empty, block);
+    }
+
+    pipe.xml_context = xmlCreateIOParserCtxt (NULL, NULL, sixtp_parser_read,
+                                              NULL /*no close */, fd,
+                                              XML_CHAR_ENCODING_NONE);
+    ctxt->data.saxParserCtxt = pipe.xml_context;
+    ctxt->data.saxParserCtxt->sax = &pipe.handler;
+    ctxt->data.saxParserCtxt->userData = &pipe;
+    ctxt->data.bad_xml_parser = sixtp_dom_parser_new (gnc_bad_xml_end_handler,
+                                                      NULL, NULL);
+
+    n_threads = MAX (g_get_num_processors (), 1);
+    jobs.pdata = &ctxt->data;
+    jobs.pool = g_thread_pool_new (sixtp_job_run, &jobs, n_threads, FALSE,
+                                   NULL);
+    jobs.max_jobs = SIXTP_JOBS_PER_THREAD * n_threads;
+    g_mutex_init (&jobs.mutex);
+    g_cond_init (&jobs.cond);
+    sixtp_current_jobs = &jobs;
+
+    thread = g_thread_new ("xml_tokenizer", sixtp_pipe_thread_func, &pipe);
+    parse_ret = sixtp_pipe_replay (&pipe, &ctxt->data, &jobs);
+    g_thread_join (thread);
+
+    sixtp_jobs_commit (&jobs, 0);
+    sixtp_current_jobs = NULL;
+    g_thread_pool_free (jobs.pool, FALSE, TRUE);
+    g_mutex_clear (&jobs.mutex);
+    g_cond_clear (&jobs.cond);
+
+    for (int i = 0; i < SIXTP_EVENT_BLOCKS; i++)
+        delete static_cast<sixtp_event_block*> (g_async_queue_pop (pipe.empty));
+    g_async_queue_unref (pipe.full);
+    g_async_queue_unref (pipe.empty);
+
+    return sixtp_parse_finish (ctxt, parse_ret, parse_result);
 }
 
 gboolean
@@ -42,6 +42,7 @@ extern "C"
 #include <string.h>
 
 #include <cashobjects.h>
+#include <Transaction.h>
 #include <TransLog.h>
 #include <gnc-engine.h>
 #include <gnc-prefs.h>
@@ -55,6 +56,8 @@ extern "C"
 #include "test-file-stuff.h"
 #include <test-stuff.h>
 
+#include <vector>
+
 #define GNC_LIB_NAME "gncmod-backend-xml"
 #define GNC_LIB_REL_PATH "xml"
 
@@ -121,6 +124,98 @@ test_load_file (const char* filename)
     qof_book_destroy (book);
 }
 
+static void
+collect_trans (QofInstance* inst, gpointer data)
+{
+    auto list = static_cast<std::vector<Transaction*>*> (data);
+    if (!xaccTransGetReadOnly (GNC_TRANSACTION (inst)))
+        list->push_back (GNC_TRANSACTION (inst));
+}
+
+/* With journaled saves on, a save after editing a few transactions only
+   appends to the journal, and loading the file replays it. */
+static void
+test_journaled_save (void)
+{
+    auto dir = g_dir_make_tmp ("test-journal-XXXXXX", NULL);
+    auto filename = g_build_filename (dir, "journaled.gnucash", (gchar*)NULL);
+    auto journal = g_strconcat (filename, ".journal", (gchar*)NULL);
+    auto uri = g_strconcat ("xml://", filename, (gchar*)NULL);
+    std::vector<Transaction*> trans;
+    GStatBuf before, after;
+
+    auto book = get_random_book ();
+    add_random_transactions_to_book (book, 20);
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_TRANS),
+                            collect_trans, &trans);
+    do_test (trans.size () >= 2, "random book has transactions to edit");
+
+    auto session = qof_session_new (book);
+    qof_session_begin (session, uri, SESSION_NEW_STORE);
+    qof_book_mark_session_dirty (book);
+    qof_session_save (session, NULL);
+    do_test (qof_session_get_error (session) == ERR_BACKEND_NO_ERR,
+             "full save");
+    g_stat (filename, &before);
+
+    gnc_prefs_set_file_save_journaled (TRUE);
+    auto changed = trans[0];
+    GncGUID changed_guid = *qof_instance_get_guid (changed);
+    GncGUID deleted_guid = *qof_instance_get_guid (trans[1]);
+    xaccTransBeginEdit (changed);
+    xaccTransSetDescription (changed, "changed by the journal");
+    xaccTransCommitEdit (changed);
+    xaccTransDestroy (trans[1]);
+    qof_session_save (session, NULL);
+    do_test (qof_session_get_error (session) == ERR_BACKEND_NO_ERR,
+             "journaled save");
+    g_stat (filename, &after);
+    do_test (g_file_test (journal, G_FILE_TEST_EXISTS), "journal written");
+    do_test (before.st_size == after.st_size &&
+             before.st_mtime == after.st_mtime, "data file left alone");
+
+    auto book2 = qof_book_new ();
+    auto session2 = qof_session_new (book2);
+    qof_session_begin (session2, uri, SESSION_READ_ONLY);
+    qof_session_load (session2, NULL);
+    do_test (qof_session_get_error (session2) == ERR_BACKEND_NO_ERR,
+             "load with journal");
+    do_test (qof_collection_count (qof_book_get_collection (book2, GNC_ID_TRANS))
+             == qof_collection_count (qof_book_get_collection (book, GNC_ID_TRANS)),
+             "journal replays to the same number of transactions");
+    do_test (xaccTransLookup (&deleted_guid, book2) == NULL,
+             "journal replays the deletion");
+    auto reloaded = xaccTransLookup (&changed_guid, book2);
+    do_test (reloaded && g_strcmp0 (xaccTransGetDescription (reloaded),
+                                    "changed by the journal") == 0,
+             "journal replays the change");
+    qof_session_end (session2);
+    qof_session_destroy (session2);
+
+    qof_session_end (session);
+    do_test (!g_file_test (journal, G_FILE_TEST_EXISTS),
+             "journal folded into the file when the session ends");
+    qof_session_destroy (session);
+    gnc_prefs_set_file_save_journaled (FALSE);
+
+    /* The saves leave backups and logs beside the file. */
+    auto gdir = g_dir_open (dir, 0, NULL);
+    const gchar* entry;
+    while (gdir && (entry = g_dir_read_name (gdir)) != NULL)
+    {
+        auto path = g_build_filename (dir, entry, (gchar*)NULL);
+        g_unlink (path);
+        g_free (path);
+    }
+    if (gdir)
+        g_dir_close (gdir);
+    g_rmdir (dir);
+    g_free (uri);
+    g_free (journal);
+    g_free (filename);
+    g_free (dir);
+}
+
 int
 main (int argc, char** argv)
 {
@@ -166,6 +261,8 @@ main (int argc, char** argv)
 
     g_dir_close (xml2_dir);
 
+    test_journaled_save ();
+
     if (files_tested == 0)
     {
         failure ("handled 0 files in test-load-xml2");
@@ -51,6 +51,7 @@ extern "C"
 #include "../gnc-xml.h"
 #include "../sixtp-parsers.h"
 #include "../sixtp-dom-parsers.h"
+#include "../sixtp-xml-writer.hpp"
 #include "../io-gncxml-gen.h"
 #include "test-file-stuff.h"
 #include <test-stuff.h>
@@ -371,6 +372,47 @@ test_add_transaction (const char* tag, gpointer globaldata, gpointer data)
     return retval;
 }
 
+static std::string
+read_back (FILE* file)
+{
+    std::string contents;
+    char buf[4096];
+    size_t len;
+
+    rewind (file);
+    while ((len = fread (buf, 1, sizeof (buf), file)) > 0)
+        contents.append (buf, len);
+    fclose (file);
+    return contents;
+}
+
+/* The streaming writer must produce exactly what xmlElemDump makes of
+   the DOM tree, followed by the newline xml_add_trn_data adds. */
+static gboolean
+writer_matches_dom (xmlNodePtr node, Transaction* trn)
+{
+    FILE* dom_file = tmpfile ();
+    FILE* sax_file = tmpfile ();
+
+    g_return_val_if_fail (dom_file && sax_file, FALSE);
+
+    xmlElemDump (dom_file, NULL, node);
+    fprintf (dom_file, "\n");
+    {
+        sixtp_xml_writer writer (sax_file);
+        gnc_transaction_write (writer, trn);
+    }
+
+    auto dom_text = read_back (dom_file);
+    auto sax_text = read_back (sax_file);
+    if (dom_text == sax_text)
+        return TRUE;
+
+    printf ("xmlElemDump:\n%s\nsixtp_xml_writer:\n%s\n", dom_text.c_str (),
+            sax_text.c_str ());
+    return FALSE;
+}
+
 static void
 test_transaction (void)
 {
@@ -382,6 +424,7 @@ test_transaction (void)
         xmlNodePtr test_node;
         gnc_commodity* com, *new_com;
         gchar* filename1;
+        FILE* file;
         int fd;
 
         /* The next line exists for its side effect of creating the
@@ -442,6 +485,10 @@ test_transaction (void)
             success_args ("transaction_xml", __FILE__, __LINE__, "%d", i);
         }
 
+        do_test_args (writer_matches_dom (test_node, ran_trn),
+                      "transaction_xml", __FILE__, __LINE__,
+                      "streaming writer differs from xmlElemDump: %d", i);
+
         filename1 = g_strdup_printf ("test_file_XXXXXX");
 
         fd = g_mkstemp (filename1);
@@ -492,6 +539,34 @@ test_transaction (void)
             }
             else
                 really_get_rid_of_transaction (data.new_trn);
+
+            /* The DOM parser must give the same transaction. */
+            parser = gnc_transaction_dom_sixtp_parser_create ();
+
+            if (!gnc_xml_parse_file (parser, filename1, test_add_transaction,
+                                     (gpointer)&data, book))
+            {
+                failure_args ("gnc_xml_parse_file (DOM) returned FALSE",
+                              __FILE__, __LINE__, "%d", i);
+            }
+            else
+                really_get_rid_of_transaction (data.new_trn);
+
+            /* So must gnc_xml_parse_fd, which reads it on a worker. */
+            parser = gnc_transaction_sixtp_parser_create ();
+            file = g_fopen (filename1, "r");
+
+            if (!file ||
+                !gnc_xml_parse_fd (parser, file, test_add_transaction,
+                                   (gpointer)&data, book))
+            {
+                failure_args ("gnc_xml_parse_fd returned FALSE",
+                              __FILE__, __LINE__, "%d", i);
+            }
+            else
+                really_get_rid_of_transaction (data.new_trn);
+            if (file)
+                fclose (file);
         }
         /* no handling of circular data structures.  We'll do that later */
         /* sixtp_destroy(parser); */
@@ -17,13 +17,24 @@
  * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
  *                                                                  *
 \********************************************************************/
+#include <glib.h>
+#include <glib/gstdio.h>
+
 extern "C"
 {
 #include <config.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <cashobjects.h>
+#include <gnc-engine.h>
+#include <TransLog.h>
 }
 
+#include <string>
+
 #include "test-engine-stuff.h"
 #include "io-gncxml-v2.h"
 #include "test-file-stuff.h"
@@ -31,6 +42,59 @@ extern "C"
 
 #define FILENAME "Money95bank_fr.gml2"
 
+static std::string
+read_gzipped (const char* filename)
+{
+    std::string contents;
+    char buf[4096];
+    int len;
+
+    auto file = gzopen (filename, "rb");
+    if (!file)
+        return contents;
+    while ((len = gzread (file, buf, sizeof (buf))) > 0)
+        contents.append (buf, len);
+    gzclose (file);
+    return contents;
+}
+
+/* A compressed save is written in blocks by several threads; zlib must
+   still read it back as the same text an uncompressed save writes. */
+static void
+test_compressed_save (void)
+{
+    gchar* plain_name = g_strdup ("test_plain_XXXXXX");
+    gchar* gz_name = g_strdup ("test_gzip_XXXXXX");
+    gchar* plain = NULL;
+    gsize plain_len = 0;
+
+    close (g_mkstemp (plain_name));
+    close (g_mkstemp (gz_name));
+
+    auto book = get_random_book ();
+    /* Enough data for several compression blocks. */
+    add_random_transactions_to_book (book, 400);
+
+    do_test (gnc_book_write_to_xml_file_v2 (book, plain_name, FALSE),
+             "uncompressed save");
+    do_test (gnc_book_write_to_xml_file_v2 (book, gz_name, TRUE),
+             "compressed save");
+    do_test (g_file_get_contents (plain_name, &plain, &plain_len, NULL),
+             "read uncompressed save");
+    do_test (plain_len > 256 * 1024, "save spans several blocks");
+    do_test (read_gzipped (gz_name) == std::string (plain, plain_len),
+             "compressed save decompresses to the uncompressed save");
+    do_test (gnc_is_xml_data_file_v2 (gz_name, NULL),
+             "gnc_is_xml_data_file_v2 on a compressed save");
+
+    g_free (plain);
+    qof_book_destroy (book);
+    g_unlink (plain_name);
+    g_unlink (gz_name);
+    g_free (plain_name);
+    g_free (gz_name);
+}
+
 int
 main (int argc, char** argv)
 {
@@ -46,6 +110,12 @@ main (int argc, char** argv)
     sprintf (filename, "%s/%s", directory, FILENAME);
     do_test (gnc_is_xml_data_file_v2 (filename, NULL), "gnc_is_xml_data_file_v2");
 
+    qof_init ();
+    cashobjects_register ();
+    xaccLogDisable ();
+    test_compressed_save ();
+    qof_close ();
+
     print_test_results ();
     exit (get_rv ());
 }
@@ -32,6 +32,9 @@ static gchar *namespace_regexp    = NULL;
 static gboolean is_debugging      = FALSE;
 static gboolean extras_enabled    = FALSE;
 static gboolean use_compression   = TRUE; // This is also the default in the prefs backend
+static gint compression_level     = 6;    // This is also the default in the prefs backend
+static gboolean use_journal       = FALSE; // This is also the default in the prefs backend
+static gboolean load_on_demand    = FALSE; // This is also the default in the prefs backend
 static gint file_retention_policy = 1;    // 1 = "days", the default in the prefs backend
 static gint file_retention_days   = 30;   // This is also the default in the prefs backend
 
@@ -95,6 +98,42 @@ gnc_prefs_set_file_save_compressed(gboolean compressed)
     use_compression = compressed;
 }
 
+gint
+gnc_prefs_get_file_compression_level(void)
+{
+    return compression_level;
+}
+
+void
+gnc_prefs_set_file_compression_level(gint level)
+{
+    compression_level = CLAMP(level, 1, 9);
+}
+
+gboolean
+gnc_prefs_get_file_save_journaled(void)
+{
+    return use_journal;
+}
+
+void
+gnc_prefs_set_file_save_journaled(gboolean journaled)
+{
+    use_journal = journaled;
+}
+
+gboolean
+gnc_prefs_get_sql_load_on_demand(void)
+{
+    return load_on_demand;
+}
+
+void
+gnc_prefs_set_sql_load_on_demand(gboolean on_demand)
+{
+    load_on_demand = on_demand;
+}
+
 gint
 gnc_prefs_get_file_retention_policy(void)
 {
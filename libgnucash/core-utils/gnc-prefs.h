@@ -113,6 +113,15 @@ void gnc_prefs_set_extra(gboolean enabled);
 gboolean gnc_prefs_get_file_save_compressed(void);
 void gnc_prefs_set_file_save_compressed(gboolean compressed);
 
+gint gnc_prefs_get_file_compression_level(void);
+void gnc_prefs_set_file_compression_level(gint level);
+
+gboolean gnc_prefs_get_file_save_journaled(void);
+void gnc_prefs_set_file_save_journaled(gboolean journaled);
+
+gboolean gnc_prefs_get_sql_load_on_demand(void);
+void gnc_prefs_set_sql_load_on_demand(gboolean on_demand);
+
 gint gnc_prefs_get_file_retention_policy(void);
 void gnc_prefs_set_file_retention_policy(gint policy);
 
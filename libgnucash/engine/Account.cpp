@@ -44,11 +44,20 @@ extern "C" {
 #include "gnc-lot.h"
 #include "gnc-pricedb.h"
 #include "qofinstance-p.h"
+#include "qofquery-p.h"
+#include "qofquerycore-p.h"
+#include "qof-backend.hpp"
 #include "gnc-features.h"
 #include "guid.hpp"
 
+#include <algorithm>
 #include <numeric>
 #include <map>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 static QofLogModule log_module = GNC_MOD_ACCOUNT;
 
@@ -137,6 +146,133 @@ enum
 #define GET_PRIVATE(o)  \
     ((AccountPrivate*)g_type_instance_get_private((GTypeInstance*)o, GNC_TYPE_ACCOUNT))
 
+/* The split index.
+ *
+ * priv->splits remains the list returned by xaccAccountGetSplitList,
+ * but its nodes are owned by the index: every split of the account has
+ * an entry pointing at its list node.  Splits whose sort key is known
+ * to be current are "placed" in a balanced tree ordered by
+ * xaccSplitOrder; placed splits always appear in priv->splits in tree
+ * order, so a split's list neighbour is found from its tree neighbour
+ * without walking the list.
+ *
+ * Splits added while the account is open for editing, or whose sort
+ * key is about to change (gnc_account_mark_split_dirty), are "pending":
+ * they keep their list node where it is and are repositioned one by
+ * one by the next xaccAccountSortSplits.  A split must leave the tree
+ * before its key changes, since the tree can only find and order its
+ * splits by their current keys.  Only when the caller cannot tell which
+ * split moved (gnc_account_set_sort_dirty), or when the book's
+ * num-source option changed, is the whole list resorted.
+ *
+ * While priv->balance_dirty is set, clean_upto names the placed split
+ * up to which (in list order) the running balances stored in the
+ * splits are still correct, so that xaccAccountRecomputeBalance can
+ * resume from there; nullptr means from the first split.
+ */
+/* The posted date is the primary key of xaccSplitOrder; splits without
+ * a transaction sort last. */
+static inline time64
+split_order_date (const Split *split)
+{
+    auto trans = xaccSplitGetParent (split);
+    return trans ? xaccTransGetDate (trans) : INT64_MAX;
+}
+
+/* Besides ordering splits, allows looking up the splits posted before
+ * or after a date in the tree. */
+struct SplitOrderLess
+{
+    using is_transparent = void;
+
+    bool operator()(const Split *a, const Split *b) const
+    {
+        return xaccSplitOrder (a, b) < 0;
+    }
+    bool operator()(const Split *a, time64 date) const
+    {
+        return split_order_date (a) < date;
+    }
+    bool operator()(time64 date, const Split *b) const
+    {
+        return date < split_order_date (b);
+    }
+};
+
+using SplitOrderSet = std::set<Split*, SplitOrderLess>;
+
+struct AccountSplitEntry
+{
+    GList *node;
+    SplitOrderSet::iterator pos;
+    bool placed;
+};
+
+struct AccountSplitIndex
+{
+    SplitOrderSet order;
+    std::unordered_map<Split*, AccountSplitEntry> entries;
+    /* May hold splits that were since placed or removed; those are
+     * skipped when the pending splits are placed. */
+    std::vector<Split*> pending;
+    bool full_resort = false;
+    Split *clean_upto = nullptr;
+    /* The book's num-source option the tree is ordered by. */
+    TriState num_source = Unset;
+};
+
+/* The closest split before node in the list that is placed, and thus
+ * comparable with clean_upto. */
+static Split*
+split_index_placed_before (AccountSplitIndex *idx, GList *node)
+{
+    for (node = node->prev; node; node = node->prev)
+    {
+        auto split = static_cast<Split*>(node->data);
+        if (idx->entries.at (split).placed)
+            return split;
+    }
+    return nullptr;
+}
+
+/* Mark the running balances dirty after the placed split 'clean', or
+ * from the first split if it is nullptr. */
+static void
+split_index_dirty_from (AccountPrivate *priv, Split *clean)
+{
+    auto idx = priv->split_index;
+
+    if (!priv->balance_dirty)
+        idx->clean_upto = clean;
+    else if (idx->clean_upto &&
+             (!clean || xaccSplitOrder (clean, idx->clean_upto) < 0))
+        idx->clean_upto = clean;
+    priv->balance_dirty = TRUE;
+}
+
+/* Open lots are ordered by the sign of their earliest split's amount,
+ * then by its post date, then by when they came into the account. */
+using OpenLotKey = std::tuple<int, time64, uint64_t>;
+using OpenLotMap = std::map<OpenLotKey, GNCLot*>;
+
+struct AccountLotEntry
+{
+    uint64_t seq;
+    OpenLotMap::iterator pos;
+    bool placed;
+    bool queued;
+};
+
+struct AccountLotIndex
+{
+    OpenLotMap open;
+    std::unordered_map<GNCLot*, AccountLotEntry> entries;
+    /* Lots to look at again before the next search.  May hold lots
+     * that were since removed; those are skipped. */
+    std::vector<GNCLot*> pending;
+    uint64_t next_seq = 0;
+};
+
 /* This map contains a set of strings representing the different column types. */
 static const std::map<GNCAccountType, const char*> gnc_acct_debit_strs = {
     { ACCT_TYPE_NONE,       N_("Funds In") },
@@ -310,6 +446,7 @@ gnc_account_init(Account* acc)
 
     priv->policy = xaccGetFIFOPolicy();
     priv->lots = NULL;
+    priv->lot_index = new AccountLotIndex;
 
     priv->commodity = NULL;
     priv->commodity_scu = 0;
@@ -337,6 +474,7 @@ gnc_account_init(Account* acc)
 
     priv->splits = NULL;
     priv->sort_dirty = FALSE;
+    priv->split_index = new AccountSplitIndex;
 }
 
 static void
@@ -348,6 +486,12 @@ gnc_account_dispose (GObject *acctp)
 static void
 gnc_account_finalize(GObject* acctp)
 {
+    AccountPrivate *priv = GET_PRIVATE(acctp);
+
+    delete priv->split_index;
+    priv->split_index = nullptr;
+    delete priv->lot_index;
+    priv->lot_index = nullptr;
     G_OBJECT_CLASS(gnc_account_parent_class)->finalize(acctp);
 }
 
@@ -566,6 +710,10 @@ gnc_account_set_property (GObject         *object,
         number = static_cast<gnc_numeric*>(g_value_get_boxed(value));
         gnc_account_set_start_reconciled_balance(account, *number);
         break;
+    case PROP_START_NOCLOSING_BALANCE:
+        number = static_cast<gnc_numeric*>(g_value_get_boxed(value));
+        gnc_account_set_start_noclosing_balance(account, *number);
+        break;
     case PROP_POLICY:
         gnc_account_set_policy(account, static_cast<GNCPolicy*>(g_value_get_pointer(value)));
         break;
@@ -1345,6 +1493,9 @@ xaccFreeAccount (Account *acc)
         }
         g_list_free (priv->lots);
         priv->lots = NULL;
+        priv->lot_index->open.clear();
+        priv->lot_index->entries.clear();
+        priv->lot_index->pending.clear();
     }
 
     /* Next, clean up the splits */
@@ -1510,6 +1661,10 @@ xaccAccountCommitEdit (Account *acc)
         {
             g_list_free(priv->splits);
             priv->splits = NULL;
+            priv->split_index->order.clear();
+            priv->split_index->entries.clear();
+            priv->split_index->pending.clear();
+            priv->split_index->clean_upto = nullptr;
         }
 
         /* It turns out there's a case where this assertion does not hold:
@@ -1534,6 +1689,9 @@ xaccAccountCommitEdit (Account *acc)
         }
         g_list_free(priv->lots);
         priv->lots = NULL;
+        priv->lot_index->open.clear();
+        priv->lot_index->entries.clear();
+        priv->lot_index->pending.clear();
 
         qof_instance_set_dirty(&acc->inst);
         qof_instance_decrease_editlevel(acc);
@@ -1878,6 +2036,43 @@ gnc_account_set_sort_dirty (Account *acc)
 
     priv = GET_PRIVATE(acc);
     priv->sort_dirty = TRUE;
+    priv->split_index->full_resort = true;
+}
+
+void
+gnc_account_mark_split_dirty (Account *acc, Split *split)
+{
+    AccountPrivate *priv;
+    AccountSplitIndex *idx;
+
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+
+    if (qof_instance_get_destroying(acc))
+        return;
+
+    priv = GET_PRIVATE(acc);
+    idx = priv->split_index;
+    priv->sort_dirty = TRUE;
+
+    /* A split that isn't in the account yet is positioned, and its
+     * balance accounted for, when it is inserted. */
+    auto it = idx->entries.find (split);
+    if (it == idx->entries.end ())
+    {
+        split_index_dirty_from (priv, idx->order.empty () ? nullptr :
+                                *idx->order.rbegin ());
+        return;
+    }
+
+    split_index_dirty_from (priv, split_index_placed_before (idx, it->second.node));
+    if (!it->second.placed)
+        return;
+
+    /* Taken out by position, in case the caller has already changed
+     * the key. */
+    idx->order.erase (it->second.pos);
+    it->second.placed = false;
+    idx->pending.push_back (split);
 }
 
 void
@@ -1891,7 +2086,7 @@ gnc_account_set_balance_dirty (Account *acc)
         return;
 
     priv = GET_PRIVATE(acc);
-    priv->balance_dirty = TRUE;
+    split_index_dirty_from (priv, nullptr);
 }
 
 void gnc_account_set_defer_bal_computation (Account *acc, gboolean defer)
@@ -1920,29 +2115,144 @@ gboolean gnc_account_get_defer_bal_computation (Account *acc)
 /********************************************************************\
 \********************************************************************/
 
+/* Put a split into the order tree and move its list node, which may
+ * be detached, right after the node of its new tree predecessor.  The
+ * running balances are dirtied from both its old and new position. */
+static void
+split_index_place (AccountPrivate *priv, Split *split, AccountSplitEntry& entry)
+{
+    auto idx = priv->split_index;
+    GList *node = entry.node, *after = nullptr;
+    Split *before = nullptr;
+
+    if (node->prev || priv->splits == node)
+        split_index_dirty_from (priv, split_index_placed_before (idx, node));
+
+    entry.pos = idx->order.insert (split).first;
+    entry.placed = true;
+    if (entry.pos != idx->order.begin ())
+    {
+        before = *std::prev (entry.pos);
+        after = idx->entries.at (before).node;
+    }
+    split_index_dirty_from (priv, before);
+
+    priv->splits = g_list_remove_link (priv->splits, node);
+    node->prev = after;
+    node->next = after ? after->next : priv->splits;
+    if (node->next)
+        node->next->prev = node;
+    if (after)
+        after->next = node;
+    else
+        priv->splits = node;
+}
+
+/* xaccSplitOrder compares the split actions rather than the
+ * transaction nums when the book's num-source option says so.  When
+ * that option has changed since the tree was built, every account of
+ * the book is ordered the old way, so all of them are marked for a
+ * full resort.  Must be called before anything is placed in the tree. */
+static void
+split_index_check_num_source (Account *acc)
+{
+    auto priv = GET_PRIVATE(acc);
+    auto book = gnc_account_get_book (acc);
+    TriState num_source = qof_book_use_split_action_for_num_field (book) ?
+        True : False;
+
+    if (priv->split_index->num_source == num_source)
+        return;
+    if (priv->split_index->num_source != Unset)
+    {
+        auto root = gnc_book_get_root_account (book);
+        auto accounts = root ? gnc_account_get_descendants (root) : nullptr;
+        accounts = g_list_prepend (accounts, acc);
+        if (root && root != acc)
+            accounts = g_list_prepend (accounts, root);
+        for (auto node = accounts; node; node = node->next)
+        {
+            auto other = static_cast<Account*>(node->data);
+            gnc_account_set_sort_dirty (other);
+            GET_PRIVATE(other)->split_index->num_source = num_source;
+        }
+        g_list_free (accounts);
+    }
+    priv->split_index->num_source = num_source;
+}
+
+/* Rebuild the order tree from scratch and relink the whole list in
+ * tree order. */
+static void
+split_index_resort (AccountPrivate *priv)
+{
+    auto idx = priv->split_index;
+    GList *prev = nullptr;
+
+    idx->order.clear ();
+    /* The list is usually close to sorted already, in which case the
+     * end hint makes most insertions constant time. */
+    for (GList *node = priv->splits; node; node = node->next)
+    {
+        auto split = static_cast<Split*>(node->data);
+        auto& entry = idx->entries.at (split);
+        entry.pos = idx->order.insert (idx->order.end (), split);
+        entry.placed = true;
+    }
+
+    priv->splits = nullptr;
+    for (auto split : idx->order)
+    {
+        GList *node = idx->entries.at (split).node;
+        node->prev = prev;
+        node->next = nullptr;
+        if (prev)
+            prev->next = node;
+        else
+            priv->splits = node;
+        prev = node;
+    }
+
+    idx->pending.clear ();
+    idx->full_resort = false;
+    split_index_dirty_from (priv, nullptr);
+}
+
+static void account_sort_splits (Account *acc, gboolean force);
+
 gboolean
 gnc_account_insert_split (Account *acc, Split *s)
 {
     AccountPrivate *priv;
-    GList *node;
+    AccountSplitIndex *idx;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
     g_return_val_if_fail(GNC_IS_SPLIT(s), FALSE);
 
     priv = GET_PRIVATE(acc);
-    node = g_list_find(priv->splits, s);
-    if (node)
+    idx = priv->split_index;
+    if (idx->entries.count (s))
         return FALSE;
 
+    split_index_check_num_source (acc);
+    if (idx->full_resort && qof_instance_get_editlevel(acc) == 0)
+        account_sort_splits (acc, FALSE);
+
+    auto& entry = idx->entries[s];
+    entry.node = g_list_alloc ();
+    entry.node->data = s;
+    entry.placed = false;
+
     if (qof_instance_get_editlevel(acc) == 0)
     {
-        priv->splits = g_list_insert_sorted(priv->splits, s,
-                                            (GCompareFunc)xaccSplitOrder);
+        split_index_place (priv, s, entry);
     }
     else
     {
-        priv->splits = g_list_prepend(priv->splits, s);
+        priv->splits = g_list_concat (entry.node, priv->splits);
+        idx->pending.push_back (s);
         priv->sort_dirty = TRUE;
+        split_index_dirty_from (priv, nullptr);
     }
 
     //FIXME: find better event
@@ -1950,7 +2260,6 @@ gnc_account_insert_split (Account *acc, Split *s)
     /* Also send an event based on the account */
     qof_event_gen(&acc->inst, GNC_EVENT_ITEM_ADDED, s);
 
-    priv->balance_dirty = TRUE;
 //  DRH: Should the below be added? It is present in the delete path.
 //  xaccAccountRecomputeBalance(acc);
     return TRUE;
@@ -1960,40 +2269,68 @@ gboolean
 gnc_account_remove_split (Account *acc, Split *s)
 {
     AccountPrivate *priv;
-    GList *node;
+    AccountSplitIndex *idx;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
     g_return_val_if_fail(GNC_IS_SPLIT(s), FALSE);
 
     priv = GET_PRIVATE(acc);
-    node = g_list_find(priv->splits, s);
-    if (NULL == node)
+    idx = priv->split_index;
+    auto it = idx->entries.find (s);
+    if (it == idx->entries.end ())
         return FALSE;
 
-    priv->splits = g_list_delete_link(priv->splits, node);
+    split_index_dirty_from (priv, split_index_placed_before (idx, it->second.node));
+    if (it->second.placed)
+        idx->order.erase (it->second.pos);
+    priv->splits = g_list_delete_link(priv->splits, it->second.node);
+    idx->entries.erase (it);
     //FIXME: find better event type
     qof_event_gen(&acc->inst, QOF_EVENT_MODIFY, NULL);
     // And send the account-based event, too
     qof_event_gen(&acc->inst, GNC_EVENT_ITEM_REMOVED, s);
 
-    priv->balance_dirty = TRUE;
     xaccAccountRecomputeBalance(acc);
     return TRUE;
 }
 
-void
-xaccAccountSortSplits (Account *acc, gboolean force)
+static void
+account_sort_splits (Account *acc, gboolean force)
 {
     AccountPrivate *priv;
-
-    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+    AccountSplitIndex *idx;
 
     priv = GET_PRIVATE(acc);
     if (!priv->sort_dirty || (!force && qof_instance_get_editlevel(acc) > 0))
         return;
-    priv->splits = g_list_sort(priv->splits, (GCompareFunc)xaccSplitOrder);
+
+    idx = priv->split_index;
+    /* Repositioning splits one at a time only pays while most of the
+     * list is still in order. */
+    if (idx->full_resort || idx->pending.size () > idx->order.size ())
+    {
+        split_index_resort (priv);
+    }
+    else
+    {
+        for (auto split : idx->pending)
+        {
+            auto it = idx->entries.find (split);
+            if (it != idx->entries.end () && !it->second.placed)
+                split_index_place (priv, split, it->second);
+        }
+        idx->pending.clear ();
+    }
     priv->sort_dirty = FALSE;
-    priv->balance_dirty = TRUE;
+}
+
+void
+xaccAccountSortSplits (Account *acc, gboolean force)
+{
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+
+    split_index_check_num_source (acc);
+    account_sort_splits (acc, force);
 }
 
 static void
@@ -2102,6 +2439,98 @@ gnc_account_set_policy (Account *acc, GNCPolicy *policy)
 /********************************************************************\
 \********************************************************************/
 
+static void
+lot_index_queue (AccountLotIndex *idx, GNCLot *lot, AccountLotEntry& entry)
+{
+    if (entry.placed)
+        idx->open.erase (entry.pos);
+    entry.placed = false;
+    if (!entry.queued)
+        idx->pending.push_back (lot);
+    entry.queued = true;
+}
+
+static void
+lot_index_insert (AccountLotIndex *idx, GNCLot *lot)
+{
+    auto res = idx->entries.emplace (lot, AccountLotEntry {});
+    auto& entry = res.first->second;
+    if (res.second)
+    {
+        entry.seq = idx->next_seq++;
+        entry.placed = false;
+        entry.queued = false;
+    }
+    lot_index_queue (idx, lot, entry);
+}
+
+static void
+lot_index_remove (AccountLotIndex *idx, GNCLot *lot)
+{
+    auto it = idx->entries.find (lot);
+    if (it == idx->entries.end ())
+        return;
+    if (it->second.placed)
+        idx->open.erase (it->second.pos);
+    idx->entries.erase (it);
+}
+
+/* Put the queued lots that are open back into the tree under their
+ * current keys. */
+static void
+lot_index_update (AccountLotIndex *idx)
+{
+    for (auto lot : idx->pending)
+    {
+        auto it = idx->entries.find (lot);
+        if (it == idx->entries.end () || !it->second.queued)
+            continue;
+        it->second.queued = false;
+        if (gnc_lot_is_closed (lot))
+            continue;
+        auto split = gnc_lot_get_earliest_split (lot);
+        if (!split)
+            continue;
+        auto amount = xaccSplitGetAmount (split);
+        int sign = gnc_numeric_positive_p (amount) ? 1 :
+            gnc_numeric_negative_p (amount) ? -1 : 0;
+        OpenLotKey key {sign, split_order_date (split), it->second.seq};
+        it->second.pos = idx->open.emplace (key, lot).first;
+        it->second.placed = true;
+    }
+    idx->pending.clear ();
+}
+
+void
+gnc_account_mark_lot_dirty (Account *acc, GNCLot *lot)
+{
+    AccountLotIndex *idx;
+
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+
+    if (qof_instance_get_destroying(acc))
+        return;
+
+    idx = GET_PRIVATE(acc)->lot_index;
+    auto it = idx->entries.find (lot);
+    if (it != idx->entries.end ())
+        lot_index_queue (idx, lot, it->second);
+}
+
+gint
+gnc_account_lot_order (const Account *acc, const GNCLot *lot_a,
+                       const GNCLot *lot_b)
+{
+    g_return_val_if_fail(GNC_IS_ACCOUNT(acc), 0);
+
+    auto& entries = GET_PRIVATE(acc)->lot_index->entries;
+    auto a = entries.find (const_cast<GNCLot*>(lot_a));
+    auto b = entries.find (const_cast<GNCLot*>(lot_b));
+    if (a == entries.end () || b == entries.end ())
+        return (a == entries.end ()) - (b == entries.end ());
+    return (a->second.seq > b->second.seq) - (a->second.seq < b->second.seq);
+}
+
 void
 xaccAccountRemoveLot (Account *acc, GNCLot *lot)
 {
@@ -2115,6 +2544,7 @@ xaccAccountRemoveLot (Account *acc, GNCLot *lot)
 
     ENTER ("(acc=%p, lot=%p)", acc, lot);
     priv->lots = g_list_remove(priv->lots, lot);
+    lot_index_remove (priv->lot_index, lot);
     qof_event_gen (QOF_INSTANCE(lot), QOF_EVENT_REMOVE, NULL);
     qof_event_gen (&acc->inst, QOF_EVENT_MODIFY, NULL);
     LEAVE ("(acc=%p, lot=%p)", acc, lot);
@@ -2144,10 +2574,12 @@ xaccAccountInsertLot (Account *acc, GNCLot *lot)
         old_acc = lot_account;
         opriv = GET_PRIVATE(old_acc);
         opriv->lots = g_list_remove(opriv->lots, lot);
+        lot_index_remove (opriv->lot_index, lot);
     }
 
     priv = GET_PRIVATE(acc);
     priv->lots = g_list_prepend(priv->lots, lot);
+    lot_index_insert (priv->lot_index, lot);
     gnc_lot_set_account(lot, acc);
 
     /* Don't move the splits to the new account.  The caller will do this
@@ -2258,32 +2690,42 @@ xaccAccountMoveAllSplits (Account *accfrom, Account *accto)
  * Return: void                                                     *
 \********************************************************************/
 
-void
-xaccAccountRecomputeBalance (Account * acc)
+static void
+account_recompute_balance (AccountPrivate *priv)
 {
-    AccountPrivate *priv;
+    AccountSplitIndex *idx;
     gnc_numeric  balance;
     gnc_numeric  noclosing_balance;
     gnc_numeric  cleared_balance;
     gnc_numeric  reconciled_balance;
     GList *lp;
 
-    if (NULL == acc) return;
-
-    priv = GET_PRIVATE(acc);
-    if (qof_instance_get_editlevel(acc) > 0) return;
-    if (!priv->balance_dirty || priv->defer_bal_computation) return;
-    if (qof_instance_get_destroying(acc)) return;
-    if (qof_book_shutting_down(qof_instance_get_book(acc))) return;
-
     balance            = priv->starting_balance;
     noclosing_balance  = priv->starting_noclosing_balance;
     cleared_balance    = priv->starting_cleared_balance;
     reconciled_balance = priv->starting_reconciled_balance;
+    lp = priv->splits;
+
+    /* Resume from the last split whose running balances are known to
+     * be current instead of walking the whole account. */
+    idx = priv->split_index;
+    if (idx->clean_upto)
+    {
+        auto it = idx->entries.find (idx->clean_upto);
+        if (it != idx->entries.end () && it->second.placed)
+        {
+            Split *clean = idx->clean_upto;
+            balance            = clean->balance;
+            noclosing_balance  = clean->noclosing_balance;
+            cleared_balance    = clean->cleared_balance;
+            reconciled_balance = clean->reconciled_balance;
+            lp = it->second.node->next;
+        }
+    }
 
     PINFO ("acct=%s starting baln=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT,
            priv->accountName, balance.num, balance.denom);
-    for (lp = priv->splits; lp; lp = lp->next)
+    for (; lp; lp = lp->next)
     {
         Split *split = (Split *) lp->data;
         gnc_numeric amt = xaccSplitGetAmount (split);
@@ -2317,6 +2759,95 @@ xaccAccountRecomputeBalance (Account * acc)
     priv->cleared_balance = cleared_balance;
     priv->reconciled_balance = reconciled_balance;
     priv->balance_dirty = FALSE;
+    idx->clean_upto = nullptr;
+}
+
+void
+xaccAccountRecomputeBalance (Account * acc)
+{
+    AccountPrivate *priv;
+
+    if (NULL == acc) return;
+
+    priv = GET_PRIVATE(acc);
+    if (qof_instance_get_editlevel(acc) > 0) return;
+    if (!priv->balance_dirty || priv->defer_bal_computation) return;
+    if (qof_instance_get_destroying(acc)) return;
+    if (qof_book_shutting_down(qof_instance_get_book(acc))) return;
+
+    account_recompute_balance (priv);
+}
+
+/* xaccSplitOrder fills the closing-transaction flag and the book's
+ * num-source option on first use; fill them before any worker runs so
+ * that the workers only ever read the shared transactions and book. */
+static void
+warm_split_order_caches (QofInstance *inst, gpointer data)
+{
+    xaccTransGetIsClosingTxn (GNC_TRANSACTION (inst));
+}
+
+static void
+sort_and_recompute_account (gpointer data, gpointer user_data)
+{
+    auto acc = static_cast<Account*>(data);
+    auto priv = GET_PRIVATE(acc);
+
+    account_sort_splits (acc, TRUE);
+    if (priv->balance_dirty && !priv->defer_bal_computation)
+        account_recompute_balance (priv);
+}
+
+void
+gnc_account_tree_sort_and_recompute (Account *root)
+{
+    g_return_if_fail (GNC_IS_ACCOUNT(root));
+
+    auto book = gnc_account_get_book (root);
+    if (qof_book_shutting_down (book))
+        return;
+
+    /* An account's sort and balances touch only its own splits and
+     * index, so the accounts are independent of one another. */
+    std::vector<Account*> accounts;
+    auto descendants = gnc_account_get_descendants (root);
+    descendants = g_list_prepend (descendants, root);
+    /* May mark every account for a resort, so done for all of them
+     * before any is looked at, and never from the workers. */
+    for (auto node = descendants; node; node = node->next)
+        split_index_check_num_source (static_cast<Account*>(node->data));
+    for (auto node = descendants; node; node = node->next)
+    {
+        auto acc = static_cast<Account*>(node->data);
+        auto priv = GET_PRIVATE(acc);
+        if (!qof_instance_get_destroying (acc) &&
+            (priv->sort_dirty || priv->balance_dirty))
+            accounts.push_back (acc);
+    }
+    g_list_free (descendants);
+    if (accounts.empty ())
+        return;
+
+    qof_event_suspend ();
+    qof_book_use_split_action_for_num_field (book);
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_TRANS),
+                            warm_split_order_caches, nullptr);
+
+    auto n_threads = std::min<gsize> (g_get_num_processors (), accounts.size ());
+    GThreadPool *pool = nullptr;
+    if (n_threads > 1)
+        pool = g_thread_pool_new (sort_and_recompute_account, nullptr,
+                                  n_threads, FALSE, nullptr);
+    for (auto acc : accounts)
+    {
+        if (pool)
+            g_thread_pool_push (pool, acc, nullptr);
+        else
+            sort_and_recompute_account (acc, nullptr);
+    }
+    if (pool)
+        g_thread_pool_free (pool, FALSE, TRUE);
+    qof_event_resume ();
 }
 
 /********************************************************************\
@@ -2419,7 +2950,8 @@ xaccAccountSetType (Account *acc, GNCAccountType tip)
 
     xaccAccountBeginEdit(acc);
     priv->type = tip;
-    priv->balance_dirty = TRUE; /* new type may affect balance computation */
+    /* new type may affect balance computation */
+    split_index_dirty_from (priv, nullptr);
     mark_account(acc);
     xaccAccountCommitEdit(acc);
 }
@@ -2643,7 +3175,7 @@ xaccAccountSetCommodity (Account * acc, gnc_commodity * com)
     }
 
     priv->sort_dirty = TRUE;  /* Not needed. */
-    priv->balance_dirty = TRUE;
+    split_index_dirty_from (priv, nullptr);
     mark_account (acc);
 
     xaccAccountCommitEdit(acc);
@@ -3453,7 +3985,7 @@ gnc_account_set_start_balance (Account *acc, const gnc_numeric start_baln)
 
     priv = GET_PRIVATE(acc);
     priv->starting_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    split_index_dirty_from (priv, nullptr);
 }
 
 void
@@ -3466,7 +3998,7 @@ gnc_account_set_start_cleared_balance (Account *acc,
 
     priv = GET_PRIVATE(acc);
     priv->starting_cleared_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    split_index_dirty_from (priv, nullptr);
 }
 
 void
@@ -3479,7 +4011,20 @@ gnc_account_set_start_reconciled_balance (Account *acc,
 
     priv = GET_PRIVATE(acc);
     priv->starting_reconciled_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    split_index_dirty_from (priv, nullptr);
+}
+
+void
+gnc_account_set_start_noclosing_balance (Account *acc,
+        const gnc_numeric start_baln)
+{
+    AccountPrivate *priv;
+
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+
+    priv = GET_PRIVATE(acc);
+    priv->starting_noclosing_balance = start_baln;
+    split_index_dirty_from (priv, nullptr);
 }
 
 gnc_numeric
@@ -3503,6 +4048,16 @@ xaccAccountGetReconciledBalance (const Account *acc)
     return GET_PRIVATE(acc)->reconciled_balance;
 }
 
+/* A backend that loads transactions on demand may not have loaded all of
+ * the account's splits posted on or after since yet. */
+static void
+account_ensure_loaded (const Account *acc, time64 since)
+{
+    auto be = qof_book_get_backend (gnc_account_get_book (acc));
+    if (be)
+        be->ensure_loaded (QOF_INSTANCE (acc), since);
+}
+
 gnc_numeric
 xaccAccountGetProjectedMinimumBalance (const Account *acc)
 {
@@ -3516,6 +4071,7 @@ xaccAccountGetProjectedMinimumBalance (const Account *acc)
 
     priv = GET_PRIVATE(acc);
     today = gnc_time64_get_today_end();
+    account_ensure_loaded (acc, today);
     for (node = g_list_last(priv->splits); node; node = node->prev)
     {
         Split *split = static_cast<Split*>(node->data);
@@ -3534,6 +4090,10 @@ xaccAccountGetProjectedMinimumBalance (const Account *acc)
             return lowest;
     }
 
+    /* Every split is still to come; the balance before them is today's. */
+    if (!seen_a_transaction ||
+        gnc_numeric_compare (priv->starting_balance, lowest) < 0)
+        lowest = priv->starting_balance;
     return lowest;
 }
 
@@ -3541,36 +4101,38 @@ xaccAccountGetProjectedMinimumBalance (const Account *acc)
 /********************************************************************\
 \********************************************************************/
 
+/* The account must be sorted and its running balances current. Once
+ * sorted every split is in the order tree, whose primary key is the
+ * posted date, and carries its running balance: the last split posted
+ * before date is found by bisection. Before the first split it's the
+ * starting balance, what a backend's unloaded splits add up to. */
 static gnc_numeric
-GetBalanceAsOfDate (Account *acc, time64 date, gboolean ignclosing)
+split_index_balance_before (AccountPrivate *priv, time64 date,
+                            gboolean ignclosing)
 {
-    /* Ideally this could use xaccAccountForEachSplit, but
-     * it doesn't exist yet and I'm uncertain of exactly how
-     * it would work at this time, since it differs from
-     * xaccAccountForEachTransaction by using gpointer return
-     * values rather than gints.
-     */
-    Split *latest = nullptr;
+    auto& order = priv->split_index->order;
+    auto it = order.lower_bound (date);
+    if (it == order.begin ())
+        return ignclosing ? priv->starting_noclosing_balance :
+            priv->starting_balance;
+    auto latest = *std::prev (it);
+
+    if (ignclosing)
+        return xaccSplitGetNoclosingBalance (latest);
+    else
+        return xaccSplitGetBalance (latest);
+}
 
+static gnc_numeric
+GetBalanceAsOfDate (Account *acc, time64 date, gboolean ignclosing)
+{
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), gnc_numeric_zero());
 
+    account_ensure_loaded (acc, date);
     xaccAccountSortSplits (acc, TRUE); /* just in case, normally a noop */
     xaccAccountRecomputeBalance (acc); /* just in case, normally a noop */
 
-    for (GList *lp = GET_PRIVATE(acc)->splits; lp; lp = lp->next)
-    {
-        if (xaccTransGetDate (xaccSplitGetParent ((Split *)lp->data)) >= date)
-            break;
-        latest = (Split *)lp->data;
-    }
-
-    if (!latest)
-        return gnc_numeric_zero();
-
-    if (ignclosing)
-        return xaccSplitGetNoclosingBalance (latest);
-    else
-        return xaccSplitGetBalance (latest);
+    return split_index_balance_before (GET_PRIVATE(acc), date, ignclosing);
 }
 
 gnc_numeric
@@ -3945,6 +4507,88 @@ xaccAccountGetNoclosingBalanceChangeForPeriod (Account *acc, time64 t1,
     return gnc_numeric_sub(b2, b1, GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED);
 }
 
+gnc_numeric *
+xaccAccountGetBalancesAsOfDates (Account *acc, const time64 *dates,
+                                 gsize n_dates,
+                                 const gnc_commodity *report_commodity,
+                                 gboolean ignclosing,
+                                 gboolean include_children,
+                                 gsize *n_accounts)
+{
+    g_return_val_if_fail (GNC_IS_ACCOUNT(acc), nullptr);
+    g_return_val_if_fail (dates || !n_dates, nullptr);
+
+    std::vector<Account*> accounts{acc};
+    if (include_children)
+    {
+        auto descendants = gnc_account_get_descendants (acc);
+        for (auto node = descendants; node; node = node->next)
+            accounts.push_back (static_cast<Account*>(node->data));
+        g_list_free (descendants);
+    }
+    if (!report_commodity)
+        report_commodity = xaccAccountGetCommodity (acc);
+    if (n_accounts)
+        *n_accounts = accounts.size ();
+
+    auto pdb = gnc_pricedb_get_db (gnc_account_get_book (acc));
+    auto fraction = report_commodity ?
+        gnc_commodity_get_fraction (report_commodity) : 0;
+    /* One row of nearest-before rates per commodity, looked up on
+     * first use and shared by every account holding it. */
+    std::unordered_map<const gnc_commodity*, std::vector<gnc_numeric>> rates;
+    auto balances = g_new (gnc_numeric, accounts.size () * n_dates);
+    auto row = balances;
+
+    for (auto account : accounts)
+    {
+        auto priv = GET_PRIVATE(account);
+        bool convert = report_commodity &&
+            !gnc_commodity_equiv (priv->commodity, report_commodity);
+        std::vector<gnc_numeric> *rate_row = nullptr;
+
+        if (n_dates)
+            account_ensure_loaded (account,
+                                   *std::min_element (dates, dates + n_dates));
+        xaccAccountSortSplits (account, TRUE);
+        xaccAccountRecomputeBalance (account);
+
+        /* The running balances start from the starting balance, which
+         * a backend sets for splits it hasn't loaded; the sums here
+         * start from zero like the report code they replace. */
+        auto start = ignclosing ? priv->starting_noclosing_balance :
+            priv->starting_balance;
+
+        for (gsize i = 0; i < n_dates; ++i)
+        {
+            auto bal = split_index_balance_before (priv, dates[i], ignclosing);
+            bal = gnc_numeric_sub_fixed (bal, start);
+            if (convert && !gnc_numeric_zero_p (bal))
+            {
+                if (!rate_row)
+                {
+                    rate_row = &rates[priv->commodity];
+                    if (rate_row->empty ())
+                        for (gsize j = 0; j < n_dates; ++j)
+                            rate_row->push_back (
+                                gnc_pricedb_get_nearest_before_price (
+                                    pdb, priv->commodity, report_commodity,
+                                    dates[j]));
+                }
+                auto rate = (*rate_row)[i];
+                /* As in the price DB an invalid rate gives zero, see 798015 */
+                bal = gnc_numeric_check (rate) ? gnc_numeric_zero () :
+                    gnc_numeric_mul (bal, rate, fraction,
+                                     GNC_HOW_DENOM_EXACT | GNC_HOW_RND_ROUND);
+            }
+            row[i] = bal;
+        }
+        row += n_dates;
+    }
+
+    return balances;
+}
+
 
 /********************************************************************\
 \********************************************************************/
@@ -3964,6 +4608,7 @@ SplitList *
 xaccAccountGetSplitList (const Account *acc)
 {
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), NULL);
+    account_ensure_loaded (acc, INT64_MIN);
     xaccAccountSortSplits((Account*)acc, FALSE);  // normally a noop
     return GET_PRIVATE(acc)->splits;
 }
@@ -4064,6 +4709,38 @@ xaccAccountForEachLot(const Account *acc,
     return result;
 }
 
+gpointer
+xaccAccountForEachOpenLotByDate (const Account *acc, gboolean positive,
+                                 gboolean latest,
+                                 gpointer (*proc)(GNCLot *lot, void *data),
+                                 void *data)
+{
+    AccountLotIndex *idx;
+    gpointer result = NULL;
+
+    g_return_val_if_fail(GNC_IS_ACCOUNT(acc), NULL);
+    g_return_val_if_fail(proc, NULL);
+
+    idx = GET_PRIVATE(acc)->lot_index;
+    lot_index_update (idx);
+
+    int sign = positive ? 1 : -1;
+    auto first = idx->open.lower_bound (OpenLotKey {sign, INT64_MIN, 0});
+    auto last = idx->open.upper_bound (OpenLotKey {sign, INT64_MAX, UINT64_MAX});
+    if (latest)
+    {
+        for (auto it = last; it != first && !result;)
+            result = proc ((--it)->second, data);
+    }
+    else
+    {
+        for (auto it = first; it != last && !result; ++it)
+            result = proc (it->second, data);
+    }
+
+    return result;
+}
+
 static void
 set_boolean_key (Account *acc, std::vector<std::string> const & path, gboolean option)
 {
@@ -5078,6 +5755,29 @@ xaccAccountGetReconcileChildrenStatus(const Account *acc)
 /********************************************************************\
 \********************************************************************/
 
+/* The list is in date order, so iterating backwards finds the most
+ * recent match. Splits posted before since may not all be loaded, so a
+ * match among them doesn't count.
+ */
+static Split *
+finder_latest_split (AccountPrivate *priv, const char *description,
+                     time64 since)
+{
+    GList *slp;
+
+    for (slp = g_list_last(priv->splits); slp; slp = slp->prev)
+    {
+        Split *lsplit = static_cast<Split*>(slp->data);
+        Transaction *ltrans = xaccSplitGetParent(lsplit);
+
+        if (xaccTransGetDate (ltrans) < since)
+            break;
+        if (g_strcmp0 (description, xaccTransGetDescription (ltrans)) == 0)
+            return lsplit;
+    }
+    return NULL;
+}
+
 /* The caller of this function can get back one or both of the
  * matching split and transaction pointers, depending on whether
  * a valid pointer to the location to store those pointers is
@@ -5088,7 +5788,8 @@ finder_help_function(const Account *acc, const char *description,
                      Split **split, Transaction **trans )
 {
     AccountPrivate *priv;
-    GList *slp;
+    Split *lsplit;
+    time64 since;
 
     /* First, make sure we set the data to NULL BEFORE we start */
     if (split) *split = NULL;
@@ -5097,22 +5798,21 @@ finder_help_function(const Account *acc, const char *description,
     /* Then see if we have any work to do */
     if (acc == NULL) return;
 
-    /* Why is this loop iterated backwards ?? Presumably because the split
-     * list is in date order, and the most recent matches should be
-     * returned!?  */
+    /* A description is usually typed again soon after, so look through
+     * the last year first and only load the whole history if that fails. */
     priv = GET_PRIVATE(acc);
-    for (slp = g_list_last(priv->splits); slp; slp = slp->prev)
+    since = gnc_time64_get_today_start () - 365 * 24 * 60 * 60;
+    account_ensure_loaded (acc, since);
+    lsplit = finder_latest_split (priv, description, since);
+    if (!lsplit)
     {
-        Split *lsplit = static_cast<Split*>(slp->data);
-        Transaction *ltrans = xaccSplitGetParent(lsplit);
-
-        if (g_strcmp0 (description, xaccTransGetDescription (ltrans)) == 0)
-        {
-            if (split) *split = lsplit;
-            if (trans) *trans = ltrans;
-            return;
-        }
+        account_ensure_loaded (acc, INT64_MIN);
+        lsplit = finder_latest_split (priv, description, INT64_MIN);
     }
+    if (!lsplit) return;
+
+    if (split) *split = lsplit;
+    if (trans) *trans = xaccSplitGetParent (lsplit);
 }
 
 Split *
@@ -5318,6 +6018,7 @@ xaccAccountStagedTransactionTraversal (const Account *acc,
 
     if (!acc) return 0;
 
+    account_ensure_loaded (acc, INT64_MIN);
     priv = GET_PRIVATE(acc);
     for (split_p = priv->splits; split_p; split_p = next)
     {
@@ -5367,6 +6068,7 @@ gnc_account_tree_staged_transaction_traversal (const Account *acc,
     }
 
     /* Now this account */
+    account_ensure_loaded (acc, INT64_MIN);
     for (split_p = priv->splits; split_p; split_p = g_list_next(split_p))
     {
         s = static_cast <Split*> (split_p->data);
@@ -6052,6 +6754,209 @@ gnc_account_delete_all_bayes_maps (Account *acc)
     }
 }
 
+/* ================================================================ */
+/* Split query index
+ *
+ * A split search whose terms restrict the account, or the posted date
+ * of the transaction, is answered from the accounts' split indexes:
+ * the splits of the matching accounts, bisected down to the posted
+ * date range, rather than every split in the book.  Other terms, such
+ * as the reconcile state, are left to the query to check on these
+ * candidates.
+ *
+ * A split only moves into its new account's index when its transaction
+ * is committed, so the splits of transactions with an edit open that
+ * aren't in the index they will go to are handed over as well.
+ */
+struct SplitQueryRange
+{
+    const GList *account_guids = nullptr;
+    bool by_account = false;
+    time64 start = INT64_MIN;
+    time64 end = INT64_MAX;
+};
+
+static bool
+query_param_path_is (const GSList *path,
+                     std::initializer_list<const char*> names)
+{
+    for (auto name : names)
+    {
+        if (!path || g_strcmp0 (static_cast<const char*>(path->data), name))
+            return false;
+        path = path->next;
+    }
+    return path == nullptr;
+}
+
+static void
+split_query_range_add_term (SplitQueryRange& range, const QofQueryTerm *qt)
+{
+    auto path = qof_query_term_get_param_path (qt);
+    auto pd = qof_query_term_get_pred_data (qt);
+
+    if (!pd || qof_query_term_is_inverted (qt))
+        return;
+
+    if (!g_strcmp0 (pd->type_name, QOF_TYPE_GUID) &&
+        (query_param_path_is (path, {SPLIT_ACCOUNT, QOF_PARAM_GUID}) ||
+         query_param_path_is (path, {SPLIT_ACCOUNT_GUID})))
+    {
+        auto pdata = reinterpret_cast<const query_guid_def*>(pd);
+        if (pdata->options != QOF_GUID_MATCH_ANY)
+            return;
+        /* Of several account terms, the shortest list is the tightest. */
+        if (!range.by_account ||
+            g_list_length (pdata->guids) <
+            g_list_length (const_cast<GList*>(range.account_guids)))
+            range.account_guids = pdata->guids;
+        range.by_account = true;
+    }
+    else if (!g_strcmp0 (pd->type_name, QOF_TYPE_DATE) &&
+             query_param_path_is (path, {SPLIT_TRANS, TRANS_DATE_POSTED}))
+    {
+        auto pdata = reinterpret_cast<const query_date_def*>(pd);
+        auto lo = pdata->date, hi = pdata->date;
+
+        if (pdata->options == QOF_DATE_MATCH_DAY)
+        {
+            lo = gnc_time64_get_day_start (pdata->date);
+            hi = gnc_time64_get_day_end (pdata->date);
+        }
+        if (pd->how == QOF_COMPARE_GT || pd->how == QOF_COMPARE_GTE ||
+            pd->how == QOF_COMPARE_EQUAL)
+            range.start = std::max (range.start, lo);
+        if (pd->how == QOF_COMPARE_LT || pd->how == QOF_COMPARE_LTE ||
+            pd->how == QOF_COMPARE_EQUAL)
+            range.end = std::min (range.end, hi);
+    }
+}
+
+/* Hand over the splits of acc posted between start and end, both
+ * included, along with the ones whose place isn't known yet. */
+static void
+split_query_account_range (Account *acc, time64 start, time64 end,
+                           QofInstanceForeachCB cb, gpointer user_data)
+{
+    auto priv = GET_PRIVATE(acc);
+    auto idx = priv->split_index;
+
+    /* The tree keys may be stale until the whole list is resorted. */
+    if (idx->full_resort)
+    {
+        for (auto node = priv->splits; node; node = node->next)
+            cb (QOF_INSTANCE(node->data), user_data);
+        return;
+    }
+
+    if (start <= end)
+    {
+        auto last = idx->order.upper_bound (end);
+        for (auto it = idx->order.lower_bound (start); it != last; ++it)
+            cb (QOF_INSTANCE(*it), user_data);
+    }
+
+    /* A split removed and added back may be listed twice. */
+    std::vector<Split*> pending;
+    for (auto split : idx->pending)
+    {
+        auto it = idx->entries.find (split);
+        if (it != idx->entries.end () && !it->second.placed)
+            pending.push_back (split);
+    }
+    std::sort (pending.begin (), pending.end ());
+    auto last = std::unique (pending.begin (), pending.end ());
+    for (auto it = pending.begin (); it != last; ++it)
+        cb (QOF_INSTANCE(*it), user_data);
+}
+
+static void
+collect_query_account (QofInstance *inst, gpointer user_data)
+{
+    static_cast<std::vector<Account*>*>(user_data)->push_back (GNC_ACCOUNT(inst));
+}
+
+static bool
+split_in_index (const Account *acc, Split *split)
+{
+    return acc && GET_PRIVATE(acc)->split_index->entries.count (split);
+}
+
+/* The splits of the transactions being edited, which may not be in the
+ * index of the account they name yet. */
+static std::vector<Split*>
+split_query_open_splits (QofBook *book)
+{
+    std::vector<Split*> splits;
+    auto open = xaccTransGetOpenList ();
+    for (auto node = open; node; node = node->next)
+    {
+        auto trans = static_cast<Transaction*>(node->data);
+        if (qof_instance_get_book (trans) != book)
+            continue;
+        for (auto snode = trans->splits; snode; snode = snode->next)
+            splits.push_back (static_cast<Split*>(snode->data));
+    }
+    g_list_free (open);
+    return splits;
+}
+
+static gboolean
+split_query_index (QofBook *book, const GList *and_terms,
+                   QofInstanceForeachCB cb, gpointer user_data)
+{
+    SplitQueryRange range;
+
+    for (auto node = and_terms; node; node = node->next)
+        split_query_range_add_term (range,
+                                    static_cast<QofQueryTerm*>(node->data));
+
+    if (range.by_account)
+    {
+        auto open_splits = split_query_open_splits (book);
+        std::unordered_set<Account*> seen;
+        for (auto node = range.account_guids; node; node = node->next)
+        {
+            auto acc = xaccAccountLookup (static_cast<GncGUID*>(node->data), book);
+            if (!acc || !seen.insert (acc).second)
+                continue;
+            split_query_account_range (acc, range.start, range.end,
+                                       cb, user_data);
+            /* The ones moved out of acc are still in its index. */
+            for (auto split : open_splits)
+                if (split->acc == acc && !split_in_index (acc, split))
+                    cb (QOF_INSTANCE(split), user_data);
+        }
+        return TRUE;
+    }
+
+    if (range.start == INT64_MIN && range.end == INT64_MAX)
+        return FALSE;
+
+    /* A date range alone is served by walking every account, which is
+     * only complete while every split of the book is in an index or
+     * being edited. A split being moved is in the index it came from. */
+    std::vector<Split*> unfiled;
+    for (auto split : split_query_open_splits (book))
+        if (!split_in_index (split->acc, split) &&
+            !split_in_index (split->orig_acc, split))
+            unfiled.push_back (split);
+    std::vector<Account*> all;
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_ACCOUNT),
+                            collect_query_account, &all);
+    guint n_splits = unfiled.size ();
+    for (auto acc : all)
+        n_splits += GET_PRIVATE(acc)->split_index->entries.size ();
+    if (n_splits != qof_collection_count (qof_book_get_collection (book, GNC_ID_SPLIT)))
+        return FALSE;
+
+    for (auto acc : all)
+        split_query_account_range (acc, range.start, range.end, cb, user_data);
+    for (auto split : unfiled)
+        cb (QOF_INSTANCE(split), user_data);
+    return TRUE;
+}
+
 /* ================================================================ */
 /* QofObject function implementation and registration */
 
@@ -6193,6 +7098,7 @@ gboolean xaccAccountRegister (void)
     };
 
     qof_class_register (GNC_ID_ACCOUNT, (QofSortFunc) qof_xaccAccountOrder, params);
+    qof_query_register_index (GNC_ID_SPLIT, split_query_index);
 
     return qof_object_register (&account_object_def);
 }
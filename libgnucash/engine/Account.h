@@ -355,8 +355,17 @@ void gnc_account_set_start_cleared_balance (Account *acc,
 void gnc_account_set_start_reconciled_balance (Account *acc,
         const gnc_numeric start_baln);
 
+/** This function will set the starting commodity balance for this
+ *  account, ignoring the splits of closing transactions.  Like the
+ *  other starting balances it is intended for use with backends that
+ *  do not return the complete list of splits for an account. */
+void gnc_account_set_start_noclosing_balance (Account *acc,
+        const gnc_numeric start_baln);
+
 /** Tell the account that the running balances may be incorrect and
- *  need to be recomputed.
+ *  need to be recomputed.  Unlike the dirtying done when a split
+ *  changes, this makes the next recomputation start from the first
+ *  split.
  *
  *  @param acc Set the flag on this account. */
 void gnc_account_set_balance_dirty (Account *acc);
@@ -621,6 +630,35 @@ gnc_numeric xaccAccountGetNoclosingBalanceChangeForPeriod (
 gnc_numeric xaccAccountGetBalanceChangeForPeriod (
     Account *acc, time64 date1, time64 date2, gboolean recurse);
 
+/** Get the balances of an account, and optionally of all its
+    descendants, at many dates in one call.  Each account is sorted
+    and has its running balances recomputed once; the dates are then
+    answered by bisection and each commodity's rates to
+    report_commodity are looked up once per date, however many
+    accounts hold it.
+
+    As with xaccAccountGetBalanceAsOfDate, splits posted exactly on a
+    date are not included in the balance for that date.  Unlike it,
+    the account's starting balance is not included: each balance is
+    the sum of the account's splits posted before the date.
+
+    @param acc The account.
+    @param dates The dates; results follow their order.
+    @param n_dates The number of dates.
+    @param report_commodity The commodity to convert balances to, or
+    NULL to use the commodity of acc.
+    @param ignclosing If TRUE, leave out closing transactions.
+    @param include_children If TRUE, add a row for every descendant in
+    the order of gnc_account_get_descendants.  Rows hold each account's
+    own balance; children are not summed into their parent.
+    @param n_accounts Returns the number of rows, may be NULL.
+    @return A newly allocated row-major array of n_accounts * n_dates
+    balances, with acc in the first row.  Free it with g_free. */
+gnc_numeric *xaccAccountGetBalancesAsOfDates (
+    Account *acc, const time64 *dates, gsize n_dates,
+    const gnc_commodity *report_commodity, gboolean ignclosing,
+    gboolean include_children, gsize *n_accounts);
+
 /** @} */
 
 /** @name Account Children and Parents.
@@ -1141,6 +1179,18 @@ gpointer xaccAccountForEachLot(
     const Account *acc,
     gpointer (*proc)(GNCLot *lot, gpointer user_data), /*@ null @*/ gpointer user_data);
 
+/** The xaccAccountForEachOpenLotByDate() method is like
+ *    xaccAccountForEachLot(), but only visits the open lots whose
+ *    earliest split has a positive amount, or a negative one if
+ *    'positive' is FALSE.  They are visited in the order of that
+ *    split's post date, latest first if 'latest' is TRUE.  The lots
+ *    are kept in an index, so finding the first one doesn't look at
+ *    the account's other lots.  'proc' must not change any lots.
+ */
+gpointer xaccAccountForEachOpenLotByDate (
+    const Account *acc, gboolean positive, gboolean latest,
+    gpointer (*proc)(GNCLot *lot, gpointer user_data), /*@ null @*/ gpointer user_data);
+
 
 /** Find a list of open lots that match the match_func.  Sort according
  * to sort_func.  If match_func is NULL, then all open lots are returned.
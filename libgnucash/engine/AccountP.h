@@ -125,8 +125,14 @@ typedef struct AccountPrivate
 
     GList *splits;              /* list of split pointers */
     gboolean sort_dirty;        /* sort order of splits is bad */
+    /* Ordered index over the splits; owns the nodes of the splits list.
+     * Opaque outside of Account.cpp. */
+    struct AccountSplitIndex *split_index;
 
     LotList   *lots;		/* list of lot pointers */
+    /* The open lots ordered by their opening split.  Opaque outside
+     * of Account.cpp. */
+    struct AccountLotIndex *lot_index;
     GNCPolicy *policy;		/* Cached pointer to policy method */
 
     TriState sort_reversed;
@@ -156,6 +162,29 @@ struct account_s
  * call this on an existing account! */
 void xaccAccountSetGUID (Account *account, const GncGUID *guid);
 
+/* Tell the account that the sort key of one of its splits (its
+ * transaction's date or num, its memo, amount, reconcile state, ...)
+ * may have changed.  Only that split gets repositioned by the next
+ * xaccAccountSortSplits() instead of the whole list being resorted. */
+void gnc_account_mark_split_dirty (Account *acc, Split *split);
+
+/* Tell the account that one of its lots may have been opened or
+ * closed, or that its earliest split may have changed.  The lot is
+ * looked at again the next time the open lots are searched. */
+void gnc_account_mark_lot_dirty (Account *acc, GNCLot *lot);
+
+/* Compare two lots of acc by when they were put in it, oldest first,
+ * which is the order xaccAccountFindOpenLots returns them in. */
+gint gnc_account_lot_order (const Account *acc, const GNCLot *lot_a,
+                            const GNCLot *lot_b);
+
+/* Sort the splits and recompute the running balances of root and all
+ * of its descendants, spreading the accounts over a thread pool.  The
+ * accounts may still be open for editing, as they are while a book is
+ * loading; their splits must not change while this runs.  Events are
+ * suspended throughout. */
+void gnc_account_tree_sort_and_recompute (Account *root);
+
 /* Register Accounts with the engine */
 gboolean xaccAccountRegister (void);
 
@@ -81,8 +81,10 @@ gains_possible (GNCLot *lot)
  * happen is we'll end up with an empty, closed lot ... ?
  */
 
-gboolean
-xaccScrubLot (GNCLot *lot)
+/* Scrub the lot as xaccScrubLot() does, leaving out the cap gains if
+ * compute_gains is FALSE. */
+static gboolean
+scrub_lot (GNCLot *lot, gboolean compute_gains)
 {
     gboolean splits_deleted = FALSE;
     gnc_numeric lot_baln;
@@ -142,7 +144,7 @@ rethin:
      * selling dollars for dollars.  The business modules
      * use lots with lot commodity == lot currency.
      */
-    if (gains_possible (lot))
+    if (compute_gains && gains_possible (lot))
     {
         xaccLotComputeCapGains (lot, NULL);
         xaccLotScrubDoubleBalance (lot);
@@ -153,10 +155,16 @@ rethin:
     return splits_deleted;
 }
 
+gboolean
+xaccScrubLot (GNCLot *lot)
+{
+    return scrub_lot (lot, TRUE);
+}
+
 /* ============================================================== */
 
-void
-xaccAccountScrubLots (Account *acc)
+static void
+account_scrub_lots (Account *acc, gboolean compute_gains)
 {
     LotList *lots, *node;
     if (!acc) return;
@@ -170,20 +178,43 @@ xaccAccountScrubLots (Account *acc)
     for (node = lots; node; node = node->next)
     {
         GNCLot *lot = node->data;
-        xaccScrubLot (lot);
+        scrub_lot (lot, compute_gains);
     }
     g_list_free(lots);
     xaccAccountCommitEdit(acc);
     LEAVE ("(acc=%s)", xaccAccountGetName(acc));
 }
 
+void
+xaccAccountScrubLots (Account *acc)
+{
+    account_scrub_lots (acc, TRUE);
+}
+
 /* ============================================================== */
 
 static void
 lot_scrub_cb (Account *acc, gpointer data)
 {
+    account_scrub_lots (acc, FALSE);
+}
+
+static void
+lot_double_balance_cb (Account *acc, gpointer data)
+{
+    LotList *lots, *node;
     if (FALSE == xaccAccountHasTrades (acc)) return;
-    xaccAccountScrubLots (acc);
+
+    xaccAccountBeginEdit(acc);
+    lots = xaccAccountGetLotList(acc);
+    for (node = lots; node; node = node->next)
+    {
+        GNCLot *lot = node->data;
+        if (gains_possible (lot))
+            xaccLotScrubDoubleBalance (lot);
+    }
+    g_list_free(lots);
+    xaccAccountCommitEdit(acc);
 }
 
 void
@@ -191,8 +222,13 @@ xaccAccountTreeScrubLots (Account *acc)
 {
     if (!acc) return;
 
+    /* Straighten out the lots of all the accounts first, then compute
+     * all of their gains in one go, then double-check them. */
     gnc_account_foreach_descendant(acc, lot_scrub_cb, NULL);
-    xaccAccountScrubLots (acc);
+    lot_scrub_cb (acc, NULL);
+    xaccAccountTreeComputeCapGains (acc, NULL);
+    gnc_account_foreach_descendant(acc, lot_double_balance_cb, NULL);
+    lot_double_balance_cb (acc, NULL);
 }
 
 /* ========================== END OF FILE  ========================= */
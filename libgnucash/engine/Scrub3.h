@@ -62,6 +62,10 @@ gboolean xaccScrubLot (GNCLot *lot);
  *    lot structure, and the cap-gains for an account are in good
  *    order.
  *
+ *    xaccAccountTreeScrubLots() does the same for the account and all
+ *    of its descendants, computing the cap gains of all of them in one
+ *    go with xaccAccountTreeComputeCapGains().
+ *
  * Most GUI routines will want to use one of these xacc[*]ScrubLots()
  * routines, instead of the various component routines, since it will
  * usually makes sense to work only with these high-level routines.
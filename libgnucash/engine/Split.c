@@ -733,11 +733,29 @@ void mark_split (Split *s)
 {
     if (s->acc)
     {
-        g_object_set(s->acc, "sort-dirty", TRUE, "balance-dirty", TRUE, NULL);
+        gnc_account_mark_split_dirty (s->acc, s);
     }
 
     /* set dirty flag on lot too. */
-    if (s->lot) gnc_lot_set_closed_unknown(s->lot);
+    if (s->lot) gnc_lot_split_changed(s->lot, s);
+}
+
+void mark_split_unsorted (Split *s)
+{
+    /* Until the transaction is committed the split is still filed under
+     * the account it was in before. */
+    if (s->orig_acc)
+        gnc_account_mark_split_dirty (s->orig_acc, s);
+    if (s->acc && s->acc != s->orig_acc)
+        gnc_account_mark_split_dirty (s->acc, s);
+}
+
+void
+xaccSplitSetGUID (Split *s, const GncGUID *guid)
+{
+    g_return_if_fail (s);
+    mark_split_unsorted (s);
+    qof_instance_set_guid (QOF_INSTANCE (s), guid);
 }
 
 /*
@@ -1034,7 +1052,7 @@ xaccSplitCommitEdit(Split *s)
 
     if (acc)
     {
-        g_object_set(acc, "sort-dirty", TRUE, "balance-dirty", TRUE, NULL);
+        gnc_account_mark_split_dirty (acc, s);
         xaccAccountRecomputeBalance(acc);
     }
 }
@@ -1171,6 +1189,7 @@ xaccSplitSetSharePriceAndAmount (Split *s, gnc_numeric price, gnc_numeric amt)
     ENTER (" ");
     xaccTransBeginEdit (s->parent);
 
+    mark_split_unsorted (s);
     s->amount = gnc_numeric_convert(amt, get_commodity_denom(s),
                                     GNC_HOW_RND_ROUND_HALF_UP);
     s->value  = gnc_numeric_mul(s->amount, price,
@@ -1187,6 +1206,7 @@ static void
 qofSplitSetSharePrice (Split *split, gnc_numeric price)
 {
     g_return_if_fail(split);
+    mark_split_unsorted (split);
     split->value = gnc_numeric_mul(xaccSplitGetAmount(split),
                                    price, get_currency_denom(split),
                                    GNC_HOW_RND_ROUND_HALF_UP);
@@ -1199,6 +1219,7 @@ xaccSplitSetSharePrice (Split *s, gnc_numeric price)
     ENTER (" ");
     xaccTransBeginEdit (s->parent);
 
+    mark_split_unsorted (s);
     s->value = gnc_numeric_mul(xaccSplitGetAmount(s),
                                price, get_currency_denom(s),
                                GNC_HOW_RND_ROUND_HALF_UP);
@@ -1214,6 +1235,7 @@ static void
 qofSplitSetAmount (Split *split, gnc_numeric amt)
 {
     g_return_if_fail(split);
+    mark_split_unsorted (split);
     if (split->acc)
     {
         split->amount = gnc_numeric_convert(amt,
@@ -1236,6 +1258,7 @@ xaccSplitSetAmount (Split *s, gnc_numeric amt)
            s->amount.num, s->amount.denom, amt.num, amt.denom);
 
     xaccTransBeginEdit (s->parent);
+    mark_split_unsorted (s);
     if (s->acc)
     {
         s->amount = gnc_numeric_convert(amt, get_commodity_denom(s),
@@ -1256,6 +1279,7 @@ static void
 qofSplitSetValue (Split *split, gnc_numeric amt)
 {
     g_return_if_fail(split);
+    mark_split_unsorted (split);
     split->value = gnc_numeric_convert(amt,
                                        get_currency_denom(split), GNC_HOW_RND_ROUND_HALF_UP);
     g_assert(gnc_numeric_check (split->value) != GNC_ERROR_OK);
@@ -1278,7 +1302,10 @@ xaccSplitSetValue (Split *s, gnc_numeric amt)
                                   GNC_HOW_RND_ROUND_HALF_UP);
     if (gnc_numeric_check(new_val) == GNC_ERROR_OK &&
         !(gnc_numeric_zero_p (new_val) && !gnc_numeric_zero_p (amt)))
+    {
+        mark_split_unsorted (s);
         s->value = new_val;
+    }
     else PERR("numeric error %s in converting the split value's denominator with amount %s and denom  %d", gnc_numeric_errorCode_to_string(gnc_numeric_check(new_val)), gnc_numeric_to_string(amt), get_currency_denom(s));
 
     SET_GAINS_VDIRTY(s);
@@ -1337,6 +1364,7 @@ xaccSplitSetBaseValue (Split *s, gnc_numeric value,
     /* If the base_currency is the transaction's commodity ('currency'),
      * set the value.  If it's the account commodity, set the
      * amount. If both, set both. */
+    mark_split_unsorted (s);
     if (gnc_commodity_equiv(currency, base_currency))
     {
         if (gnc_commodity_equiv(commodity, base_currency))
@@ -1721,6 +1749,7 @@ static void
 qofSplitSetMemo (Split *split, const char* memo)
 {
     g_return_if_fail(split);
+    mark_split_unsorted (split);
     CACHE_REPLACE(split->memo, memo);
 }
 
@@ -1730,6 +1759,7 @@ xaccSplitSetMemo (Split *split, const char *memo)
     if (!split || !memo) return;
     xaccTransBeginEdit (split->parent);
 
+    mark_split_unsorted (split);
     CACHE_REPLACE(split->memo, memo);
     qof_instance_set_dirty(QOF_INSTANCE(split));
     xaccTransCommitEdit(split->parent);
@@ -1740,6 +1770,7 @@ static void
 qofSplitSetAction (Split *split, const char *actn)
 {
     g_return_if_fail(split);
+    mark_split_unsorted (split);
     CACHE_REPLACE(split->action, actn);
 }
 
@@ -1749,6 +1780,7 @@ xaccSplitSetAction (Split *split, const char *actn)
     if (!split || !actn) return;
     xaccTransBeginEdit (split->parent);
 
+    mark_split_unsorted (split);
     CACHE_REPLACE(split->action, actn);
     qof_instance_set_dirty(QOF_INSTANCE(split));
     xaccTransCommitEdit(split->parent);
@@ -1766,6 +1798,7 @@ qofSplitSetReconcile (Split *split, char recn)
         case YREC:
         case FREC:
         case VREC:
+            mark_split_unsorted (split);
             split->reconciled = recn;
             mark_split (split);
             xaccAccountRecomputeBalance (split->acc);
@@ -1789,6 +1822,7 @@ xaccSplitSetReconcile (Split *split, char recn)
         case YREC:
         case FREC:
         case VREC:
+            mark_split_unsorted (split);
             split->reconciled = recn;
             mark_split (split);
             qof_instance_set_dirty(QOF_INSTANCE(split));
@@ -1808,6 +1842,7 @@ xaccSplitSetDateReconciledSecs (Split *split, time64 secs)
     if (!split) return;
     xaccTransBeginEdit (split->parent);
 
+    mark_split_unsorted (split);
     split->date_reconciled = secs;
     qof_instance_set_dirty(QOF_INSTANCE(split));
     xaccTransCommitEdit(split->parent);
@@ -1856,6 +1891,7 @@ xaccSplitSetParent(Split *s, Transaction *t)
         ed.idx = xaccTransGetSplitIndex(old_trans, s);
         qof_event_gen(&old_trans->inst, GNC_EVENT_ITEM_REMOVED, &ed);
     }
+    mark_split_unsorted (s);
     s->parent = t;
 
     xaccTransCommitEdit(old_trans);
@@ -2004,6 +2040,7 @@ xaccSplitMakeStockSplit(Split *s)
     GValue v = G_VALUE_INIT;
     xaccTransBeginEdit (s->parent);
 
+    mark_split_unsorted (s);
     s->value = gnc_numeric_zero();
     g_value_init (&v, G_TYPE_STRING);
     g_value_set_static_string (&v, split_type_stock_split);
@@ -138,8 +138,10 @@ struct _SplitClass
 
 /* Set the split's GncGUID. This should only be done when reading
  * a split from a datafile, or some other external source. Never
- * call this on an existing split! */
-#define xaccSplitSetGUID(s,g) qof_instance_set_guid(QOF_INSTANCE(s),g)
+ * call this on an existing split! The guid is the last key of
+ * xaccSplitOrder(), so a split already in an account is taken out of
+ * its sort order first. */
+void xaccSplitSetGUID (Split *s, const GncGUID *guid);
 
 /* The xaccFreeSplit() method simply frees all memory associated
  * with the split.  It does not verify that the split isn't
@@ -154,6 +156,10 @@ void xaccSplitCopyKvp (const Split *from, Split *to);
 
 Split *xaccDupeSplit (const Split *s);
 void mark_split (Split *s);
+/* Take the split out of its account's sort order.  Must be called
+ * before changing any field that xaccSplitOrder() compares; the account
+ * puts the split back in place the next time it sorts its splits. */
+void mark_split_unsorted (Split *s);
 
 void xaccSplitVoid(Split *split);
 void xaccSplitUnvoid(Split *split);
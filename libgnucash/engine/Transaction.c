@@ -189,6 +189,10 @@ const char *doclink_uri_str = "assoc_uri"; // this is the old name for the docum
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = GNC_MOD_ENGINE;
 
+/* The transactions holding a rollback copy, that is with an edit open. */
+static GHashTable *open_trans = NULL;
+G_LOCK_DEFINE_STATIC (open_trans);
+
 enum
 {
     PROP_0,
@@ -234,6 +238,25 @@ void mark_trans (Transaction *trans)
     FOR_EACH_SPLIT(trans, mark_split(s));
 }
 
+/* Call before changing a field that xaccTransOrder() compares: takes
+ * every split of the transaction, including the ones being removed,
+ * out of its account's sort order. */
+static void
+mark_trans_unsorted (Transaction *trans)
+{
+    GList *node;
+    for (node = trans->splits; node; node = node->next)
+        mark_split_unsorted (node->data);
+}
+
+void
+xaccTransSetGUID (Transaction *trans, const GncGUID *guid)
+{
+    g_return_if_fail (trans);
+    mark_trans_unsorted (trans);
+    qof_instance_set_guid (QOF_INSTANCE (trans), guid);
+}
+
 static inline void gen_event_trans (Transaction *trans);
 void gen_event_trans (Transaction *trans)
 {
@@ -793,6 +816,21 @@ xaccTransCopyFromClipBoard(const Transaction *from_trans, Transaction *to_trans,
 /********************************************************************\
  Free the transaction.
 \********************************************************************/
+static void xaccFreeTransaction (Transaction *trans);
+
+/* Drop the rollback copy made when the edit was opened. */
+static void
+free_trans_orig (Transaction *trans)
+{
+    if (!trans->orig) return;
+
+    xaccFreeTransaction (trans->orig);
+    trans->orig = NULL;
+    G_LOCK (open_trans);
+    g_hash_table_remove (open_trans, trans);
+    G_UNLOCK (open_trans);
+}
+
 static void
 xaccFreeTransaction (Transaction *trans)
 {
@@ -835,11 +873,7 @@ xaccFreeTransaction (Transaction *trans)
     trans->doclink = NULL;
     trans->notes = NULL;
     trans->void_reason = NULL;
-    if (trans->orig)
-    {
-        xaccFreeTransaction (trans->orig);
-        trans->orig = NULL;
-    }
+    free_trans_orig (trans);
 
     /* qof_instance_release (&trans->inst); */
     g_object_unref(trans);
@@ -1467,6 +1501,21 @@ xaccTransBeginEdit (Transaction *trans)
     /* Make a clone of the transaction; we will use this
      * in case we need to roll-back the edit. */
     trans->orig = dupe_trans (trans);
+    G_LOCK (open_trans);
+    if (!open_trans)
+        open_trans = g_hash_table_new (NULL, NULL);
+    g_hash_table_add (open_trans, trans);
+    G_UNLOCK (open_trans);
+}
+
+GList *
+xaccTransGetOpenList (void)
+{
+    GList *list;
+    G_LOCK (open_trans);
+    list = open_trans ? g_hash_table_get_keys (open_trans) : NULL;
+    G_UNLOCK (open_trans);
+    return list;
 }
 
 /********************************************************************\
@@ -1634,8 +1683,7 @@ static void trans_cleanup_commit(Transaction *trans)
     /* Get rid of the copy we made. We won't be rolling back,
      * so we don't need it any more.  */
     PINFO ("get rid of rollback trans=%p", trans->orig);
-    xaccFreeTransaction (trans->orig);
-    trans->orig = NULL;
+    free_trans_orig (trans);
 
     /* Sort the splits. Why do we need to do this ?? */
     /* Good question.  Who knows?  */
@@ -1701,6 +1749,7 @@ xaccTransCommitEdit (Transaction *trans)
     /* Record the time of last modification */
     if (0 == trans->date_entered)
     {
+        mark_trans_unsorted (trans);
         trans->date_entered = gnc_time(NULL);
         qof_instance_set_dirty(QOF_INSTANCE(trans));
     }
@@ -1753,6 +1802,7 @@ xaccTransRollbackEdit (Transaction *trans)
     /* copy the original values back in. */
 
     orig = trans->orig;
+    mark_trans_unsorted (trans);
     SWAP_STR(trans->num, orig->num);
     SWAP_STR(trans->description, orig->description);
     trans->date_entered = orig->date_entered;
@@ -1822,6 +1872,9 @@ xaccTransRollbackEdit (Transaction *trans)
     g_list_free(orig->splits);
     orig->splits = NULL;
 
+    /* The amounts and post date were restored behind the lots' backs. */
+    FOR_EACH_SPLIT (trans, if (s->lot) gnc_lot_set_closed_unknown (s->lot));
+
     /* Now that the engine copy is back to its original version,
      * get the backend to fix it in the database */
     be = qof_book_get_backend(qof_instance_get_book(trans));
@@ -1867,9 +1920,7 @@ xaccTransRollbackEdit (Transaction *trans)
     if (!qof_book_is_readonly(qof_instance_get_book(trans)))
         xaccTransWriteLog (trans, 'R');
 
-    xaccFreeTransaction (trans->orig);
-
-    trans->orig = NULL;
+    free_trans_orig (trans);
     qof_instance_set_destroying(trans, FALSE);
 
     /* Put back to zero. */
@@ -1993,6 +2044,7 @@ xaccTransSetDateInternal(Transaction *trans, time64 *dadate, time64 val)
         g_free(tstr);
     }
 #endif
+    mark_trans_unsorted (trans);
     *dadate = val;
     qof_instance_set_dirty(QOF_INSTANCE(trans));
     mark_trans(trans);
@@ -2174,6 +2226,7 @@ xaccTransSetNum (Transaction *trans, const char *xnum)
     if (!trans || !xnum) return;
     xaccTransBeginEdit(trans);
 
+    mark_trans_unsorted (trans);
     CACHE_REPLACE(trans->num, xnum);
     qof_instance_set_dirty(QOF_INSTANCE(trans));
     mark_trans(trans);  /* Dirty balance of every account in trans */
@@ -2194,6 +2247,7 @@ xaccTransSetDescription (Transaction *trans, const char *desc)
     if (!trans || !desc) return;
     xaccTransBeginEdit(trans);
 
+    mark_trans_unsorted (trans);
     CACHE_REPLACE(trans->description, desc);
     qof_instance_set_dirty(QOF_INSTANCE(trans));
     xaccTransCommitEdit(trans);
@@ -2267,6 +2321,7 @@ xaccTransSetIsClosingTxn (Transaction *trans, gboolean is_closing)
     if (!trans) return;
     xaccTransBeginEdit(trans);
 
+    mark_trans_unsorted (trans);
     if (is_closing)
     {
         GValue v = G_VALUE_INIT;
@@ -2282,6 +2337,7 @@ xaccTransSetIsClosingTxn (Transaction *trans, gboolean is_closing)
         trans->isClosingTxn_cached = 0;
     }
     qof_instance_set_dirty(QOF_INSTANCE(trans));
+    mark_trans(trans);  /* Closing transactions sort and balance differently */
     xaccTransCommitEdit(trans);
 }
 
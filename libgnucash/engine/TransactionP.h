@@ -135,8 +135,10 @@ struct _TransactionClass
 
 /* Set the transaction's GncGUID. This should only be done when reading
  * a transaction from a datafile, or some other external source. Never
- * call this on an existing transaction! */
-#define xaccTransSetGUID(t,g) qof_instance_set_guid(QOF_INSTANCE(t),g)
+ * call this on an existing transaction! Its splits already in accounts
+ * are taken out of their sort order first, the guid being a key of
+ * xaccTransOrder(). */
+void xaccTransSetGUID (Transaction *trans, const GncGUID *guid);
 
 /* This routine makes a 'duplicate' of the indicated transaction.
  * This routine cannot be exposed publicly since the duplicate
@@ -181,6 +183,11 @@ void xaccEnableDataScrubbing(void);
 void xaccDisableDataScrubbing(void);
 
 void xaccTransRemoveSplit (Transaction *trans, const Split *split);
+
+/* The transactions with an edit open, during which their splits may
+ * not yet be filed in the accounts they name, in no particular order.
+ * The caller frees the list but not the transactions. */
+GList *xaccTransGetOpenList (void);
 void check_open (const Transaction *trans);
 
 /* Structure for accessing static functions for testing */
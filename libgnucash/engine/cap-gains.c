@@ -102,88 +102,49 @@ xaccAccountHasTrades (const Account *acc)
 
 /* ============================================================== */
 
-struct find_lot_s
-{
-    GNCLot *lot;
-    gnc_commodity *currency;
-    time64 time;
-    int (*numeric_pred)(gnc_numeric);
-    gboolean (*date_pred)(time64 e, time64 tr);
-};
-
-static gboolean
-earliest_pred (time64 earl, time64 tran)
-{
-    return earl > tran;
-}
-
-static gboolean
-latest_pred (time64 earl, time64 tran)
-{
-    return earl < tran;
-}
-
 static gpointer
 finder_helper (GNCLot *lot,  gpointer user_data)
 {
-    struct find_lot_s *els = user_data;
+    gnc_commodity *currency = user_data;
     Split *s;
     Transaction *trans;
     gnc_numeric bal;
     gboolean opening_is_positive, bal_is_positive;
-    time64 posted = 0;
-
-    if (gnc_lot_is_closed (lot)) return NULL;
 
     s = gnc_lot_get_earliest_split (lot);
     if (s == NULL) return NULL;
 
     /* We want a lot whose balance is of the correct sign.  All splits
-       in a lot must be the opposite sign of the opening split.  We also
-       want to ignore lots that are overfull, i.e., where the balance in
-       the lot is of opposite sign to the opening split in the lot. */
-    if (0 == (els->numeric_pred) (s->amount)) return NULL;
+       in a lot must be the opposite sign of the opening split, which
+       the account's open lot index has already picked.  We also want
+       to ignore lots that are overfull, i.e., where the balance in the
+       lot is of opposite sign to the opening split in the lot. */
     bal = gnc_lot_get_balance (lot);
     opening_is_positive = gnc_numeric_positive_p (s->amount);
     bal_is_positive = gnc_numeric_positive_p (bal);
     if (opening_is_positive != bal_is_positive) return NULL;
 
     trans = s->parent;
-    if (els->currency &&
-            (FALSE == gnc_commodity_equiv (els->currency,
+    if (currency &&
+            (FALSE == gnc_commodity_equiv (currency,
                                            trans->common_currency)))
     {
         return NULL;
     }
 
-    posted = trans->date_posted;
-    if (els->date_pred (els->time, posted))
-    {
-        els->time = trans->date_posted;
-        els->lot = lot;
-    }
-
-    return NULL;
+    return lot;
 }
 
+/* The open lots are visited in date order, so the first one that
+ * suits is the earliest or the latest one. */
 static inline GNCLot *
 xaccAccountFindOpenLot (Account *acc, gnc_numeric sign,
-                        gnc_commodity *currency,
-                        gint64 guess,
-                        gboolean (*date_pred)(time64, time64))
+                        gnc_commodity *currency, gboolean latest)
 {
-    struct find_lot_s es;
-
-    es.lot = NULL;
-    es.currency = currency;
-    es.time = guess;
-    es.date_pred = date_pred;
-
-    if (gnc_numeric_positive_p(sign)) es.numeric_pred = gnc_numeric_negative_p;
-    else es.numeric_pred = gnc_numeric_positive_p;
-
-    xaccAccountForEachLot (acc, finder_helper, &es);
-    return es.lot;
+    return xaccAccountForEachOpenLotByDate (acc,
+                                            !gnc_numeric_positive_p (sign),
+                                            latest, finder_helper,
+                                            currency);
 }
 
 GNCLot *
@@ -194,8 +155,7 @@ xaccAccountFindEarliestOpenLot (Account *acc, gnc_numeric sign,
     ENTER (" sign=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT, sign.num,
            sign.denom);
 
-    lot = xaccAccountFindOpenLot (acc, sign, currency,
-                                  G_MAXINT64, earliest_pred);
+    lot = xaccAccountFindOpenLot (acc, sign, currency, FALSE);
     LEAVE ("found lot=%p %s baln=%s", lot, gnc_lot_get_title (lot),
            gnc_num_dbg_to_string(gnc_lot_get_balance(lot)));
     return lot;
@@ -209,8 +169,7 @@ xaccAccountFindLatestOpenLot (Account *acc, gnc_numeric sign,
     ENTER (" sign=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT,
            sign.num, sign.denom);
 
-    lot = xaccAccountFindOpenLot (acc, sign, currency,
-                                  G_MININT64, latest_pred);
+    lot = xaccAccountFindOpenLot (acc, sign, currency, TRUE);
     LEAVE ("found lot=%p %s", lot, gnc_lot_get_title (lot));
     return lot;
 }
@@ -524,39 +483,76 @@ xaccSplitGetGainsSourceSplit (const Split *split)
 
 /* ============================================================== */
 
-void
-xaccSplitComputeCapGains(Split *split, Account *gain_acc)
+/* What gains_source_split() and gains_compute() found out about a
+ * split.  They log nothing, so that the gains of several accounts can
+ * be worked out at once; gains_report() logs it afterwards. */
+typedef struct
+{
+    Split *split;               /* the split that generates the gains */
+    gnc_commodity *currency;    /* the currency of the gains */
+    const char *skip;           /* why there are no gains to record */
+    gboolean malformed;         /* the lot is too thin or too fat */
+    gboolean bad_pointer;       /* split->gains_split had to be looked up */
+    gnc_numeric lot_amount;
+    gnc_numeric lot_value;
+    gnc_numeric value;          /* the gains */
+} GainsResult;
+
+/* If the value of the 'opening' split(s) has changed, then the cap
+ * gains are changed.  To capture this, mark all splits of the lot
+ * dirty if the opening splits are dirty. */
+static void
+lot_mark_gains_dirty (GNCLot *lot, GNCPolicy *pcy)
 {
     SplitList *node;
-    GNCLot *lot;
-    GNCPolicy *pcy;
-    gnc_commodity *currency = NULL;
-    gnc_numeric zero = gnc_numeric_zero();
-    gnc_numeric value;
-    gnc_numeric frac;
-    gnc_numeric opening_amount, opening_value;
-    gnc_numeric lot_amount, lot_value;
-    gnc_commodity *opening_currency;
+    gboolean is_dirty = FALSE;
 
-    if (!split) return;
-    lot = split->lot;
-    if (!lot) return;
-    pcy = gnc_account_get_policy(gnc_lot_get_account(lot));
-    currency = split->parent->common_currency;
+    for (node = gnc_lot_get_split_list(lot); node; node = node->next)
+    {
+        Split *s = node->data;
+        if (pcy->PolicyIsOpeningSplit(pcy, lot, s))
+        {
+            if (GAINS_STATUS_UNKNOWN == s->gains)
+                xaccSplitDetermineGainStatus(s);
+            if (s->gains & GAINS_STATUS_VDIRTY)
+            {
+                is_dirty = TRUE;
+                s->gains &= ~GAINS_STATUS_VDIRTY;
+            }
+        }
+    }
 
-    ENTER ("(split=%p gains=%p status=0x%x lot=%s)", split,
-           split->gains_split, split->gains, gnc_lot_get_title(lot));
+    if (is_dirty)
+    {
+        for (node = gnc_lot_get_split_list(lot); node; node = node->next)
+        {
+            Split *s = node->data;
+            s->gains |= GAINS_STATUS_VDIRTY;
+        }
+    }
+}
+
+/* Find the split whose gains would be recorded for the indicated
+ * split: the split itself, or the source of the gains if it is the
+ * split that records them.  Returns NULL and sets res->skip if there
+ * can't be any gains.  Changes nothing but the gains status of the
+ * splits in the lot. */
+static Split *
+gains_source_split (Split *split, GNCLot *lot, GNCPolicy *pcy,
+                    GainsResult *res)
+{
+    res->currency = split->parent->common_currency;
 
     /* Make sure the status flags and pointers are initialized */
     xaccSplitDetermineGainStatus(split);
 
     /* Not possible to have gains if the transaction currency and
      * account commodity are identical. */
-    if (gnc_commodity_equal (currency,
+    if (gnc_commodity_equal (res->currency,
                              xaccAccountGetCommodity(split->acc)))
     {
-        LEAVE ("Currency transfer, gains not possible, returning.");
-        return;
+        res->skip = "Currency transfer, gains not possible, returning.";
+        return NULL;
     }
 
     if (pcy->PolicyIsOpeningSplit (pcy, lot, split))
@@ -579,20 +575,19 @@ xaccSplitComputeCapGains(Split *split, Account *gain_acc)
             xaccTransCommitEdit (trans);
         }
 #endif
-        LEAVE ("Lot opening split, returning.");
-        return;
+        res->skip = "Lot opening split, returning.";
+        return NULL;
     }
 
     if (g_strcmp0 ("stock-split", xaccSplitGetType (split)) == 0)
     {
-        LEAVE ("Stock split split, returning.");
-        return;
+        res->skip = "Stock split split, returning.";
+        return NULL;
     }
 
     if (GAINS_STATUS_GAINS & split->gains)
     {
         Split *s;
-        PINFO ("split is a gains recording split, switch over");
         /* If this is the split that records the gains, then work with
          * the split that generates the gains.
          */
@@ -606,16 +601,40 @@ xaccSplitComputeCapGains(Split *split, Account *gain_acc)
          */
         if (!s)
         {
-            PERR ("Bad gains-split pointer! .. trying to recover.");
+            res->bad_pointer = TRUE;
             split->gains_split = xaccSplitGetCapGainsSplit (split);
             s = split->gains_split;
-            if (!s) return;
+            if (!s)
+            {
+                res->skip = "No gains source split, returning.";
+                return NULL;
+            }
 #if MOVE_THIS_TO_A_DATA_INTEGRITY_SCRUBBER
             xaccTransDestroy (trans);
 #endif
         }
         split = s;
     }
+    res->split = split;
+    return split;
+}
+
+/* Work out the gains of the source split found by gains_source_split()
+ * into res->value, or set res->skip.  The amount and value of the lot
+ * before the split are taken to be adj_amount and adj_value more than
+ * what the lot holds now.  Changes nothing but the gains status of the
+ * splits in the lot. */
+static void
+gains_compute (Split *split, GNCLot *lot, GNCPolicy *pcy,
+               gnc_numeric adj_amount, gnc_numeric adj_value,
+               GainsResult *res)
+{
+    SplitList *node;
+    gnc_numeric value;
+    gnc_numeric frac;
+    gnc_numeric opening_amount, opening_value;
+    gnc_numeric lot_amount, lot_value;
+    gnc_commodity *opening_currency;
 
     /* Note: if the value of the 'opening' split(s) has changed,
      * then the cap gains are changed. So we need to check not
@@ -641,13 +660,17 @@ xaccSplitComputeCapGains(Split *split, Account *gain_acc)
             (split->gains_split) &&
             (FALSE == (split->gains_split->gains & GAINS_STATUS_A_VDIRTY)))
     {
-        LEAVE ("split not dirty, returning");
+        res->skip = "split not dirty, returning";
         return;
     }
 
     /* Yow! If amount is zero, there's nothing to do! Amount-zero splits
      * may exist if users attempted to manually record gains. */
-    if (gnc_numeric_zero_p (split->amount)) return;
+    if (gnc_numeric_zero_p (split->amount))
+    {
+        res->skip = "Zero amount split, returning.";
+        return;
+    }
 
     /* If we got to here, then the split or something related is
      * 'dirty' and the gains really do need to be recomputed.
@@ -655,19 +678,23 @@ xaccSplitComputeCapGains(Split *split, Account *gain_acc)
 
     /* Get the amount and value in this lot at the time of this transaction. */
     gnc_lot_get_balance_before (lot, split, &lot_amount, &lot_value);
+    lot_amount = gnc_numeric_add_fixed (lot_amount, adj_amount);
+    lot_value = gnc_numeric_add_fixed (lot_value, adj_value);
+    res->lot_amount = lot_amount;
+    res->lot_value = lot_value;
 
     pcy->PolicyGetLotOpening (pcy, lot, &opening_amount, &opening_value,
                               &opening_currency);
 
     /* Check to make sure the lot-opening currency and this split
      * use the same currency */
-    if (FALSE == gnc_commodity_equiv (currency, opening_currency))
+    if (FALSE == gnc_commodity_equiv (res->currency, opening_currency))
     {
         /* OK, the purchase and the sale were made in different currencies.
          * I don't know how to compute cap gains for that.  This is not
          * an error. Just punt, silently.
          */
-        LEAVE ("Can't compute gains, mismatched commodities!");
+        res->skip = "Can't compute gains, mismatched commodities!";
         return;
     }
 
@@ -679,18 +706,8 @@ xaccSplitComputeCapGains(Split *split, Account *gain_acc)
     if (0 > gnc_numeric_compare (gnc_numeric_abs(lot_amount),
                                  gnc_numeric_abs(split->amount)))
     {
-        GList *n;
-        for (n = gnc_lot_get_split_list(lot); n; n = n->next)
-        {
-            Split *s = n->data;
-            PINFO ("split amt=%s", gnc_num_dbg_to_string(s->amount));
-        }
-        PERR ("Malformed Lot \"%s\"! (too thin!) "
-              "opening amt=%s split amt=%s baln=%s",
-              gnc_lot_get_title (lot),
-              gnc_num_dbg_to_string (lot_amount),
-              gnc_num_dbg_to_string (split->amount),
-              gnc_num_dbg_to_string (gnc_lot_get_balance(lot)));
+        res->skip = "too thin!";
+        res->malformed = TRUE;
         return;
     }
     if ( (gnc_numeric_negative_p(lot_amount) ||
@@ -698,18 +715,8 @@ xaccSplitComputeCapGains(Split *split, Account *gain_acc)
             (gnc_numeric_positive_p(lot_amount) ||
              gnc_numeric_negative_p(split->amount)))
     {
-        GList *n;
-        for (n = gnc_lot_get_split_list(lot); n; n = n->next)
-        {
-            Split *s = n->data;
-            PINFO ("split amt=%s", gnc_num_dbg_to_string(s->amount));
-        }
-        PERR ("Malformed Lot \"%s\"! (too fat!) "
-              "opening amt=%s split amt=%s baln=%s",
-              gnc_lot_get_title (lot),
-              gnc_num_dbg_to_string (lot_amount),
-              gnc_num_dbg_to_string (split->amount),
-              gnc_num_dbg_to_string (gnc_lot_get_balance(lot)));
+        res->skip = "too fat!";
+        res->malformed = TRUE;
         return;
     }
 
@@ -731,26 +738,97 @@ xaccSplitComputeCapGains(Split *split, Account *gain_acc)
     /* Capital gain for this split: */
     value = gnc_numeric_sub (value, split->value,
                              GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED);
+    res->value = value;
+}
+
+/* Log what gains_source_split() and gains_compute() found.  Returns
+ * TRUE if res->value holds gains that can be recorded. */
+static gboolean
+gains_report (const GainsResult *res, GNCLot *lot)
+{
+    Split *split = res->split;
+
+    if (res->bad_pointer)
+        PERR ("Bad gains-split pointer! .. trying to recover.");
+    if (res->malformed)
+    {
+        GList *n;
+        for (n = gnc_lot_get_split_list(lot); n; n = n->next)
+        {
+            Split *s = n->data;
+            PINFO ("split amt=%s", gnc_num_dbg_to_string(s->amount));
+        }
+        PERR ("Malformed Lot \"%s\"! (%s) "
+              "opening amt=%s split amt=%s baln=%s",
+              gnc_lot_get_title (lot), res->skip,
+              gnc_num_dbg_to_string (res->lot_amount),
+              gnc_num_dbg_to_string (split->amount),
+              gnc_num_dbg_to_string (gnc_lot_get_balance(lot)));
+        return FALSE;
+    }
+    if (res->skip)
+    {
+        PINFO ("%s", res->skip);
+        return FALSE;
+    }
+
     PINFO ("Open amt=%s val=%s;  split amt=%s val=%s; gains=%s\n",
-           gnc_num_dbg_to_string (lot_amount),
-           gnc_num_dbg_to_string (lot_value),
+           gnc_num_dbg_to_string (res->lot_amount),
+           gnc_num_dbg_to_string (res->lot_value),
            gnc_num_dbg_to_string (split->amount),
            gnc_num_dbg_to_string (split->value),
-           gnc_num_dbg_to_string (value));
-    if (gnc_numeric_check (value))
+           gnc_num_dbg_to_string (res->value));
+    if (gnc_numeric_check (res->value))
     {
         PERR ("Numeric overflow during gains calculation\n"
               "Acct=%s Txn=%s\n"
               "\tOpen amt=%s val=%s\n\tsplit amt=%s val=%s\n\tgains=%s\n",
               xaccAccountGetName(split->acc),
               xaccTransGetDescription(split->parent),
-              gnc_num_dbg_to_string (lot_amount),
-              gnc_num_dbg_to_string (lot_value),
+              gnc_num_dbg_to_string (res->lot_amount),
+              gnc_num_dbg_to_string (res->lot_value),
               gnc_num_dbg_to_string (split->amount),
               gnc_num_dbg_to_string (split->value),
-              gnc_num_dbg_to_string (value));
-        return;
+              gnc_num_dbg_to_string (res->value));
+        return FALSE;
     }
+    return TRUE;
+}
+
+/* TRUE if recording value as the gains of split would change nothing,
+ * either because the gain is already recorded correctly, or because
+ * the gains transaction has been edited so that it no longer has just
+ * two splits. */
+static gboolean
+gains_up_to_date (const Split *split, gnc_numeric value)
+{
+    Split *lot_split = split->gains_split;
+    Split *gain_split;
+    gnc_numeric negvalue = gnc_numeric_neg (value);
+
+    if (NULL == lot_split) return FALSE;
+    gain_split = xaccSplitGetOtherSplit (lot_split);
+    if (!gain_split) return TRUE;
+
+    return (lot_split->gains_split == split &&
+            gain_split->gains_split == split &&
+            gnc_numeric_equal (xaccSplitGetValue (lot_split), value) &&
+            gnc_numeric_zero_p (xaccSplitGetAmount (lot_split)) &&
+            gnc_numeric_equal (xaccSplitGetValue (gain_split), negvalue) &&
+            gnc_numeric_equal (xaccSplitGetAmount (gain_split), negvalue));
+}
+
+/* Record value as the gains of split in its lot, creating the gains
+ * transaction if there isn't one yet.  Returns the account holding
+ * the other side of the gains, if anything was recorded. */
+static Account *
+gains_record (Split *split, GNCLot *lot, gnc_commodity *currency,
+              gnc_numeric value, Account *gain_acc)
+{
+    gnc_numeric zero = gnc_numeric_zero();
+    Transaction *trans;
+    Split *lot_split, *gain_split;
+    gnc_numeric negvalue = gnc_numeric_neg (value);
 
     /* Are the cap gains zero?  If not, add a balancing transaction.
      * As per design doc lots.txt: the transaction has two splits,
@@ -758,141 +836,138 @@ xaccSplitComputeCapGains(Split *split, Account *gain_acc)
      * not to upset the lot balance), the amt of the other is the same
      * as its value (its the realized gain/loss).
      */
-    if (FALSE == gnc_numeric_zero_p (value))
+    if (gnc_numeric_zero_p (value))
+        return NULL;
+
+    /* See if there already is an associated gains transaction.
+     * If there is, adjust its value as appropriate. Else, create
+     * a new gains transaction.
+     */
+    /* lot_split = xaccSplitGetCapGainsSplit (split);  */
+    lot_split = split->gains_split;
+
+    if (NULL == lot_split)
     {
-        Transaction *trans;
-        Split *lot_split, *gain_split;
-        gboolean new_gain_split;
-        gnc_numeric negvalue = gnc_numeric_neg (value);
+        Account *lot_acc = gnc_lot_get_account(lot);
+        QofBook *book = qof_instance_get_book(lot_acc);
+        Transaction *base_txn = xaccSplitGetParent (split);
 
-        /* See if there already is an associated gains transaction.
-         * If there is, adjust its value as appropriate. Else, create
-         * a new gains transaction.
-         */
-        /* lot_split = xaccSplitGetCapGainsSplit (split);  */
-        lot_split = split->gains_split;
+        lot_split = xaccMallocSplit (book);
+        gain_split = xaccMallocSplit (book);
 
-        if (NULL == lot_split)
+        /* Check to make sure the gains account currency matches. */
+        if ((NULL == gain_acc) ||
+                (FALSE == gnc_commodity_equiv (currency,
+                                               xaccAccountGetCommodity(gain_acc))))
         {
-            Account *lot_acc = gnc_lot_get_account(lot);
-            QofBook *book = qof_instance_get_book(lot_acc);
-            Transaction *base_txn = xaccSplitGetParent (split);
+            gain_acc = xaccAccountGainsAccount (lot_acc, currency);
+        }
 
-            new_gain_split = TRUE;
+        xaccAccountBeginEdit (gain_acc);
+        xaccAccountInsertSplit (gain_acc, gain_split);
+        xaccAccountCommitEdit (gain_acc);
 
-            lot_split = xaccMallocSplit (book);
-            gain_split = xaccMallocSplit (book);
+        xaccAccountBeginEdit (lot_acc);
+        xaccAccountInsertSplit (lot_acc, lot_split);
+        xaccAccountCommitEdit (lot_acc);
 
-            /* Check to make sure the gains account currency matches. */
-            if ((NULL == gain_acc) ||
-                    (FALSE == gnc_commodity_equiv (currency,
-                                                   xaccAccountGetCommodity(gain_acc))))
-            {
-                gain_acc = xaccAccountGainsAccount (lot_acc, currency);
-            }
+        trans = xaccMallocTransaction (book);
 
-            xaccAccountBeginEdit (gain_acc);
-            xaccAccountInsertSplit (gain_acc, gain_split);
-            xaccAccountCommitEdit (gain_acc);
+        xaccTransBeginEdit (trans);
+        xaccTransSetCurrency (trans, currency);
+        xaccTransSetDescription (trans, _("Realized Gain/Loss"));
 
-            xaccAccountBeginEdit (lot_acc);
-            xaccAccountInsertSplit (lot_acc, lot_split);
-            xaccAccountCommitEdit (lot_acc);
+        xaccTransAppendSplit (trans, lot_split);
+        xaccTransAppendSplit (trans, gain_split);
 
-            trans = xaccMallocTransaction (book);
+        xaccSplitSetMemo (lot_split, _("Realized Gain/Loss"));
+        xaccSplitSetMemo (gain_split, _("Realized Gain/Loss"));
 
-            xaccTransBeginEdit (trans);
-            xaccTransSetCurrency (trans, currency);
-            xaccTransSetDescription (trans, _("Realized Gain/Loss"));
-
-            xaccTransAppendSplit (trans, lot_split);
-            xaccTransAppendSplit (trans, gain_split);
-
-            xaccSplitSetMemo (lot_split, _("Realized Gain/Loss"));
-            xaccSplitSetMemo (gain_split, _("Realized Gain/Loss"));
-
-            /* For the new transaction, set the split properties indicating
-             * that this is the gains transaction that corresponds
-             * to the gains source.
-             */
-            xaccTransBeginEdit (base_txn);
-            qof_instance_set (QOF_INSTANCE (split),
-                              "gains-split", xaccSplitGetGUID (lot_split),
-                              NULL);
-            xaccTransCommitEdit (base_txn);
-            qof_instance_set (QOF_INSTANCE (lot_split),
-                              "gains-source", xaccSplitGetGUID (split),
-                              NULL);
+        /* For the new transaction, set the split properties indicating
+         * that this is the gains transaction that corresponds
+         * to the gains source.
+         */
+        xaccTransBeginEdit (base_txn);
+        qof_instance_set (QOF_INSTANCE (split),
+                          "gains-split", xaccSplitGetGUID (lot_split),
+                          NULL);
+        xaccTransCommitEdit (base_txn);
+        qof_instance_set (QOF_INSTANCE (lot_split),
+                          "gains-source", xaccSplitGetGUID (split),
+                          NULL);
 
-        }
-        else
-        {
-            trans = lot_split->parent;
-            gain_split = xaccSplitGetOtherSplit (lot_split);
+    }
+    else
+    {
+        /* If the gains transaction has been edited so that it no longer has
+           just two splits, ignore it and assume it's still correct.
+           If the gain is already recorded correctly do nothing.  This is
+           more than just an optimization since this may be called during
+           gnc_book_partition_txn and depending on the order in which things
+           happen some splits may be in the wrong book at that time. */
+        if (gains_up_to_date (split, value))
+            return NULL;
+
+        trans = lot_split->parent;
+        gain_split = xaccSplitGetOtherSplit (lot_split);
+        xaccTransBeginEdit (trans);
 
-            /* If the gains transaction has been edited so that it no longer has
-               just two splits, ignore it and assume it's still correct. */
-            if (!gain_split)
-            {
-                new_gain_split = FALSE;
-            }
-            /* If the gain is already recorded correctly do nothing.  This is
-             * more than just an optimization since this may be called during
-             * gnc_book_partition_txn and depending on the order in which things
-             * happen some splits may be in the wrong book at that time. */
-            else if (split->gains_split == lot_split &&
-                     lot_split->gains_split == split &&
-                     gain_split->gains_split == split &&
-                     gnc_numeric_equal (xaccSplitGetValue (lot_split), value) &&
-                     gnc_numeric_zero_p (xaccSplitGetAmount (lot_split)) &&
-                     gnc_numeric_equal (xaccSplitGetValue (gain_split), negvalue) &&
-                     gnc_numeric_equal (xaccSplitGetAmount (gain_split), negvalue))
-            {
-                new_gain_split = FALSE;
-            }
-            else
-            {
-                new_gain_split = TRUE;
-                xaccTransBeginEdit (trans);
-
-                /* Make sure the existing gains trans has the correct currency,
-                 * just in case someone screwed with it! */
-                if (FALSE == gnc_commodity_equiv(currency, trans->common_currency))
-                {
-                    PWARN ("Resetting the transaction currency!");
-                    xaccTransSetCurrency (trans, currency);
-                }
-            }
+        /* Make sure the existing gains trans has the correct currency,
+         * just in case someone screwed with it! */
+        if (FALSE == gnc_commodity_equiv(currency, trans->common_currency))
+        {
+            PWARN ("Resetting the transaction currency!");
+            xaccTransSetCurrency (trans, currency);
         }
+    }
 
-        if (new_gain_split)
-        {
-            /* Common to both */
-            time64 time = xaccTransRetDatePosted (split->parent);
-            xaccTransSetDatePostedSecs (trans, time);
-            xaccTransSetDateEnteredSecs (trans, gnc_time (NULL));
+    /* Common to both */
+    xaccTransSetDatePostedSecs (trans, xaccTransRetDatePosted (split->parent));
+    xaccTransSetDateEnteredSecs (trans, gnc_time (NULL));
 
-            xaccSplitSetAmount (lot_split, zero);
-            xaccSplitSetValue (lot_split, value);
+    xaccSplitSetAmount (lot_split, zero);
+    xaccSplitSetValue (lot_split, value);
 
-            xaccSplitSetAmount (gain_split, negvalue);
-            xaccSplitSetValue (gain_split, negvalue);
+    xaccSplitSetAmount (gain_split, negvalue);
+    xaccSplitSetValue (gain_split, negvalue);
 
-            /* Some short-cuts to help avoid the above property lookup. */
-            split->gains = GAINS_STATUS_CLEAN;
-            split->gains_split = lot_split;
-            lot_split->gains = GAINS_STATUS_GAINS;
-            lot_split->gains_split = split;
-            gain_split->gains = GAINS_STATUS_GAINS;
-            gain_split->gains_split = split;
+    /* Some short-cuts to help avoid the above property lookup. */
+    split->gains = GAINS_STATUS_CLEAN;
+    split->gains_split = lot_split;
+    lot_split->gains = GAINS_STATUS_GAINS;
+    lot_split->gains_split = split;
+    gain_split->gains = GAINS_STATUS_GAINS;
+    gain_split->gains_split = split;
 
-            /* Do this last since it may generate an event that will call us
-               recursively. */
-            gnc_lot_add_split (lot, lot_split);
+    /* Do this last since it may generate an event that will call us
+       recursively. */
+    gnc_lot_add_split (lot, lot_split);
+
+    xaccTransCommitEdit (trans);
+    return xaccSplitGetAccount (gain_split);
+}
+
+void
+xaccSplitComputeCapGains(Split *split, Account *gain_acc)
+{
+    GNCLot *lot;
+    GNCPolicy *pcy;
+    GainsResult res = { NULL };
+    gnc_numeric zero = gnc_numeric_zero();
+
+    if (!split) return;
+    lot = split->lot;
+    if (!lot) return;
+    pcy = gnc_account_get_policy(gnc_lot_get_account(lot));
+
+    ENTER ("(split=%p gains=%p status=0x%x lot=%s)", split,
+           split->gains_split, split->gains, gnc_lot_get_title(lot));
+
+    if (gains_source_split (split, lot, pcy, &res))
+        gains_compute (res.split, lot, pcy, zero, zero, &res);
+    if (gains_report (&res, lot))
+        gains_record (res.split, lot, res.currency, res.value, gain_acc);
 
-            xaccTransCommitEdit (trans);
-        }
-    }
     LEAVE ("(lot=%s)", gnc_lot_get_title(lot));
 }
 
@@ -935,44 +1010,256 @@ xaccLotComputeCapGains (GNCLot *lot, Account *gain_acc)
 {
     SplitList *node;
     GNCPolicy *pcy;
-    gboolean is_dirty = FALSE;
-
-    /* Note: if the value of the 'opening' split(s) has changed,
-     * then the cap gains are changed. To capture this, we need
-     * to mark all splits dirty if the opening splits are dirty. */
 
     ENTER("(lot=%p)", lot);
     pcy = gnc_account_get_policy(gnc_lot_get_account(lot));
+    lot_mark_gains_dirty (lot, pcy);
+
     for (node = gnc_lot_get_split_list(lot); node; node = node->next)
     {
         Split *s = node->data;
-        if (pcy->PolicyIsOpeningSplit(pcy, lot, s))
+        xaccSplitComputeCapGains (s, gain_acc);
+    }
+    LEAVE("(lot=%p)", lot);
+}
+
+/* ============================================================== */
+
+/* Gains that xaccAccountTreeComputeCapGains() is going to record, or a
+ * problem it is going to report. */
+typedef struct
+{
+    GNCLot *lot;
+    GainsResult res;
+    gboolean record;            /* recording res.value changes the lot */
+} GainsPlan;
+
+/* An account with trades and the GainsPlans for its lots. */
+typedef struct
+{
+    Account *acc;
+    GArray *plans;
+} AccountGains;
+
+/* How much recording the planned gains changes the amount and value
+ * of the lot. */
+static void
+gains_plan_lot_change (const GainsPlan *plan, gnc_numeric *amount,
+                       gnc_numeric *value)
+{
+    Split *lot_split = plan->res.split->gains_split;
+
+    *amount = gnc_numeric_zero();
+    *value = plan->res.value;
+    if (lot_split && lot_split->lot == plan->lot)
+    {
+        *amount = gnc_numeric_neg (lot_split->amount);
+        *value = gnc_numeric_sub_fixed (*value, lot_split->value);
+    }
+}
+
+/* Plan the gains of the splits in the lot the way xaccLotComputeCapGains
+ * would compute them, one after the other.  Nothing gets recorded, so
+ * each split is computed as if the gains planned for the splits before
+ * it in the lot had been. */
+static void
+lot_plan_gains (GNCLot *lot, GNCPolicy *pcy, GHashTable *seen,
+                GArray *plans)
+{
+    guint first = plans->len;
+    SplitList *node;
+
+    lot_mark_gains_dirty (lot, pcy);
+    for (node = gnc_lot_get_split_list(lot); node; node = node->next)
+    {
+        GainsPlan plan = { lot };
+        gnc_numeric adj_amount = gnc_numeric_zero();
+        gnc_numeric adj_value = gnc_numeric_zero();
+        Split *split;
+        guint i;
+
+        split = gains_source_split (node->data, lot, pcy, &plan.res);
+        if (split)
         {
-            if (GAINS_STATUS_UNKNOWN == s->gains)
-                xaccSplitDetermineGainStatus(s);
-            if (s->gains & GAINS_STATUS_VDIRTY)
+            /* A source split and the split recording its gains are
+             * both in the lot; plan once. */
+            if (g_hash_table_contains (seen, split))
+                continue;
+            g_hash_table_add (seen, split);
+
+            /* Take in the planned gains that gnc_lot_get_balance_before
+             * will count before this split once they are recorded. */
+            for (i = first; i < plans->len; i++)
             {
-                is_dirty = TRUE;
-                s->gains &= ~GAINS_STATUS_VDIRTY;
+                GainsPlan *p = &g_array_index (plans, GainsPlan, i);
+                Transaction *ta = p->res.split->parent;
+                gnc_numeric amt, val;
+
+                if (!p->record)
+                    continue;
+                if ((ta != split->parent || p->res.split == split) &&
+                        xaccTransOrder (ta, split->parent) >= 0)
+                    continue;
+                gains_plan_lot_change (p, &amt, &val);
+                adj_amount = gnc_numeric_add_fixed (adj_amount, amt);
+                adj_value = gnc_numeric_add_fixed (adj_value, val);
             }
+            gains_compute (split, lot, pcy, adj_amount, adj_value, &plan.res);
+            plan.record = (!plan.res.skip &&
+                           !gnc_numeric_check (plan.res.value) &&
+                           !gnc_numeric_zero_p (plan.res.value) &&
+                           !gains_up_to_date (split, plan.res.value));
         }
+
+        if (plan.record || plan.res.malformed || plan.res.bad_pointer)
+            g_array_append_val (plans, plan);
     }
+}
 
-    if (is_dirty)
+/* Thread pool worker: plan the gains of all the lots of an account.
+ * Reads the rest of the book but changes only the account's lots and
+ * the gains status of their splits. */
+static void
+account_plan_gains (gpointer data, gpointer user_data)
+{
+    AccountGains *ag = data;
+    GNCPolicy *pcy = gnc_account_get_policy (ag->acc);
+    GHashTable *seen = g_hash_table_new (NULL, NULL);
+    LotList *lots, *node;
+
+    lots = xaccAccountGetLotList (ag->acc);
+    for (node = lots; node; node = node->next)
+        lot_plan_gains (node->data, pcy, seen, ag->plans);
+    g_list_free (lots);
+    g_hash_table_destroy (seen);
+}
+
+/* xaccTransOrder fills in the closing-transaction flag on first use;
+ * fill it in before any worker compares transactions. */
+static void
+warm_closing_txn_flag (QofInstance *inst, gpointer data)
+{
+    xaccTransGetIsClosingTxn (GNC_TRANSACTION (inst));
+}
+
+/* xaccSplitDetermineGainStatus fills in the gains status and pointer of
+ * a split on first use, and the splits a worker reaches through them
+ * may be in another job's account; fill them all in before the workers
+ * start, so each worker only changes the status of its own lots. */
+static void
+warm_gains_status (Account *acc)
+{
+    SplitList *node;
+
+    for (node = xaccAccountGetSplitList (acc); node; node = node->next)
     {
-        for (node = gnc_lot_get_split_list(lot); node; node = node->next)
-        {
-            Split *s = node->data;
-            s->gains |= GAINS_STATUS_VDIRTY;
-        }
+        Split *s = node->data;
+
+        xaccSplitDetermineGainStatus (s);
+        if (s->gains_split)
+            xaccSplitDetermineGainStatus (s->gains_split);
     }
+}
 
-    for (node = gnc_lot_get_split_list(lot); node; node = node->next)
+void
+xaccAccountTreeComputeCapGains (Account *root, Account *gain_acc)
+{
+    QofBook *book;
+    GList *accounts, *node;
+    GPtrArray *jobs, *edited;
+    GHashTable *editing;
+    GThreadPool *pool = NULL;
+    guint n_threads, i, j;
+
+    g_return_if_fail (GNC_IS_ACCOUNT (root));
+    book = gnc_account_get_book (root);
+    if (qof_book_shutting_down (book)) return;
+
+    ENTER ("(root=%s)", xaccAccountGetName (root));
+    /* Lots never span accounts, so each account's gains can be planned
+     * on its own. */
+    jobs = g_ptr_array_new ();
+    accounts = gnc_account_get_descendants (root);
+    accounts = g_list_prepend (accounts, root);
+    for (node = accounts; node; node = node->next)
     {
-        Split *s = node->data;
-        xaccSplitComputeCapGains (s, gain_acc);
+        Account *acc = node->data;
+        AccountGains *ag;
+
+        if (qof_instance_get_destroying (acc) || !xaccAccountHasTrades (acc))
+            continue;
+        ag = g_new0 (AccountGains, 1);
+        ag->acc = acc;
+        ag->plans = g_array_new (FALSE, FALSE, sizeof (GainsPlan));
+        g_ptr_array_add (jobs, ag);
     }
-    LEAVE("(lot=%p)", lot);
+    g_list_free (accounts);
+
+    qof_event_suspend ();
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_TRANS),
+                            warm_closing_txn_flag, NULL);
+    for (i = 0; i < jobs->len; i++)
+        warm_gains_status (((AccountGains*) g_ptr_array_index (jobs, i))->acc);
+
+    n_threads = MIN (g_get_num_processors (), jobs->len);
+    if (n_threads > 1)
+        pool = g_thread_pool_new (account_plan_gains, NULL, n_threads,
+                                  FALSE, NULL);
+    for (i = 0; i < jobs->len; i++)
+    {
+        if (pool)
+            g_thread_pool_push (pool, g_ptr_array_index (jobs, i), NULL);
+        else
+            account_plan_gains (g_ptr_array_index (jobs, i), NULL);
+    }
+    if (pool)
+        g_thread_pool_free (pool, FALSE, TRUE);
+
+    /* Creating the gains splits and transactions isn't safe from several
+     * threads, and many accounts can share a gains account, so record
+     * the gains one after the other, with every account involved held
+     * open for editing until all of them are in. */
+    edited = g_ptr_array_new ();
+    editing = g_hash_table_new (NULL, NULL);
+    for (i = 0; i < jobs->len; i++)
+    {
+        AccountGains *ag = g_ptr_array_index (jobs, i);
+
+        for (j = 0; j < ag->plans->len; j++)
+        {
+            GainsPlan *plan = &g_array_index (ag->plans, GainsPlan, j);
+            Account *acc;
+
+            if (!g_hash_table_contains (editing, ag->acc))
+            {
+                xaccAccountBeginEdit (ag->acc);
+                g_hash_table_add (editing, ag->acc);
+                g_ptr_array_add (edited, ag->acc);
+            }
+            if (!gains_report (&plan->res, plan->lot) || !plan->record)
+                continue;
+            acc = gains_record (plan->res.split, plan->lot,
+                                plan->res.currency, plan->res.value,
+                                gain_acc);
+            if (acc && !g_hash_table_contains (editing, acc))
+            {
+                xaccAccountBeginEdit (acc);
+                g_hash_table_add (editing, acc);
+                g_ptr_array_add (edited, acc);
+            }
+        }
+        g_array_free (ag->plans, TRUE);
+        g_free (ag);
+    }
+    g_ptr_array_free (jobs, TRUE);
+    qof_event_resume ();
+
+    /* One modify event per account instead of one per gains split. */
+    for (i = 0; i < edited->len; i++)
+        xaccAccountCommitEdit (g_ptr_array_index (edited, i));
+    LEAVE ("(root=%s, accounts=%u)", xaccAccountGetName (root), edited->len);
+    g_ptr_array_free (edited, TRUE);
+    g_hash_table_destroy (editing);
 }
 
 /* =========================== END OF FILE ======================= */
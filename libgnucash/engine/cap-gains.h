@@ -205,6 +205,16 @@ Split * xaccSplitAssignToLot (Split *split, GNCLot *lot);
 void xaccSplitComputeCapGains(Split *split, Account *gain_acc);
 void xaccLotComputeCapGains (GNCLot *lot, Account *gain_acc);
 
+/** The xaccAccountTreeComputeCapGains() routine computes the cap
+ *    gains of every lot in root and all of its descendants, with the
+ *    same results as calling xaccLotComputeCapGains() on each lot.
+ *    The gains of different accounts are worked out in parallel on
+ *    a thread pool; the gains transactions are then created or
+ *    updated one after the other with events suspended, and each
+ *    account involved is committed, and so signals a change, once.
+ */
+void xaccAccountTreeComputeCapGains (Account *root, Account *gain_acc);
+
 #endif /* XACC_CAP_GAINS_H */
 /** @} */
 /** @} */
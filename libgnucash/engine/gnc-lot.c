@@ -76,6 +76,22 @@ enum
     PROP_MARKER,        /* Runtime */
 };
 
+/* A split of the lot as gnc_lot_get_balance_before() orders them: by
+ * the post date of the transaction it compares them by, which for a
+ * gains split is that of its source split.  Also holds the split's own
+ * post date, amount and value as last seen and, once summed, the
+ * running sums of the amounts and values up to this entry. */
+typedef struct
+{
+    Split *split;
+    time64 date;
+    time64 own_date;
+    gnc_numeric amount;
+    gnc_numeric value;
+    gnc_numeric sum_amount;
+    gnc_numeric sum_value;
+} LotOrderEntry;
+
 typedef struct GNCLotPrivate
 {
     /* Account to which this lot applies.  All splits in the lot must
@@ -83,8 +99,24 @@ typedef struct GNCLotPrivate
      */
     Account * account;
 
-    /* List of splits that belong to this lot. */
+    /* List of splits that belong to this lot, in date order unless
+     * sort_dirty is set.  last is its last node. */
     SplitList *splits;
+    SplitList *last;
+    gboolean sort_dirty;
+
+    /* The sum of the splits' amounts, kept up to date as splits are
+     * added and removed.  Recomputed when balance_dirty is set. */
+    gnc_numeric balance;
+    gboolean balance_dirty;
+
+    /* The splits as LotOrderEntry, and the position of each split in
+     * it plus one.  Rebuilt from the split list when order_dirty is
+     * set; the running sums are good for the first order_summed. */
+    GArray *order;
+    GHashTable *order_pos;
+    guint order_summed;
+    gboolean order_dirty;
 
     char *title;
     char *notes;
@@ -120,6 +152,14 @@ gnc_lot_init(GNCLot* lot)
     priv = GET_PRIVATE(lot);
     priv->account = NULL;
     priv->splits = NULL;
+    priv->last = NULL;
+    priv->sort_dirty = FALSE;
+    priv->balance = gnc_numeric_zero ();
+    priv->balance_dirty = FALSE;
+    priv->order = g_array_new (FALSE, FALSE, sizeof (LotOrderEntry));
+    priv->order_pos = g_hash_table_new (NULL, NULL);
+    priv->order_summed = 0;
+    priv->order_dirty = TRUE;
     priv->cached_invoice = NULL;
     priv->is_closed = LOT_CLOSED_UNKNOWN;
     priv->title = is_unset;
@@ -136,6 +176,10 @@ gnc_lot_dispose(GObject *lotp)
 static void
 gnc_lot_finalize(GObject* lotp)
 {
+    GNCLotPrivate* priv = GET_PRIVATE(lotp);
+
+    g_array_free (priv->order, TRUE);
+    g_hash_table_destroy (priv->order_pos);
     G_OBJECT_CLASS(gnc_lot_parent_class)->finalize(lotp);
 }
 
@@ -194,6 +238,8 @@ gnc_lot_set_property (GObject* object,
     {
     case PROP_IS_CLOSED:
         priv->is_closed = g_value_get_int(value);
+        if (priv->account)
+            gnc_account_mark_lot_dirty (priv->account, lot);
         break;
     case PROP_MARKER:
         priv->marker = g_value_get_int(value);
@@ -429,6 +475,11 @@ gnc_lot_set_closed_unknown(GNCLot* lot)
     {
         priv = GET_PRIVATE(lot);
         priv->is_closed = LOT_CLOSED_UNKNOWN;
+        priv->balance_dirty = TRUE;
+        priv->sort_dirty = TRUE;
+        priv->order_dirty = TRUE;
+        if (priv->account)
+            gnc_account_mark_lot_dirty (priv->account, lot);
     }
 }
 
@@ -526,6 +577,173 @@ gnc_lot_set_notes (GNCLot *lot, const char *str)
 
 /* ============================================================= */
 
+/* Keep the cached balance up to date with a split being added or
+ * removed, or give up on it if the amounts don't add up. */
+static void
+gnc_lot_adjust_balance (GNCLotPrivate *priv, gnc_numeric amt)
+{
+    if (priv->balance_dirty) return;
+    priv->balance = gnc_numeric_add_fixed (priv->balance, amt);
+    if (gnc_numeric_check (priv->balance) != GNC_ERROR_OK)
+        priv->balance_dirty = TRUE;
+}
+
+static void
+lot_order_fill (LotOrderEntry *entry, Split *split)
+{
+    const Split *source = xaccSplitGetGainsSourceSplit (split);
+    Transaction *trans = (source ? source : split)->parent;
+
+    entry->split = split;
+    entry->date = trans ? trans->date_posted : G_MAXINT64;
+    entry->own_date = split->parent ? split->parent->date_posted : G_MAXINT64;
+    entry->amount = split->amount;
+    entry->value = split->value;
+}
+
+static gint
+lot_order_cmp (gconstpointer a, gconstpointer b)
+{
+    time64 da = ((const LotOrderEntry*)a)->date;
+    time64 db = ((const LotOrderEntry*)b)->date;
+    return (da > db) - (da < db);
+}
+
+static void
+lot_order_rebuild (GNCLotPrivate *priv)
+{
+    GList *node;
+    guint i;
+
+    g_array_set_size (priv->order, 0);
+    g_hash_table_remove_all (priv->order_pos);
+    for (node = priv->splits; node; node = node->next)
+    {
+        LotOrderEntry entry;
+        lot_order_fill (&entry, node->data);
+        g_array_append_val (priv->order, entry);
+    }
+    g_array_sort (priv->order, lot_order_cmp);
+    for (i = 0; i < priv->order->len; i++)
+        g_hash_table_insert (priv->order_pos,
+                             g_array_index (priv->order, LotOrderEntry, i).split,
+                             GUINT_TO_POINTER (i + 1));
+    priv->order_summed = 0;
+    priv->order_dirty = FALSE;
+}
+
+/* Bring the running sums of the first n entries up to date. */
+static void
+lot_order_sum (GNCLotPrivate *priv, guint n)
+{
+    for (; priv->order_summed < n; priv->order_summed++)
+    {
+        LotOrderEntry *entry = &g_array_index (priv->order, LotOrderEntry,
+                                               priv->order_summed);
+        if (priv->order_summed == 0)
+        {
+            entry->sum_amount = entry->amount;
+            entry->sum_value = entry->value;
+        }
+        else
+        {
+            entry->sum_amount = gnc_numeric_add_fixed ((entry - 1)->sum_amount,
+                                                       entry->amount);
+            entry->sum_value = gnc_numeric_add_fixed ((entry - 1)->sum_value,
+                                                      entry->value);
+        }
+    }
+}
+
+/* The position of the first entry posted on or after date, or after
+ * it if 'after' is set. */
+static guint
+lot_order_bound (GArray *order, time64 date, gboolean after)
+{
+    guint lo = 0, hi = order->len;
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        time64 d = g_array_index (order, LotOrderEntry, mid).date;
+        if (d < date || (after && d == date))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void
+lot_order_append (GNCLotPrivate *priv, Split *split)
+{
+    LotOrderEntry entry;
+    guint len = priv->order->len;
+
+    if (priv->order_dirty) return;
+    lot_order_fill (&entry, split);
+    if (len && g_array_index (priv->order, LotOrderEntry, len - 1).date > entry.date)
+    {
+        priv->order_dirty = TRUE;
+        return;
+    }
+    g_array_append_val (priv->order, entry);
+    g_hash_table_insert (priv->order_pos, split, GUINT_TO_POINTER (len + 1));
+}
+
+static void
+lot_order_remove (GNCLotPrivate *priv, Split *split)
+{
+    guint pos;
+
+    if (priv->order_dirty) return;
+    pos = GPOINTER_TO_UINT (g_hash_table_lookup (priv->order_pos, split));
+    if (pos == 0 || pos != priv->order->len)
+    {
+        priv->order_dirty = TRUE;
+        return;
+    }
+    g_array_set_size (priv->order, pos - 1);
+    g_hash_table_remove (priv->order_pos, split);
+    priv->order_summed = MIN (priv->order_summed, pos - 1);
+}
+
+void
+gnc_lot_split_changed (GNCLot *lot, Split *split)
+{
+    GNCLotPrivate* priv;
+    LotOrderEntry *entry, fresh;
+    guint pos = 0;
+
+    if (!lot || !split) return;
+    priv = GET_PRIVATE(lot);
+    if (!priv->order_dirty)
+        pos = GPOINTER_TO_UINT (g_hash_table_lookup (priv->order_pos, split));
+    if (pos == 0)
+    {
+        gnc_lot_set_closed_unknown (lot);
+        return;
+    }
+
+    /* A split that was moved to another date needs the splits put in
+     * order again, but one whose amount or value changed only needs
+     * the sums after it redone. */
+    entry = &g_array_index (priv->order, LotOrderEntry, pos - 1);
+    lot_order_fill (&fresh, split);
+    if (fresh.date != entry->date || fresh.own_date != entry->own_date)
+    {
+        gnc_lot_set_closed_unknown (lot);
+        return;
+    }
+    gnc_lot_adjust_balance (priv, gnc_numeric_sub_fixed (fresh.amount,
+                                                         entry->amount));
+    *entry = fresh;
+    priv->order_summed = MIN (priv->order_summed, pos - 1);
+
+    priv->is_closed = LOT_CLOSED_UNKNOWN;
+    if (priv->account)
+        gnc_account_mark_lot_dirty (priv->account, lot);
+}
+
 gnc_numeric
 gnc_lot_get_balance (GNCLot *lot)
 {
@@ -542,16 +760,22 @@ gnc_lot_get_balance (GNCLot *lot)
         return zero;
     }
 
-    /* Sum over splits; because they all belong to same account
-     * they will have same denominator.
-     */
-    for (node = priv->splits; node; node = node->next)
+    if (priv->balance_dirty)
     {
-        Split *s = node->data;
-        gnc_numeric amt = xaccSplitGetAmount (s);
-        baln = gnc_numeric_add_fixed (baln, amt);
-        g_assert (gnc_numeric_check (baln) == GNC_ERROR_OK);
+        /* Sum over splits; because they all belong to same account
+         * they will have same denominator.
+         */
+        for (node = priv->splits; node; node = node->next)
+        {
+            Split *s = node->data;
+            gnc_numeric amt = xaccSplitGetAmount (s);
+            baln = gnc_numeric_add_fixed (baln, amt);
+            g_assert (gnc_numeric_check (baln) == GNC_ERROR_OK);
+        }
+        priv->balance = baln;
+        priv->balance_dirty = FALSE;
     }
+    baln = priv->balance;
 
     /* cache a zero balance as a closed lot */
     if (gnc_numeric_equal (baln, zero))
@@ -573,7 +797,6 @@ gnc_lot_get_balance_before (const GNCLot *lot, const Split *split,
                             gnc_numeric *amount, gnc_numeric *value)
 {
     GNCLotPrivate* priv;
-    GList *node;
     gnc_numeric zero = gnc_numeric_zero();
     gnc_numeric amt = zero;
     gnc_numeric val = zero;
@@ -587,6 +810,7 @@ gnc_lot_get_balance_before (const GNCLot *lot, const Split *split,
     {
         Transaction *ta, *tb;
         const Split *target;
+        guint lo = 0, hi, i;
         /* If this is a gains split, find the source of the gains and use
            its transaction for the comparison.  Gains splits are in separate
            transactions that may sort after non-gains transactions.  */
@@ -594,9 +818,29 @@ gnc_lot_get_balance_before (const GNCLot *lot, const Split *split,
         if (target == NULL)
             target = split;
         tb = xaccSplitGetParent (target);
-        for (node = priv->splits; node; node = node->next)
+
+        if (priv->order_dirty)
+            lot_order_rebuild (priv);
+        hi = priv->order->len;
+        /* The splits posted before tb's date all sort before it and
+           those posted after it don't, so only the ones posted on the
+           same date need comparing. */
+        if (tb)
         {
-            Split *s = node->data;
+            lo = lot_order_bound (priv->order, tb->date_posted, FALSE);
+            hi = lot_order_bound (priv->order, tb->date_posted, TRUE);
+        }
+        lot_order_sum (priv, lo);
+        if (lo > 0)
+        {
+            LotOrderEntry *entry = &g_array_index (priv->order, LotOrderEntry,
+                                                   lo - 1);
+            amt = entry->sum_amount;
+            val = entry->sum_value;
+        }
+        for (i = lo; i < hi; i++)
+        {
+            Split *s = g_array_index (priv->order, LotOrderEntry, i).split;
             Split *source = xaccSplitGetGainsSourceSplit (s);
             if (source == NULL)
                 source = s;
@@ -660,10 +904,20 @@ gnc_lot_add_split (GNCLot *lot, Split *split)
     }
     xaccSplitSetLot(split, lot);
 
-    priv->splits = g_list_append (priv->splits, split);
+    if (!priv->sort_dirty && priv->last &&
+            xaccSplitOrderDateOnly (priv->last->data, split) > 0)
+        priv->sort_dirty = TRUE;
+    if (priv->last)
+        priv->last = g_list_append (priv->last, split)->next;
+    else
+        priv->splits = priv->last = g_list_append (NULL, split);
+    gnc_lot_adjust_balance (priv, split->amount);
+    lot_order_append (priv, split);
 
     /* for recomputation of is-closed */
     priv->is_closed = LOT_CLOSED_UNKNOWN;
+    if (priv->account)
+        gnc_account_mark_lot_dirty (priv->account, lot);
     gnc_lot_commit_edit(lot);
 
     qof_event_gen (QOF_INSTANCE(lot), QOF_EVENT_MODIFY, NULL);
@@ -674,13 +928,22 @@ void
 gnc_lot_remove_split (GNCLot *lot, Split *split)
 {
     GNCLotPrivate* priv;
+    GList *node;
     if (!lot || !split) return;
     priv = GET_PRIVATE(lot);
 
     ENTER ("(lot=%p, split=%p)", lot, split);
     gnc_lot_begin_edit(lot);
     qof_instance_set_dirty(QOF_INSTANCE(lot));
-    priv->splits = g_list_remove (priv->splits, split);
+    node = g_list_find (priv->splits, split);
+    if (node)
+    {
+        gnc_lot_adjust_balance (priv, gnc_numeric_neg (split->amount));
+        lot_order_remove (priv, split);
+        if (node == priv->last)
+            priv->last = node->prev;
+        priv->splits = g_list_delete_link (priv->splits, node);
+    }
     xaccSplitSetLot(split, NULL);
     priv->is_closed = LOT_CLOSED_UNKNOWN;   /* force an is-closed computation */
 
@@ -689,12 +952,27 @@ gnc_lot_remove_split (GNCLot *lot, Split *split)
         xaccAccountRemoveLot (priv->account, lot);
         priv->account = NULL;
     }
+    else if (priv->account)
+    {
+        gnc_account_mark_lot_dirty (priv->account, lot);
+    }
     gnc_lot_commit_edit(lot);
     qof_event_gen (QOF_INSTANCE(lot), QOF_EVENT_MODIFY, NULL);
     LEAVE("removed from lot");
 }
 
 /* ============================================================== */
+/* Utility function, put the lot's splits back in date order */
+
+static void
+gnc_lot_sort_splits (GNCLotPrivate *priv)
+{
+    if (!priv->sort_dirty) return;
+    priv->splits = g_list_sort (priv->splits, (GCompareFunc) xaccSplitOrderDateOnly);
+    priv->last = g_list_last (priv->splits);
+    priv->sort_dirty = FALSE;
+}
+
 /* Utility function, get earliest split in lot */
 
 Split *
@@ -704,7 +982,7 @@ gnc_lot_get_earliest_split (GNCLot *lot)
     if (!lot) return NULL;
     priv = GET_PRIVATE(lot);
     if (! priv->splits) return NULL;
-    priv->splits = g_list_sort (priv->splits, (GCompareFunc) xaccSplitOrderDateOnly);
+    gnc_lot_sort_splits (priv);
     return priv->splits->data;
 }
 
@@ -713,17 +991,12 @@ Split *
 gnc_lot_get_latest_split (GNCLot *lot)
 {
     GNCLotPrivate* priv;
-    SplitList *node;
 
     if (!lot) return NULL;
     priv = GET_PRIVATE(lot);
     if (! priv->splits) return NULL;
-    priv->splits = g_list_sort (priv->splits, (GCompareFunc) xaccSplitOrderDateOnly);
-
-    for (node = priv->splits; node->next; node = node->next)
-        ;
-
-    return node->data;
+    gnc_lot_sort_splits (priv);
+    return priv->last->data;
 }
 
 /* ============================================================= */
@@ -154,23 +154,28 @@ void gnc_lot_get_balance_before (const GNCLot *, const Split *,
 gboolean gnc_lot_is_closed (GNCLot *);
 
 /** The gnc_lot_get_earliest_split() routine is a convenience routine
- *    that helps identify the earliest date in the lot.   It simply
- *    loops over all of the splits in the lot, and returns the split
- *    with the earliest split->transaction->date_posted.  It may not
- *    necessarily identify the lot opening split.
+ *    that helps identify the earliest date in the lot.   It returns
+ *    the split with the earliest split->transaction->date_posted; the
+ *    lot keeps its splits in that order, so this is cheap.  It may
+ *    not necessarily identify the lot opening split.
  */
 Split * gnc_lot_get_earliest_split (GNCLot *lot);
 
 /** The gnc_lot_get_latest_split() routine is a convenience routine
- *    that helps identify the date this lot was closed.   It simply
- *    loops over all of the splits in the lot, and returns the split
- *    with the latest split->transaction->date_posted.
+ *    that helps identify the date this lot was closed.   It returns
+ *    the split with the latest split->transaction->date_posted.
  */
 Split * gnc_lot_get_latest_split (GNCLot *lot);
 
 /** Reset closed flag so that it will be recalculated. */
 void gnc_lot_set_closed_unknown(GNCLot*);
 
+/** Tell the lot that the amount, value or post date of one of its
+ *    splits may have changed.  Unlike gnc_lot_set_closed_unknown(),
+ *    a change of amount or value keeps the lot's split order and only
+ *    adjusts its balance. */
+void gnc_lot_split_changed (GNCLot *lot, Split *split);
+
 /** Get and set the account title, or the account notes, or the marker. */
 const char * gnc_lot_get_title (const GNCLot *);
 const char * gnc_lot_get_notes (const GNCLot *);
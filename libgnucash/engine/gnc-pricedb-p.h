@@ -58,6 +58,19 @@ struct gnc_price_db_s
     GHashTable *commodity_hash;
     gboolean bulk_update;		 /* TRUE while reading XML file, etc. */
     gboolean reset_nth_price_cache;
+
+    /* Conversion rates already worked out by get_nearest_price, keyed
+     * by (from, to, time, before).  Any change to a price bumps
+     * generation, which empties the cache on its next use.  The cache
+     * holds at most PRICE_RATE_CACHE_SIZE rates; rate_cache_lru has
+     * their keys, most recently used first, so the least recently
+     * used rate is dropped to make room. */
+    GHashTable *rate_cache;
+    GQueue rate_cache_lru;
+    guint64 generation;
+    guint64 rate_cache_generation;
+    guint64 rate_cache_hits;
+    guint64 rate_cache_misses;
 };
 
 struct _GncPriceDBClass
@@ -86,6 +99,8 @@ typedef struct gnc_price_lookup_helper_s
     time64 time;
 } GNCPriceLookupHelper;
 
+#define PRICE_RATE_CACHE_SIZE 4096
+
 #define  gnc_price_set_guid(P,G)  qof_instance_set_guid(QOF_INSTANCE(P),(G))
 void     gnc_pricedb_substitute_commodity(GNCPriceDB *db,
         gnc_commodity *old_c,
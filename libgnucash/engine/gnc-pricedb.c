@@ -42,7 +42,7 @@ static GNCPrice *lookup_nearest_in_time(GNCPriceDB *db, const gnc_commodity *c,
                                         time64 t, gboolean sameday);
 static gboolean
 pricedb_pricelist_traversal(GNCPriceDB *db,
-                            gboolean (*f)(GList *p, gpointer user_data),
+                            gboolean (*f)(GPtrArray *p, gpointer user_data),
                             gpointer user_data);
 
 enum
@@ -575,6 +575,8 @@ gnc_price_set_value(GNCPrice *p, gnc_numeric value)
         p->value = value;
         gnc_price_set_dirty(p);
         gnc_price_commit_edit (p);
+        if (p->db)
+            p->db->generation++;
     }
 }
 
@@ -819,13 +821,157 @@ gnc_price_list_equal(PriceList *prices1, PriceList *prices2)
     return TRUE;
 }
 
+/* ==================================================================== */
+/* price array functions
+
+   The price DB keeps the prices of each commodity/currency pair in a
+   GPtrArray that holds a reference to each price.  The array is sorted
+   from oldest to newest, the reverse of compare_prices_by_date, so that
+   adding the latest quote is an append and walking the array backwards
+   gives the newest-first order of a PriceList.
+ */
+
+static GPtrArray *
+price_array_new (void)
+{
+    return g_ptr_array_new_with_free_func ((GDestroyNotify) gnc_price_unref);
+}
+
+static inline GNCPrice *
+price_array_index (GPtrArray *prices, guint i)
+{
+    return (GNCPrice *) g_ptr_array_index (prices, i);
+}
+
+/* Index of the first price in the array at or after t. */
+static guint
+price_array_lower_bound (GPtrArray *prices, time64 t)
+{
+    guint lo = 0, hi = prices->len;
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        if (gnc_price_get_time64 (price_array_index (prices, mid)) < t)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* Index of the first price in the array after t. */
+static guint
+price_array_upper_bound (GPtrArray *prices, time64 t)
+{
+    guint lo = 0, hi = prices->len;
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        if (gnc_price_get_time64 (price_array_index (prices, mid)) <= t)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* The same as gnc_price_list_insert, including its handling of
+ * duplicates, but only the prices on the same day as p are checked. */
+static void
+price_array_insert (GPtrArray *prices, GNCPrice *p, gboolean check_dupl)
+{
+    guint lo, hi;
+
+    gnc_price_ref (p);
+
+    if (check_dupl)
+    {
+        time64 day = time64CanonicalDayTime (gnc_price_get_time64 (p));
+        PriceListIsDuplStruct dupl = { p, FALSE };
+        guint i = price_array_upper_bound (prices, gnc_price_get_time64 (p));
+        guint j;
+
+        for (j = i; j > 0 && !dupl.isDupl; --j)
+        {
+            GNCPrice *other = price_array_index (prices, j - 1);
+            if (time64CanonicalDayTime (gnc_price_get_time64 (other)) != day)
+                break;
+            price_list_is_duplicate (other, &dupl);
+        }
+        for (j = i; j < prices->len && !dupl.isDupl; ++j)
+        {
+            GNCPrice *other = price_array_index (prices, j);
+            if (time64CanonicalDayTime (gnc_price_get_time64 (other)) != day)
+                break;
+            price_list_is_duplicate (other, &dupl);
+        }
+        if (dupl.isDupl)
+            return;
+    }
+
+    /* New quotes are almost always the latest ones. */
+    hi = prices->len;
+    if (hi == 0 ||
+        compare_prices_by_date (p, price_array_index (prices, hi - 1)) < 0)
+    {
+        g_ptr_array_add (prices, p);
+        return;
+    }
+
+    lo = 0;
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        if (compare_prices_by_date (p, price_array_index (prices, mid)) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    g_ptr_array_insert (prices, lo, p);
+}
+
+/* Drops the array's reference to p, if it holds p. */
+static void
+price_array_remove (GPtrArray *prices, GNCPrice *p)
+{
+    time64 t = gnc_price_get_time64 (p);
+    guint i;
+
+    for (i = price_array_lower_bound (prices, t); i < prices->len; ++i)
+    {
+        GNCPrice *found = price_array_index (prices, i);
+        if (found == p)
+        {
+            g_ptr_array_remove_index (prices, i);
+            return;
+        }
+        if (gnc_price_get_time64 (found) != t)
+            return;
+    }
+}
+
+/* A PriceList view of the array, newest first.  The prices in it are
+ * not reffed; free it with g_list_free. */
+static PriceList *
+price_array_to_list (GPtrArray *prices)
+{
+    PriceList *result = NULL;
+    guint i;
+
+    for (i = 0; i < prices->len; ++i)
+        result = g_list_prepend (result, price_array_index (prices, i));
+    return result;
+}
+
 /* ==================================================================== */
 /* GNCPriceDB functions
 
    Structurally a GNCPriceDB contains a hash mapping price commodities
    (of type gnc_commodity*) to hashes mapping price currencies (of
-   type gnc_commodity*) to GNCPrice lists (see gnc-pricedb.h for a
-   description of GNCPrice lists).  The top-level key is the commodity
+   type gnc_commodity*) to arrays of GNCPrices sorted by time (see
+   "price array functions" above).  The top-level key is the commodity
    you want the prices for, and the second level key is the commodity
    that the value is expressed in terms of.
  */
@@ -837,6 +983,7 @@ static void
 gnc_pricedb_init(GNCPriceDB* pdb)
 {
     pdb->reset_nth_price_cache = FALSE;
+    g_queue_init (&pdb->rate_cache_lru);
 }
 
 static void
@@ -887,18 +1034,13 @@ destroy_pricedb_currency_hash_data(gpointer key,
                                    gpointer data,
                                    gpointer user_data)
 {
-    GList *price_list = (GList *) data;
-    GList *node;
-    GNCPrice *p;
-
-    for (node = price_list; node; node = node->next)
-    {
-        p = node->data;
+    GPtrArray *prices = (GPtrArray *) data;
+    guint i;
 
-        p->db = NULL;
-    }
+    for (i = 0; i < prices->len; ++i)
+        price_array_index (prices, i)->db = NULL;
 
-    gnc_price_list_destroy(price_list);
+    g_ptr_array_free (prices, TRUE);
 }
 
 static void
@@ -926,6 +1068,10 @@ gnc_pricedb_destroy(GNCPriceDB *db)
     }
     g_hash_table_destroy (db->commodity_hash);
     db->commodity_hash = NULL;
+    if (db->rate_cache)
+        g_hash_table_destroy (db->rate_cache);
+    db->rate_cache = NULL;
+    g_queue_init (&db->rate_cache_lru);
     /* qof_instance_release (&db->inst); */
     g_object_unref(db);
 }
@@ -1008,7 +1154,7 @@ pricedb_equal_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
     GNCPriceDBEqualData *equal_data = user_data;
     gnc_commodity *currency = key;
-    GList *price_list1 = val;
+    GList *price_list1 = price_array_to_list (val);
     GList *price_list2;
 
     price_list2 = gnc_pricedb_get_prices (equal_data->db2,
@@ -1018,6 +1164,7 @@ pricedb_equal_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
     if (!gnc_price_list_equal (price_list1, price_list2))
         equal_data->equal = FALSE;
 
+    g_list_free (price_list1);
     gnc_price_list_destroy (price_list2);
 }
 
@@ -1067,7 +1214,7 @@ add_price(GNCPriceDB *db, GNCPrice *p)
 {
     /* This function will use p, adding a ref, so treat p as read-only
        if this function succeeds. */
-    GList *price_list;
+    GPtrArray *prices;
     gnc_commodity *commodity;
     gnc_commodity *currency;
     GHashTable *currency_hash;
@@ -1130,21 +1277,15 @@ add_price(GNCPriceDB *db, GNCPrice *p)
         g_hash_table_insert(db->commodity_hash, commodity, currency_hash);
     }
 
-    price_list = g_hash_table_lookup(currency_hash, currency);
-    if (!gnc_price_list_insert(&price_list, p, !db->bulk_update))
-    {
-        LEAVE ("gnc_price_list_insert failed");
-        return FALSE;
-    }
-
-    if (!price_list)
+    prices = g_hash_table_lookup(currency_hash, currency);
+    if (!prices)
     {
-        LEAVE (" no price list");
-        return FALSE;
+        prices = price_array_new ();
+        g_hash_table_insert(currency_hash, currency, prices);
     }
-
-    g_hash_table_insert(currency_hash, currency, price_list);
+    price_array_insert (prices, p, !db->bulk_update);
     p->db = db;
+    db->generation++;
 
     qof_event_gen (&p->inst, QOF_EVENT_ADD, NULL);
 
@@ -1194,7 +1335,7 @@ gnc_pricedb_add_price(GNCPriceDB *db, GNCPrice *p)
 static gboolean
 remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup)
 {
-    GList *price_list;
+    GPtrArray *prices;
     gnc_commodity *commodity;
     gnc_commodity *currency;
     GHashTable *currency_hash;
@@ -1230,24 +1371,19 @@ remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup)
     }
 
     qof_event_gen (&p->inst, QOF_EVENT_REMOVE, NULL);
-    price_list = g_hash_table_lookup(currency_hash, currency);
+    prices = g_hash_table_lookup(currency_hash, currency);
     gnc_price_ref(p);
-    if (!gnc_price_list_remove(&price_list, p))
-    {
-        gnc_price_unref(p);
-        LEAVE (" cannot remove price list");
-        return FALSE;
-    }
+    if (prices)
+        price_array_remove (prices, p);
+    db->generation++;
 
-    /* if the price list is empty, then remove this currency from the
+    /* if the price array is empty, then remove this currency from the
        commodity hash */
-    if (price_list)
-    {
-        g_hash_table_insert(currency_hash, currency, price_list);
-    }
-    else
+    if (!prices || prices->len == 0)
     {
         g_hash_table_remove(currency_hash, currency);
+        if (prices)
+            g_ptr_array_free (prices, TRUE);
 
         if (cleanup)
         {
@@ -1355,14 +1491,15 @@ pricedb_remove_foreach_pricelist (gpointer key,
                                   gpointer val,
                                   gpointer user_data)
 {
-    GList *price_list = (GList *) val;
-    GList *node = price_list;
+    GPtrArray *prices = (GPtrArray *) val;
     remove_info *data = (remove_info *) user_data;
+    guint i;
 
     ENTER("key %p, value %p, data %p", key, val, user_data);
 
-    /* now check each item in the list */
-    g_list_foreach(node, (GFunc)check_one_price_date, data);
+    /* now check each item in the array */
+    for (i = 0; i < prices->len; ++i)
+        check_one_price_date (price_array_index (prices, i), data);
 
     LEAVE(" ");
 }
@@ -1672,30 +1809,33 @@ static void
 hash_values_helper(gpointer key, gpointer value, gpointer data)
 {
     GList ** l = data;
+    GList *value_list = price_array_to_list (value);
     if (*l)
     {
         GList *new_l;
-        new_l = pricedb_price_list_merge(*l, value);
+        new_l = pricedb_price_list_merge(*l, value_list);
         g_list_free (*l);
+        g_list_free (value_list);
         *l = new_l;
     }
     else
-        *l = g_list_copy (value);
+        *l = value_list;
 }
 
 static PriceList *
 price_list_from_hashtable (GHashTable *hash, const gnc_commodity *currency)
 {
-    GList *price_list = NULL, *result = NULL ;
+    GPtrArray *prices;
+    GList *result = NULL;
     if (currency)
     {
-        price_list = g_hash_table_lookup(hash, currency);
-        if (!price_list)
+        prices = g_hash_table_lookup(hash, currency);
+        if (!prices)
         {
             LEAVE (" no price list");
             return NULL;
         }
-        result = g_list_copy (price_list);
+        result = price_array_to_list (prices);
     }
     else
     {
@@ -1784,24 +1924,65 @@ pricedb_get_prices_internal(GNCPriceDB *db, const gnc_commodity *commodity,
     return forward_list;
 }
 
+/* Bisects the prices of commodity in currency and of currency in
+ * commodity for t.  Of the newest-first list the two would merge into,
+ * before is set to the first price at or before t and after to the
+ * price just ahead of it, the oldest one later than t.  Either is NULL
+ * if there is no such price; neither is reffed. */
+static void
+pricedb_bracket_time (GNCPriceDB *db, const gnc_commodity *commodity,
+                      const gnc_commodity *currency, time64 t,
+                      GNCPrice **before, GNCPrice **after)
+{
+    GPtrArray *arrays[2] = { NULL, NULL };
+    GHashTable *currency_hash;
+    int i;
+
+    *before = NULL;
+    *after = NULL;
+    currency_hash = g_hash_table_lookup (db->commodity_hash, commodity);
+    if (currency_hash)
+        arrays[0] = g_hash_table_lookup (currency_hash, currency);
+    currency_hash = g_hash_table_lookup (db->commodity_hash, currency);
+    if (currency_hash)
+        arrays[1] = g_hash_table_lookup (currency_hash, commodity);
+
+    for (i = 0; i < 2; ++i)
+    {
+        GPtrArray *prices = arrays[i];
+        guint idx;
+
+        if (!prices)
+            continue;
+        idx = price_array_upper_bound (prices, t);
+        if (idx > 0)
+        {
+            GNCPrice *price = price_array_index (prices, idx - 1);
+            if (!*before || compare_prices_by_date (price, *before) < 0)
+                *before = price;
+        }
+        if (idx < prices->len)
+        {
+            GNCPrice *price = price_array_index (prices, idx);
+            if (!*after || compare_prices_by_date (price, *after) > 0)
+                *after = price;
+        }
+    }
+}
+
 GNCPrice *gnc_pricedb_lookup_latest(GNCPriceDB *db,
                           const gnc_commodity *commodity,
                           const gnc_commodity *currency)
 {
-    GList *price_list;
-    GNCPrice *result;
+    GNCPrice *result, *after;
 
     if (!db || !commodity || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, commodity, currency);
 
-    price_list = pricedb_get_prices_internal(db, commodity, currency, TRUE);
-    if (!price_list) return NULL;
-    /* This works magically because prices are inserted in date-sorted
-     * order, and the latest date always comes first. So return the
-     * first in the list.  */
-    result = price_list->data;
+    /* Nothing is later than INT64_MAX, so this is the newest price. */
+    pricedb_bracket_time (db, commodity, currency, INT64_MAX, &result, &after);
+    if (!result) return NULL;
     gnc_price_ref(result);
-    g_list_free (price_list);
     LEAVE("price is %p", result);
     return result;
 }
@@ -1824,54 +2005,48 @@ typedef struct
 */
 
 static gboolean
-price_list_scan_any_currency(GList *price_list, gpointer data)
+price_list_scan_any_currency(GPtrArray *prices, gpointer data)
 {
     UsesCommodity *helper = (UsesCommodity*)data;
-    GList *node = price_list;
+    GNCPrice *price;
     gnc_commodity *com;
     gnc_commodity *cur;
+    guint idx;
 
-    if (!price_list)
+    if (!prices || !prices->len)
         return TRUE;
 
-    com = gnc_price_get_commodity(node->data);
-    cur = gnc_price_get_currency(node->data);
+    price = price_array_index (prices, 0);
+    com = gnc_price_get_commodity(price);
+    cur = gnc_price_get_currency(price);
 
     /* if this price list isn't for the commodity we are interested in,
        ignore it. */
     if (com != helper->com && cur != helper->com)
         return TRUE;
 
-    /* The price list is sorted in decreasing order of time.  Find the first
-       price on it that is older than the requested time and add it and the
-       previous price to the result list. */
-    while (node != NULL)
+    /* The price array is sorted in increasing order of time.  Find the
+       newest price older than the requested time and add it and the
+       next newer price to the result list. */
+    idx = price_array_lower_bound (prices, helper->t);
+    if (idx == 0)
     {
-        GNCPrice *price = node->data;
-        time64 price_t = gnc_price_get_time64(price);
-        if (price_t < helper->t)
-        {
-            /* If there is a previous price add it to the results. */
-            if (node->prev)
-            {
-                GNCPrice *prev_price = node->prev->data;
-                gnc_price_ref(prev_price);
-                *helper->list = g_list_prepend(*helper->list, prev_price);
-            }
-            /* Add the first price before the desired time */
-            gnc_price_ref(price);
-            *helper->list = g_list_prepend(*helper->list, price);
-            /* No point in looking further, they will all be older */
-            break;
-        }
-        else if (node->next == NULL)
-        {
-            /* The last price is later than given time, add it */
-            gnc_price_ref(price);
-            *helper->list = g_list_prepend(*helper->list, price);
-        }
-        node = node->next;
+        /* The oldest price is later than given time, add it */
+        gnc_price_ref(price);
+        *helper->list = g_list_prepend(*helper->list, price);
+        return TRUE;
     }
+    /* If there is a newer price add it to the results. */
+    if (idx < prices->len)
+    {
+        GNCPrice *next_price = price_array_index (prices, idx);
+        gnc_price_ref(next_price);
+        *helper->list = g_list_prepend(*helper->list, next_price);
+    }
+    /* Add the first price before the desired time */
+    price = price_array_index (prices, idx - 1);
+    gnc_price_ref(price);
+    *helper->list = g_list_prepend(*helper->list, price);
 
     return TRUE;
 }
@@ -2066,7 +2241,7 @@ gnc_pricedb_has_prices(GNCPriceDB *db,
                        const gnc_commodity *commodity,
                        const gnc_commodity *currency)
 {
-    GList *price_list;
+    GPtrArray *prices;
     GHashTable *currency_hash;
     gint size;
 
@@ -2081,8 +2256,8 @@ gnc_pricedb_has_prices(GNCPriceDB *db,
 
     if (currency)
     {
-        price_list = g_hash_table_lookup(currency_hash, currency);
-        if (price_list)
+        prices = g_hash_table_lookup(currency_hash, currency);
+        if (prices)
         {
             LEAVE("yes");
             return TRUE;
@@ -2126,9 +2301,9 @@ static void
 price_count_helper(gpointer key, gpointer value, gpointer data)
 {
     int *result = data;
-    GList *price_list = value;
+    GPtrArray *prices = value;
 
-    *result += g_list_length(price_list);
+    *result += prices->len;
 }
 
 int
@@ -2157,10 +2332,11 @@ list_combine (gpointer element, gpointer data)
 {
     GList *list = *(GList**)data;
     if (list == NULL)
-        *(GList**)data = g_list_copy (element);
+        *(GList**)data = price_array_to_list (element);
     else
     {
-        GList *new_list = g_list_concat ((GList *)list, g_list_copy (element));
+        GList *new_list = g_list_concat ((GList *)list,
+                                         price_array_to_list (element));
         *(GList**)data = new_list;
     }
 }
@@ -2244,27 +2420,17 @@ gnc_pricedb_lookup_at_time64(GNCPriceDB *db,
                              const gnc_commodity *currency,
                              time64 t)
 {
-    GList *price_list;
-    GList *item = NULL;
+    GNCPrice *p, *after;
 
     if (!db || !c || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    item = price_list;
-    while (item)
+    pricedb_bracket_time (db, c, currency, t, &p, &after);
+    if (p && gnc_price_get_time64(p) == t)
     {
-        GNCPrice *p = item->data;
-        time64 price_time = gnc_price_get_time64(p);
-        if (price_time == t)
-        {
-            gnc_price_ref(p);
-            g_list_free (price_list);
-            LEAVE("price is %p", p);
-            return p;
-        }
-        item = item->next;
+        gnc_price_ref(p);
+        LEAVE("price is %p", p);
+        return p;
     }
-    g_list_free (price_list);
     LEAVE (" ");
     return NULL;
 }
@@ -2276,36 +2442,22 @@ lookup_nearest_in_time(GNCPriceDB *db,
                        time64 t,
                        gboolean sameday)
 {
-    GList *price_list;
     GNCPrice *current_price = NULL;
     GNCPrice *next_price = NULL;
     GNCPrice *result = NULL;
-    GList *item = NULL;
 
     if (!db || !c || !currency) return NULL;
     if (t == INT64_MAX) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    if (!price_list) return NULL;
-    item = price_list;
 
-    /* default answer */
-    current_price = item->data;
-
-    /* find the first candidate past the one we want.  Remember that
-       prices are in most-recent-first order. */
-    while (!next_price && item)
-    {
-        GNCPrice *p = item->data;
-        time64 price_time = gnc_price_get_time64(p);
-        if (price_time <= t)
-        {
-            next_price = item->data;
-            break;
-        }
-        current_price = item->data;
-        item = item->next;
-    }
+    /* next_price is the newest price not later than t and current_price
+       the oldest one later than it.  When all the prices are later
+       current_price is the oldest of them, when none are it is
+       next_price. */
+    pricedb_bracket_time (db, c, currency, t, &next_price, &current_price);
+    if (!current_price)
+        current_price = next_price;
+    if (!current_price) return NULL;
 
     if (current_price)      /* How can this be null??? */
     {
@@ -2377,7 +2529,6 @@ lookup_nearest_in_time(GNCPriceDB *db,
     }
 
     gnc_price_ref(result);
-    g_list_free (price_list);
     LEAVE (" ");
     return result;
 }
@@ -2398,28 +2549,13 @@ gnc_pricedb_lookup_nearest_before_t64 (GNCPriceDB *db,
                                        const gnc_commodity *currency,
                                        time64 t)
 {
-    GList *price_list;
     GNCPrice *current_price = NULL;
-    /*  GNCPrice *next_price = NULL;
-        GNCPrice *result = NULL;*/
-    GList *item = NULL;
-    time64 price_time;
+    GNCPrice *next_price = NULL;
 
     if (!db || !c || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    if (!price_list) return NULL;
-    item = price_list;
-    do
-    {
-        price_time = gnc_price_get_time64 (item->data);
-        if (price_time <= t)
-            current_price = item->data;
-        item = item->next;
-    }
-    while (price_time > t && item);
+    pricedb_bracket_time (db, c, currency, t, &current_price, &next_price);
     gnc_price_ref(current_price);
-    g_list_free (price_list);
     LEAVE (" ");
     return current_price;
 }
@@ -2573,6 +2709,42 @@ direct_price_conversion (GNCPriceDB *db, const gnc_commodity *from,
     return retval;
 }
 
+typedef struct
+{
+    const gnc_commodity *from;
+    const gnc_commodity *to;
+    time64 t;
+    gboolean before;
+} PriceRateKey;
+
+/* A cached rate; link sits in the db's rate_cache_lru and points at
+ * the rate's key. */
+typedef struct
+{
+    gnc_numeric rate;
+    GList link;
+} PriceRateEntry;
+
+static guint
+price_rate_key_hash (gconstpointer key)
+{
+    const PriceRateKey *k = key;
+    guint hash = g_direct_hash (k->from);
+
+    hash = hash * 31 + g_direct_hash (k->to);
+    hash = hash * 31 + g_int64_hash (&k->t);
+    return hash * 31 + k->before;
+}
+
+static gboolean
+price_rate_key_equal (gconstpointer a, gconstpointer b)
+{
+    const PriceRateKey *ka = a, *kb = b;
+
+    return ka->from == kb->from && ka->to == kb->to &&
+        ka->t == kb->t && ka->before == kb->before;
+}
+
 static gnc_numeric
 get_nearest_price (GNCPriceDB *pdb,
                    const gnc_commodity *orig_curr,
@@ -2581,10 +2753,37 @@ get_nearest_price (GNCPriceDB *pdb,
                    gboolean before)
 {
     gnc_numeric price;
+    PriceRateKey key = { orig_curr, new_curr, t, before };
+    PriceRateEntry *cached;
 
     if (gnc_commodity_equiv (orig_curr, new_curr))
         return gnc_numeric_create (1, 1);
 
+    /* The latest prices are those before the current time, which moves,
+     * so only lookups at a given time can be reused. */
+    if (pdb && t != INT64_MAX)
+    {
+        if (!pdb->rate_cache)
+            pdb->rate_cache = g_hash_table_new_full (price_rate_key_hash,
+                                                     price_rate_key_equal,
+                                                     g_free, g_free);
+        if (pdb->rate_cache_generation != pdb->generation)
+        {
+            g_hash_table_remove_all (pdb->rate_cache);
+            g_queue_init (&pdb->rate_cache_lru);
+            pdb->rate_cache_generation = pdb->generation;
+        }
+        cached = g_hash_table_lookup (pdb->rate_cache, &key);
+        if (cached)
+        {
+            pdb->rate_cache_hits++;
+            g_queue_unlink (&pdb->rate_cache_lru, &cached->link);
+            g_queue_push_head_link (&pdb->rate_cache_lru, &cached->link);
+            return cached->rate;
+        }
+        pdb->rate_cache_misses++;
+    }
+
     /* Look for a direct price. */
     price = direct_price_conversion (pdb, orig_curr, new_curr, t, before);
 
@@ -2594,7 +2793,36 @@ get_nearest_price (GNCPriceDB *pdb,
     if (gnc_numeric_zero_p (price))
         price = indirect_price_conversion (pdb, orig_curr, new_curr, t, before);
 
-    return gnc_numeric_reduce (price);
+    price = gnc_numeric_reduce (price);
+    if (pdb && t != INT64_MAX)
+    {
+        PriceRateKey *new_key = g_new (PriceRateKey, 1);
+        PriceRateEntry *entry = g_new0 (PriceRateEntry, 1);
+
+        if (pdb->rate_cache_lru.length >= PRICE_RATE_CACHE_SIZE)
+        {
+            GList *oldest = g_queue_pop_tail_link (&pdb->rate_cache_lru);
+            g_hash_table_remove (pdb->rate_cache, oldest->data);
+        }
+        *new_key = key;
+        entry->rate = price;
+        entry->link.data = new_key;
+        g_hash_table_insert (pdb->rate_cache, new_key, entry);
+        g_queue_push_head_link (&pdb->rate_cache_lru, &entry->link);
+    }
+    return price;
+}
+
+void
+gnc_pricedb_get_rate_cache_stats (GNCPriceDB *pdb, guint64 *hits,
+                                  guint64 *misses)
+{
+    g_return_if_fail (pdb);
+
+    if (hits)
+        *hits = pdb->rate_cache_hits;
+    if (misses)
+        *misses = pdb->rate_cache_misses;
 }
 
 gnc_numeric
@@ -2696,16 +2924,16 @@ typedef struct
 static void
 pricedb_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
-    GList *node = price_list;
+    GPtrArray *prices = (GPtrArray *) val;
+    guint i = prices->len;
     GNCPriceDBForeachData *foreach_data = (GNCPriceDBForeachData *) user_data;
 
-    /* stop traversal when func returns FALSE */
-    while (foreach_data->ok && node)
+    /* newest first, as in a PriceList; stop traversal when func
+       returns FALSE */
+    while (foreach_data->ok && i > 0)
     {
-        GNCPrice *p = (GNCPrice *) node->data;
+        GNCPrice *p = price_array_index (prices, --i);
         foreach_data->ok = foreach_data->func(p, foreach_data->user_data);
-        node = node->next;
     }
 }
 
@@ -2742,18 +2970,18 @@ unstable_price_traversal(GNCPriceDB *db,
 typedef struct
 {
     gboolean ok;
-    gboolean (*func)(GList *p, gpointer user_data);
+    gboolean (*func)(GPtrArray *p, gpointer user_data);
     gpointer user_data;
 } GNCPriceListForeachData;
 
 static void
 pricedb_pricelist_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
+    GPtrArray *prices = (GPtrArray *) val;
     GNCPriceListForeachData *foreach_data = (GNCPriceListForeachData *) user_data;
     if (foreach_data->ok)
     {
-        foreach_data->ok = foreach_data->func(price_list, foreach_data->user_data);
+        foreach_data->ok = foreach_data->func(prices, foreach_data->user_data);
     }
 }
 
@@ -2766,7 +2994,7 @@ pricedb_pricelist_foreach_currencies_hash(gpointer key, gpointer val, gpointer u
 
 static gboolean
 pricedb_pricelist_traversal(GNCPriceDB *db,
-                         gboolean (*f)(GList *p, gpointer user_data),
+                         gboolean (*f)(GPtrArray *p, gpointer user_data),
                          gpointer user_data)
 {
     GNCPriceListForeachData foreach_data;
@@ -2838,12 +3066,12 @@ stable_price_traversal(GNCPriceDB *db,
         for (j = price_lists; j; j = j->next)
         {
             HashEntry *pricelist_entry = (HashEntry *) j->data;
-            GList *price_list = (GList *) pricelist_entry->value;
-            GList *node;
+            GPtrArray *prices = (GPtrArray *) pricelist_entry->value;
+            guint k;
 
-            for (node = (GList *) price_list; node; node = node->next)
+            for (k = prices->len; k > 0; --k)
             {
-                GNCPrice *price = (GNCPrice *) node->data;
+                GNCPrice *price = price_array_index (prices, k - 1);
 
                 /* stop traversal when f returns FALSE */
                 if (FALSE == ok) break;
@@ -3063,15 +3291,14 @@ VoidGNCPriceDBForeachData;
 static void
 void_pricedb_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
-    GList *node = price_list;
+    GPtrArray *prices = (GPtrArray *) val;
+    guint i;
     VoidGNCPriceDBForeachData *foreach_data = (VoidGNCPriceDBForeachData *) user_data;
 
-    while (node)
+    for (i = prices->len; i > 0; --i)
     {
-        GNCPrice *p = (GNCPrice *) node->data;
+        GNCPrice *p = price_array_index (prices, i - 1);
         foreach_data->func(p, foreach_data->user_data);
-        node = node->next;
     }
 }
 
@@ -646,6 +646,17 @@ gnc_pricedb_convert_balance_nearest_before_price_t64 (GNCPriceDB *pdb,
                                                      const gnc_commodity *new_currency,
                                                      time64 t);
 
+/** @brief Report how often the conversion functions above found their
+ * rate in the price DB's rate cache rather than searching the prices.
+ *
+ * The cache is emptied whenever a price is added, removed or changed.
+ * @param pdb The pricedb
+ * @param hits Returns the number of lookups answered from the cache, may be NULL
+ * @param misses Returns the number of lookups that searched the prices, may be NULL
+ */
+void gnc_pricedb_get_rate_cache_stats (GNCPriceDB *pdb, guint64 *hits,
+                                       guint64 *misses);
+
 typedef gboolean (*GncPriceForeachFunc)(GNCPrice *p, gpointer user_data);
 
 /** @brief Call a GncPriceForeachFunction once for each price in db, until the
@@ -41,6 +41,7 @@
 
 #include "gncCustomer.h"
 #include "gncCustomerP.h"
+#include "gncIDSearchP.h"
 #include "gncJobP.h"
 #include "gncTaxTableP.h"
 
@@ -328,6 +329,7 @@ GncCustomer *gncCustomerCreate (QofBook *book)
         cust_qof_event_handler_id = qof_event_register_handler (cust_handle_qof_events, NULL);
 
     qof_event_gen (&cust->inst, QOF_EVENT_CREATE, NULL);
+    gnc_id_search_update (&cust->inst);
 
     return cust;
 }
@@ -383,6 +385,7 @@ void gncCustomerSetID (GncCustomer *cust, const char *id)
     SET_STR(cust, cust->id, id);
     mark_customer (cust);
     gncCustomerCommitEdit (cust);
+    gnc_id_search_update (&cust->inst);
 }
 
 void gncCustomerSetName (GncCustomer *cust, const char *name)
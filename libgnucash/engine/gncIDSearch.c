@@ -22,6 +22,7 @@
 **********************************************************************/
 
 #include "gncIDSearch.h"
+#include "gncIDSearchP.h"
 
 typedef enum
 {   UNDEFINED,
@@ -31,6 +32,23 @@ typedef enum
     BILL
 }GncSearchType;
 
+/* Each book keeps, for each of customers, vendors and invoices, an
+ * index from ID to the objects with that ID.  It's built the first
+ * time it is searched and kept current by the ID setters from then
+ * on; freed objects drop out of it. */
+typedef struct
+{
+    QofIdTypeConst type;
+    GHashTable *ids;        /* ID -> GQueue of objects */
+    GHashTable *entries;    /* object -> IDIndexEntry */
+} IDIndex;
+
+typedef struct
+{
+    gchar *id;
+    GList *link;            /* the object in its ID's queue */
+} IDIndexEntry;
+
 static void * search(QofBook * book, const gchar *id, void * object, GncSearchType type);
 static QofLogModule log_module = G_LOG_DOMAIN;
 /***********************************************************************
@@ -80,84 +98,183 @@ gnc_search_vendor_on_id (QofBook * book, const gchar *id)
 }
 
 
+/******************************************************************
+ * The ID indexes
+ ****************************************************************/
+static const gchar *
+id_index_key (QofIdTypeConst type)
+{
+    if (!g_strcmp0 (type, GNC_ID_CUSTOMER))
+        return "gncIDSearch-customer-index";
+    if (!g_strcmp0 (type, GNC_ID_VENDOR))
+        return "gncIDSearch-vendor-index";
+    if (!g_strcmp0 (type, GNC_ID_INVOICE))
+        return "gncIDSearch-invoice-index";
+    return NULL;
+}
+
+static const gchar *
+instance_get_id (QofIdTypeConst type, QofInstance *inst)
+{
+    if (!g_strcmp0 (type, GNC_ID_CUSTOMER))
+        return gncCustomerGetID (GNC_CUSTOMER (inst));
+    if (!g_strcmp0 (type, GNC_ID_VENDOR))
+        return gncVendorGetID (GNC_VENDOR (inst));
+    return gncInvoiceGetID (GNC_INVOICE (inst));
+}
+
+static void
+id_index_unlink (IDIndex *idx, IDIndexEntry *entry)
+{
+    GQueue *queue = g_hash_table_lookup (idx->ids, entry->id);
+
+    g_queue_delete_link (queue, entry->link);
+    if (g_queue_is_empty (queue))
+        g_hash_table_remove (idx->ids, entry->id);
+    g_free (entry->id);
+    entry->id = NULL;
+}
+
+static void
+id_index_entry_free (gpointer data)
+{
+    IDIndexEntry *entry = data;
+    g_free (entry->id);
+    g_free (entry);
+}
+
+static void
+id_index_object_freed (gpointer data, GObject *inst)
+{
+    IDIndex *idx = data;
+    IDIndexEntry *entry = g_hash_table_lookup (idx->entries, inst);
+
+    if (!entry) return;
+    id_index_unlink (idx, entry);
+    g_hash_table_remove (idx->entries, inst);
+}
+
+static void
+id_index_file (QofInstance *inst, gpointer data)
+{
+    IDIndex *idx = data;
+    const gchar *id = instance_get_id (idx->type, inst);
+    IDIndexEntry *entry = g_hash_table_lookup (idx->entries, inst);
+    GQueue *queue;
+
+    if (!id) id = "";
+    if (entry && !g_strcmp0 (entry->id, id))
+        return;
+    if (entry)
+        id_index_unlink (idx, entry);
+    else
+    {
+        entry = g_new0 (IDIndexEntry, 1);
+        g_hash_table_insert (idx->entries, inst, entry);
+        g_object_weak_ref (G_OBJECT (inst), id_index_object_freed, idx);
+    }
+
+    queue = g_hash_table_lookup (idx->ids, id);
+    if (!queue)
+    {
+        queue = g_queue_new ();
+        g_hash_table_insert (idx->ids, g_strdup (id), queue);
+    }
+    g_queue_push_tail (queue, inst);
+    entry->id = g_strdup (id);
+    entry->link = queue->tail;
+}
+
+static void
+id_index_free (QofBook *book, gpointer key, gpointer user_data)
+{
+    IDIndex *idx = user_data;
+    GHashTableIter iter;
+    gpointer inst;
+
+    g_hash_table_iter_init (&iter, idx->entries);
+    while (g_hash_table_iter_next (&iter, &inst, NULL))
+        g_object_weak_unref (G_OBJECT (inst), id_index_object_freed, idx);
+    g_hash_table_destroy (idx->entries);
+    g_hash_table_destroy (idx->ids);
+    g_free (idx);
+    qof_book_set_data (book, key, NULL);
+}
+
+static IDIndex *
+id_index_get (QofBook *book, QofIdTypeConst type)
+{
+    const gchar *key = id_index_key (type);
+    IDIndex *idx = qof_book_get_data (book, key);
+
+    if (idx) return idx;
+
+    idx = g_new0 (IDIndex, 1);
+    idx->type = type;
+    idx->ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                      (GDestroyNotify) g_queue_free);
+    idx->entries = g_hash_table_new_full (NULL, NULL, NULL,
+                                          id_index_entry_free);
+    qof_collection_foreach (qof_book_get_collection (book, type),
+                            id_index_file, idx);
+    qof_book_set_data_fin (book, key, idx, id_index_free);
+    return idx;
+}
+
+void
+gnc_id_search_update (QofInstance *inst)
+{
+    const gchar *key;
+    IDIndex *idx;
+
+    if (!inst) return;
+    key = id_index_key (inst->e_type);
+    if (!key) return;
+    idx = qof_book_get_data (qof_instance_get_book (inst), key);
+    if (idx)
+        id_index_file (inst, idx);
+}
+
 /******************************************************************
  * Generic search called after setting up stuff
  * DO NOT call directly but type tests should fail anyway
  ****************************************************************/
 static void * search(QofBook * book, const gchar *id, void * object, GncSearchType type)
 {
-    void *c;
-    GList *result;
-    QofQuery *q;
-    gint len;
-    QofQueryPredData* string_pred_data;
-    
+    IDIndex *idx;
+    GQueue *queue;
+    GList *node;
+
     PINFO("Type = %d", type);
     g_return_val_if_fail (type, NULL);
     g_return_val_if_fail (id, NULL);
     g_return_val_if_fail (book, NULL);
 
-    // Build the query
-    q = qof_query_create ();
-    qof_query_set_book (q, book);
-    // Search only the id field
-    string_pred_data = qof_query_string_predicate (QOF_COMPARE_EQUAL, id, QOF_STRING_MATCH_NORMAL, FALSE);
     if (type == CUSTOMER)
-    {
-        qof_query_search_for(q,GNC_CUSTOMER_MODULE_NAME);
-        qof_query_add_term (q, qof_query_build_param_list("CUSTOMER_ID"), string_pred_data, QOF_QUERY_AND);
-    }
-    else if (type ==  INVOICE || type ==  BILL)
-    {
-        qof_query_search_for(q,GNC_INVOICE_MODULE_NAME);
-        qof_query_add_term (q, qof_query_build_param_list("INVOICE_ID"), string_pred_data, QOF_QUERY_AND);
-    }
+        idx = id_index_get (book, GNC_ID_CUSTOMER);
     else if (type == VENDOR)
-    {
-        qof_query_search_for(q,GNC_VENDOR_MODULE_NAME);
-        qof_query_add_term (q, qof_query_build_param_list("VENDOR_ID"), string_pred_data, QOF_QUERY_AND);
-    }
-
+        idx = id_index_get (book, GNC_ID_VENDOR);
+    else
+        idx = id_index_get (book, GNC_ID_INVOICE);
 
-    // Run the query
-    result = qof_query_run (q);
+    queue = g_hash_table_lookup (idx->ids, id);
+    if (!queue)
+        return object;
 
-    // now compare _exactly_
-    len = g_list_length (result);
-    if (result && (len > 0))
+    for (node = queue->head; node; node = node->next)
     {
-        result = g_list_first (result);
-
-        while (result)
-        {
-            c = result->data;
-            
-            if (type == CUSTOMER && strcmp(id, gncCustomerGetID(c)) == 0)
-            {
-                // correct id found
-                object = c;
-                break;
-            }
-            else if (type == INVOICE && strcmp(id, gncInvoiceGetID(c)) == 0 
-                        && gncInvoiceGetType(c) == GNC_INVOICE_CUST_INVOICE)
-            {
-                object = c;
-                break;
-            }
-            else if (type == BILL && strcmp(id, gncInvoiceGetID(c)) == 0 
-                        && gncInvoiceGetType(c) == GNC_INVOICE_VEND_INVOICE)
-            {
-                object = c;
-                break;
-            }
-            else if (type == VENDOR && strcmp(id, gncVendorGetID(c)) == 0)
-            {
-                object = c;
-                break;
-            }
-            result = g_list_next (result);
-        }
+        QofInstance *c = node->data;
+
+        if (qof_instance_get_destroying (c))
+            continue;
+        if (type == INVOICE
+                && gncInvoiceGetType (GNC_INVOICE (c)) != GNC_INVOICE_CUST_INVOICE)
+            continue;
+        if (type == BILL
+                && gncInvoiceGetType (GNC_INVOICE (c)) != GNC_INVOICE_VEND_INVOICE)
+            continue;
+        object = c;
+        break;
     }
-    qof_query_destroy (q);
     return object;
 }
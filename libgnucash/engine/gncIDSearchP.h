@@ -0,0 +1,32 @@
+/********************************************************************\
+ * gncIDSearchP.h -- keep the business object ID indexes current     *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+#ifndef GNC_IDSEARCHP_H_
+#define GNC_IDSEARCHP_H_
+
+#include "qof.h"
+
+/* Tell the ID index of the customer, vendor or invoice's book that
+ * the object's ID may have changed, or that it was just created. */
+void gnc_id_search_update (QofInstance *inst);
+
+#endif /* GNC_IDSEARCHP_H_ */
@@ -43,6 +43,7 @@
 #include "gncJobP.h"
 #include "gncInvoice.h"
 #include "gncInvoiceP.h"
+#include "gncIDSearchP.h"
 #include "gncOwnerP.h"
 #include "engine-helpers.h"
 
@@ -335,6 +336,7 @@ GncInvoice *gncInvoiceCreate (QofBook *book)
     invoice->doclink = (char*) is_unset;
 
     qof_event_gen (&invoice->inst, QOF_EVENT_CREATE, NULL);
+    gnc_id_search_update (&invoice->inst);
 
     return invoice;
 }
@@ -408,6 +410,7 @@ GncInvoice *gncInvoiceCopy (const GncInvoice *from)
     // copy isn't "posted" but needs to be posted by the user.
     mark_invoice (invoice);
     gncInvoiceCommitEdit (invoice);
+    gnc_id_search_update (&invoice->inst);
 
     return invoice;
 }
@@ -452,6 +455,7 @@ void gncInvoiceSetID (GncInvoice *invoice, const char *id)
     SET_STR (invoice, invoice->id, id);
     mark_invoice (invoice);
     gncInvoiceCommitEdit (invoice);
+    gnc_id_search_update (&invoice->inst);
 }
 
 void gncInvoiceSetOwner (GncInvoice *invoice, GncOwner *owner)
@@ -462,6 +466,7 @@ void gncInvoiceSetOwner (GncInvoice *invoice, GncOwner *owner)
     gncOwnerCopy (owner, &invoice->owner);
     mark_invoice (invoice);
     gncInvoiceCommitEdit (invoice);
+    gncOwnerLotIndexUpdate (invoice->posted_lot);
 }
 
 static void
@@ -475,6 +480,7 @@ qofInvoiceSetOwner (GncInvoice *invoice, QofInstance *ent)
     qofOwnerSetEntity (&invoice->owner, ent);
     mark_invoice (invoice);
     gncInvoiceCommitEdit (invoice);
+    gncOwnerLotIndexUpdate (invoice->posted_lot);
 }
 
 static void
@@ -1280,6 +1286,7 @@ gncInvoiceDetachFromLot (GNCLot *lot)
     qof_instance_set (QOF_INSTANCE (lot), "invoice", NULL, NULL);
     gnc_lot_commit_edit (lot);
     gnc_lot_set_cached_invoice (lot, NULL);
+    gncOwnerLotIndexUpdate (lot);
 }
 
 void
@@ -1296,6 +1303,7 @@ gncInvoiceAttachToLot (GncInvoice *invoice, GNCLot *lot)
     gnc_lot_commit_edit (lot);
     gnc_lot_set_cached_invoice (lot, invoice);
     gncInvoiceSetPostedLot (invoice, lot);
+    gncOwnerLotIndexUpdate (lot);
 }
 
 GncInvoice * gncInvoiceGetInvoiceFromLot (GNCLot *lot)
@@ -1953,7 +1961,7 @@ void gncInvoiceAutoApplyPayments (GncInvoice *invoice)
     GNCLot *inv_lot;
     Account *acct;
     const GncOwner *owner;
-    GList *lot_list;
+    GList *lot_list, *candidates, *node;
     struct lotmatch lm;
 
     /* General note: "paying" in this context means balancing
@@ -1979,8 +1987,13 @@ void gncInvoiceAutoApplyPayments (GncInvoice *invoice)
      * could be used. */
     lm.positive_balance =  gnc_numeric_positive_p (gnc_lot_get_balance (inv_lot));
     lm.owner = owner;
-    lot_list = xaccAccountFindOpenLots (acct, gnc_lot_match_owner_balancing,
-                                        &lm, NULL);
+    lot_list = NULL;
+    candidates = gncOwnerFindOpenLots (owner, acct, NULL);
+    for (node = candidates; node; node = node->next)
+        if (gnc_lot_match_owner_balancing (node->data, &lm))
+            lot_list = g_list_prepend (lot_list, node->data);
+    g_list_free (candidates);
+    lot_list = g_list_reverse (lot_list);
 
     lot_list = g_list_prepend (lot_list, inv_lot);
     gncOwnerAutoApplyPaymentsWithLots (owner, lot_list);
@@ -36,6 +36,7 @@
 #include <string.h>		/* for memcpy() */
 #include <qofinstance-p.h>
 
+#include "AccountP.h"
 #include "gncCustomerP.h"
 #include "gncEmployeeP.h"
 #include "gncJobP.h"
@@ -632,6 +633,7 @@ void gncOwnerAttachToLot (const GncOwner *owner, GNCLot *lot)
 		      GNC_OWNER_GUID, gncOwnerGetGUID (owner),
 		      NULL);
     gnc_lot_commit_edit (lot);
+    gncOwnerLotIndexUpdate (lot);
 }
 
 gboolean gncOwnerGetOwnerFromLot (GNCLot *lot, GncOwner *owner)
@@ -747,6 +749,240 @@ gncOwnerLotsSortFunc (GNCLot *lotA, GNCLot *lotB)
     return (da > db) - (da < db);
 }
 
+/* ============================================================== */
+/* The lots of each owner
+ *
+ * Kept as book data and built the first time it is needed, from the
+ * lots of all the accounts.  From then on, attaching a lot to an owner
+ * or an invoice, or giving a posted invoice another owner, refiles
+ * the lot, and freed lots drop out.  A lot is filed under the owner
+ * of its invoice, else the owner attached to it, which may be a job;
+ * so the lots of a customer or vendor are looked for under its jobs
+ * too.  What's found is checked with gncOwnerLotMatchOwnerFunc. */
+
+#define GNC_OWNER_LOT_INDEX "gncOwner-lot-index"
+
+typedef struct
+{
+    GHashTable *lots;       /* owner instance -> GQueue of its lots */
+    GHashTable *entries;    /* lot -> OwnerLotEntry */
+} OwnerLotIndex;
+
+typedef struct
+{
+    QofInstance *owner;
+    GList *link;            /* the lot in its owner's queue */
+} OwnerLotEntry;
+
+static QofInstance *
+lot_filing_owner (GNCLot *lot)
+{
+    GncInvoice *invoice = gncInvoiceGetInvoiceFromLot (lot);
+    GncOwner owner;
+
+    if (invoice)
+        return qofOwnerGetOwner (gncInvoiceGetOwner (invoice));
+    if (gncOwnerGetOwnerFromLot (lot, &owner))
+        return qofOwnerGetOwner (&owner);
+    return NULL;
+}
+
+static void
+owner_lot_index_unlink (OwnerLotIndex *idx, OwnerLotEntry *entry)
+{
+    GQueue *queue = g_hash_table_lookup (idx->lots, entry->owner);
+    g_queue_delete_link (queue, entry->link);
+}
+
+static void
+owner_lot_index_lot_freed (gpointer data, GObject *lot)
+{
+    OwnerLotIndex *idx = data;
+    OwnerLotEntry *entry = g_hash_table_lookup (idx->entries, lot);
+
+    if (!entry) return;
+    owner_lot_index_unlink (idx, entry);
+    g_hash_table_remove (idx->entries, lot);
+}
+
+static void
+owner_lot_index_file (OwnerLotIndex *idx, GNCLot *lot)
+{
+    QofInstance *owner = lot_filing_owner (lot);
+    OwnerLotEntry *entry = g_hash_table_lookup (idx->entries, lot);
+    GQueue *queue;
+
+    if (entry && entry->owner == owner)
+        return;
+    if (entry)
+        owner_lot_index_unlink (idx, entry);
+
+    if (!owner)
+    {
+        if (entry)
+        {
+            g_hash_table_remove (idx->entries, lot);
+            g_object_weak_unref (G_OBJECT (lot), owner_lot_index_lot_freed, idx);
+        }
+        return;
+    }
+    if (!entry)
+    {
+        entry = g_new0 (OwnerLotEntry, 1);
+        g_hash_table_insert (idx->entries, lot, entry);
+        g_object_weak_ref (G_OBJECT (lot), owner_lot_index_lot_freed, idx);
+    }
+
+    queue = g_hash_table_lookup (idx->lots, owner);
+    if (!queue)
+    {
+        queue = g_queue_new ();
+        g_hash_table_insert (idx->lots, owner, queue);
+    }
+    g_queue_push_tail (queue, lot);
+    entry->owner = owner;
+    entry->link = queue->tail;
+}
+
+static void
+owner_lot_index_free (QofBook *book, gpointer key, gpointer user_data)
+{
+    OwnerLotIndex *idx = user_data;
+    GHashTableIter iter;
+    gpointer lot;
+
+    g_hash_table_iter_init (&iter, idx->entries);
+    while (g_hash_table_iter_next (&iter, &lot, NULL))
+        g_object_weak_unref (G_OBJECT (lot), owner_lot_index_lot_freed, idx);
+    g_hash_table_destroy (idx->entries);
+    g_hash_table_destroy (idx->lots);
+    g_free (idx);
+    qof_book_set_data (book, GNC_OWNER_LOT_INDEX, NULL);
+}
+
+static void
+owner_lot_index_file_unaccounted (QofInstance *inst, gpointer user_data)
+{
+    GNCLot *lot = GNC_LOT (inst);
+    if (!gnc_lot_get_account (lot))
+        owner_lot_index_file (user_data, lot);
+}
+
+static OwnerLotIndex *
+owner_lot_index_get (QofBook *book)
+{
+    OwnerLotIndex *idx = qof_book_get_data (book, GNC_OWNER_LOT_INDEX);
+    GList *accounts, *node;
+
+    if (idx) return idx;
+
+    idx = g_new0 (OwnerLotIndex, 1);
+    idx->lots = g_hash_table_new_full (NULL, NULL, NULL,
+                                       (GDestroyNotify) g_queue_free);
+    idx->entries = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+
+    /* File each account's lots, then the lots that aren't in an
+     * account yet. */
+    accounts = gnc_account_get_descendants (gnc_book_get_root_account (book));
+    for (node = accounts; node; node = node->next)
+    {
+        LotList *lots = g_list_reverse (xaccAccountGetLotList (node->data));
+        LotList *lot_node;
+
+        for (lot_node = lots; lot_node; lot_node = lot_node->next)
+            owner_lot_index_file (idx, lot_node->data);
+        g_list_free (lots);
+    }
+    g_list_free (accounts);
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_LOT),
+                            owner_lot_index_file_unaccounted, idx);
+
+    qof_book_set_data_fin (book, GNC_OWNER_LOT_INDEX, idx,
+                           owner_lot_index_free);
+    return idx;
+}
+
+void
+gncOwnerLotIndexUpdate (GNCLot *lot)
+{
+    OwnerLotIndex *idx;
+
+    if (!lot) return;
+    idx = qof_book_get_data (gnc_lot_get_book (lot), GNC_OWNER_LOT_INDEX);
+    if (idx)
+        owner_lot_index_file (idx, lot);
+}
+
+static GList *
+owner_lot_index_add_open (GList *found, GQueue *queue, const GncOwner *owner,
+                          const Account *account)
+{
+    GList *node;
+
+    if (!queue) return found;
+    for (node = queue->head; node; node = node->next)
+    {
+        GNCLot *lot = node->data;
+        Account *lot_acc = gnc_lot_get_account (lot);
+
+        if (!lot_acc || (account && lot_acc != account))
+            continue;
+        if (gnc_lot_is_closed (lot) ||
+                !gncOwnerLotMatchOwnerFunc (lot, (gpointer) owner))
+            continue;
+        found = g_list_prepend (found, lot);
+    }
+    return found;
+}
+
+/* The order of xaccAccountFindOpenLots within an account; the lots of
+ * different accounts are kept apart. */
+static gint
+owner_lot_account_order (gconstpointer a, gconstpointer b)
+{
+    GNCLot *lot_a = (GNCLot*) a, *lot_b = (GNCLot*) b;
+    Account *acc_a = gnc_lot_get_account (lot_a);
+    Account *acc_b = gnc_lot_get_account (lot_b);
+
+    if (acc_a != acc_b)
+        return xaccAccountOrder (acc_a, acc_b);
+    return gnc_account_lot_order (acc_a, lot_a, lot_b);
+}
+
+LotList *
+gncOwnerFindOpenLots (const GncOwner *owner, const Account *account,
+                      GCompareFunc sort_func)
+{
+    OwnerLotIndex *idx;
+    QofInstance *inst;
+    GList *jobs = NULL, *node;
+    LotList *found;
+
+    if (!gncOwnerIsValid (owner)) return NULL;
+    inst = qofOwnerGetOwner (owner);
+    idx = owner_lot_index_get (qof_instance_get_book (inst));
+
+    found = owner_lot_index_add_open (NULL, g_hash_table_lookup (idx->lots, inst),
+                                      owner, account);
+    if (owner->type == GNC_OWNER_CUSTOMER)
+        jobs = gncCustomerGetJoblist (owner->owner.customer, TRUE);
+    else if (owner->type == GNC_OWNER_VENDOR)
+        jobs = gncVendorGetJoblist (owner->owner.vendor, TRUE);
+    for (node = jobs; node; node = node->next)
+        found = owner_lot_index_add_open (found,
+                                          g_hash_table_lookup (idx->lots, node->data),
+                                          owner, account);
+    g_list_free (jobs);
+
+    /* The owner's own lots, then each job's, come out of the index in
+     * the order they were filed; put them back in account order, in
+     * which payments have always been applied. */
+    found = g_list_sort (found, owner_lot_account_order);
+    if (sort_func)
+        found = g_list_sort (found, sort_func);
+    return found;
+}
+
 GNCLot *
 gncOwnerCreatePaymentLotSecs (const GncOwner *owner, Transaction **preset_txn,
                               Account *posted_acc, Account *xfer_acc,
@@ -1428,8 +1664,7 @@ gncOwnerApplyPaymentSecs (const GncOwner *owner, Transaction **preset_txn,
     if (lots)
         selected_lots = lots;
     else if (auto_pay)
-        selected_lots = xaccAccountFindOpenLots (posted_acc, gncOwnerLotMatchOwnerFunc,
-                        (gpointer)owner, NULL);
+        selected_lots = gncOwnerFindOpenLots (owner, posted_acc, NULL);
 
     /* And link the selected lots and the payment lot together as well as possible.
      * If the payment was bigger than the selected documents/overpayments, only
@@ -1496,41 +1731,33 @@ gncOwnerGetBalanceInCurrency (const GncOwner *owner,
     else
     {
         /* No valid cache value found for balance. Let's recalculate */
-        GList *acct_list  = gnc_account_get_descendants (gnc_book_get_root_account (book));
         GList *acct_types = gncOwnerGetAccountTypesList (owner);
-        GList *acct_node;
+        GList *lot_list = gncOwnerFindOpenLots (owner, NULL, NULL);
+        GList *lot_node;
 
-        /* For each account */
-        for (acct_node = acct_list; acct_node; acct_node = acct_node->next)
+        /* For each open lot of the owner */
+        for (lot_node = lot_list; lot_node; lot_node = lot_node->next)
         {
-            Account *account = acct_node->data;
-            GList *lot_list = NULL, *lot_node;
+            GNCLot *lot = lot_node->data;
+            Account *account = gnc_lot_get_account (lot);
+            gnc_numeric lot_balance;
+            GncInvoice *invoice;
 
-            /* Check if this account can have lots for the owner, otherwise skip to next */
+            /* Check if the lot's account can have lots for the owner, otherwise skip to next */
             if (g_list_index (acct_types, (gpointer)xaccAccountGetType (account))
                     == -1)
                 continue;
 
-
             if (!gnc_commodity_equal (owner_currency, xaccAccountGetCommodity (account)))
                 continue;
 
-            /* Get a list of open lots for this owner and account */
-            lot_list = xaccAccountFindOpenLots (account, gncOwnerLotMatchOwnerFunc,
-                                                (gpointer)owner, NULL);
-            /* For each lot */
-            for (lot_node = lot_list; lot_node; lot_node = lot_node->next)
-            {
-                GNCLot *lot = lot_node->data;
-                gnc_numeric lot_balance = gnc_lot_get_balance (lot);
-                GncInvoice *invoice = gncInvoiceGetInvoiceFromLot(lot);
-                if (invoice)
+            lot_balance = gnc_lot_get_balance (lot);
+            invoice = gncInvoiceGetInvoiceFromLot(lot);
+            if (invoice)
                 balance = gnc_numeric_add (balance, lot_balance,
-                                            gnc_commodity_get_fraction (owner_currency), GNC_HOW_RND_ROUND_HALF_UP);
-            }
-            g_list_free (lot_list);
+                                           gnc_commodity_get_fraction (owner_currency), GNC_HOW_RND_ROUND_HALF_UP);
         }
-        g_list_free (acct_list);
+        g_list_free (lot_list);
         g_list_free (acct_types);
 
         gncOwnerSetCachedBalance (owner, &balance);
@@ -192,6 +192,17 @@ gboolean gncOwnerLotMatchOwnerFunc (GNCLot *lot, gpointer user_data);
  */
 gint gncOwnerLotsSortFunc (GNCLot *lotA, GNCLot *lotB);
 
+/** Find the open lots of the owner, in the given account or, if
+ * account is NULL, in any account.  Returns the same lots as
+ * xaccAccountFindOpenLots with gncOwnerLotMatchOwnerFunc, but looks
+ * only at the owner's own lots and those of its jobs, so it doesn't
+ * slow down with the number of other owners.  The lots come in the
+ * same order, account by account, unless sorted with sort_func.  The
+ * caller must free the list.
+ */
+LotList * gncOwnerFindOpenLots (const GncOwner *owner, const Account *account,
+                                GCompareFunc sort_func);
+
 /** Get the owner from the lot.  If an owner is found in the lot,
  * fill in "owner" and return TRUE.  Otherwise return FALSE.
  */
@@ -33,6 +33,9 @@
 gboolean gncOwnerRegister (void);
 const gnc_numeric *gncOwnerGetCachedBalance (const GncOwner *owner);
 void gncOwnerSetCachedBalance (const GncOwner *owner, const gnc_numeric *new_bal);
+/* Tell the owner lots index that the owner or invoice the lot is
+ * attached to may have changed. */
+void gncOwnerLotIndexUpdate (GNCLot *lot);
 
 
 #endif /* GNC_OWNERP_H_ */
@@ -36,6 +36,7 @@
 #include "gncAddressP.h"
 #include "gncBillTermP.h"
 #include "gncInvoice.h"
+#include "gncIDSearchP.h"
 #include "gncJobP.h"
 #include "gncTaxTableP.h"
 #include "gncVendor.h"
@@ -474,6 +475,7 @@ GncVendor *gncVendorCreate (QofBook *book)
         vend_qof_event_handler_id = qof_event_register_handler (vend_handle_qof_events, NULL);
 
     qof_event_gen (&vendor->inst, QOF_EVENT_CREATE, NULL);
+    gnc_id_search_update (&vendor->inst);
 
     return vendor;
 }
@@ -524,6 +526,7 @@ void gncVendorSetID (GncVendor *vendor, const char *id)
     SET_STR(vendor, vendor->id, id);
     mark_vendor (vendor);
     gncVendorCommitEdit (vendor);
+    gnc_id_search_update (&vendor->inst);
 }
 
 void gncVendorSetName (GncVendor *vendor, const char *name)
@@ -716,6 +719,27 @@ GncTaxTable* gncVendorGetTaxTable (const GncVendor *vendor)
     return vendor->taxtable;
 }
 
+GList * gncVendorGetJoblist (const GncVendor *vendor, gboolean show_all)
+{
+    if (!vendor) return NULL;
+
+    if (show_all)
+    {
+        return (g_list_copy (vendor->jobs));
+    }
+    else
+    {
+        GList *list = NULL, *iterator;
+        for (iterator = vendor->jobs; iterator; iterator = iterator->next)
+        {
+            GncJob *j = iterator->data;
+            if (gncJobGetActive (j))
+                list = g_list_prepend (list, j);
+        }
+        return g_list_reverse (list);
+    }
+}
+
 static const char*
 qofVendorGetTaxIncluded(const GncVendor *vendor)
 {
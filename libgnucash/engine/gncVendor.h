@@ -102,6 +102,7 @@ GncTaxTable* gncVendorGetTaxTable (const GncVendor *vendor);
 /** XXX should be renamed to RetJobList to be consistent with
  * other usage, since caller must free the copied list
  */
+GList * gncVendorGetJoblist (const GncVendor *vendor, gboolean show_all);
 
 int gncVendorCompare (const GncVendor *a, const GncVendor *b);
 
@@ -108,17 +108,12 @@ using KvpEntry = std::pair <std::vector <std::string>, KvpValue*>;
  */
 struct KvpFrameImpl
 {
-    class cstring_comparer
-    {
-    public:
-	/* Returns true if one is less than two. */
-	bool operator()(const char * one, const char * two) const
-	    {
-		auto ret = std::strcmp(one, two) < 0;
-		return ret;
-	    }
-    };
-    using map_type = std::map<const char *, KvpValue*, cstring_comparer>;
+    /* The slots are kept in a vector sorted by key: a frame usually
+     * holds only a handful of them, which a binary search over
+     * contiguous memory finds faster than a tree walk, without a node
+     * allocation per slot.  The keys are interned in the string cache,
+     * so a key taken from another frame is matched by its address. */
+    using map_type = std::vector<std::pair<const char *, KvpValue*>>;
 
     public:
     KvpFrameImpl() noexcept {};
@@ -229,6 +224,8 @@ struct KvpFrameImpl
     private:
     map_type m_valuemap;
 
+    map_type::iterator find (const char *) noexcept;
+    map_type::const_iterator find (const char *) const noexcept;
     KvpFrame * get_child_frame_or_nullptr (Path const &) noexcept;
     KvpFrame * get_child_frame_or_create (Path const &) noexcept;
     void flatten_kvp_impl(std::vector <std::string>, std::vector <KvpEntry> &) const noexcept;
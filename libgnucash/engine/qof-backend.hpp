@@ -225,6 +225,17 @@ public:
  *    Revert changes in the engine and unlock the backend.
  */
     virtual void rollback(QofInstance*) {}
+/**
+ *    Called before a query searches a book, so that a backend which loaded
+ *    only part of the book can load the objects the query might match.
+ */
+    virtual void run_query(QofQuery*) {}
+/**
+ *    Called before the engine reads the splits of an instance, so that a
+ *    backend which loaded only part of the book can load those posted on or
+ *    after since. INT64_MIN asks for all of them.
+ */
+    virtual void ensure_loaded(QofInstance*, time64 since) {}
 /**
  *    Synchronizes the engine contents to the backend.
  *    This should done by using version numbers (hack alert -- the engine
@@ -63,6 +63,21 @@ gboolean qof_query_term_is_inverted (const QofQueryTerm *queryterm);
 /* This function returns the primary, secondary, and tertiary sorts.
  * These are part of the query and should NOT be changed!
  */
+/** An index function enumerates, from an index its module keeps, the
+ * objects of a book that may satisfy all of the and_terms (a list of
+ * QofQueryTerm); the query still checks every object it is handed, so
+ * a superset is fine, but every object the scan would match must be
+ * among them.  It returns FALSE, without calling cb, when no
+ * term lets it narrow the search, and the book is then scanned. */
+typedef gboolean (*QofQueryIndexFunc) (QofBook *book, const GList *and_terms,
+                                       QofInstanceForeachCB cb,
+                                       gpointer user_data);
+
+/** Register the index function used to run queries searching for
+ * obj_type.  Only one may be registered per type. */
+void qof_query_register_index (QofIdTypeConst obj_type,
+                               QofQueryIndexFunc index_fcn);
+
 void qof_query_get_sorts (QofQuery *q, QofQuerySort **primary,
                           QofQuerySort **secondary, QofQuerySort **tertiary);
 
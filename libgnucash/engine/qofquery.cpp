@@ -39,8 +39,14 @@ extern "C"
 #include "qofquery-p.h"
 #include "qofquerycore-p.h"
 
+#include <algorithm>
+#include <vector>
+
 static QofLogModule log_module = QOF_MOD_QUERY;
 
+/* QofIdType -> QofQueryIndexFunc */
+static GHashTable *query_indexes = NULL;
+
 struct _QofQueryTerm
 {
     QofQueryParamList *     param_list;
@@ -106,11 +112,28 @@ struct _QofQuery
     GList *           results;
 };
 
+/* A match kept for a query limited to max_results; seq orders the
+ * matches that sort equal by the order they were found in. */
+struct QofQueryMatch
+{
+    gpointer          object;
+    gint              seq;
+};
+
 typedef struct _QofQueryCB
 {
     QofQuery *        query;
     GList *           list;
     gint              count;
+
+    /* With max_results set, only the matches that will be returned
+     * are kept, in a heap whose top is the first one to go. */
+    std::vector<QofQueryMatch> top;
+
+    /* Set when matches are handed straight to the caller */
+    QofQueryResultCB  result_cb;
+    gpointer          result_data;
+    gboolean          stopped;
 } QofQueryCB;
 
 /* initial_term will be owned by the new Query */
@@ -356,6 +379,54 @@ sort_func (const gconstpointer a, const gconstpointer b, const gpointer q)
     }
 }
 
+static gboolean
+query_is_sorted (const QofQuery *q)
+{
+    return q->primary_sort.comp_fcn || q->primary_sort.obj_cmp ||
+           (q->primary_sort.use_default && q->defaultSort);
+}
+
+/* Whether match a comes after b in the results: the results are the
+ * last max_results of the sorted matches, the stable sort leaving the
+ * ones that sort equal in the order they were found. */
+static bool
+query_match_after (QofQuery *q, const QofQueryMatch& a, const QofQueryMatch& b)
+{
+    if (query_is_sorted (q))
+    {
+        int retval = sort_func (a.object, b.object, q);
+        if (retval)
+            return retval > 0;
+    }
+    return a.seq > b.seq;
+}
+
+/* Keep object if it is among the max_results last matches so far. */
+static void
+query_keep_top (QofQueryCB* ql, gpointer object)
+{
+    QofQuery* q = ql->query;
+    QofQueryMatch match {object, ql->count};
+    auto after = [q](const QofQueryMatch& a, const QofQueryMatch& b)
+    {
+        return query_match_after (q, a, b);
+    };
+
+    if (q->max_results == 0)
+        return;
+    if (ql->top.size () < static_cast<size_t>(q->max_results))
+    {
+        ql->top.push_back (match);
+        std::push_heap (ql->top.begin (), ql->top.end (), after);
+    }
+    else if (after (match, ql->top.front ()))
+    {
+        std::pop_heap (ql->top.begin (), ql->top.end (), after);
+        ql->top.back () = match;
+        std::push_heap (ql->top.begin (), ql->top.end (), after);
+    }
+}
+
 /* ==================================================================== */
 /* This is the main workhorse for performing the query.  For each
  * object, it walks over all of the query terms to see if the
@@ -573,9 +644,19 @@ static void check_item_cb (gpointer object, gpointer user_data)
 
     if (!object || !ql) return;
 
+    if (ql->stopped) return;
+
     if (check_object (ql->query, object))
     {
-        ql->list = g_list_prepend (ql->list, object);
+        if (ql->result_cb)
+        {
+            if (!ql->result_cb (object, ql->result_data))
+                ql->stopped = TRUE;
+        }
+        else if (ql->query->max_results > -1)
+            query_keep_top (ql, object);
+        else
+            ql->list = g_list_prepend (ql->list, object);
         ql->count++;
     }
     return;
@@ -723,19 +804,12 @@ void qof_query_purge_terms (QofQuery *q, QofQueryParamList *param_list)
     }
 }
 
-static GList * qof_query_run_internal (QofQuery *q,
-                                       void(*run_cb)(QofQueryCB*, gpointer),
-                                       gpointer cb_arg)
+/* Compile the query if needed and run it, collecting the matches in
+ * qcb or handing them to its result_cb. */
+static void query_collect (QofQuery *q, QofQueryCB *qcb,
+                           void(*run_cb)(QofQueryCB*, gpointer),
+                           gpointer cb_arg)
 {
-    GList *matching_objects = NULL;
-    int        object_count = 0;
-
-    if (!q) return NULL;
-    g_return_val_if_fail (q->search_for, NULL);
-    g_return_val_if_fail (q->books, NULL);
-    g_return_val_if_fail (run_cb, NULL);
-    ENTER (" q=%p", q);
-
     /* XXX: Prioritize the query terms? */
 
     /* prepare the Query for processing */
@@ -743,6 +817,7 @@ static GList * qof_query_run_internal (QofQuery *q,
     {
         query_clear_compiles (q);
         compile_terms (q);
+        q->changed = 0;
     }
 
     /* Maybe log this sucker */
@@ -750,19 +825,30 @@ static GList * qof_query_run_internal (QofQuery *q,
         qof_query_print (q);
 
     /* Now run the query over all the objects and save the results */
-    {
-        QofQueryCB qcb;
-
-        memset (&qcb, 0, sizeof (qcb));
-        qcb.query = q;
+    qcb->query = q;
+    run_cb (qcb, cb_arg);
+    PINFO ("matching objects=%p count=%d", qcb->list, qcb->count);
+}
 
-        /* Run the query callback */
-        run_cb(&qcb, cb_arg);
+/* Return the collected matches, sorted and cropped to max_results. */
+static GList * query_collected_list (QofQueryCB *qcb)
+{
+    QofQuery *q = qcb->query;
+    GList *matching_objects = NULL;
 
-        matching_objects = qcb.list;
-        object_count = qcb.count;
+    /* Only the matches to return were kept, so there's no need to sort
+     * all of them and throw most away. */
+    if (q->max_results > -1)
+    {
+        std::sort (qcb->top.begin (), qcb->top.end (),
+                   [q](const QofQueryMatch& a, const QofQueryMatch& b)
+                   {
+                       return query_match_after (q, b, a);
+                   });
+        for (auto it = qcb->top.rbegin (); it != qcb->top.rend (); ++it)
+            matching_objects = g_list_prepend (matching_objects, it->object);
+        return matching_objects;
     }
-    PINFO ("matching objects=%p count=%d", matching_objects, object_count);
 
     /* There is no absolute need to reverse this list, since it's being
      * sorted below. However, in the common case, we will be searching
@@ -770,43 +856,35 @@ static GList * qof_query_run_internal (QofQuery *q,
      * thus reversing will put us in the correct order we want and make
      * the sorting go much faster.
      */
-    matching_objects = g_list_reverse(matching_objects);
+    matching_objects = g_list_reverse (qcb->list);
+    qcb->list = NULL;
 
     /* Now sort the matching objects based on the search criteria */
-    if (q->primary_sort.comp_fcn || q->primary_sort.obj_cmp ||
-            (q->primary_sort.use_default && q->defaultSort))
-    {
-        matching_objects = g_list_sort_with_data(matching_objects, sort_func, q);
-    }
+    if (query_is_sorted (q))
+        matching_objects = g_list_sort_with_data (matching_objects, sort_func, q);
+
+    return matching_objects;
+}
+
+static GList * qof_query_run_internal (QofQuery *q,
+                                       void(*run_cb)(QofQueryCB*, gpointer),
+                                       gpointer cb_arg)
+{
+    GList *matching_objects = NULL;
+
+    if (!q) return NULL;
+    g_return_val_if_fail (q->search_for, NULL);
+    g_return_val_if_fail (q->books, NULL);
+    g_return_val_if_fail (run_cb, NULL);
+    ENTER (" q=%p", q);
 
-    /* Crop the list to limit the number of splits. */
-    if ((object_count > q->max_results) && (q->max_results > -1))
     {
-        if (q->max_results > 0)
-        {
-            GList *mptr;
+        QofQueryCB qcb {};
 
-            /* mptr is set to the first node of what will be the new list */
-            mptr = g_list_nth(matching_objects, object_count - q->max_results);
-            /* mptr should not be NULL, but let's be safe */
-            if (mptr != NULL)
-            {
-                if (mptr->prev != NULL) mptr->prev->next = NULL;
-                mptr->prev = NULL;
-            }
-            g_list_free(matching_objects);
-            matching_objects = mptr;
-        }
-        else
-        {
-            /* q->max_results == 0 */
-            g_list_free(matching_objects);
-            matching_objects = NULL;
-        }
+        query_collect (q, &qcb, run_cb, cb_arg);
+        matching_objects = query_collected_list (&qcb);
     }
 
-    q->changed = 0;
-
     g_list_free(q->results);
     q->results = matching_objects;
 
@@ -814,6 +892,62 @@ static GList * qof_query_run_internal (QofQuery *q,
     return matching_objects;
 }
 
+static void check_candidate_cb (QofInstance* object, gpointer user_data)
+{
+    GPtrArray* candidates = static_cast<GPtrArray*>(user_data);
+    g_ptr_array_add (candidates, object);
+}
+
+/* Ask the index of the searched-for type for the candidates of each
+ * of the OR-terms; if any of them can't be narrowed down the whole
+ * book must be scanned anyway.  An object matching several OR-terms
+ * is only checked once. */
+static gboolean
+query_run_indexed (QofQueryCB* qcb, QofBook* book)
+{
+    QofQuery* q = qcb->query;
+    QofQueryIndexFunc index_fcn;
+    GPtrArray* candidates;
+    GList* or_ptr;
+
+    if (!query_indexes || !q->terms)
+        return FALSE;
+    index_fcn = reinterpret_cast<QofQueryIndexFunc>(
+        g_hash_table_lookup (query_indexes, q->search_for));
+    if (!index_fcn)
+        return FALSE;
+
+    candidates = g_ptr_array_new ();
+    for (or_ptr = q->terms; or_ptr; or_ptr = or_ptr->next)
+    {
+        if (!index_fcn (book, static_cast<GList*>(or_ptr->data),
+                        check_candidate_cb, candidates))
+        {
+            g_ptr_array_free (candidates, TRUE);
+            return FALSE;
+        }
+    }
+
+    if (q->terms->next)
+    {
+        GHashTable* seen = g_hash_table_new (g_direct_hash, g_direct_equal);
+        for (guint i = 0; i < candidates->len; i++)
+        {
+            gpointer object = g_ptr_array_index (candidates, i);
+            if (g_hash_table_add (seen, object))
+                check_item_cb (object, qcb);
+        }
+        g_hash_table_destroy (seen);
+    }
+    else
+    {
+        g_ptr_array_foreach (candidates, check_item_cb, qcb);
+    }
+    PINFO ("checked %u indexed candidates", candidates->len);
+    g_ptr_array_free (candidates, TRUE);
+    return TRUE;
+}
+
 static void qof_query_run_cb(QofQueryCB* qcb, gpointer cb_arg)
 {
     GList *node;
@@ -839,6 +973,14 @@ static void qof_query_run_cb(QofQueryCB* qcb, gpointer cb_arg)
             }
         }
 #endif
+        auto qof_be = qof_book_get_backend (book);
+        if (qof_be)
+            qof_be->run_query (qcb->query);
+
+        /* Only look at the objects an index can't rule out */
+        if (query_run_indexed (qcb, book))
+            continue;
+
         /* And then iterate over all the objects */
         qof_object_foreach (qcb->query->search_for, book,
                             (QofInstanceForeachCB) check_item_cb, qcb);
@@ -851,6 +993,44 @@ GList * qof_query_run (QofQuery *q)
     return qof_query_run_internal(q, qof_query_run_cb, NULL);
 }
 
+void qof_query_run_foreach (QofQuery *q, QofQueryResultCB cb,
+                            gpointer user_data)
+{
+    QofQueryCB qcb {};
+    GList *matching_objects, *node;
+
+    if (!q) return;
+    g_return_if_fail (q->search_for);
+    g_return_if_fail (q->books);
+    g_return_if_fail (cb);
+    ENTER (" q=%p", q);
+
+    /* Without a sort or a limit the matches are returned in the order
+     * they are found, so they can go to the caller as they are. */
+    if (q->changed)
+    {
+        query_clear_compiles (q);
+        compile_terms (q);
+        q->changed = 0;
+    }
+    if (!query_is_sorted (q) && q->max_results < 0)
+    {
+        qcb.result_cb = cb;
+        qcb.result_data = user_data;
+        query_collect (q, &qcb, qof_query_run_cb, NULL);
+        LEAVE (" q=%p streamed %d", q, qcb.count);
+        return;
+    }
+
+    query_collect (q, &qcb, qof_query_run_cb, NULL);
+    matching_objects = query_collected_list (&qcb);
+    for (node = matching_objects; node; node = node->next)
+        if (!cb (node->data, user_data))
+            break;
+    g_list_free (matching_objects);
+    LEAVE (" q=%p", q);
+}
+
 static void qof_query_run_subq_cb(QofQueryCB* qcb, gpointer cb_arg)
 {
     QofQuery* pq = static_cast<QofQuery*>(cb_arg);
@@ -1349,10 +1529,29 @@ void qof_query_init (void)
 
 void qof_query_shutdown (void)
 {
+    if (query_indexes)
+    {
+        g_hash_table_destroy (query_indexes);
+        query_indexes = NULL;
+    }
     qof_class_shutdown ();
     qof_query_core_shutdown ();
 }
 
+void qof_query_register_index (QofIdTypeConst obj_type,
+                               QofQueryIndexFunc index_fcn)
+{
+    g_return_if_fail (obj_type);
+    g_return_if_fail (index_fcn);
+
+    /* Object types register before the query subsystem may have been
+     * initialized, so the table is created on first use. */
+    if (!query_indexes)
+        query_indexes = g_hash_table_new (g_str_hash, g_str_equal);
+    g_hash_table_insert (query_indexes, (gpointer)obj_type,
+                         reinterpret_cast<gpointer>(index_fcn));
+}
+
 int qof_query_get_max_results (const QofQuery *q)
 {
     if (!q) return 0;
@@ -221,6 +221,20 @@ void qof_query_add_boolean_match (QofQuery *q,
  */
 GList * qof_query_run (QofQuery *query);
 
+/** Called by qof_query_run_foreach() with each result in turn; return
+ *  FALSE to stop before the rest of the results.
+ */
+typedef gboolean (*QofQueryResultCB) (gpointer object, gpointer user_data);
+
+/** Perform the query, passing the results to cb in the order
+ *  qof_query_run() would return them.  A query without sort order
+ *  or max_results hands each result to cb as soon as it is found,
+ *  without building a list of them.  The results are not saved for
+ *  qof_query_last_run().
+ */
+void qof_query_run_foreach (QofQuery *query, QofQueryResultCB cb,
+                            gpointer user_data);
+
 /** Return the results of the last query, without causing the query to
  *  be re-run.  Do NOT free the resulting list.  This list is managed
  *  internally by QofQuery.
@@ -31,6 +31,7 @@
 
 #include "cashobjects.h"
 #include "gncCustomerP.h"
+#include "gncIDSearch.h"
 #include "gncInvoiceP.h"
 #include "gncJobP.h"
 #include "test-stuff.h"
@@ -132,6 +133,35 @@ test_customer (void)
         do_test (gncCustomerLookup (book, guid) == customer, "Entity Table");
     }
 
+    /* Test the ID search */
+    {
+        GncCustomer *other;
+
+        gncCustomerSetID (customer, "ID-search");
+        do_test (gnc_search_customer_on_id (book, "ID-search") == customer,
+                 "search on id");
+        do_test (gnc_search_customer_on_id (book, "ID-none") == NULL,
+                 "search on unknown id");
+
+        gncCustomerSetID (customer, "ID-changed");
+        do_test (gnc_search_customer_on_id (book, "ID-search") == NULL,
+                 "search on old id");
+        do_test (gnc_search_customer_on_id (book, "ID-changed") == customer,
+                 "search on changed id");
+
+        other = gncCustomerCreate (book);
+        gncCustomerSetID (other, "ID-other");
+        do_test (gnc_search_customer_on_id (book, "ID-other") == other,
+                 "search on new customer's id");
+        do_test (gnc_search_vendor_on_id (book, "ID-other") == NULL,
+                 "search on customer id for a vendor");
+
+        gncCustomerBeginEdit (other);
+        gncCustomerDestroy (other);
+        do_test (gnc_search_customer_on_id (book, "ID-other") == NULL,
+                 "search on destroyed customer's id");
+    }
+
     /* Note: JobList is tested from the Job tests */
     qof_book_destroy (book);
 }
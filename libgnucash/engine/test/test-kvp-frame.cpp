@@ -189,6 +189,30 @@ TEST_F (KvpFrameTest, Empty)
     EXPECT_FALSE(f2.empty());
 }
 
+TEST (KvpFrameTestSlots, ordered_by_key)
+{
+    KvpFrameImpl f1;
+    for (auto key : {"delta", "alpha", "charlie", "bravo"})
+        EXPECT_EQ (nullptr, f1.set ({key}, new KvpValue {INT64_C(1)}));
+    EXPECT_EQ (f1.get_keys (), (std::vector<std::string> {"alpha", "bravo", "charlie", "delta"}));
+
+    auto v1 = new KvpValue {INT64_C(2)};
+    auto old = f1.set ({"charlie"}, v1);
+    EXPECT_NE (nullptr, old);
+    delete old;
+    EXPECT_EQ (v1, f1.get_slot ({"charlie"}));
+    EXPECT_EQ (4ul, f1.get_keys ().size ());
+
+    old = f1.set ({"alpha"}, nullptr);
+    delete old;
+    EXPECT_EQ (nullptr, f1.get_slot ({"alpha"}));
+    EXPECT_EQ (f1.get_keys (), (std::vector<std::string> {"bravo", "charlie", "delta"}));
+
+    KvpFrameImpl f2 {f1};
+    EXPECT_EQ (0, compare (f1, f2));
+    EXPECT_EQ (f2.get_keys (), f1.get_keys ());
+}
+
 TEST (KvpFrameTestForEachPrefix, for_each_prefix_1)
 {
     KvpFrame fr;
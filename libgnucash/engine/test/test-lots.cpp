@@ -34,10 +34,12 @@ extern "C"
 #include "Account.h"
 #include "gnc-lot.h"
 #include "Scrub3.h"
+#include "cap-gains.h"
 #include "cashobjects.h"
 #include "test-stuff.h"
 #include "test-engine-stuff.h"
 #include "Transaction.h"
+#include "gnc-commodity.h"
 }
 
 static gint transaction_num = 32;
@@ -85,6 +87,286 @@ test_lot_kvp ()
     qof_session_end (sess);
 }
 
+/* Add a trade of amount of acct's commodity for value of cash's. With
+ * trading accounts for each commodity it's balanced through them. */
+static Split*
+add_lot_split (GNCLot *lot, Account *acct, Account *cash, time64 date,
+               gint64 amount, gint64 value, Account *stock_trading = nullptr,
+               Account *cash_trading = nullptr)
+{
+    QofBook *book = gnc_account_get_book (acct);
+    Transaction *trans = xaccMallocTransaction (book);
+    Split *split = xaccMallocSplit (book);
+    Split *other = xaccMallocSplit (book);
+
+    xaccTransBeginEdit (trans);
+    xaccTransSetCurrency (trans, xaccAccountGetCommodity (cash));
+    xaccTransSetDatePostedSecs (trans, date);
+    xaccSplitSetParent (split, trans);
+    xaccSplitSetAccount (split, acct);
+    xaccSplitSetAmount (split, gnc_numeric_create (amount, 1));
+    xaccSplitSetValue (split, gnc_numeric_create (value, 1));
+    xaccSplitSetParent (other, trans);
+    xaccSplitSetAccount (other, cash);
+    xaccSplitSetAmount (other, gnc_numeric_create (-value, 1));
+    xaccSplitSetValue (other, gnc_numeric_create (-value, 1));
+    if (stock_trading && cash_trading)
+    {
+        Split *stock_tr = xaccMallocSplit (book);
+        Split *cash_tr = xaccMallocSplit (book);
+
+        xaccSplitSetParent (stock_tr, trans);
+        xaccSplitSetAccount (stock_tr, stock_trading);
+        xaccSplitSetAmount (stock_tr, gnc_numeric_create (-amount, 1));
+        xaccSplitSetValue (stock_tr, gnc_numeric_create (-value, 1));
+        xaccSplitSetParent (cash_tr, trans);
+        xaccSplitSetAccount (cash_tr, cash_trading);
+        xaccSplitSetAmount (cash_tr, gnc_numeric_create (value, 1));
+        xaccSplitSetValue (cash_tr, gnc_numeric_create (value, 1));
+    }
+    xaccTransCommitEdit (trans);
+
+    gnc_lot_add_split (lot, split);
+    return split;
+}
+
+/* Compare gnc_lot_get_balance_before with adding up the lot's splits. */
+static void
+check_balance_before (GNCLot *lot)
+{
+    for (GList *node = gnc_lot_get_split_list (lot); node; node = node->next)
+    {
+        auto split = static_cast<Split*>(node->data);
+        auto tb = xaccSplitGetParent (split);
+        auto amt = gnc_numeric_zero (), val = gnc_numeric_zero ();
+        gnc_numeric lot_amt, lot_val;
+
+        for (GList *n = gnc_lot_get_split_list (lot); n; n = n->next)
+        {
+            auto s = static_cast<Split*>(n->data);
+            auto ta = xaccSplitGetParent (s);
+            if ((ta == tb && s != split) || xaccTransOrder (ta, tb) < 0)
+            {
+                amt = gnc_numeric_add_fixed (amt, xaccSplitGetAmount (s));
+                val = gnc_numeric_add_fixed (val, xaccSplitGetValue (s));
+            }
+        }
+        gnc_lot_get_balance_before (lot, split, &lot_amt, &lot_val);
+        g_assert (gnc_numeric_equal (amt, lot_amt));
+        g_assert (gnc_numeric_equal (val, lot_val));
+    }
+}
+
+static void
+test_lot_split_order ()
+{
+    QofSession *sess = get_random_session ();
+    QofBook *book = qof_session_get_book (sess);
+    gnc_commodity *stock = gnc_commodity_new (book, "Stock", "NASDAQ", "STK",
+                                              "", 1);
+    gnc_commodity *usd = gnc_commodity_new (book, "Dollar",
+                                            GNC_COMMODITY_NS_CURRENCY, "USD",
+                                            "", 100);
+    Account *acct = xaccMallocAccount (book);
+    Account *cash = xaccMallocAccount (book);
+    GNCLot *lot = gnc_lot_new (book);
+    const time64 day = 86400, base = 1500000000;
+    Split *s1, *s2, *s3, *s4;
+
+    xaccAccountSetCommodity (acct, stock);
+    xaccAccountSetCommodity (cash, usd);
+
+    s1 = add_lot_split (lot, acct, cash, base, 100, 1000);
+    s2 = add_lot_split (lot, acct, cash, base + 2 * day, -30, -300);
+    s3 = add_lot_split (lot, acct, cash, base + day, 50, 500);
+    s4 = add_lot_split (lot, acct, cash, base + 2 * day, -20, -200);
+    g_assert (gnc_numeric_equal (gnc_lot_get_balance (lot),
+                                 gnc_numeric_create (100, 1)));
+    g_assert (gnc_lot_get_earliest_split (lot) == s1);
+    g_assert (gnc_lot_get_latest_split (lot) == s4);
+    check_balance_before (lot);
+
+    /* Changing an amount keeps the order but changes the sums. */
+    xaccSplitSetAmount (s3, gnc_numeric_create (60, 1));
+    g_assert (gnc_numeric_equal (gnc_lot_get_balance (lot),
+                                 gnc_numeric_create (110, 1)));
+    check_balance_before (lot);
+
+    /* Moving a transaction reorders the lot. */
+    xaccTransSetDatePostedSecs (xaccSplitGetParent (s1), base + 3 * day);
+    g_assert (gnc_lot_get_earliest_split (lot) == s3);
+    g_assert (gnc_lot_get_latest_split (lot) == s1);
+    check_balance_before (lot);
+
+    gnc_lot_remove_split (lot, s1);
+    g_assert (gnc_numeric_equal (gnc_lot_get_balance (lot),
+                                 gnc_numeric_create (10, 1)));
+    g_assert (gnc_lot_get_latest_split (lot) == s4 ||
+              gnc_lot_get_latest_split (lot) == s2);
+    check_balance_before (lot);
+
+    qof_session_end (sess);
+}
+
+/* Give the split, and the other split of its transaction, a new value. */
+static void
+set_lot_split_value (Split *split, gint64 value)
+{
+    auto trans = xaccSplitGetParent (split);
+    auto other = xaccSplitGetOtherSplit (split);
+
+    xaccTransBeginEdit (trans);
+    xaccSplitSetValue (split, gnc_numeric_create (value, 1));
+    xaccSplitSetAmount (other, gnc_numeric_create (-value, 1));
+    xaccSplitSetValue (other, gnc_numeric_create (-value, 1));
+    xaccTransCommitEdit (trans);
+}
+
+static void
+check_cap_gains (Split *split, gint64 gains)
+{
+    auto lot_split = xaccSplitGetCapGainsSplit (split);
+    g_assert (lot_split != NULL);
+    g_assert (xaccSplitGetLot (lot_split) == xaccSplitGetLot (split));
+    g_assert (gnc_numeric_zero_p (xaccSplitGetAmount (lot_split)));
+    g_assert (gnc_numeric_equal (xaccSplitGetValue (lot_split),
+                                 gnc_numeric_create (gains, 1)));
+}
+
+static void
+test_tree_compute_cap_gains ()
+{
+    QofSession *sess = get_random_session ();
+    QofBook *book = qof_session_get_book (sess);
+    gnc_commodity *stock = gnc_commodity_new (book, "Stock", "NASDAQ", "STK",
+                                              "", 1);
+    gnc_commodity *usd = gnc_commodity_new (book, "Dollar",
+                                            GNC_COMMODITY_NS_CURRENCY, "USD",
+                                            "", 100);
+    Account *top = xaccMallocAccount (book);
+    Account *cash = xaccMallocAccount (book);
+    Account *gains = xaccMallocAccount (book);
+    const time64 day = 86400, base = 1500000000;
+    Split *sales[2][2];
+
+    xaccAccountSetCommodity (top, usd);
+    xaccAccountSetCommodity (cash, usd);
+    xaccAccountSetCommodity (gains, usd);
+    xaccAccountSetType (gains, ACCT_TYPE_INCOME);
+    gnc_account_append_child (top, cash);
+    gnc_account_append_child (top, gains);
+    for (auto i = 0; i < 2; i++)
+    {
+        Account *acct = xaccMallocAccount (book);
+        GNCLot *lot = gnc_lot_new (book);
+
+        xaccAccountSetCommodity (acct, stock);
+        xaccAccountSetType (acct, ACCT_TYPE_STOCK);
+        gnc_account_append_child (top, acct);
+        add_lot_split (lot, acct, cash, base, 100, 1000);
+        sales[i][0] = add_lot_split (lot, acct, cash, base + day, -30, -300);
+        sales[i][1] = add_lot_split (lot, acct, cash, base + 2 * day, -20,
+                                     -200);
+        set_lot_split_value (sales[i][0], -450);
+        set_lot_split_value (sales[i][1], -100);
+    }
+
+    /* The second sale's basis includes the gains of the first: 100
+     * shares cost 1000, 30 of them are sold for 450 (a gain of 150),
+     * leaving 70 shares worth 700 of which 20 are sold for 100. */
+    xaccAccountTreeComputeCapGains (top, gains);
+    for (auto i = 0; i < 2; i++)
+    {
+        check_cap_gains (sales[i][0], 150);
+        check_cap_gains (sales[i][1], -100);
+    }
+    g_assert_cmpint (g_list_length (xaccAccountGetSplitList (gains)), ==, 4);
+    g_assert (gnc_numeric_equal (xaccAccountGetBalance (gains),
+                                 gnc_numeric_create (-100, 1)));
+
+    /* Nothing changed, nothing to do. */
+    xaccAccountTreeComputeCapGains (top, gains);
+    g_assert_cmpint (g_list_length (xaccAccountGetSplitList (gains)), ==, 4);
+    g_assert (gnc_numeric_equal (xaccAccountGetBalance (gains),
+                                 gnc_numeric_create (-100, 1)));
+
+    /* The existing gains transaction is updated. */
+    set_lot_split_value (sales[0][0], -400);
+    xaccAccountTreeComputeCapGains (top, gains);
+    check_cap_gains (sales[0][0], 100);
+    check_cap_gains (sales[0][1], -100);
+    check_cap_gains (sales[1][0], 150);
+    g_assert_cmpint (g_list_length (xaccAccountGetSplitList (gains)), ==, 4);
+    g_assert (gnc_numeric_equal (xaccAccountGetBalance (gains),
+                                 gnc_numeric_create (-50, 1)));
+
+    qof_session_end (sess);
+}
+
+static void
+test_tree_compute_cap_gains_trading ()
+{
+    QofSession *sess = get_random_session ();
+    QofBook *book = qof_session_get_book (sess);
+    gnc_commodity *stock = gnc_commodity_new (book, "Stock", "NASDAQ", "STK",
+                                              "", 1);
+    gnc_commodity *eur = gnc_commodity_new (book, "Euro",
+                                            GNC_COMMODITY_NS_CURRENCY, "EUR",
+                                            "", 100);
+    Account *top = xaccMallocAccount (book);
+    Account *cash = xaccMallocAccount (book);
+    Account *gains = xaccMallocAccount (book);
+    Account *stock_trading = xaccMallocAccount (book);
+    Account *eur_trading = xaccMallocAccount (book);
+    const time64 day = 86400, base = 1500000000;
+    Split *sales[2][2];
+
+    xaccAccountSetCommodity (top, eur);
+    xaccAccountSetCommodity (cash, eur);
+    xaccAccountSetCommodity (gains, eur);
+    xaccAccountSetType (gains, ACCT_TYPE_INCOME);
+    xaccAccountSetCommodity (stock_trading, stock);
+    xaccAccountSetType (stock_trading, ACCT_TYPE_TRADING);
+    xaccAccountSetCommodity (eur_trading, eur);
+    xaccAccountSetType (eur_trading, ACCT_TYPE_TRADING);
+    gnc_account_append_child (top, cash);
+    gnc_account_append_child (top, gains);
+    gnc_account_append_child (top, stock_trading);
+    gnc_account_append_child (top, eur_trading);
+    for (auto i = 0; i < 2; i++)
+    {
+        Account *acct = xaccMallocAccount (book);
+        GNCLot *lot = gnc_lot_new (book);
+
+        xaccAccountSetCommodity (acct, stock);
+        xaccAccountSetType (acct, ACCT_TYPE_STOCK);
+        gnc_account_append_child (top, acct);
+        add_lot_split (lot, acct, cash, base, 100, 1000, stock_trading,
+                       eur_trading);
+        sales[i][0] = add_lot_split (lot, acct, cash, base + day, -30, -450,
+                                     stock_trading, eur_trading);
+        sales[i][1] = add_lot_split (lot, acct, cash, base + 2 * day, -20,
+                                     -100, stock_trading, eur_trading);
+    }
+
+    /* Both stock accounts trade through the same two trading accounts;
+     * the gains come out as they do without them. */
+    xaccAccountTreeComputeCapGains (top, gains);
+    for (auto i = 0; i < 2; i++)
+    {
+        check_cap_gains (sales[i][0], 150);
+        check_cap_gains (sales[i][1], -100);
+    }
+    g_assert_cmpint (g_list_length (xaccAccountGetSplitList (gains)), ==, 4);
+    g_assert (gnc_numeric_equal (xaccAccountGetBalance (gains),
+                                 gnc_numeric_create (-100, 1)));
+
+    xaccAccountTreeComputeCapGains (top, gains);
+    g_assert_cmpint (g_list_length (xaccAccountGetSplitList (gains)), ==, 4);
+
+    qof_session_end (sess);
+}
+
 static void
 run_test (void)
 {
@@ -139,6 +421,9 @@ main (int argc, char **argv)
     }
 
     test_lot_kvp ();
+    test_lot_split_order ();
+    test_tree_compute_cap_gains ();
+    test_tree_compute_cap_gains_trading ();
 
     /* 'erase' the recurring tag line with dummy spaces. */
     fprintf(stdout, "Lots: Test series complete.\n");
@@ -34,6 +34,8 @@ extern "C"
 #include "test-stuff.h"
 }
 
+#include <vector>
+
 static int
 test_trans_query (Transaction *trans, gpointer data)
 {
@@ -68,6 +70,68 @@ test_trans_query (Transaction *trans, gpointer data)
     return 0;
 }
 
+static gboolean
+collect_result (gpointer object, gpointer user_data)
+{
+    auto results = static_cast<std::vector<gpointer>*>(user_data);
+    results->push_back (object);
+    return results->size () < 2;
+}
+
+static void
+test_query_top_results (QofBook *book)
+{
+    std::vector<gpointer> results;
+    QofQuery *q;
+    GList *all, *top;
+    guint n_all;
+
+    q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    all = g_list_copy (qof_query_run (q));
+    n_all = g_list_length (all);
+    if (n_all <= 2)
+    {
+        failure_args ("query top results", __FILE__, __LINE__,
+                      "only %d splits", n_all);
+        g_list_free (all);
+        qof_query_destroy (q);
+        return;
+    }
+
+    /* The last of the sorted matches are kept, in order */
+    qof_query_set_max_results (q, 2);
+    top = qof_query_run (q);
+    do_test (g_list_length (top) == 2 &&
+             top->data == g_list_nth_data (all, n_all - 2) &&
+             top->next->data == g_list_nth_data (all, n_all - 1),
+             "max_results keeps the last sorted matches");
+
+    qof_query_set_max_results (q, n_all + 1);
+    do_test (g_list_length (qof_query_run (q)) == n_all,
+             "max_results above the number of matches keeps them all");
+    qof_query_set_max_results (q, 0);
+    do_test (qof_query_run (q) == NULL, "max_results of zero matches none");
+
+    /* The callback stops the run by returning FALSE */
+    qof_query_set_max_results (q, -1);
+    qof_query_run_foreach (q, collect_result, &results);
+    do_test (results.size () == 2 && results[0] == all->data &&
+             results[1] == all->next->data,
+             "foreach hands over the first sorted matches");
+
+    /* Without a sort order the matches are handed over as found */
+    results.clear ();
+    qof_query_set_sort_order (q, NULL, NULL, NULL);
+    qof_query_run_foreach (q, collect_result, &results);
+    do_test (results.size () == 2 && g_list_find (all, results[0]) &&
+             g_list_find (all, results[1]),
+             "foreach without a sort order stops when asked");
+
+    g_list_free (all);
+    qof_query_destroy (q);
+}
+
 static void
 run_test (void)
 {
@@ -82,6 +146,7 @@ run_test (void)
     add_random_transactions_to_book (book, 20);
 
     xaccAccountTreeForEachTransaction (root, test_trans_query, book);
+    test_query_top_results (book);
 
     qof_session_end (session);
 }
@@ -33,8 +33,11 @@ extern "C"
 #include "../Account.h"
 #include "../AccountP.h"
 #include "../Split.h"
+#include "../SplitP.h"
 #include "../Transaction.h"
 #include "../gnc-lot.h"
+#include "../cap-gains.h"
+#include "../Query.h"
 
 #if defined(__clang__) && (__clang_major__ == 5 || (__clang_major__ == 3 && __clang_minor__ < 5))
 #define USE_CLANG_FUNC_SIG 1
@@ -45,6 +48,7 @@ void test_suite_account (void);
 
 #include <qofinstance-p.h>
 #include <kvp-frame.hpp>
+#include <vector>
 
 typedef struct
 {
@@ -1428,6 +1432,108 @@ Passthrough, no test.
 	gnc_account_get_policy
 	gnc_account_set_policy
 */
+/* gnc_account_mark_split_dirty
+void
+gnc_account_mark_split_dirty (Account *acc, Split *split)// C: 2 in 1 */
+static void
+check_split_order (GList *splits, guint length)
+{
+    g_assert_cmpuint (g_list_length (splits), ==, length);
+    for (GList *node = splits; node && node->next; node = node->next)
+    {
+        g_assert (node->next->prev == node);
+        g_assert_cmpint (xaccSplitOrder (static_cast<Split*>(node->data),
+                                         static_cast<Split*>(node->next->data)),
+                         <, 0);
+    }
+}
+
+static void
+test_gnc_account_split_order (Fixture *fixture, gconstpointer pData)
+{
+    QofBook *book = gnc_account_get_book (fixture->acct);
+    AccountPrivate *priv = fixture->func->get_private (fixture->acct);
+    const char *memos[] = {"d", "b", "e", "a", "c"};
+    Split *splits[G_N_ELEMENTS (memos)];
+    Split *late, *extra;
+    Account *other;
+    AccountPrivate *other_priv;
+
+    /* Splits without a transaction sort on their memos. */
+    for (guint i = 0; i < G_N_ELEMENTS (memos); ++i)
+    {
+        splits[i] = xaccMallocSplit (book);
+        xaccSplitSetMemo (splits[i], memos[i]);
+        g_assert (gnc_account_insert_split (fixture->acct, splits[i]));
+        xaccSplitSetAccount (splits[i], fixture->acct);
+    }
+    g_assert (!priv->sort_dirty);
+    check_split_order (priv->splits, 5);
+    g_assert (priv->splits->data == splits[3]);
+
+    /* A split added while the account is open for editing goes to the
+     * front and is put in its place by the next sort. */
+    late = xaccMallocSplit (book);
+    xaccSplitSetMemo (late, "bb");
+    qof_instance_increase_editlevel (fixture->acct);
+    g_assert (gnc_account_insert_split (fixture->acct, late));
+    xaccSplitSetAccount (late, fixture->acct);
+    qof_instance_decrease_editlevel (fixture->acct);
+    g_assert (priv->sort_dirty);
+    g_assert (priv->splits->data == late);
+    xaccAccountSortSplits (fixture->acct, FALSE);
+    g_assert (!priv->sort_dirty);
+    check_split_order (priv->splits, 6);
+    g_assert (g_list_nth_data (priv->splits, 2) == late);
+
+    /* Changing a split's sort key takes it out of the order first, so
+     * that splits can still be added in between, and moves only that
+     * split. */
+    xaccSplitSetMemo (splits[3], "f");
+    g_assert (priv->sort_dirty);
+    extra = xaccMallocSplit (book);
+    xaccSplitSetMemo (extra, "ee");
+    g_assert (gnc_account_insert_split (fixture->acct, extra));
+    xaccSplitSetAccount (extra, fixture->acct);
+    g_assert (gnc_account_remove_split (fixture->acct, extra));
+    g_assert (priv->balance_dirty);
+    xaccAccountSortSplits (fixture->acct, FALSE);
+    check_split_order (priv->splits, 6);
+    g_assert (g_list_last (priv->splits)->data == splits[3]);
+
+    /* Removing a pending split mustn't disturb the next sort. */
+    xaccSplitSetMemo (splits[0], "0");
+    g_assert (gnc_account_remove_split (fixture->acct, splits[0]));
+    g_assert (!gnc_account_remove_split (fixture->acct, splits[0]));
+    xaccAccountSortSplits (fixture->acct, FALSE);
+    check_split_order (priv->splits, 5);
+
+    /* So does changing its guid, the last key. */
+    auto guid = guid_new_return ();
+    xaccSplitSetGUID (splits[1], &guid);
+    g_assert (priv->sort_dirty);
+    xaccAccountSortSplits (fixture->acct, FALSE);
+    check_split_order (priv->splits, 5);
+
+    /* A full resort gives the same order. */
+    gnc_account_set_sort_dirty (fixture->acct);
+    xaccAccountSortSplits (fixture->acct, FALSE);
+    check_split_order (priv->splits, 5);
+    g_assert (xaccAccountGetSplitList (fixture->acct) == priv->splits);
+
+    /* Changing the book's num-source option reorders every account. */
+    other = xaccMallocAccount (book);
+    gnc_account_append_child (fixture->acct, other);
+    other_priv = fixture->func->get_private (other);
+    xaccAccountSortSplits (other, FALSE);
+    g_assert (!other_priv->sort_dirty);
+    qof_book_begin_edit (book);
+    qof_instance_set (QOF_INSTANCE (book), "split-action-num-field", "t", NULL);
+    qof_book_commit_edit (book);
+    xaccAccountSortSplits (fixture->acct, FALSE);
+    check_split_order (priv->splits, 5);
+    g_assert (other_priv->sort_dirty);
+}
 /* xaccAccountRemoveLot
 void
 xaccAccountRemoveLot (Account *acc, GNCLot *lot)// C: 6 in 4 */
@@ -1548,6 +1654,97 @@ test_xaccAccountRecomputeBalance (Fixture *fixture, gconstpointer pData)
     g_assert (!priv->balance_dirty);
 }
 
+static void
+test_xaccAccountRecomputeBalanceIncremental (Fixture *fixture, gconstpointer pData)
+{
+    auto root = gnc_account_get_root (fixture->acct);
+    auto acct = gnc_account_lookup_by_name (root, "baz");
+    AccountPrivate *priv = fixture->func->get_private (acct);
+    auto amount = gnc_numeric_create (-50000, 100);
+    auto check_balances = [priv]()
+    {
+        auto bal = gnc_numeric_zero ();
+        for (GList *node = priv->splits; node; node = node->next)
+        {
+            auto split = static_cast<Split*>(node->data);
+            bal = gnc_numeric_add_fixed (bal, xaccSplitGetAmount (split));
+            g_assert (gnc_numeric_eq (xaccSplitGetBalance (split), bal));
+        }
+        g_assert (gnc_numeric_eq (priv->balance, bal));
+    };
+
+    xaccAccountSortSplits (acct, TRUE);
+    xaccAccountRecomputeBalance (acct);
+    g_assert (!priv->balance_dirty);
+    check_balances ();
+
+    /* Changing an amount in the middle of the account only dirties the
+     * balances from that split on. */
+    auto split = static_cast<Split*>(g_list_nth_data (priv->splits, 2));
+    auto txn = xaccSplitGetParent (split);
+    xaccTransBeginEdit (txn);
+    xaccSplitSetAmount (split, amount);
+    /* xaccTransCommitEdit () does a bunch of scrubbing that we don't need */
+    qof_commit_edit (QOF_INSTANCE (txn));
+    g_assert (priv->balance_dirty);
+    xaccAccountRecomputeBalance (acct);
+    g_assert (!priv->balance_dirty);
+    check_balances ();
+
+    /* So does removing a split... */
+    split = static_cast<Split*>(g_list_nth_data (priv->splits, 1));
+    g_assert (gnc_account_remove_split (acct, split));
+    g_assert (!priv->balance_dirty);
+    check_balances ();
+
+    /* ...and putting it back. */
+    g_assert (gnc_account_insert_split (acct, split));
+    g_assert (priv->balance_dirty);
+    xaccAccountRecomputeBalance (acct);
+    check_balances ();
+    g_assert_cmpint (g_list_index (priv->splits, split), ==, 1);
+}
+
+/* gnc_account_tree_sort_and_recompute
+void
+gnc_account_tree_sort_and_recompute (Account *root)
+*/
+static void
+test_gnc_account_tree_sort_and_recompute (Fixture *fixture, gconstpointer pData)
+{
+    auto root = gnc_account_get_root (fixture->acct);
+    auto accounts = gnc_account_get_descendants (root);
+    /* Loading leaves every account open for editing, sort- and
+     * balance-dirty. */
+    for (auto node = accounts; node; node = node->next)
+    {
+        auto acc = static_cast<Account*>(node->data);
+        xaccAccountBeginEdit (acc);
+        gnc_account_set_sort_dirty (acc);
+        gnc_account_set_balance_dirty (acc);
+    }
+    gnc_account_tree_sort_and_recompute (root);
+    for (auto node = accounts; node; node = node->next)
+    {
+        auto acc = static_cast<Account*>(node->data);
+        AccountPrivate *priv = fixture->func->get_private (acc);
+        auto bal = gnc_numeric_zero ();
+        g_assert (!priv->sort_dirty);
+        g_assert (!priv->balance_dirty);
+        for (auto snode = priv->splits; snode; snode = snode->next)
+        {
+            auto split = static_cast<Split*>(snode->data);
+            if (snode->next)
+                g_assert_cmpint (xaccSplitOrder (split, static_cast<Split*>(snode->next->data)), <, 0);
+            bal = gnc_numeric_add_fixed (bal, xaccSplitGetAmount (split));
+            g_assert (gnc_numeric_eq (xaccSplitGetBalance (split), bal));
+        }
+        g_assert (gnc_numeric_eq (priv->balance, bal));
+        xaccAccountCommitEdit (acc);
+    }
+    g_list_free (accounts);
+}
+
 /* xaccAccountOrder
 int
 xaccAccountOrder (const Account *aa, const Account *ab)// C: 11 in 3 */
@@ -2151,6 +2348,191 @@ test_xaccAccountGetBalanceAsOfDate (Fixture *fixture, gconstpointer pData)
     dval = gnc_numeric_to_double (val);
     g_assert_cmpfloat (dval, == , dbal);
 }
+
+static void
+test_xaccAccountGetBalanceAsOfDate_boundaries (Fixture *fixture, gconstpointer pData)
+{
+    auto splits = xaccAccountGetSplitList (fixture->acct);
+    g_assert (splits != NULL);
+    xaccAccountRecomputeBalance (fixture->acct);
+    /* A split posted exactly on the date isn't included, nor is any
+     * split after it. */
+    for (GList *node = splits; node; node = node->next)
+    {
+        auto split = static_cast<Split*>(node->data);
+        auto date = xaccTransGetDate (xaccSplitGetParent (split));
+        auto expected = gnc_numeric_zero ();
+        for (GList *prior = splits; prior != node; prior = prior->next)
+            expected = gnc_numeric_add_fixed (expected, xaccSplitGetAmount (static_cast<Split*>(prior->data)));
+        g_assert (gnc_numeric_eq (xaccAccountGetBalanceAsOfDate (fixture->acct, date), expected));
+        expected = gnc_numeric_add_fixed (expected, xaccSplitGetAmount (split));
+        g_assert (gnc_numeric_eq (xaccAccountGetBalanceAsOfDate (fixture->acct, date + 1), expected));
+    }
+    g_assert (gnc_numeric_zero_p (xaccAccountGetBalanceAsOfDate (fixture->acct, INT64_MIN)));
+}
+/* xaccAccountGetBalancesAsOfDates
+gnc_numeric *
+xaccAccountGetBalancesAsOfDates (Account *acc, const time64 *dates, ...)
+*/
+static void
+test_xaccAccountGetBalancesAsOfDates (Fixture *fixture, gconstpointer pData)
+{
+    auto comm = xaccAccountGetCommodity (fixture->acct);
+    std::vector<time64> dates{INT64_MIN, gnc_time (nullptr)};
+    for (auto node = xaccAccountGetSplitList (fixture->acct); node; node = node->next)
+    {
+        auto date = xaccTransGetDate (xaccSplitGetParent (static_cast<Split*>(node->data)));
+        dates.push_back (date);
+        dates.push_back (date + 1);
+    }
+    gsize n_accounts = 0;
+    auto balances = xaccAccountGetBalancesAsOfDates (fixture->acct, dates.data (), dates.size (),
+                                                     nullptr, FALSE, TRUE, &n_accounts);
+    auto descendants = gnc_account_get_descendants (fixture->acct);
+    g_assert_cmpuint (n_accounts, ==, 1 + g_list_length (descendants));
+    descendants = g_list_prepend (descendants, fixture->acct);
+    auto row = balances;
+    for (auto node = descendants; node; node = node->next, row += dates.size ())
+    {
+        auto acc = static_cast<Account*>(node->data);
+        for (gsize i = 0; i < dates.size (); ++i)
+        {
+            auto expected = xaccAccountConvertBalanceToCurrencyAsOfDate (
+                acc, xaccAccountGetBalanceAsOfDate (acc, dates[i]),
+                xaccAccountGetCommodity (acc), comm, dates[i]);
+            g_assert (gnc_numeric_equal (row[i], expected));
+        }
+    }
+    g_list_free (descendants);
+    g_free (balances);
+
+    balances = xaccAccountGetBalancesAsOfDates (fixture->acct, dates.data (), dates.size (),
+                                                nullptr, FALSE, FALSE, &n_accounts);
+    g_assert_cmpuint (n_accounts, ==, 1);
+    g_assert (gnc_numeric_zero_p (balances[0]));
+    g_free (balances);
+
+    /* A starting balance isn't part of the sums */
+    auto before = xaccAccountGetBalancesAsOfDates (fixture->acct, dates.data (), dates.size (),
+                                                   nullptr, FALSE, FALSE, nullptr);
+    gnc_account_set_start_balance (fixture->acct, gnc_numeric_create (1000, 1));
+    balances = xaccAccountGetBalancesAsOfDates (fixture->acct, dates.data (), dates.size (),
+                                                nullptr, FALSE, FALSE, nullptr);
+    for (gsize i = 0; i < dates.size (); ++i)
+        g_assert (gnc_numeric_equal (balances[i], before[i]));
+    /* but a single balance starts from it */
+    g_assert (gnc_numeric_equal (xaccAccountGetBalanceAsOfDate (fixture->acct, INT64_MIN),
+                                 gnc_numeric_create (1000, 1)));
+    g_free (before);
+    g_free (balances);
+}
+/* split_query_index
+static gboolean
+split_query_index (QofBook *book, const GList *and_terms, ...)
+*/
+static guint
+count_splits_between (GList *splits, time64 start, time64 end)
+{
+    guint count = 0;
+    for (auto node = splits; node; node = node->next)
+    {
+        auto date = xaccTransGetDate (xaccSplitGetParent (static_cast<Split*>(node->data)));
+        if (date >= start && date <= end)
+            ++count;
+    }
+    return count;
+}
+
+static void
+test_split_query_index (Fixture *fixture, gconstpointer pData)
+{
+    auto book = gnc_account_get_book (fixture->acct);
+    auto splits = xaccAccountGetSplitList (fixture->acct);
+    auto first = static_cast<Split*>(splits->data);
+    auto start = xaccTransGetDate (xaccSplitGetParent (first));
+    auto end = xaccTransGetDate (xaccSplitGetParent (static_cast<Split*>(g_list_last (splits)->data)));
+    auto mid = start + (end - start) / 2;
+
+    auto q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddSingleAccountMatch (q, fixture->acct, QOF_QUERY_AND);
+    g_assert_cmpuint (g_list_length (qof_query_run (q)), ==, g_list_length (splits));
+
+    xaccQueryAddDateMatchTT (q, TRUE, mid, FALSE, 0, QOF_QUERY_AND);
+    g_assert_cmpuint (g_list_length (qof_query_run (q)), ==,
+                      count_splits_between (splits, mid, INT64_MAX));
+
+    /* Terms the index doesn't serve are still checked */
+    xaccQueryAddGUIDMatch (q, xaccSplitGetGUID (first), GNC_ID_SPLIT, QOF_QUERY_AND);
+    g_assert_cmpuint (g_list_length (qof_query_run (q)), ==, mid <= start ? 1 : 0);
+    qof_query_destroy (q);
+
+    /* Either of two terms naming the same account is found once */
+    q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddSingleAccountMatch (q, fixture->acct, QOF_QUERY_AND);
+    xaccQueryAddSingleAccountMatch (q, fixture->acct, QOF_QUERY_OR);
+    g_assert_cmpuint (g_list_length (qof_query_run (q)), ==, g_list_length (splits));
+    qof_query_destroy (q);
+
+    /* A date range alone covers the splits of every account */
+    q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddDateMatchTT (q, TRUE, start, TRUE, mid, QOF_QUERY_AND);
+    auto expected = 0u;
+    auto accounts = gnc_account_get_descendants (gnc_account_get_root (fixture->acct));
+    for (auto node = accounts; node; node = node->next)
+        expected += count_splits_between (xaccAccountGetSplitList (static_cast<Account*>(node->data)),
+                                          start, mid);
+    g_list_free (accounts);
+    g_assert_cmpuint (expected, >, 0);
+    g_assert_cmpuint (g_list_length (qof_query_run (q)), ==, expected);
+    qof_query_destroy (q);
+
+    /* A split moved into the account by an open edit is found */
+    Split *moved = nullptr;
+    accounts = gnc_account_get_descendants (gnc_account_get_root (fixture->acct));
+    for (auto node = accounts; node && !moved; node = node->next)
+    {
+        auto acc = static_cast<Account*>(node->data);
+        auto acc_splits = xaccAccountGetSplitList (acc);
+        if (acc != fixture->acct && acc_splits)
+            moved = static_cast<Split*>(acc_splits->data);
+    }
+    g_list_free (accounts);
+    g_assert (moved);
+    auto trans = xaccSplitGetParent (moved);
+    q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddSingleAccountMatch (q, fixture->acct, QOF_QUERY_AND);
+    xaccTransBeginEdit (trans);
+    xaccSplitSetAccount (moved, fixture->acct);
+    g_assert (g_list_find (qof_query_run (q), moved));
+    xaccTransRollbackEdit (trans);
+    g_assert (!g_list_find (qof_query_run (q), moved));
+    qof_query_destroy (q);
+
+    /* So is the split of a new transaction being entered, also by date */
+    auto blank = xaccMallocTransaction (book);
+    xaccTransBeginEdit (blank);
+    xaccTransSetCurrency (blank, xaccAccountGetCommodity (fixture->acct));
+    xaccTransSetDatePostedSecs (blank, start);
+    auto blank_split = xaccMallocSplit (book);
+    xaccSplitSetParent (blank_split, blank);
+    xaccSplitSetAccount (blank_split, fixture->acct);
+    q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddSingleAccountMatch (q, fixture->acct, QOF_QUERY_AND);
+    g_assert (g_list_find (qof_query_run (q), blank_split));
+    qof_query_destroy (q);
+    q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddDateMatchTT (q, TRUE, start, TRUE, mid, QOF_QUERY_AND);
+    g_assert_cmpuint (g_list_length (qof_query_run (q)), ==, expected + 1);
+    qof_query_destroy (q);
+    xaccTransDestroy (blank);
+    xaccTransCommitEdit (blank);
+}
 /* xaccAccountGetPresentBalance
 gnc_numeric
 xaccAccountGetPresentBalance (const Account *acc)// C: 4 in 2 */
@@ -2281,6 +2663,81 @@ test_xaccAccountForEachLot (Fixture *fixture, gconstpointer pData)
     xaccAccountForEachLot (acct, bogus_for_each_lot_func, &count_calls);
     g_assert_cmpint (count_calls, == , 5);
 }
+
+static gpointer
+collect_lot_func (GNCLot *lot, gpointer data)
+{
+    auto lots = static_cast<std::vector<GNCLot*>*>(data);
+    lots->push_back (lot);
+    return NULL;
+}
+
+/* xaccAccountForEachOpenLotByDate
+gpointer
+xaccAccountForEachOpenLotByDate (const Account *acc,// C: 1 in 1 */
+static void
+test_xaccAccountForEachOpenLotByDate (Fixture *fixture, gconstpointer pData)
+{
+    Account *root = gnc_account_get_root (fixture->acct);
+    Account *acct = gnc_account_lookup_by_name (root, "baz");
+    std::vector<GNCLot*> lots;
+    GNCLot *waldo, *links;
+    Transaction *txn;
+    Split *split;
+
+    g_assert (acct);
+    xaccAccountForEachOpenLotByDate (acct, FALSE, FALSE, collect_lot_func,
+                                     &lots);
+    g_assert_cmpint (lots.size (), == , 0);
+    /* The lots opened by "waldo" and "links" are open; the one opened
+     * by "salt" was closed by "pork". */
+    xaccAccountForEachOpenLotByDate (acct, TRUE, FALSE, collect_lot_func,
+                                     &lots);
+    g_assert_cmpint (lots.size (), == , 2);
+    waldo = lots[0];
+    links = lots[1];
+    g_assert_cmpstr (xaccSplitGetMemo (gnc_lot_get_earliest_split (waldo)),
+                     == , "waldo_baz");
+    g_assert_cmpstr (xaccSplitGetMemo (gnc_lot_get_earliest_split (links)),
+                     == , "links_baz");
+    lots.clear ();
+    xaccAccountForEachOpenLotByDate (acct, TRUE, TRUE, collect_lot_func,
+                                     &lots);
+    g_assert_cmpint (lots.size (), == , 2);
+    g_assert (lots[0] == links && lots[1] == waldo);
+    g_assert (xaccAccountFindEarliestOpenLot (acct, gnc_numeric_create (-1, 1),
+                                              NULL) == waldo);
+    g_assert (xaccAccountFindLatestOpenLot (acct, gnc_numeric_create (-1, 1),
+                                            NULL) == links);
+    g_assert (xaccAccountFindEarliestOpenLot (acct, gnc_numeric_create (1, 1),
+                                              NULL) == NULL);
+
+    /* Moving the opening transaction moves the lot. */
+    txn = xaccSplitGetParent (gnc_lot_get_earliest_split (links));
+    xaccTransBeginEdit (txn);
+    xaccTransSetDatePostedSecs (txn, xaccTransGetDate (xaccSplitGetParent (
+                                    gnc_lot_get_earliest_split (waldo))) - 86400);
+    qof_commit_edit (QOF_INSTANCE (txn));
+    lots.clear ();
+    xaccAccountForEachOpenLotByDate (acct, TRUE, FALSE, collect_lot_func,
+                                     &lots);
+    g_assert_cmpint (lots.size (), == , 2);
+    g_assert (lots[0] == links && lots[1] == waldo);
+
+    /* Changing an amount so that the lot balances closes it. */
+    split = gnc_lot_get_latest_split (waldo);
+    g_assert_cmpstr (xaccSplitGetMemo (split), == , "sausage_baz");
+    txn = xaccSplitGetParent (split);
+    xaccTransBeginEdit (txn);
+    xaccSplitSetAmount (split, gnc_numeric_create (-1000, 1));
+    qof_commit_edit (QOF_INSTANCE (txn));
+    g_assert (gnc_numeric_zero_p (gnc_lot_get_balance (waldo)));
+    lots.clear ();
+    xaccAccountForEachOpenLotByDate (acct, TRUE, FALSE, collect_lot_func,
+                                     &lots);
+    g_assert_cmpint (lots.size (), == , 1);
+    g_assert (lots[0] == links);
+}
 /* These getters and setters look in KVP, so I guess their delegators instead:
  * xaccAccountGetTaxRelated
  * xaccAccountSetTaxRelated
@@ -2778,8 +3235,11 @@ test_suite_account (void)
     GNC_TEST_ADD (suitename, "gnc account kvp getters & setters", Fixture, NULL, setup, test_gnc_account_kvp_setters_getters,  teardown );
     GNC_TEST_ADD (suitename, "test_gnc_account_get_map_entry", Fixture, NULL, setup, test_gnc_account_get_map_entry,  teardown );
     GNC_TEST_ADD (suitename, "gnc account insert & remove split", Fixture, NULL, setup, test_gnc_account_insert_remove_split,  teardown );
+    GNC_TEST_ADD (suitename, "gnc account split order", Fixture, NULL, setup, test_gnc_account_split_order,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccount Insert and Remove Lot", Fixture, &good_data, setup, test_xaccAccountInsertRemoveLot,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountRecomputeBalance", Fixture, &some_data, setup, test_xaccAccountRecomputeBalance,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountRecomputeBalance incremental", Fixture, &some_data, setup, test_xaccAccountRecomputeBalanceIncremental,  teardown );
+    GNC_TEST_ADD (suitename, "gnc account tree sort and recompute", Fixture, &complex_data, setup, test_gnc_account_tree_sort_and_recompute,  teardown );
     GNC_TEST_ADD_FUNC (suitename, "xaccAccountOrder", test_xaccAccountOrder );
     GNC_TEST_ADD (suitename, "qofAccountSetParent", Fixture, &some_data, setup, test_qofAccountSetParent,  teardown );
     GNC_TEST_ADD (suitename, "gnc account append/remove child", Fixture, NULL, setup, test_gnc_account_append_remove_child,  teardown );
@@ -2798,9 +3258,13 @@ test_suite_account (void)
     GNC_TEST_ADD (suitename, "gnc account get full name", Fixture, &good_data, setup, test_gnc_account_get_full_name,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetProjectedMinimumBalance", Fixture, &some_data, setup, test_xaccAccountGetProjectedMinimumBalance,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetBalanceAsOfDate", Fixture, &some_data, setup, test_xaccAccountGetBalanceAsOfDate,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountGetBalanceAsOfDate boundaries", Fixture, &some_data, setup, test_xaccAccountGetBalanceAsOfDate_boundaries,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountGetBalancesAsOfDates", Fixture, &complex_data, setup, test_xaccAccountGetBalancesAsOfDates,  teardown );
+    GNC_TEST_ADD (suitename, "split query index", Fixture, &complex_data, setup, test_split_query_index,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetPresentBalance", Fixture, &some_data, setup, test_xaccAccountGetPresentBalance,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountFindOpenLots", Fixture, &complex_data, setup, test_xaccAccountFindOpenLots,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountForEachLot", Fixture, &complex_data, setup, test_xaccAccountForEachLot,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountForEachOpenLotByDate", Fixture, &complex_data, setup, test_xaccAccountForEachOpenLotByDate,  teardown );
 
     GNC_TEST_ADD (suitename, "xaccAccountHasAncestor", Fixture, &complex, setup, test_xaccAccountHasAncestor,  teardown );
     GNC_TEST_ADD_FUNC (suitename, "AccountType Stuff", test_xaccAccountType_Stuff );
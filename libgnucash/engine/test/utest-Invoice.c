@@ -25,6 +25,8 @@
 #include <qof.h>
 #include <unittest-support.h>
 #include "../gncInvoice.h"
+#include "../Transaction.h"
+#include "../Split.h"
 
 static const gchar *suitename = "/engine/gncInvoice";
 void test_suite_gncInvoice ( void );
@@ -229,6 +231,96 @@ test_invoice_posted_trans ( Fixture *fixture, gconstpointer pData )
     }
 }
 
+static void
+test_invoice_owner_open_lots ( Fixture *fixture, gconstpointer pData )
+{
+    GNCLot *lot = gncInvoiceGetPostedLot(fixture->invoice);
+    LotList *lots;
+
+    g_assert (lot);
+
+    lots = gncOwnerFindOpenLots (&fixture->owner, NULL, NULL);
+    g_assert (lots && !lots->next && lots->data == lot);
+    g_list_free (lots);
+
+    lots = gncOwnerFindOpenLots (&fixture->owner, fixture->account2, NULL);
+    g_assert (lots && !lots->next && lots->data == lot);
+    g_list_free (lots);
+
+    g_assert (gncOwnerFindOpenLots (&fixture->owner, fixture->account, NULL) == NULL);
+
+    gncInvoiceUnpost(fixture->invoice, TRUE);
+    g_assert (gncOwnerFindOpenLots (&fixture->owner, NULL, NULL) == NULL);
+}
+
+/* Open a lot in account2 for owner. */
+static GNCLot *
+add_owner_lot (Fixture *fixture, const GncOwner *owner)
+{
+    QofBook *book = fixture->book;
+    Transaction *trans = xaccMallocTransaction (book);
+    Split *split = xaccMallocSplit (book);
+    Split *other = xaccMallocSplit (book);
+    GNCLot *lot = gnc_lot_new (book);
+
+    xaccTransBeginEdit (trans);
+    xaccTransSetCurrency (trans, fixture->commodity);
+    xaccTransSetDatePostedSecs (trans, gnc_time (NULL));
+    xaccSplitSetParent (split, trans);
+    xaccSplitSetAccount (split, fixture->account2);
+    xaccSplitSetAmount (split, gnc_numeric_create (1000, 100));
+    xaccSplitSetValue (split, gnc_numeric_create (1000, 100));
+    xaccSplitSetParent (other, trans);
+    xaccSplitSetAccount (other, fixture->account);
+    xaccSplitSetAmount (other, gnc_numeric_create (-1000, 100));
+    xaccSplitSetValue (other, gnc_numeric_create (-1000, 100));
+    xaccTransCommitEdit (trans);
+
+    gnc_lot_add_split (lot, split);
+    gncOwnerAttachToLot (owner, lot);
+    return lot;
+}
+
+static void
+test_invoice_owner_job_open_lots ( Fixture *fixture, gconstpointer pData )
+{
+    GncJob *job = gncJobCreate (fixture->book);
+    GncOwner job_owner;
+    GNCLot *expected[4];
+    LotList *lots, *node;
+    int i;
+
+    gncJobSetOwner (job, &fixture->owner);
+    gncOwnerInitJob (&job_owner, job);
+    /* Look once so the lots below are filed as they come. */
+    g_list_free (gncOwnerFindOpenLots (&fixture->owner, NULL, NULL));
+
+    /* The lots of the owner and of its job, interleaved; they are found
+     * in the order they were put in the account, as
+     * xaccAccountFindOpenLots finds them. */
+    expected[0] = gncInvoiceGetPostedLot (fixture->invoice);
+    expected[1] = add_owner_lot (fixture, &job_owner);
+    expected[2] = add_owner_lot (fixture, &fixture->owner);
+    expected[3] = add_owner_lot (fixture, &job_owner);
+    /* Refiling a lot under another owner doesn't move it either. */
+    gncOwnerAttachToLot (&fixture->owner, expected[1]);
+
+    lots = gncOwnerFindOpenLots (&fixture->owner, fixture->account2, NULL);
+    g_assert_cmpint (g_list_length (lots), ==, 4);
+    for (node = lots, i = 0; node; node = node->next, i++)
+        g_assert (node->data == expected[i]);
+    g_list_free (lots);
+
+    lots = xaccAccountFindOpenLots (fixture->account2, gncOwnerLotMatchOwnerFunc,
+                                    &fixture->owner, NULL);
+    for (node = lots, i = 0; node; node = node->next, i++)
+        g_assert (node->data == expected[i]);
+    g_list_free (lots);
+
+    gncJobBeginEdit (job);
+    gncJobDestroy (job);
+}
+
 void
 test_suite_gncInvoice ( void )
 {
@@ -237,10 +329,13 @@ test_suite_gncInvoice ( void )
 
     GNC_TEST_ADD( suitename, "doclink", Fixture, &pData, setup, test_invoice_doclink, teardown );
     GNC_TEST_ADD( suitename, "post trans - vendor bill", Fixture, &pData, setup_with_invoice, test_invoice_posted_trans, teardown_with_invoice );
+    GNC_TEST_ADD( suitename, "owner open lots - vendor bill", Fixture, &pData, setup_with_invoice, test_invoice_owner_open_lots, teardown_with_invoice );
     pData.is_cn = TRUE;   // Vendor credit note
     GNC_TEST_ADD( suitename, "post trans - vendor credit note", Fixture, &pData, setup_with_invoice, test_invoice_posted_trans, teardown_with_invoice );
     pData.is_cust_doc = TRUE;   // Customer credit note
     GNC_TEST_ADD( suitename, "post trans - customer creditnote", Fixture, &pData, setup_with_invoice, test_invoice_posted_trans, teardown_with_invoice );
     pData.is_cn = FALSE;   // Customer invoice
     GNC_TEST_ADD( suitename, "post trans - customer invoice", Fixture, &pData, setup_with_invoice, test_invoice_posted_trans, teardown_with_invoice );
+    GNC_TEST_ADD( suitename, "owner open lots - customer invoice", Fixture, &pData, setup_with_invoice, test_invoice_owner_open_lots, teardown_with_invoice );
+    GNC_TEST_ADD( suitename, "owner and job open lots - customer invoice", Fixture, &pData, setup_with_invoice, test_invoice_owner_job_open_lots, teardown_with_invoice );
 }
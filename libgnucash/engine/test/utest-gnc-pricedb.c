@@ -1165,6 +1165,40 @@ test_gnc_pricedb_lookup_nearest_before_t64 (PriceDBFixture *fixture, gconstpoint
     g_assert_cmpstr(GET_CUR_NAME(price), ==, "USD");
 
 }
+
+/* price_array_insert, price_array_remove */
+static void
+test_gnc_pricedb_price_order (PriceDBFixture *fixture, gconstpointer pData)
+{
+    GNCPriceDB *db = fixture->pricedb;
+    Commodities *c = fixture->com;
+    time64 t = gnc_dmy2time64 (1, 1, 2020);
+    PriceList *prices = gnc_pricedb_get_prices (db, c->usd, c->aud);
+    GList *node;
+    GNCPrice *moved, *price;
+
+    g_assert (prices != NULL);
+    for (node = prices; node->next; node = node->next)
+        g_assert_cmpint (gnc_price_get_time64 (node->data), >=,
+                         gnc_price_get_time64 (node->next->data));
+
+    /* Moving the oldest price past the others makes it the latest. */
+    moved = g_list_last (prices)->data;
+    gnc_price_set_time64 (moved, t);
+    price = gnc_pricedb_lookup_latest (db, c->usd, c->aud);
+    g_assert (price == moved);
+    gnc_price_unref (price);
+    price = gnc_pricedb_lookup_at_time64 (db, c->usd, c->aud, t);
+    g_assert (price == moved);
+    gnc_price_unref (price);
+
+    gnc_pricedb_remove_price (db, moved);
+    g_assert (gnc_pricedb_lookup_at_time64 (db, c->usd, c->aud, t) == NULL);
+    price = gnc_pricedb_lookup_latest (db, c->usd, c->aud);
+    g_assert (price != NULL && price != moved);
+    gnc_price_unref (price);
+    gnc_price_list_destroy (prices);
+}
 /* direct_balance_conversion
 static gnc_numeric
 direct_balance_conversion (GNCPriceDB *db, gnc_numeric bal,// Local: 2:0:0
@@ -1399,6 +1433,53 @@ test_gnc_pricedb_get_nearest_price (PriceDBFixture *fixture, gconstpointer pData
     g_assert_cmpint(result.denom, ==, 1331);
 }
 
+/* gnc_pricedb_get_rate_cache_stats */
+static void
+test_gnc_pricedb_rate_cache (PriceDBFixture *fixture, gconstpointer pData)
+{
+    GNCPriceDB *db = fixture->pricedb;
+    QofBook *book = qof_instance_get_book (QOF_INSTANCE (db));
+    Commodities *c = fixture->com;
+    time64 t = gnc_dmy2time64(15, 8, 2011);
+    guint64 hits, misses, hits2, misses2;
+    gnc_numeric first, second;
+    GNCPrice *price;
+    int i;
+
+    first = gnc_pricedb_get_nearest_price (db, c->usd, c->aud, t);
+    gnc_pricedb_get_rate_cache_stats (db, &hits, &misses);
+    second = gnc_pricedb_get_nearest_price (db, c->usd, c->aud, t);
+    gnc_pricedb_get_rate_cache_stats (db, &hits2, &misses2);
+    g_assert (gnc_numeric_equal (first, second));
+    g_assert_cmpint (hits2, ==, hits + 1);
+    g_assert_cmpint (misses2, ==, misses);
+
+    /* A new price invalidates the cached rates. */
+    price = construct_price (book, c->usd, c->aud, t, PRICE_SOURCE_EDIT_DLG,
+                             gnc_numeric_create (2, 1));
+    g_assert (gnc_pricedb_add_price (db, price));
+    second = gnc_pricedb_get_nearest_price (db, c->usd, c->aud, t);
+    gnc_pricedb_get_rate_cache_stats (db, &hits, &misses);
+    g_assert (!gnc_numeric_equal (first, second));
+    g_assert_cmpint (hits, ==, hits2);
+    g_assert_cmpint (misses, ==, misses2 + 1);
+
+    /* The cache is bounded and drops the least recently used rate. */
+    for (i = 1; i <= PRICE_RATE_CACHE_SIZE; i++)
+    {
+        gnc_pricedb_get_nearest_price (db, c->usd, c->aud, t + i);
+        gnc_pricedb_get_nearest_price (db, c->usd, c->aud, t);
+    }
+    g_assert_cmpuint (g_hash_table_size (db->rate_cache), ==,
+                      PRICE_RATE_CACHE_SIZE);
+    gnc_pricedb_get_rate_cache_stats (db, &hits, &misses);
+    gnc_pricedb_get_nearest_price (db, c->usd, c->aud, t);
+    gnc_pricedb_get_nearest_price (db, c->usd, c->aud, t + 1);
+    gnc_pricedb_get_rate_cache_stats (db, &hits2, &misses2);
+    g_assert_cmpint (hits2, ==, hits + 1);
+    g_assert_cmpint (misses2, ==, misses + 1);
+}
+
 static void
 test_gnc_pricedb_get_nearest_before_price (PriceDBFixture *fixture, gconstpointer pData)
 {
@@ -1690,6 +1771,7 @@ test_suite_gnc_pricedb (void)
 // GNC_TEST_ADD (suitename, "lookup nearest in time", Fixture, NULL, setup, test_lookup_nearest_in_time, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb lookup nearest in time", PriceDBFixture, NULL, setup, test_gnc_pricedb_lookup_nearest_in_time64, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb lookup nearest before in time", PriceDBFixture, NULL, setup, test_gnc_pricedb_lookup_nearest_before_t64, teardown);
+    GNC_TEST_ADD (suitename, "gnc pricedb price order", PriceDBFixture, NULL, setup, test_gnc_pricedb_price_order, teardown);
 // GNC_TEST_ADD (suitename, "direct balance conversion", Fixture, NULL, setup, test_direct_balance_conversion, teardown);
 // GNC_TEST_ADD (suitename, "extract common prices", Fixture, NULL, setup, test_extract_common_prices, teardown);
 // GNC_TEST_ADD (suitename, "convert balance", Fixture, NULL, setup, test_convert_balance, teardown);
@@ -1699,6 +1781,7 @@ test_suite_gnc_pricedb (void)
     GNC_TEST_ADD (suitename, "gnc pricedb convert balance nearest before price", PriceDBFixture, NULL, setup, test_gnc_pricedb_convert_balance_nearest_before_price_t64, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb get latest price", PriceDBFixture, NULL, setup, test_gnc_pricedb_get_latest_price, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb get nearest price", PriceDBFixture, NULL, setup, test_gnc_pricedb_get_nearest_price, teardown);
+    GNC_TEST_ADD (suitename, "gnc pricedb rate cache", PriceDBFixture, NULL, setup, test_gnc_pricedb_rate_cache, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb get nearest before price", PriceDBFixture, NULL, setup, test_gnc_pricedb_get_nearest_before_price, teardown);
 // GNC_TEST_ADD (suitename, "pricedb foreach pricelist", Fixture, NULL, setup, test_pricedb_foreach_pricelist, teardown);
 // GNC_TEST_ADD (suitename, "pricedb foreach currencies hash", Fixture, NULL, setup, test_pricedb_foreach_currencies_hash, teardown);